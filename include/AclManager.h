@@ -23,6 +23,7 @@
 #include "AclRule.h"
 
 #include "SqlDB.h"
+#include "ChangeLog.h"
 
 using namespace std;
 
@@ -40,11 +41,14 @@ public:
     /**
      *  @param _db pointer to the DB
      *  @param zone_id of the Zone
+     *  @param is_federation_enabled true if this oned is part of a federation.
+     *  The changes of the rules are recorded in the change log
      *  @param is_federation_slave true is this oned is a federation slave. If
      *  it is true, it will reload periodically rules from the DB
      *  @param timer_period period to reload the rules
      */
-    AclManager(SqlDB * _db, int zone_id, bool is_federation_slave, time_t timer);
+    AclManager(SqlDB * _db, int zone_id, bool is_federation_enabled,
+            bool is_federation_slave, time_t timer);
 
     virtual ~AclManager();
 
@@ -221,7 +225,8 @@ protected:
      *  from DB)
      */
     AclManager(int _zone_id)
-        :zone_id(_zone_id), db(0),lastOID(0), is_federation_slave(false)
+        :zone_id(_zone_id), db(0),lastOID(0), change_log(0), last_seq(0),
+        is_federation_slave(false)
     {
        pthread_mutex_init(&mutex, 0);
     };
@@ -381,22 +386,43 @@ private:
      */
     void update_lastOID();
 
+    /**
+     *  Changes of the ACL rules, only used in a federation. The master
+     *  records the rules added or deleted, the slaves read them to reload
+     *  only the rules changed
+     */
+    ChangeLog * change_log;
+
+    /**
+     *  Sequence number of the last change loaded by a slave
+     */
+    long long last_seq;
+
     /**
      *  Callback function to unmarshall the ACL rules
+     *    @param _rules map to store the rules, indexed by oid
      *    @param num the number of columns read from the DB
      *    @param names the column names
      *    @param vaues the column values
      *    @return 0 on success
      */
-    int select_cb(void *nil, int num, char **values, char **names);
+    int select_cb(void *_rules, int num, char **values, char **names);
 
     /**
-     *  Reads the ACL rule set from the database.
-     *    @param db pointer to the db
+     *  Reads the ACL rule set from the database. The rules are loaded
+     *  without the manager lock, and then swapped with the current ones.
      *    @return 0 on success
      */
     int select();
 
+    /**
+     *  Reads the rules changed since the last load, as recorded in the
+     *  change log, and updates the rule set with them. The manager is only
+     *  locked to apply the changes.
+     *    @return 0 on success
+     */
+    int reload();
+
     /**
      *  Inserts the ACL rule in the database.
      *    @param rule to insert
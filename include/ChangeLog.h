@@ -0,0 +1,152 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef CHANGE_LOG_H_
+#define CHANGE_LOG_H_
+
+#include <map>
+#include <string>
+
+#include "SqlDB.h"
+
+using namespace std;
+
+/**
+ *  The ChangeLog class records the changes of the objects stored in the
+ *  tables shared by a federation. The federation master records a new
+ *  sequence number for an object each time it is updated or dropped, so the
+ *  slaves can check if their cached copy is still valid, or get the objects
+ *  changed since their last reload, without reading the objects. Any zone
+ *  records the changes it writes itself in the shared tables (quotas).
+ */
+class ChangeLog : public Callbackable
+{
+public:
+    /**
+     *  @param _db pointer to the DB
+     *  @param _tablename of the objects tracked by this log
+     */
+    ChangeLog(SqlDB * _db, const char * _tablename);
+
+    virtual ~ChangeLog()
+    {
+        pthread_mutex_destroy(&mutex);
+    };
+
+    /**
+     *  Records a change of an object. It must be called once the object has
+     *  been written (or dropped) in the DB. The sequence number includes the
+     *  zone ID (see next_seq), so changes recorded by different zones never
+     *  get the same number.
+     *    @param oid of the object
+     *    @return 0 on success
+     */
+    int log(int oid);
+
+    /**
+     *  Gets the version of an object, the sequence number of its last change
+     *    @param oid of the object
+     *    @param version of the object, 0 if it has not been changed
+     *    @return 0 on success
+     */
+    int get_version(int oid, long long& version);
+
+    /**
+     *  Gets the objects changed after a given sequence number
+     *    @param seq the last sequence number known
+     *    @param changes map of changed objects and their versions
+     *    @return 0 on success
+     */
+    int get_changes(long long seq, map<int, long long>& changes);
+
+    /**
+     *  Gets the sequence number of the last change recorded in the DB
+     *    @param seq the last sequence number, 0 if there are no changes
+     *    @return 0 on success
+     */
+    int get_last(long long& seq);
+
+    /**
+     *  Bootstraps the database table for the change log
+     *    @return 0 on success
+     */
+    static int bootstrap(SqlDB * _db);
+
+private:
+    /**
+     *  Pointer to the database.
+     */
+    SqlDB * db;
+
+    /**
+     *  Table of the objects tracked by this log
+     */
+    string tablename;
+
+    /**
+     *  ID of this zone, in the lower bits of the sequence numbers
+     */
+    int zone_id;
+
+    /**
+     *  Last sequence counter used by this oned, seeded from the DB
+     */
+    long long last_seq;
+
+    /**
+     *  Changes of this oned are serialized so they are written in sequence
+     *  order
+     */
+    pthread_mutex_t mutex;
+
+    /**
+     *  Sequence numbers are counter * MAX_ZONES + zone_id
+     */
+    static const long long MAX_ZONES;
+
+    /**
+     *  Gets the next sequence number of this zone, the mutex must be locked
+     *    @return the sequence number
+     */
+    long long next_seq()
+    {
+        return ++last_seq * MAX_ZONES + zone_id;
+    };
+
+    /**
+     *  Callback to get a sequence number (get_version, get_last)
+     */
+    int seq_cb(void * _seq, int num, char **values, char **names);
+
+    /**
+     *  Callback to get the changed objects (get_changes)
+     */
+    int changes_cb(void * _changes, int num, char **values, char **names);
+
+    // -------------------------------------------------------------------------
+    // DataBase implementation variables
+    // -------------------------------------------------------------------------
+
+    static const char * table;
+
+    static const char * db_names;
+
+    static const char * db_bootstrap;
+
+    static const char * db_index;
+};
+
+#endif /*CHANGE_LOG_H_*/
@@ -18,11 +18,14 @@
 #define ONE_CLIENT_H_
 
 #include <xmlrpc-c/base.hpp>
-#include <xmlrpc-c/client_simple.hpp>
+#include <xmlrpc-c/client.hpp>
 
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <vector>
+
+#include <pthread.h>
 
 #include "NebulaLog.h"
 
@@ -32,15 +35,18 @@ using namespace std;
 // Doc:
 // http://xmlrpc-c.sourceforge.net/doc/#clientexamplepp
 // http://xmlrpc-c.sourceforge.net/doc/libxmlrpc_client++.html#simple_client
+// http://xmlrpc-c.sourceforge.net/doc/libxmlrpc_client++.html#client_xml
 // =============================================================================
 
 //TODO add documentation to the Client methods...
 
 /**
  * This class represents the connection with the core and handles the
- * xml-rpc calls.
+ * xml-rpc calls. The calls are made through a pool of curl transports, each
+ * one keeps its HTTP/1.1 connection open between calls (keep-alive). Calls
+ * can be made concurrently, up to the number of connections of the pool.
  */
-class Client : public xmlrpc_c::clientSimple
+class Client
 {
 public:
     //--------------------------------------------------------------------------
@@ -56,16 +62,50 @@ public:
      * like "http://localhost:2633/RPC2". If not set, the endpoint will be set
      * to $ONE_XMLRPC.
      * @param message_size for XML elements in the client library (in bytes)
+     * @param _max_connections number of persistent connections, calls are
+     * queued if all of them are in use
      * @throws Exception if the authorization options are invalid
      */
-    Client(const string& secret, const string& endpoint, size_t message_size)
+    Client(const string& secret, const string& endpoint, size_t message_size,
+            unsigned int _max_connections = 1):
+        max_connections(_max_connections > 0 ? _max_connections : 1),
+        num_connections(0)
     {
         set_one_auth(secret);
         set_one_endpoint(endpoint);
 
         xmlrpc_limit_set(XMLRPC_XML_SIZE_LIMIT_ID, message_size);
+
+        pthread_mutex_init(&mutex, 0);
+
+        pthread_cond_init(&cond, 0);
     }
 
+    ~Client();
+
+    /**
+     *  Makes a xml-rpc call, the arguments are given as in
+     *  xmlrpc_c::clientSimple
+     *    @param endpoint of the server
+     *    @param method name of the xml-rpc method
+     *    @param format of the arguments (e.g. "sii")
+     *    @param result of the call
+     *    @throws exception if the call fails or returns a fault
+     */
+    void call(const string& endpoint, const string& method,
+            const string& format, xmlrpc_c::value * const result, ...);
+
+    /**
+     *  Makes a xml-rpc call with a list of arguments
+     *    @param endpoint of the server
+     *    @param method name of the xml-rpc method
+     *    @param plist arguments of the call
+     *    @param result of the call
+     *    @throws exception if the call fails or returns a fault
+     */
+    void call(const string& endpoint, const string& method,
+            const xmlrpc_c::paramList& plist, xmlrpc_c::value * const result);
+
     const string& get_oneauth()
     {
         return one_auth;
@@ -81,6 +121,11 @@ public:
         return xmlrpc_limit_get(XMLRPC_XML_SIZE_LIMIT_ID);
     }
 
+    unsigned int get_max_connections()
+    {
+        return max_connections;
+    }
+
     //--------------------------------------------------------------------------
     //  PRIVATE ATTRIBUTES AND METHODS
     //--------------------------------------------------------------------------
@@ -89,6 +134,49 @@ private:
     string  one_auth;
     string  one_endpoint;
 
+    /**
+     *  A persistent connection, the curl transport reuses the HTTP connection
+     *  of its session for subsequent calls
+     */
+    struct Connection
+    {
+        Connection():client(&transport){};
+
+        xmlrpc_c::clientXmlTransport_curl transport;
+        xmlrpc_c::client_xml              client;
+    };
+
+    /**
+     *  Connections not in use by a call
+     */
+    vector<Connection *> connections;
+
+    /**
+     *  Max. number of connections, created on demand
+     */
+    unsigned int max_connections;
+
+    /**
+     *  Number of connections created
+     */
+    unsigned int num_connections;
+
+    pthread_mutex_t mutex;
+
+    pthread_cond_t  cond;
+
+    /**
+     *  Gets a connection of the pool, waits if all of them are in use
+     *    @return the connection
+     */
+    Connection * get_connection();
+
+    /**
+     *  Returns a connection to the pool
+     *    @param connection to be released
+     */
+    void release_connection(Connection * connection);
+
     void set_one_auth(string secret);
 
     void set_one_endpoint(string endpoint);
@@ -18,7 +18,7 @@
 #define CLUSTER_H_
 
 #include "PoolSQL.h"
-#include "ObjectCollection.h"
+#include "ObjectCollectionSQL.h"
 #include "DatastorePool.h"
 #include "ClusterTemplate.h"
 
@@ -192,7 +192,10 @@ public:
      *  @param xml the resulting XML string
      *  @return a reference to the generated string
      */
-    string& to_xml(string& xml) const;
+    string& to_xml(string& xml) const
+    {
+        return to_xml(xml, true);
+    };
 
     /**
      *  Rebuilds the object from an xml formatted string
@@ -224,9 +227,9 @@ private:
     // Attributes (Private)
     // *************************************************************************
 
-    ObjectCollection hosts;
-    ObjectCollection datastores;
-    ObjectCollection vnets;
+    ObjectCollectionSQL hosts;
+    ObjectCollectionSQL datastores;
+    ObjectCollectionSQL vnets;
 
     // *************************************************************************
     // DataBase implementation (Private)
@@ -238,6 +241,27 @@ private:
 
     static const char * table;
 
+    static const char * hosts_db_bootstrap;
+
+    static const char * hosts_table;
+
+    static const char * datastores_db_bootstrap;
+
+    static const char * datastores_table;
+
+    static const char * vnets_db_bootstrap;
+
+    static const char * vnets_table;
+
+    /**
+     * Function to print the Cluster object into a string in XML format
+     *  @param xml the resulting XML string
+     *  @param with_collections include the collections stored in relation
+     *  tables, or their empty elements as stored in the cluster body
+     *  @return a reference to the generated string
+     */
+    string& to_xml(string& xml, bool with_collections) const;
+
     /**
      *  Execute an INSERT or REPLACE Sql query.
      *    @param db The SQL DB
@@ -253,9 +277,19 @@ private:
      */
     static int bootstrap(SqlDB * db)
     {
+        int rc;
+
         ostringstream oss(Cluster::db_bootstrap);
+        ostringstream oss_hosts(Cluster::hosts_db_bootstrap);
+        ostringstream oss_ds(Cluster::datastores_db_bootstrap);
+        ostringstream oss_vnets(Cluster::vnets_db_bootstrap);
+
+        rc  = db->exec(oss);
+        rc += db->exec(oss_hosts);
+        rc += db->exec(oss_ds);
+        rc += db->exec(oss_vnets);
 
-        return db->exec(oss);
+        return rc;
     };
 
     /**
@@ -276,7 +310,13 @@ private:
     int update(SqlDB *db)
     {
         string error_str;
-        return insert_replace(db, true, error_str);
+
+        if ( insert_replace(db, true, error_str) != 0 )
+        {
+            return -1;
+        }
+
+        return update_collections(db);
     }
 
     /**
@@ -18,7 +18,7 @@
 #define DATASTORE_H_
 
 #include "PoolSQL.h"
-#include "ObjectCollection.h"
+#include "ObjectCollectionSQL.h"
 #include "DatastoreTemplate.h"
 #include "Clusterable.h"
 #include "Image.h"
@@ -26,7 +26,7 @@
 /**
  *  The Datastore class.
  */
-class Datastore : public PoolObjectSQL, ObjectCollection, public Clusterable
+class Datastore : public PoolObjectSQL, public Clusterable
 {
 public:
     /**
@@ -67,7 +67,10 @@ public:
      *  @param xml the resulting XML string
      *  @return a reference to the generated string
      */
-    string& to_xml(string& xml) const;
+    string& to_xml(string& xml) const
+    {
+        return to_xml(xml, true);
+    };
 
     /**
      *  Rebuilds the object from an xml formatted string
@@ -84,7 +87,7 @@ public:
      */
     int add_image(int id)
     {
-        return add_collection_id(id);
+        return images.add_collection_id(id);
     };
 
     /**
@@ -94,7 +97,7 @@ public:
      */
     int del_image(int id)
     {
-        return del_collection_id(id);
+        return images.del_collection_id(id);
     };
 
     /**
@@ -102,7 +105,15 @@ public:
      */
     set<int> get_image_ids()
     {
-        return get_collection_copy();
+        return images.get_collection_copy();
+    }
+
+    /**
+     *  Returns the number of Images in the Datastore
+     */
+    int get_collection_size()
+    {
+        return images.get_collection_size();
     }
 
     /**
@@ -252,6 +263,11 @@ private:
      */
      long long used_mb;
 
+    /**
+     *  Images of the datastore, stored in the datastore_images table
+     */
+    ObjectCollectionSQL images;
+
     // *************************************************************************
     // Constructor
     // *************************************************************************
@@ -278,6 +294,19 @@ private:
 
     static const char * table;
 
+    static const char * images_db_bootstrap;
+
+    static const char * images_table;
+
+    /**
+     * Function to print the Datastore object into a string in XML format
+     *  @param xml the resulting XML string
+     *  @param with_collections include the collections stored in relation
+     *  tables, or their empty elements as stored in the datastore body
+     *  @return a reference to the generated string
+     */
+    string& to_xml(string& xml, bool with_collections) const;
+
     /**
      *  Execute an INSERT or REPLACE Sql query.
      *    @param db The SQL DB
@@ -293,9 +322,15 @@ private:
      */
     static int bootstrap(SqlDB * db)
     {
+        int rc;
+
         ostringstream oss(Datastore::db_bootstrap);
+        ostringstream oss_images(Datastore::images_db_bootstrap);
+
+        rc  = db->exec(oss);
+        rc += db->exec(oss_images);
 
-        return db->exec(oss);
+        return rc;
     };
 
     /**
@@ -313,7 +348,13 @@ private:
     int update(SqlDB *db)
     {
         string error_str;
-        return insert_replace(db, true, error_str);
+
+        if ( insert_replace(db, true, error_str) != 0 )
+        {
+            return -1;
+        }
+
+        return update_collections(db);
     }
 
     /**
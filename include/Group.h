@@ -18,7 +18,7 @@
 #define GROUP_H_
 
 #include "PoolSQL.h"
-#include "ObjectCollection.h"
+#include "ObjectCollectionSQL.h"
 #include "User.h"
 #include "QuotasSQL.h"
 #include "Template.h"
@@ -28,7 +28,7 @@ using namespace std;
 /**
  *  The Group class.
  */
-class Group : public PoolObjectSQL, ObjectCollection
+class Group : public PoolObjectSQL
 {
 public:
 
@@ -62,7 +62,7 @@ public:
      */
     int add_user(int id)
     {
-        return add_collection_id(id);
+        return users.add_collection_id(id);
     }
 
     /**
@@ -72,7 +72,15 @@ public:
      */
     int del_user(int id)
     {
-        return del_collection_id(id);
+        return users.del_collection_id(id);
+    }
+
+    /**
+     *  Returns the number of users in the group
+     */
+    int get_collection_size()
+    {
+        return users.get_collection_size();
     }
 
     /**
@@ -101,13 +109,15 @@ public:
     GroupQuotas quota;
 
     /**
-     *  Writes/updates the Group quotas fields in the database.
+     *  Writes/updates the Group quotas fields in the database. The quotas
+     *  are stored in memory and written in the next QuotaWriter flush,
+     *  except in a federation (see QuotasSQL::set_write_behind).
      *    @param db pointer to the db
      *    @return 0 on success
      */
     int update_quotas(SqlDB *db)
     {
-        return quota.update(oid, db);
+        return quota.update_deferred(oid, db);
     };
 
     /**
@@ -132,9 +142,11 @@ private:
 
     Group(int id, const string& name):
         PoolObjectSQL(id,GROUP,name,-1,-1,"","",table),
-        ObjectCollection("USERS"),
-        quota()
+        quota(),
+        users("USERS", users_table, "group_oid", "user_oid")
     {
+        collections.push_back(&users);
+
         // Allow users in this group to see it
         group_u = 1;
 
@@ -152,6 +164,11 @@ private:
 
     set<pair<int,int> > providers;
 
+    /**
+     *  Users of the group, stored in the group_users table
+     */
+    ObjectCollectionSQL users;
+
     // *************************************************************************
     // DataBase implementation (Private)
     // *************************************************************************
@@ -162,6 +179,10 @@ private:
 
     static const char * table;
 
+    static const char * users_db_bootstrap;
+
+    static const char * users_table;
+
     /**
      *  Execute an INSERT or REPLACE Sql query.
      *    @param db The SQL DB
@@ -177,9 +198,15 @@ private:
      */
     static int bootstrap(SqlDB * db)
     {
+        int rc;
+
         ostringstream oss_group(Group::db_bootstrap);
+        ostringstream oss_users(Group::users_db_bootstrap);
+
+        rc  = db->exec(oss_group);
+        rc += db->exec(oss_users);
 
-        return db->exec(oss_group);
+        return rc;
     };
 
     /**
@@ -199,6 +226,16 @@ private:
      */
     int select(SqlDB * db, const string& name, int uid);
 
+    /**
+     *  Reads the quotas of a Group rebuilt from its body.
+     *    @param db pointer to the db
+     *    @return 0 on success
+     */
+    int select_extra(SqlDB * db)
+    {
+        return quota.select(oid, db);
+    };
+
     /**
      *  Reads the Group quotas from the database.
      *    @param db pointer to the db
@@ -229,7 +266,13 @@ private:
     int update(SqlDB *db)
     {
         string error_str;
-        return insert_replace(db, true, error_str);
+
+        if ( insert_replace(db, true, error_str) != 0 )
+        {
+            return -1;
+        }
+
+        return update_collections(db);
     };
 
     /**
@@ -237,9 +280,12 @@ private:
      * XML format
      *  @param xml the resulting XML string
      *  @param extended If true, default quotas are included
+     *  @param with_collections include the collections stored in relation
+     *  tables, or their empty elements as stored in the group body
      *  @return a reference to the generated string
      */
-    string& to_xml_extended(string& xml, bool extended) const;
+    string& to_xml_extended(string& xml, bool extended,
+                            bool with_collections) const;
 };
 
 #endif /*GROUP_H_*/
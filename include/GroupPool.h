@@ -171,13 +171,14 @@ private:
     };
 
     /**
-     *  Callback function to get output in XML format
+     *  Callback function to get the oid, body and quotas of the groups
+     *    @param _rows vector of oid, (group body, quotas body) pairs
      *    @param num the number of columns read from the DB
      *    @param names the column names
      *    @param vaues the column values
      *    @return 0 on success
      */
-    int dump_cb(void * _oss, int num, char **values, char **names);
+    int dump_cb(void * _rows, int num, char **values, char **names);
 };
 
 #endif /*GROUP_POOL_H_*/
@@ -27,6 +27,57 @@ class Hookable;
 
 class PoolObjectSQL;
 
+/**
+ *  A hook execution, with the information of the object needed to execute the
+ *  hook. It is filled while the object is locked, and then the HookManager
+ *  thread parses the hook arguments and sends the hook to the driver.
+ */
+class HookExecution
+{
+public:
+    HookExecution():oid(-1), remote(false){};
+
+    ~HookExecution(){};
+
+    /**
+     *  Parses the hook arguments: $ID, $TEMPLATE (base64 encoding of the
+     *  object), $PREV_STATE and $PREV_LCM_STATE
+     *    @param parsed the resulting arguments
+     *    @return a reference to the parsed string
+     */
+    string& parse_arguments(string& parsed) const;
+
+    /**
+     *  Hook and object identification
+     */
+    int     oid;
+
+    string  name;
+
+    string  cmd;
+
+    string  args;
+
+    /**
+     *  True if the command is to be executed in hostname
+     */
+    bool    remote;
+
+    string  hostname;
+
+    /**
+     *  XML document of the object, only if the arguments include $TEMPLATE
+     */
+    string  xml;
+
+    /**
+     *  Previous states of the object, for VM state hooks
+     */
+    string  prev_state;
+
+    string  prev_lcm_state;
+};
+
 /**
  *  This class is an abstract representation of a hook, provides a method to
  *  check if the hook has to be executed, and a method to invoke the hook. The
@@ -76,16 +127,24 @@ public:
      */
     virtual void do_hook(void *arg) = 0;
 
+protected:
+    /**
+     *  Creates an execution of the hook for an object. The object XML is
+     *  only rendered if the hook arguments use $TEMPLATE.
+     *    @param obj pointer to the object executing the hook for, MUST be
+     *    locked
+     *    @return the execution, to be completed and queued with execute()
+     */
+    HookExecution * new_execution(PoolObjectSQL * obj);
+
     /**
-     *  Parses the arguments of the hook using a generic $ID identifier, and
-     *  the target object.  $TEMPLATE will be the base64 encoding of the
-     *  template and $ID the oid of the object.
-     *    @param obj pointer to the object executing the hook for
-     *    @param the resulting parser arguments
+     *  Queues a hook execution in the HookManager. Arguments are parsed and
+     *  the hook is sent to the driver by the HookManager thread, so the
+     *  caller (that holds the object lock) does not wait for them.
+     *    @param he the execution, it will be freed by the HookManager
      */
-    void parse_hook_arguments(PoolObjectSQL * obj,
-                              string&         parsed);
-protected:
+    static void execute(HookExecution * he);
+
     /**
      *  Name of the Hook
      */
@@ -214,6 +273,14 @@ public:
     void add_hook(Hook *hk)
     {
         hooks.push_back(hk);
+
+        for (int i=0; i<NUM_TYPES ; i++)
+        {
+            if ( hk->type() & (1 << i) )
+            {
+                typed_hooks[i].push_back(hk);
+            }
+        }
     };
 
     /**
@@ -229,6 +296,11 @@ public:
         }
 
         hooks.clear();
+
+        for (int i=0; i<NUM_TYPES ; i++)
+        {
+            typed_hooks[i].clear();
+        }
     };
 
     /**
@@ -238,7 +310,24 @@ public:
      */
     void do_hooks(void *arg = 0, int hook_mask = 0xFF)
     {
-        int sz = static_cast<int>(hooks.size());
+        int sz;
+
+        for (int i=0; i<NUM_TYPES ; i++) // Single type, use the type index
+        {
+            if ( hook_mask == (1 << i) )
+            {
+                sz = static_cast<int>(typed_hooks[i].size());
+
+                for (int j=0; j<sz ; j++)
+                {
+                    typed_hooks[i][j]->do_hook(arg);
+                }
+
+                return;
+            }
+        }
+
+        sz = static_cast<int>(hooks.size());
 
         for (int i=0; i<sz ; i++)
         {
@@ -250,10 +339,20 @@ public:
     };
 
 private:
+    /**
+     *  Number of hook types (bits in Hook::HookType)
+     */
+    static const int NUM_TYPES = 3;
+
     /**
      *  Those that hooked in the object
      */
     vector<Hook *> hooks;
+
+    /**
+     *  Hooks indexed by type, typed_hooks[i] has the hooks of type (1 << i)
+     */
+    vector<Hook *> typed_hooks[NUM_TYPES];
 };
 
 #endif
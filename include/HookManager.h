@@ -68,6 +68,16 @@ public:
         am.trigger(ACTION_FINALIZE,0);
     };
 
+    /**
+     *  Queues a hook execution. The hook arguments are parsed and the hook is
+     *  sent to the driver by the HookManager thread.
+     *    @param he the hook execution, it is freed by the HookManager
+     */
+    void trigger_execute(HookExecution * he)
+    {
+        am.trigger("EXECUTE", he);
+    };
+
     /**
      *  Returns a pointer to a Information Manager MAD. The driver is
      *  searched by its name and owned by oneadmin with uid=0.
@@ -118,6 +128,12 @@ private:
     void do_action(
         const string &  action,
         void *          arg);
+
+    /**
+     *  Parses the arguments of a hook and sends it to the driver
+     *    @param he the hook execution
+     */
+    void execute_action(HookExecution * he);
 };
 
 #endif /*HOOK_MANAGER_H*/
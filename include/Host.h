@@ -21,7 +21,7 @@
 #include "HostTemplate.h"
 #include "HostShare.h"
 #include "Clusterable.h"
-#include "ObjectCollection.h"
+#include "ObjectCollectionSQL.h"
 #include "NebulaLog.h"
 #include "NebulaUtil.h"
 
@@ -55,7 +55,10 @@ public:
      *  @param xml the resulting XML string
      *  @return a reference to the generated string
      */
-    string& to_xml(string& xml) const;
+    string& to_xml(string& xml) const
+    {
+        return to_xml(xml, true);
+    };
 
     /**
      *  Rebuilds the object from an xml formatted string
@@ -531,9 +534,10 @@ private:
     //  VM Collection
     // -------------------------------------------------------------------------
     /**
-     *  Stores a collection with the VMs running in the host
+     *  Stores a collection with the VMs running in the host, in the host_vms
+     *  table
      */
-    ObjectCollection vm_collection;
+    ObjectCollectionSQL vm_collection;
 
 
     // *************************************************************************
@@ -566,6 +570,19 @@ private:
 
     static const char * monit_table;
 
+    static const char * vms_db_bootstrap;
+
+    static const char * vms_table;
+
+    /**
+     * Function to print the Host object into a string in XML format
+     *  @param xml the resulting XML string
+     *  @param with_collections include the collections stored in relation
+     *  tables, or their empty elements as stored in the host body
+     *  @return a reference to the generated string
+     */
+    string& to_xml(string& xml, bool with_collections) const;
+
     /**
      *  Execute an INSERT or REPLACE Sql query.
      *    @param db The SQL DB
@@ -585,9 +602,11 @@ private:
 
         ostringstream oss_host(Host::db_bootstrap);
         ostringstream oss_monit(Host::monit_db_bootstrap);
+        ostringstream oss_vms(Host::vms_db_bootstrap);
 
         rc =  db->exec(oss_host);
         rc += db->exec(oss_monit);
+        rc += db->exec(oss_vms);
 
         return rc;
     };
@@ -610,7 +629,13 @@ private:
     int update(SqlDB *db)
     {
         string error_str;
-        return insert_replace(db, true, error_str);
+
+        if ( insert_replace(db, true, error_str) != 0 )
+        {
+            return -1;
+        }
+
+        return update_collections(db);
     };
 };
 
@@ -17,6 +17,7 @@
 #ifndef HOST_HOOK_H_
 #define HOST_HOOK_H_
 
+#include <map>
 #include <vector>
 #include <string>
 
@@ -77,66 +78,13 @@ private:
     }
 };
 
-/**
- *  This class provides basic functionality to store Hook states for state Hooks.
- *  The state Map is shared by all the State hooks. A maintenance hook that
- *  updates the map should be added.
- */
-class HostStateMapHook: public Hook
-{
-public:
-    virtual void do_hook(void *arg) = 0;
-
-protected:
-    // -------------------------------------------------------------------------
-    // Init the Map
-    // -------------------------------------------------------------------------
-    HostStateMapHook(const string& name,
-                     const string& cmd,
-                     const string& args,
-                     bool          remote):
-        Hook(name, cmd, args, Hook::UPDATE | Hook::ALLOCATE, remote){};
-
-    virtual ~HostStateMapHook(){};
-
-    // -------------------------------------------------------------------------
-    // Functions to handle the VM state map
-    // -------------------------------------------------------------------------
-    /**
-     *  Gets the state associated to the Host
-     *    @param id of the Host
-     *    @param state (previous) of the Host
-     *    @return 0 if the previous state for the Host has been recorded
-     */
-    int get_state(int id, Host::HostState &state);
-
-    /**
-     *  Updates the state associated to the Host
-     *    @param id of the Host
-     *    @param state (current) of the Host
-     */
-    void update_state (int id, Host::HostState state);
-
-    /**
-     *  Frees the resources associated with a host
-     *    @param id of the Host
-     */
-    void remove_host (int id);
-
-private:
-
-    /**
-     *  The state Map for the Hosts
-     */
-    static map<int,Host::HostState> host_states;
-};
-
 /**
  *  This class is a general Host State Hook that executes a command locally or
- *  remotelly when the Host gets into a given state (one shot). The Host
- *  object is looked when the hook is invoked.
+ *  remotelly when the Host gets into a given state (one shot). State hooks are
+ *  not added to the pool, they are invoked by the HostUpdateStateHook when a
+ *  Host enters their state.
  */
-class HostStateHook : public HostStateMapHook
+class HostStateHook : public Hook
 {
 public:
     // -------------------------------------------------------------------------
@@ -155,14 +103,32 @@ public:
                   const string&   args,
                   bool            remote,
                   Host::HostState _state):
-        HostStateMapHook(name,cmd,args,remote), state(_state){};
+        Hook(name, cmd, args, Hook::UPDATE | Hook::ALLOCATE, remote),
+        state(_state){};
 
     ~HostStateHook(){};
 
     // -------------------------------------------------------------------------
     // Hook methods
     // -------------------------------------------------------------------------
-    void do_hook(void *arg);
+    /**
+     *  State hooks are executed through execute(), when the Host state changes
+     */
+    void do_hook(void *arg){};
+
+    /**
+     *  Executes the hook for a Host that has just entered the hook state
+     *    @param host the Host, it MUST be locked
+     */
+    void execute(Host * host);
+
+    /**
+     *  @return the target Host state
+     */
+    Host::HostState get_state() const
+    {
+        return state;
+    };
 
 private:
     /**
@@ -172,23 +138,68 @@ private:
 };
 
 /**
- *  This class implements a state Map updater, one hook of this type should be
- *  added in order to mantain the VM state map.
+ *  This class keeps the state of the Hosts and dispatches the state hooks. One
+ *  hook of this type should be added, with the state hooks registered in it.
+ *  The hooks are indexed by state, so only those that match the new state of
+ *  a Host are evaluated.
  */
-class HostUpdateStateHook : public HostStateMapHook
+class HostUpdateStateHook : public Hook
 {
 public:
     // -------------------------------------------------------------------------
     // -------------------------------------------------------------------------
     HostUpdateStateHook():
-        HostStateMapHook("","","",false){};
+        Hook("","","",Hook::UPDATE | Hook::ALLOCATE,false)
+    {
+        pthread_mutex_init(&mutex, 0);
+    };
+
+    ~HostUpdateStateHook();
 
-    ~HostUpdateStateHook(){};
+    /**
+     *  Registers a state hook
+     *    @param hook pointer to the hook, MUST be allocated in the HEAP. It
+     *    will be freed by this object
+     */
+    void add_state_hook(HostStateHook * hook);
+
+    /**
+     *  @return true if there are no state hooks registered
+     */
+    bool empty() const
+    {
+        return state_hooks.empty();
+    };
 
     // -------------------------------------------------------------------------
     // Hook methods
     // -------------------------------------------------------------------------
     void do_hook(void *arg);
+
+private:
+    /**
+     *  The state Map for the Hosts
+     */
+    map<int,Host::HostState> host_states;
+
+    /**
+     *  The state hooks, indexed by state
+     */
+    multimap<int, HostStateHook *> state_hooks;
+
+    /**
+     *  Mutex for the state map, Hosts are updated concurrently
+     */
+    pthread_mutex_t mutex;
+
+    /**
+     *  Updates the state associated to the Host
+     *    @param id of the Host
+     *    @param state (current) of the Host
+     *    @param prev_state of the Host
+     *    @return 0 if the previous state for the Host has been recorded
+     */
+    int update_state(int id, Host::HostState state, Host::HostState& prev);
 };
 
 #endif
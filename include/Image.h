@@ -20,7 +20,7 @@
 #include "PoolSQL.h"
 #include "ImageTemplate.h"
 #include "NebulaLog.h"
-#include "ObjectCollection.h"
+#include "ObjectCollectionSQL.h"
 
 using namespace std;
 
@@ -163,7 +163,10 @@ public:
      *  @param xml the resulting XML string
      *  @return a reference to the generated string
      */
-    string& to_xml(string& xml) const;
+    string& to_xml(string& xml) const
+    {
+        return to_xml(xml, true);
+    };
 
     /**
      *  Rebuilds the object from an xml formatted string
@@ -570,9 +573,10 @@ private:
     string ds_name;
 
     /**
-     *  Stores a collection with the VMs using the image
+     *  Stores a collection with the VMs using the image, in the image_vms
+     *  table
      */
-    ObjectCollection vm_collection;
+    ObjectCollectionSQL vm_collection;
 
     /**
      *  Stores a collection with the Images cloning this image
@@ -592,15 +596,30 @@ private:
      */
     int insert_replace(SqlDB *db, bool replace, string& error_str);
 
+    /**
+     * Function to print the Image object into a string in XML format
+     *  @param xml the resulting XML string
+     *  @param with_collections include the collections stored in relation
+     *  tables, or their empty elements as stored in the image body
+     *  @return a reference to the generated string
+     */
+    string& to_xml(string& xml, bool with_collections) const;
+
     /**
      *  Bootstraps the database table(s) associated to the Image
      *    @return 0 on success
      */
     static int bootstrap(SqlDB * db)
     {
+        int rc;
+
         ostringstream oss_image(Image::db_bootstrap);
+        ostringstream oss_vms(Image::vms_db_bootstrap);
 
-        return db->exec(oss_image);
+        rc  = db->exec(oss_image);
+        rc += db->exec(oss_vms);
+
+        return rc;
     };
 
     /**
@@ -635,6 +654,10 @@ protected:
 
     static const char * table;
 
+    static const char * vms_db_bootstrap;
+
+    static const char * vms_table;
+
     /**
      *  Writes the Image in the database.
      *    @param db pointer to the db
@@ -79,6 +79,16 @@ public:
      */
     int start();
 
+    /**
+     *  Prints the state of the monitor message threads in XML format
+     *    @param xml the resulting XML string
+     *    @return a reference to the generated string
+     */
+    string& monitor_to_xml(string& xml)
+    {
+        return mtpool.to_xml(xml);
+    };
+
     /**
      *  Gets the thread identification.
      *    @return pthread_t for the manager thread (that in the action loop).
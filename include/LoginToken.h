@@ -55,6 +55,14 @@ public:
      */
     void reset();
 
+    /**
+     *  Gets the expiration time of the token, -1 if it does not expire
+     */
+    time_t get_expiration_time() const
+    {
+        return expiration_time;
+    };
+
     /**
      * Function to print the LoginToken into a string in XML format
      *  @param xml the resulting XML string
@@ -20,9 +20,11 @@
 #include <pthread.h>
 #include <sys/types.h>
 
+#include <deque>
 #include <map>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include <unistd.h>
 
@@ -30,6 +32,162 @@
 
 using namespace std;
 
+/**
+ *  A driver process. A Mad runs one or more instances of the driver, each one
+ *  with its own process, pipes and outbound message queue.
+ */
+class MadShard
+{
+private:
+    friend class Mad;
+    friend class MadManager;
+
+    MadShard(int _index, int _wake_pipe, pthread_t _listener_thread):
+        index(_index),
+        pid(-1),
+        mad_nebula_pipe(-1),
+        nebula_mad_pipe(-1),
+        wake_pipe(_wake_pipe),
+        listener_thread(_listener_thread),
+        queue_bytes(0),
+        queue_offset(0),
+        max_depth(0),
+        written(0),
+        dropped(0),
+        restarts(0)
+    {
+        pthread_mutex_init(&queue_mutex, 0);
+
+        pthread_cond_init(&queue_cond, 0);
+    };
+
+    ~MadShard()
+    {
+        clear_queue();
+
+        pthread_cond_destroy(&queue_cond);
+
+        pthread_mutex_destroy(&queue_mutex);
+    };
+
+    /**
+     *  Index of this instance in the Mad
+     */
+    int                 index;
+
+    /**
+     *  Process ID of the driver instance, -1 if it is not running
+     */
+    pid_t               pid;
+
+    /**
+     *  Communication pipe file descriptor. Represents the MAD to nebula
+     *  communication stream (nebula<-mad)
+     */
+    int                 mad_nebula_pipe;
+
+    /**
+     *  Communication pipe file descriptor. Represents the nebula to MAD
+     *  communication stream (nebula->mad)
+     */
+    int                 nebula_mad_pipe;
+
+    /**
+     *  Write end of the MadManager listener pipe, used to notify that there
+     *  are messages queued for this driver
+     */
+    int                 wake_pipe;
+
+    /**
+     *  Thread id of the MadManager listener, it never blocks on a full queue
+     */
+    pthread_t           listener_thread;
+
+    // -------------------------------------------------------------------------
+    // Outbound queue (nebula->mad), protected by queue_mutex
+    // -------------------------------------------------------------------------
+    pthread_mutex_t     queue_mutex;
+
+    pthread_cond_t      queue_cond;
+
+    /**
+     *  Messages waiting for the driver to read its pipe
+     */
+    deque<string>       queue;
+
+    /**
+     *  Bytes pending in the queue
+     */
+    size_t              queue_bytes;
+
+    /**
+     *  Bytes of the first message already written to the pipe
+     */
+    size_t              queue_offset;
+
+    /**
+     *  Queue statistics: max. length, messages written and dropped
+     */
+    unsigned int        max_depth;
+
+    unsigned long long  written;
+
+    unsigned long long  dropped;
+
+    /**
+     *  Number of times this instance has been restarted
+     */
+    unsigned int        restarts;
+
+    /**
+     *  Sends a message to the driver instance, see Mad::write()
+     *    @param str the message
+     */
+    void write(const string& str);
+
+    /**
+     *  Writes queued messages to the driver pipe without blocking. It is
+     *  called by the listener when the pipe is writable.
+     *    @return 0 on success, -1 if the pipe is broken
+     */
+    int flush();
+
+    /**
+     *  @return true if there are messages queued for the driver
+     */
+    bool pending()
+    {
+        bool rc;
+
+        pthread_mutex_lock(&queue_mutex);
+
+        rc = !queue.empty();
+
+        pthread_mutex_unlock(&queue_mutex);
+
+        return rc;
+    };
+
+    /**
+     *  Discards the queued messages, the driver has been finalized
+     */
+    void clear_queue();
+
+    /**
+     *  Sends the finalize command to the driver instance and closes the
+     *  communication pipes. Pending messages are discarded.
+     *    @return the pid of the driver process, -1 if it was not running
+     */
+    pid_t finalize();
+
+    /**
+     *  Prints the state and queue statistics of the instance in XML format
+     *    @param oss the output stream
+     *    @param name of the driver
+     */
+    void to_xml(ostringstream& oss, const string& name);
+};
+
 /**
  * Base class to build specific middleware access drivers (MAD).
  * This class provides generic MAD functionality.
@@ -51,7 +209,7 @@ protected:
             uid(userid),
             attributes(attrs),
             sudo_execution(sudo),
-            pid(-1)
+            wake_pipe(-1)
     {};
 
     /**
@@ -61,21 +219,18 @@ protected:
     virtual ~Mad();
 
     /**
-     *  Send a command to the driver
+     *  Send a command to the driver. The message is written right away if
+     *  the driver pipe has room for it, otherwise it is queued and written
+     *  by the MadManager listener thread. When the queue is full the message
+     *  is handled as set by the queue policy (see MadManager). If the driver
+     *  runs several instances, the message goes to the one selected by the
+     *  object id (second word of the message) so all the actions of a VM,
+     *  host or image are sent to the same instance, and in order.
      *    @param os an output string stream with the message, it must be
      *    terminated with the end of line character.
      */
     void write(
-        ostringstream&  os) const
-    {
-        string        str;
-        const char *  cstr;
-
-        str  = os.str();
-        cstr = str.c_str();
-
-        ::write(nebula_mad_pipe, cstr, str.size());
-    };
+        ostringstream&  os) const;
 
     /**
      *  Send a DRIVER_CANCEL command to the driver
@@ -120,17 +275,26 @@ protected:
 private:
     friend class MadManager;
 
+    friend class MadShard;
+
     /**
-     *  Communication pipe file descriptor. Represents the MAD to nebula
-     *  communication stream (nebula<-mad)
+     *  Policy to apply when the outbound queue of a driver is full
      */
-    int                 mad_nebula_pipe;
+    enum QueuePolicy
+    {
+        BLOCK = 0, /**< Wait for the listener to write queued messages */
+        DROP  = 1  /**< Discard the message                            */
+    };
 
     /**
-     *  Communication pipe file descriptor. Represents the nebula to MAD
-     *  communication stream (nebula->mad)
+     *  Max. number of messages queued for each driver
      */
-    int                 nebula_mad_pipe;
+    static unsigned int queue_limit;
+
+    /**
+     *  Policy to apply when a driver queue is full
+     */
+    static QueuePolicy  queue_policy;
 
     /**
      *  User running this MAD as defined in the upool DB
@@ -150,24 +314,64 @@ private:
     bool                sudo_execution;
 
     /**
-     *  Process ID of the running MAD.
+     *  Write end of the MadManager listener pipe, used to notify that there
+     *  are messages queued for this driver
      */
-    pid_t               pid;
+    int                 wake_pipe;
+
+    /**
+     *  Thread id of the MadManager listener
+     */
+    pthread_t           listener_thread;
+
+    /**
+     *  Driver instances, as set by the INSTANCES attribute (default 1)
+     */
+    vector<MadShard *>  shards;
+
+    /**
+     *  Gets the driver instance for a message. Instances that are not
+     *  running are skipped.
+     *    @param msg the message for the driver
+     *    @return the instance, 0 if none is running
+     */
+    MadShard * route(const string& msg) const;
+
+    /**
+     *  @return the number of driver instances running
+     */
+    int running() const;
 
     /**
-     *  Starts the MAD. This function creates a new process, sets up the
-     *  communication pipes and sends the initialization command to the driver.
+     *  Prints the queue statistics of the driver instances in XML format
+     *    @param oss the output stream
+     */
+    void to_xml(ostringstream& oss) const;
+
+    /**
+     *  Starts the MAD. This function creates the driver instances and starts
+     *  them.
      *    @return 0 on success
      */
     int start();
 
     /**
-     *  Reloads the driver: sends the finalize command, "waits" for the
-     *  driver process and closes the communication pipes. Then the driver is
-     *  started again by calling the start() function
+     *  Starts a driver instance. This function creates a new process, sets up
+     *  the communication pipes and sends the initialization command to the
+     *  driver.
+     *    @param shard the instance
+     *    @return 0 on success
+     */
+    int start(MadShard * shard);
+
+    /**
+     *  Reloads a driver instance: sends the finalize command, "waits" for the
+     *  driver process and closes the communication pipes. Then the instance
+     *  is started again by calling the start() function
+     *    @param shard the instance
      *    @return 0 on success
      */
-    int reload();
+    int reload(MadShard * shard);
 
     /**
      *  Implements the driver specific protocol, this function should trigger
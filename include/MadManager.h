@@ -46,8 +46,13 @@ public:
      *  MUST be called once before using the MadManager class. This function
      *  blocks the SIG_PIPE (broken pipe) signal that may occur when a driver
      *  crashes
+     *    @param queue_size max. number of messages queued for each driver,
+     *    0 for no limit
+     *    @param queue_policy BLOCK or DROP, what to do with new messages
+     *    when the queue of a driver is full
      */
-    static void mad_manager_system_init();
+    static void mad_manager_system_init(unsigned int queue_size,
+                                        const string& queue_policy);
 
     /**
      *  Loads Virtual Machine Manager Mads defined in configuration file
@@ -62,6 +67,13 @@ public:
      */
     void notify_request(int id, bool result, const string& message);
 
+    /**
+     *  Prints the outbound queue statistics of the drivers in XML format
+     *    @param xml the resulting XML string
+     *    @return a reference to the generated string
+     */
+    string& drivers_to_xml(string& xml);
+
 protected:
 
     MadManager(vector<const Attribute *>& _mads);
@@ -173,6 +185,14 @@ private:
      */
     vector<int>             fds;
 
+    /**
+     *  Driver and driver instance of each file descriptor in fds, 0 for the
+     *  listener pipe
+     */
+    vector<Mad *>           fd_mads;
+
+    vector<MadShard *>      fd_shards;
+
     /**
      *  The sets of Mads managed by the MadManager
      */
@@ -189,6 +209,12 @@ private:
      */
     map<int, SyncRequest *> sync_requests;
 
+    /**
+     *  Rebuilds the fd vector with the pipes of the running driver instances.
+     *  It MUST be called with the manager locked.
+     */
+    void update_fds();
+
     /**
      *  Listener thread implementation.
      */
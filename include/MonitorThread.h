@@ -19,6 +19,8 @@
 #define MONITOR_THREAD_H_
 
 #include <string>
+#include <map>
+#include <deque>
 #include <pthread.h>
 
 class HostPool;
@@ -79,7 +81,9 @@ public:
     ~MonitorThreadPool(){};
 
     /**
-     *  Creates a new thread to parse and process a monitor message
+     *  Creates a new thread to parse and process a monitor message. If all
+     *  the threads are busy the message waits for a free one, replacing any
+     *  older message of the same host still waiting (latest wins).
      *    @param hid host id
      *    @param result of the monitor operation
      *    @oaram hinfo the information sent by the driver
@@ -87,20 +91,44 @@ public:
     void do_message(int hid, const std::string& result, const std::string& hinfo);
 
     /**
-     *  Terminates a running thread, and signal the main control thread.
+     *  Terminates a running thread, and starts the next waiting message.
      */
     void exit_monitor_thread();
 
+    /**
+     *  Prints the state of the pool in XML format
+     *    @param xml the resulting XML string
+     *    @return a reference to the generated string
+     */
+    std::string& to_xml(std::string& xml);
+
 private:
 
     int concurrent_threads; /**< Max number of concurrent threads*/
 
     int running_threads;    /**< Number of running threads*/
 
+    /**
+     *  Messages waiting for a thread, at most one per host
+     */
+    std::map<int, MonitorThread *> waiting;
+
+    /**
+     *  Order of the hosts with a waiting message
+     */
+    std::deque<int> waiting_order;
+
+    unsigned long long processed;  /**< Messages processed */
+
+    unsigned long long superseded; /**< Messages replaced by a newer one */
+
     //Concurrency control variables
     pthread_mutex_t mutex;
 
-    pthread_cond_t  cond;
+    /**
+     *  Creates the thread for a message, must be called with the mutex locked
+     */
+    void start_thread(MonitorThread * mt);
 };
 
 /* -------------------------------------------------------------------------- */
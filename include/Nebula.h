@@ -43,6 +43,7 @@
 #include "HookManager.h"
 #include "AuthManager.h"
 #include "AclManager.h"
+#include "QuotaWriter.h"
 #include "ImageManager.h"
 
 #include "DefaultQuotas.h"
@@ -179,6 +180,11 @@ public:
         return aclm;
     };
 
+    RequestManager * get_rm()
+    {
+        return rm;
+    };
+
     // --------------------------------------------------------------
     // Environment & Configuration
     // --------------------------------------------------------------
@@ -387,7 +393,7 @@ public:
      */
     static string shared_db_version()
     {
-        return "4.6.0";
+        return "4.11.85";
     }
 
     /**
@@ -396,7 +402,7 @@ public:
      */
     static string local_db_version()
     {
-        return "4.11.80";
+        return "4.11.85";
     }
 
     /**
@@ -409,6 +415,12 @@ public:
      */
     void bootstrap_db();
 
+    /**
+     *  Loads the active objects (hosts, VMs not in DONE state, clusters,
+     *  datastores and virtual networks) into the pool caches
+     */
+    void prefetch_pools();
+
     // --------------------------------------------------------------
     // Federation
     // --------------------------------------------------------------
@@ -654,7 +666,7 @@ private:
         vmpool(0), hpool(0), vnpool(0), upool(0), ipool(0), gpool(0), tpool(0),
         dspool(0), clpool(0), docpool(0), zonepool(0), secgrouppool(0),
         lcm(0), vmm(0), im(0), tm(0), dm(0), rm(0), hm(0), authm(0),
-        aclm(0), imagem(0)
+        aclm(0), imagem(0), quotaw(0)
     {
         const char * nl = getenv("ONE_LOCATION");
 
@@ -711,6 +723,7 @@ private:
         delete authm;
         delete aclm;
         delete imagem;
+        delete quotaw;
         delete nebula_configuration;
         delete db;
         delete system_db;
@@ -794,6 +807,7 @@ private:
     AuthManager *           authm;
     AclManager *            aclm;
     ImageManager *          imagem;
+    QuotaWriter *           quotaw;
 
     // ---------------------------------------------------------------
     // Implementation functions
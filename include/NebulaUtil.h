@@ -55,6 +55,53 @@ namespace one_util
     */
     std::string * base64_decode(const std::string& in);
 
+   /**
+    *  Base 64 encoding, the result is stored in out (resized as needed)
+    *    @param in the string to encode
+    *    @param out the encoded string
+    */
+    void base64_encode(const std::string& in, std::string& out);
+
+   /**
+    *  Base 64 decoding, the result is stored in out (resized as needed)
+    *    @param in the string to decode
+    *    @param out the decoded string
+    *    @return 0 on success, -1 if in is not a valid base 64 string
+    */
+    int base64_decode(const std::string& in, std::string& out);
+
+   /**
+    *  Base 64 encoding into a caller provided buffer. The codec uses SSSE3 or
+    *  AVX2 instructions when available. No new lines are added to the output.
+    *    @param in data to encode
+    *    @param len of the data
+    *    @param out buffer, at least base64_encode_size(len) bytes long
+    *    @return number of bytes written to out
+    */
+    size_t base64_encode(const char * in, size_t len, char * out);
+
+   /**
+    *  Base 64 decoding into a caller provided buffer. Whitespace is ignored.
+    *    @param in data to decode
+    *    @param len of the data
+    *    @param out buffer, at least base64_decode_size(len) bytes long
+    *    @param out_len number of bytes written to out
+    *    @return 0 on success, -1 if in is not a valid base 64 string
+    */
+    int base64_decode(const char * in, size_t len, char * out, size_t& out_len);
+
+   /**
+    *  @param len of the data to encode
+    *  @return size of the buffer needed to base 64 encode len bytes
+    */
+    size_t base64_encode_size(size_t len);
+
+   /**
+    *  @param len of the base 64 data
+    *  @return size of the buffer needed to decode len base 64 bytes
+    */
+    size_t base64_decode_size(size_t len);
+
    /**
     *  AES256 encryption
     *    @param in the string to encrypt
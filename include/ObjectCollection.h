@@ -85,7 +85,7 @@ public:
         return set<int> (collection_set);
     };
 
-private:
+protected:
 
     /**
      *  The collection's name
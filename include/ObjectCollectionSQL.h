@@ -0,0 +1,210 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef OBJECT_COLLECTION_SQL_H_
+#define OBJECT_COLLECTION_SQL_H_
+
+#include <map>
+
+#include "ObjectCollection.h"
+#include "Callbackable.h"
+#include "SqlDB.h"
+
+using namespace std;
+
+/**
+ *  Set of PoolObjectSQL IDs stored in a relation table, a row for each
+ *  (owner, ID) pair. The IDs are not part of the owner body:
+ *    - Only the IDs added or removed are written when the owner is updated
+ *    - The IDs are read the first time they are needed (e.g. to generate the
+ *      XML of the owner), adding or removing an ID does not read them
+ */
+class ObjectCollectionSQL : public ObjectCollection, public Callbackable
+{
+public:
+
+    /**
+     *  @param _collection_name The collection's name
+     *  @param _table The relation table
+     *  @param _oid_column Column with the owner oid
+     *  @param _id_column Column with the IDs of the collection
+     */
+    ObjectCollectionSQL(const string& _collection_name,
+                        const char *  _table,
+                        const char *  _oid_column,
+                        const char *  _id_column)
+        :ObjectCollection(_collection_name), table(_table),
+         oid_column(_oid_column), id_column(_id_column), db(0), oid(-1),
+         loaded(true){};
+
+    ~ObjectCollectionSQL(){};
+
+    /**
+     *  Adds an ID to the set.
+     *    @param id The new id
+     *
+     *    @return 0 on success, -1 if the ID was already in the set
+     */
+    int add_collection_id(int id);
+
+    /**
+     *  Deletes an ID from the set.
+     *    @param id The id
+     *
+     *    @return 0 on success, -1 if the ID was not in the set
+     */
+    int del_collection_id(int id);
+
+    /**
+     *  Returns how many IDs are there in the set.
+     *    @return how many IDs are there in the set.
+     */
+    int get_collection_size()
+    {
+        load();
+
+        return ObjectCollection::get_collection_size();
+    };
+
+    /**
+     *  Returns a copy of the IDs set
+     */
+    set<int> get_collection_copy()
+    {
+        load();
+
+        return ObjectCollection::get_collection_copy();
+    };
+
+    /**
+     * Function to print the Collection object into a string in
+     * XML format
+     *  @param xml the resulting XML string
+     *  @return a reference to the generated string
+     */
+    string& to_xml(string& xml) const;
+
+    /**
+     *  Prints the empty collection element kept in the owner body
+     *    @param xml the resulting XML string
+     *    @return a reference to the generated string
+     */
+    string& to_xml_db(string& xml) const
+    {
+        xml = "<" + collection_name + "></" + collection_name + ">";
+
+        return xml;
+    };
+
+    /**
+     *  Sets the owner of the collection once it has been read from the DB.
+     *  The IDs are read the first time they are needed.
+     *    @param _db pointer to the DB
+     *    @param _oid of the owner
+     */
+    void select(SqlDB * _db, int _oid);
+
+    /**
+     *  Writes the IDs added and removed since the last update
+     *    @param _db pointer to the DB
+     *    @param _oid of the owner
+     *    @return 0 on success
+     */
+    int update(SqlDB * _db, int _oid);
+
+    /**
+     *  Removes the collection of the owner from the DB
+     *    @param _db pointer to the DB
+     *    @return 0 on success
+     */
+    int drop(SqlDB * _db);
+
+    /**
+     *  Sets the IDs of an owner rebuilt from its body (e.g. to dump a pool)
+     *    @param ids of the collection
+     */
+    void set_collection(const set<int>& ids)
+    {
+        collection_set = ids;
+
+        changes.clear();
+
+        loaded = true;
+    };
+
+    /**
+     *  Reads the IDs of a set of owners with a single query
+     *    @param _db pointer to the DB
+     *    @param oids comma separated list of owners, empty for all
+     *    @param ids of each owner
+     *    @return 0 on success
+     */
+    int select_ids(SqlDB * _db, const string& oids, map<int, set<int> >& ids);
+
+private:
+
+    /**
+     *  The relation table, and the owner and ID columns
+     */
+    const char * table;
+
+    const char * oid_column;
+
+    const char * id_column;
+
+    /**
+     *  DB and oid of the owner, set when it is read or written
+     */
+    SqlDB * db;
+
+    int     oid;
+
+    /**
+     *  True if collection_set has all the IDs of the owner
+     */
+    bool loaded;
+
+    /**
+     *  IDs added (true) or removed (false) since the owner was last written
+     */
+    map<int, bool> changes;
+
+    /**
+     *  Reads the IDs of the owner from the DB, if not already read. The
+     *  changes not yet written are applied over them.
+     *    @return 0 on success
+     */
+    int load();
+
+    /**
+     *  Checks if an ID is in the collection, without reading all of them
+     *    @param id to look for
+     *    @return true if the ID is in the set
+     */
+    bool contains(int id);
+
+    /**
+     *  Callback to read the IDs of the owner (load, contains)
+     */
+    int select_cb(void * _ids, int num, char **values, char **names);
+
+    /**
+     *  Callback to read the IDs of several owners (select_ids)
+     */
+    int select_ids_cb(void * _ids, int num, char **values, char **names);
+};
+
+#endif /*OBJECT_COLLECTION_SQL_H_*/
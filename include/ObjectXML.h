@@ -298,7 +298,7 @@ private:
     xmlDocPtr   xml;
 
     /**
-     *  XPath Context to access Object elements
+     *  XPath Context to modify Object elements, lookups use their own context
      */
     xmlXPathContextPtr ctx;
 
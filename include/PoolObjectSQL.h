@@ -27,6 +27,7 @@
 using namespace std;
 
 class PoolObjectAuth;
+class ObjectCollectionSQL;
 
 /**
  * PoolObject class. Provides a SQL backend interface for Pool components. Each
@@ -623,12 +624,31 @@ protected:
     virtual int select(SqlDB *db, const string& _name, int _uid);
 
     /**
-     *  Drops object from the database
+     *  Completes an object rebuilt from its body (e.g. by PoolSQL::prefetch),
+     *  reading the data stored out of the body.
+     *    @param db pointer to the db
+     *    @return 0 on success
+     */
+    virtual int select_extra(SqlDB *db)
+    {
+        return 0;
+    };
+
+    /**
+     *  Drops object from the database, and its collections
      *    @param db pointer to the db
      *    @return 0 on success
      */
     virtual int drop(SqlDB *db);
 
+    /**
+     *  Writes the IDs added to or removed from the collections of the object.
+     *  It must be called by insert and update, after writing the body.
+     *    @param db pointer to the db
+     *    @return 0 on success
+     */
+    int update_collections(SqlDB *db);
+
     /**
      *  Function to output a pool object into a stream in XML format
      *    @param oss the output stream
@@ -771,6 +791,13 @@ protected:
      */
     Template * obj_template;
 
+    /**
+     *  Collections of the object stored in relation tables, added by the
+     *  constructor of the object. They are not part of the body, and are
+     *  read when needed once the object is selected.
+     */
+    vector<ObjectCollectionSQL *> collections;
+
 private:
     /**
      *  Characters that can not be in a name
@@ -782,6 +809,12 @@ private:
      */
     friend class PoolSQL;
 
+    /**
+     *  Sets the DB of the collections, once the object has been read
+     *    @param db pointer to the db
+     */
+    void select_collections(SqlDB *db);
+
     /**
      * The mutex for the PoolObject. This implementation assumes that the mutex
      * IS LOCKED when the class destructor is called.
@@ -21,14 +21,18 @@
 #include <string>
 #include <queue>
 #include <set>
+#include <vector>
 
 #include "SqlDB.h"
 #include "PoolObjectSQL.h"
 #include "Log.h"
 #include "Hook.h"
+#include "ChangeLog.h"
 
 using namespace std;
 
+extern "C" void * pool_prefetch_loop(void *arg);
+
 /**
  * PoolSQL class. Provides a base class to implement persistent generic pools.
  * The PoolSQL provides a synchronization mechanism (mutex) to operate in
@@ -129,6 +133,8 @@ public:
 
         if ( rc == 0 )
         {
+            log_change(objsql->oid);
+
             do_hooks(objsql, Hook::UPDATE);
         }
 
@@ -153,6 +159,8 @@ public:
         }
         else
         {
+            log_change(objsql->oid);
+
             do_hooks(objsql, Hook::REMOVE);
         }
 
@@ -164,6 +172,26 @@ public:
      */
     void clean();
 
+    /**
+     *  Gets the cache statistics of the pool. A hit is an object retrieved
+     *  from the cache, a miss an object loaded from the DB.
+     *    @param hits number of cache hits
+     *    @param misses number of cache misses
+     *    @param size number of objects in the cache
+     */
+    void get_cache_stats(unsigned long& hits, unsigned long& misses,
+                         unsigned int& size);
+
+    /**
+     *  Loads the objects that match a filter into the cache. The objects are
+     *  read in ranges of oids and parsed in parallel. Objects already in the
+     *  cache are not replaced, and the load stops when the cache is full.
+     *    @param where filter for the objects, "" for all
+     *    @param num_threads number of threads used to parse the objects
+     *    @return number of objects loaded, -1 on DB error
+     */
+    int prefetch(const string& where, unsigned int num_threads);
+
     /**
      *  Dumps the pool in XML format. A filter can be also added to the
      *  query
@@ -267,9 +295,41 @@ protected:
      */
     SqlDB * db;
 
+    /**
+     *  Enables the change log for a pool shared by a federation. The master
+     *  records the changes of the objects, the slaves use it to check that
+     *  the cached objects are up to date instead of reading them on each get.
+     *    @param slave true if this oned is a federation slave
+     */
+    void enable_change_log(bool slave);
+
+    /**
+     *  Records a change of an object in the change log. Only the federation
+     *  master records changes, once the object has been written in the DB.
+     *    @param oid of the object updated or dropped
+     */
+    void log_change(int oid)
+    {
+        if ( change_log != 0 && !check_versions )
+        {
+            change_log->log(oid);
+        }
+    };
+
+    /**
+     *  Gets the change log of the pool, to record the changes written by
+     *  any zone (e.g. the quotas of Users and Groups)
+     *    @return the change log, 0 if the pool is not shared
+     */
+    ChangeLog * get_change_log()
+    {
+        return change_log;
+    };
+
     /**
      *  Dumps the pool in XML format. A filter and limit can be also added
-     *  to the query
+     *  to the query. The XML of objects with collections in relation tables
+     *  is rebuilt (see rebuild_xml)
      *  @param oss the output stream to dump the pool contents
      *  @param elem_name Name of the root xml pool name
      *  @param table Pool table name
@@ -315,6 +375,24 @@ protected:
              const string&   root_elem_name,
              ostringstream&  sql_query);
 
+    /**
+     *  Rebuilds the XML of objects with collections stored in relation tables
+     *  (see ObjectCollectionSQL), as their bodies do not include them. The
+     *  collections of all the objects are read with a query per table, and
+     *  each object is built from its body to generate its XML.
+     *    @param bodies oid and body of the objects, each body is replaced
+     *    with the XML of the object
+     *    @param all true if bodies has all the objects of the pool
+     *    @return 0 on success
+     */
+    int rebuild_xml(vector<pair<int, string> >& bodies, bool all);
+
+    /**
+     *  Checks if the objects of the pool have collections in relation tables
+     *    @return true if the object XML needs to be rebuilt (rebuild_xml)
+     */
+    bool has_collections();
+
     /**
      * Child classes can add extra elements to the dump xml, right after all the
      * pool objects
@@ -349,6 +427,8 @@ protected:
 
 private:
 
+    friend void * pool_prefetch_loop(void *arg);
+
     pthread_mutex_t mutex;
 
     /**
@@ -358,6 +438,11 @@ private:
      */
     static const unsigned int MAX_POOL_SIZE;
 
+    /**
+     *  Number of objects read by each prefetch query
+     */
+    static const unsigned int PREFETCH_RANGE;
+
     /**
      *  Last object ID assigned to an object. It must be initialized by the
      *  target pool.
@@ -385,6 +470,29 @@ private:
      */
     bool uses_name_pool;
 
+    /**
+     *  Cache statistics, updated with the pool mutex locked
+     */
+    unsigned long cache_hits;
+
+    unsigned long cache_misses;
+
+    /**
+     *  Change log of the pool, only for pools shared by a federation
+     */
+    ChangeLog * change_log;
+
+    /**
+     *  Whether or not the cached objects are checked against the change log
+     *  (federation slaves)
+     */
+    bool check_versions;
+
+    /**
+     *  Version of the cached objects, as read from the change log
+     */
+    map<int, long long> versions;
+
     /**
      *  This is a name index for the pool map. The key is the name of the object
      *  , that may be combained with the owner id.
@@ -427,6 +535,15 @@ private:
      */
     void replace();
 
+    /**
+     *  Removes an object from the cache if its version does not match the
+     *  one recorded in the change log. The method waits for the object to be
+     *  unlocked.
+     *    @param oid of the object
+     *    @param version of the object in the change log
+     */
+    void validate_cache(int oid, long long version);
+
     /**
      * Cleans all the objects in the cache, except the ones locked.
      * The object with the given oid will not be ignored if locked, the
@@ -486,6 +603,40 @@ private:
      *    @return 0 on success
      */
     int dump_cb(void * _oss, int num, char **values, char **names);
+
+    /**
+     *  Callback to get the oid and body of the objects (dump)
+     *    @param _bodies vector of oid, body pairs
+     *    @return 0 on success
+     */
+    int dump_body_cb(void * _bodies, int num, char **values, char **names);
+
+    /* ---------------------------------------------------------------------- */
+    /* Cache prefetch                                                         */
+    /* ---------------------------------------------------------------------- */
+
+    /**
+     *  A range of objects read by prefetch. The bodies are parsed by the
+     *  prefetch threads, each one takes the next body to parse.
+     */
+    struct PrefetchBatch
+    {
+        PoolSQL *               pool;
+        int                     last_oid;
+        vector<string>          bodies;
+        vector<PoolObjectSQL *> objects;
+        unsigned int            next;
+    };
+
+    /**
+     *  Parses the bodies of a batch, until all of them have been taken
+     */
+    void prefetch_loop(PrefetchBatch * batch);
+
+    /**
+     *  Callback to store the bodies of a prefetch range (PoolSQL::prefetch)
+     */
+    int prefetch_cb(void * _batch, int num, char **values, char **names);
 };
 
 #endif /*POOL_SQL_H_*/
@@ -52,7 +52,8 @@ public:
     /**
      *  Check if the resource allocation will exceed the quota limits. If not
      *  the usage counters are updated
-     *    @param tmpl template for the resource
+     *    @param tmpl template for the resource, VMS is the number of VMs
+     *    (defaults to 1) and MEMORY and CPU the total for all of them
      *    @param default_quotas Quotas that contain the default limits
      *    @param error string
      *    @return true if the operation can be performed
@@ -0,0 +1,119 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef QUOTA_WRITER_H_
+#define QUOTA_WRITER_H_
+
+#include "ActionManager.h"
+#include "SqlDB.h"
+
+using namespace std;
+
+extern "C" void * quotaw_action_loop(void *arg);
+
+/**
+ *  The QuotaWriter periodically writes in the DB the User and Group quotas
+ *  updated in memory (see QuotasSQL::update_deferred). Quota checks do not
+ *  wait for the DB, and the updates of the same object are coalesced.
+ *
+ *  The check-and-add of a request is still done with the User/Group locked.
+ *  A request may check several quotas (VM, datastores, networks, images)
+ *  that must be added or rolled back as a whole, and per-counter atomic
+ *  operations would need partial rollbacks seen by concurrent requests. With
+ *  the DB write moved out, the lock only covers the in-memory update.
+ *
+ *  The quotas updated in the last timer_period seconds are lost if oned
+ *  crashes (they are written on a clean shutdown). The usage can be
+ *  recomputed from the VMs and Images with onedb fsck.
+ *
+ *  The write-behind is disabled in a federation, as the zones share the
+ *  quotas tables and each one must read the usage added by the others.
+ */
+class QuotaWriter : public ActionListener
+{
+public:
+
+    /**
+     *  @param _db pointer to the DB
+     *  @param _timer_period period to write the pending quotas
+     */
+    QuotaWriter(SqlDB * _db, time_t _timer_period)
+        :db(_db), timer_period(_timer_period)
+    {
+        am.addListener(this);
+    };
+
+    ~QuotaWriter(){};
+
+    /**
+     *  Starts the write loop
+     *    @return 0 on success.
+     */
+    int start();
+
+    /**
+     *  Finalizes the write loop, the pending quotas are written before
+     */
+    void finalize()
+    {
+        am.trigger(ACTION_FINALIZE,0);
+    };
+
+    /**
+     *  Gets the QuotaWriter thread identification.
+     *    @return pthread_t for the writer thread (that in the action loop).
+     */
+    pthread_t get_thread_id() const
+    {
+        return quotaw_thread;
+    };
+
+private:
+    /**
+     *  Pointer to the database.
+     */
+    SqlDB *         db;
+
+    /**
+     *  Period to write the pending quotas
+     */
+    time_t          timer_period;
+
+    /**
+     *  Thread id for the QuotaWriter
+     */
+    pthread_t       quotaw_thread;
+
+    /**
+     *  Action engine for the Manager
+     */
+    ActionManager   am;
+
+    /**
+     *  Function to execute the Manager action loop method within a new pthread
+     *  (requires C linkage)
+     */
+    friend void * quotaw_action_loop(void *arg);
+
+    /**
+     *  The action function executed when an action is triggered.
+     *    @param action the name of the action
+     *    @param arg arguments for the action function
+     */
+    void do_action(const string & action, void * arg);
+};
+
+#endif /*QUOTA_WRITER_H_*/
@@ -17,8 +17,12 @@
 #ifndef GROUP_QUOTAS_H_
 #define GROUP_QUOTAS_H_
 
+#include <map>
+#include <pthread.h>
+
 #include "Quotas.h"
 #include "ObjectSQL.h"
+#include "ChangeLog.h"
 
 class QuotasSQL : public Quotas, ObjectSQL
 {
@@ -64,6 +68,47 @@ public:
      */
     int drop(SqlDB * db);
 
+    /**
+     *  Stores the Quotas to be written in the database by the next flush
+     *  (write-behind). Until then, select() reads the pending copy. If the
+     *  write-behind is disabled the Quotas are written now.
+     *    @param oid the Group/User oid
+     *    @param db pointer to the db
+     *    @return 0 on success
+     */
+    int update_deferred(int _oid, SqlDB * db);
+
+    /**
+     *  Writes the pending Quotas in the database. Quotas are written in
+     *  batches, with a multi-row REPLACE per table.
+     *    @param db pointer to the db
+     *    @return 0 on success
+     */
+    static int flush(SqlDB * db);
+
+    /**
+     *  Enables or disables the write-behind. It must be disabled in a
+     *  federation: the zones share the Quotas tables, and a pending copy
+     *  would be written over the usage added by the other zones.
+     *    @param enabled true to write the Quotas behind the checks
+     */
+    static void set_write_behind(bool enabled)
+    {
+        write_behind = enabled;
+    };
+
+    /**
+     *  Sets the change log where the writes of the Quotas of a table are
+     *  recorded. Quotas are cached with their User/Group, so the change is
+     *  recorded in the change log of its pool, by master and slaves.
+     *    @param table of the Quotas
+     *    @param log the change log of the pool, 0 if not shared
+     */
+    static void set_change_log(const string& table, ChangeLog * log)
+    {
+        change_logs[table] = log;
+    };
+
 protected:
 
     QuotasSQL(const char * ds_xpath,
@@ -143,6 +188,68 @@ private:
      *    @return the same xml string to use it in << compounds
      */
     string& to_xml_db(string& xml) const;
+
+    // -------------------------------------------------------------------------
+    // Write-behind of the Quotas
+    // -------------------------------------------------------------------------
+
+    /**
+     *  Max number of Quotas written in a single statement
+     */
+    static const unsigned int FLUSH_BATCH_SIZE;
+
+    /**
+     *  Quotas are written by the QuotaWriter (true) or by update_deferred
+     */
+    static bool write_behind;
+
+    /**
+     *  Quotas pending to be written, indexed by table and oid
+     */
+    static map<string, map<int, string> > pending;
+
+    /**
+     *  Protects the pending quotas
+     */
+    static pthread_mutex_t pending_mutex;
+
+    /**
+     *  Serializes the flush and drop operations, so a flush does not write
+     *  the Quotas of a dropped User/Group
+     */
+    static pthread_mutex_t flush_mutex;
+
+    /**
+     *  Change log of the pool of each Quotas table. Set when the pools are
+     *  created, before any flush.
+     */
+    static map<string, ChangeLog *> change_logs;
+
+    /**
+     *  Records the Quotas written for a table in its change log
+     *    @param table of the Quotas
+     *    @param batch of Quotas written
+     */
+    static void log_changes(const string&           table,
+                            const map<int, string>& batch);
+
+    /**
+     *  Gets the pending Quotas body
+     *    @param body of the Quotas, if pending
+     *    @return true if the Quotas are pending to be written
+     */
+    bool get_pending(string& body);
+
+    /**
+     *  Writes a batch of Quotas of a table
+     *    @param db pointer to the db
+     *    @param table name
+     *    @param batch of Quotas bodies
+     *    @return 0 on success
+     */
+    static int write_batch(SqlDB *                  db,
+                           const string&            table,
+                           const map<int, string>&  batch);
 };
 
 /* -------------------------------------------------------------------------- */
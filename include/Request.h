@@ -24,6 +24,7 @@
 #include "AuthRequest.h"
 #include "PoolObjectSQL.h"
 #include "Quotas.h"
+#include "RequestMetrics.h"
 
 using namespace std;
 
@@ -138,6 +139,21 @@ protected:
         };
     };
 
+public:
+    /**
+     *  Executes the request for an already authenticated user, used to run
+     *  the calls of one.system.batch without authenticating each one
+     *    @param _paramlist list of XML parameters, including the session
+     *    @param auth attributes of the authenticated user
+     *    @param _retval value to be returned to the client
+     */
+    void execute(
+        xmlrpc_c::paramList const& _paramList,
+        const RequestAttributes&   auth,
+        xmlrpc_c::value *   const  _retval);
+
+protected:
+
     /* -------- Static (shared among request of the same method) -------- */
 
     PoolSQL * pool;           /**< Pool of objects */
@@ -148,6 +164,8 @@ protected:
 
     set<int> hidden_params;
 
+    RequestMetrics * metrics; /**< Latency histograms of the method */
+
     static string format_str;
 
     /* -------------------- Constructors ---------------------------------- */
@@ -160,6 +178,8 @@ protected:
         _help      = help;
 
         hidden_params.clear();
+
+        metrics = RequestMetrics::get(method_name);
     };
 
     virtual ~Request(){};
@@ -0,0 +1,250 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+
+#ifndef REQUEST_FORWARDER_H_
+#define REQUEST_FORWARDER_H_
+
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+extern "C" void * rf_loop(void *arg);
+
+class RequestServer;
+
+/**
+ *  The RequestForwarder sends the calls of the proxied methods of a
+ *  federation slave to the master. Calls are written to a pool of persistent
+ *  (keep-alive) connections, each one with up to a number of pipelined calls,
+ *  by a single event driven thread. The XML-RPC body is forwarded as is, so
+ *  no worker thread of the RequestServer waits for the master.
+ */
+class RequestForwarder
+{
+public:
+    /**
+     *  @param _endpoint of the master, e.g. "http://master:2633/RPC2"
+     *  @param _methods names of the methods forwarded to the master
+     *  @param _connections number of connections to the master
+     *  @param _pipeline maximum calls in flight in each connection
+     *  @param _timeout seconds to wait for a response from the master
+     *  @param _max_pending calls waiting for a connection
+     */
+    RequestForwarder(
+            const string&      _endpoint,
+            const set<string>& _methods,
+            int                _connections,
+            int                _pipeline,
+            int                _timeout,
+            int                _max_pending);
+
+    ~RequestForwarder();
+
+    /**
+     *  Starts the forwarder thread
+     *    @param _server that receives the responses of the master
+     *    @return 0 on success
+     */
+    int start(RequestServer * _server);
+
+    /**
+     *  Stops the forwarder thread, pending calls are discarded
+     */
+    void stop();
+
+    /**
+     *  Checks if a method is forwarded to the master
+     *    @param method name of the method
+     *    @return true if the method is forwarded
+     */
+    bool forwards(const string& method) const
+    {
+        return methods.count(method) > 0;
+    };
+
+    /**
+     *  Queues a call to be forwarded to the master
+     *    @param conn_id of the RequestServer connection of the call
+     *    @param method name of the method
+     *    @param body of the XML-RPC call
+     *    @return 0 on success, -1 if too many calls are waiting
+     */
+    int forward(int conn_id, const string& method, const string& body);
+
+    /**
+     *  Prints the state of the forwarder in XML format
+     *    @param xml the resulting XML string
+     *    @return a reference to the generated string
+     */
+    string& to_xml(string& xml);
+
+private:
+    friend void * rf_loop(void *arg);
+
+    /**
+     *  A call forwarded to the master
+     */
+    struct Forward
+    {
+        int                conn_id;
+        string             method;
+        string             body;
+        unsigned long long queued;
+    };
+
+    /**
+     *  A connection to the master, only accessed by the forwarder thread
+     */
+    struct Upstream
+    {
+        int    fd;
+        bool   connected;
+
+        string out;
+        size_t out_pos;
+
+        string in;
+
+        deque<Forward *> inflight;
+
+        time_t last_activity;
+    };
+
+    // -------------------------------------------------------------------------
+    // Configuration
+    // -------------------------------------------------------------------------
+
+    string endpoint;
+
+    string host;
+
+    string port;
+
+    string path;
+
+    struct sockaddr_storage addr;
+
+    socklen_t addr_len;
+
+    set<string> methods;
+
+    int pipeline;
+
+    int timeout;
+
+    int max_pending;
+
+    RequestServer * server;
+
+    // -------------------------------------------------------------------------
+    // Forwarder thread
+    // -------------------------------------------------------------------------
+
+    pthread_t thread;
+
+    int epoll_fd;
+
+    int wake_fd[2];
+
+    vector<Upstream> upstreams;
+
+    // -------------------------------------------------------------------------
+    // Calls waiting for a connection and statistics, protected by mutex
+    // -------------------------------------------------------------------------
+
+    pthread_mutex_t mutex;
+
+    deque<Forward *> pending;
+
+    unsigned long long forwarded;
+
+    unsigned long long rejected;
+
+    unsigned long long failed;
+
+    unsigned long long max_pending_time;
+
+    int inflight;
+
+    bool end;
+
+    // -------------------------------------------------------------------------
+    // Forwarder functions
+    // -------------------------------------------------------------------------
+
+    void loop();
+
+    /**
+     *  Parses the endpoint of the master
+     *    @return 0 on success, -1 if it is not a http:// URL
+     */
+    int parse_endpoint();
+
+    /**
+     *  Resolves the address of the master
+     *    @return 0 on success
+     */
+    int resolve_endpoint();
+
+    /**
+     *  Opens a non-blocking connection to the master
+     *    @return 0 on success
+     */
+    int connect_upstream(Upstream& up);
+
+    /**
+     *  Closes a connection, the calls in flight are failed
+     *    @param error message for the calls in flight
+     */
+    void close_upstream(Upstream& up, const string& error);
+
+    /**
+     *  Assigns the pending calls to the connections with free slots
+     */
+    void dispatch();
+
+    void write_upstream(Upstream& up);
+
+    void read_upstream(Upstream& up);
+
+    /**
+     *  Parses the responses received in a connection
+     *    @return false if the connection has to be closed
+     */
+    bool parse_responses(Upstream& up);
+
+    /**
+     *  Sends the response of a call to the RequestServer
+     */
+    void complete(Forward * fw, const string& response, bool success);
+
+    /**
+     *  Fails the calls that wait too long for the master
+     */
+    void check_timeouts();
+
+    void set_events(Upstream& up);
+};
+
+#endif /*REQUEST_FORWARDER_H_*/
@@ -27,16 +27,56 @@
 #include "GroupPool.h"
 
 #include "AuthManager.h"
+#include "RequestServer.h"
 
 #include <xmlrpc-c/base.hpp>
 #include <xmlrpc-c/registry.hpp>
-#include <xmlrpc-c/server_abyss.hpp>
 
 using namespace std;
 
 extern "C" void * rm_action_loop(void *arg);
 
-extern "C" void * rm_xml_server_loop(void *arg);
+class Request;
+
+/**
+ *  The XML-RPC registry of the RequestManager. The OpenNebula requests are
+ *  also indexed by method name, so they can be executed without going
+ *  through the XML-RPC layer (one.system.batch).
+ */
+class RequestRegistry : public xmlrpc_c::registry
+{
+public:
+    /**
+     *  Adds a method to the XML-RPC registry and to the request index
+     *    @param name of the XML-RPC method
+     *    @param method the request
+     */
+    void addMethod(const string& name, xmlrpc_c::methodPtr method);
+
+    /**
+     *  Gets the request of a XML-RPC method
+     *    @param name of the XML-RPC method
+     *    @return the request, 0 if not found
+     */
+    Request * get_request(const string& name) const
+    {
+        map<string, Request *>::const_iterator it = requests.find(name);
+
+        if ( it == requests.end() )
+        {
+            return 0;
+        }
+
+        return it->second;
+    };
+
+private:
+    /**
+     *  Requests by method name. The registry keeps a reference to each one,
+     *  and it is not modified once the server is started.
+     */
+    map<string, Request *> requests;
+};
 
 class RequestManager : public ActionListener
 {
@@ -49,19 +89,52 @@ public:
             int _keepalive_timeout,
             int _keepalive_max_conn,
             int _timeout,
+            int _threads,
+            const int _concurrency[],
+            const int _queue_size[],
             const string _xml_log_file,
-            const string call_log_format);
+            const string call_log_format,
+            bool _prometheus,
+            int _proxy_connections,
+            int _proxy_pipeline,
+            int _proxy_timeout);
 
     ~RequestManager(){};
 
     /**
-     *  This functions starts the associated listener thread (XML server), and
+     *  This functions starts the XML-RPC server (event loop and workers), and
      *  creates a new thread for the Request Manager. This thread will wait in
      *  an action loop till it receives ACTION_FINALIZE.
      *    @return 0 on success.
      */
     int start();
 
+    /**
+     *  Prints the state of the XML-RPC server queues in XML format
+     *    @param xml the resulting XML string
+     *    @return a reference to the generated string
+     */
+    string& server_to_xml(string& xml)
+    {
+        if ( server == 0 )
+        {
+            xml = "<RPC_SERVER/>";
+            return xml;
+        }
+
+        return server->to_xml(xml);
+    };
+
+    /**
+     *  Gets the request of a XML-RPC method
+     *    @param name of the XML-RPC method, e.g. "one.vm.info"
+     *    @return the request, 0 if not found
+     */
+    Request * get_request(const string& name) const
+    {
+        return RequestManagerRegistry.get_request(name);
+    };
+
     /**
      *  Gets the thread identification.
      *    @return pthread_t for the manager thread (that in the action loop).
@@ -86,8 +159,6 @@ private:
     // Friends, thread functions require C-linkage
     //--------------------------------------------------------------------------
 
-    friend void * rm_xml_server_loop(void *arg);
-
     friend void * rm_action_loop(void *arg);
 
     /**
@@ -95,11 +166,6 @@ private:
      */
     pthread_t               rm_thread;
 
-    /**
-     *  Thread id for the XML Server
-     */
-    pthread_t               rm_xml_server_thread;
-
     /**
      *  Port number where the connection will be open
      */
@@ -135,11 +201,46 @@ private:
      */
     int timeout;
 
+    /**
+     *  Number of threads executing the XML-RPC calls
+     */
+    int threads;
+
+    /**
+     *  Max calls of each class (read, write) executed at the same time
+     */
+    int concurrency[RequestServer::NUM_CLASSES];
+
+    /**
+     *  Max calls of each class (read, write) waiting to be executed
+     */
+    int queue_size[RequestServer::NUM_CLASSES];
+
     /**
      *  Filename for the log of the xmlrpc server that listens
      */
     string xml_log_file;
 
+    /**
+     *  Serve the call metrics in the Prometheus text format (GET /metrics)
+     */
+    bool prometheus;
+
+    /**
+     *  Connections to the master used to forward the proxied calls (slaves)
+     */
+    int proxy_connections;
+
+    /**
+     *  Calls in flight in each connection to the master
+     */
+    int proxy_pipeline;
+
+    /**
+     *  Seconds to wait for the response of the master
+     */
+    int proxy_timeout;
+
     /**
      *  Action engine for the Manager
      */
@@ -148,12 +249,12 @@ private:
     /**
      *  To register XML-RPC methods
      */
-    xmlrpc_c::registry RequestManagerRegistry;
+    RequestRegistry RequestManagerRegistry;
 
     /**
      *  The XML-RPC server
      */
-    xmlrpc_c::serverAbyss *  AbyssServer;
+    RequestServer *  server;
 
     /**
      *  The action function executed when an action is triggered.
@@ -73,7 +73,11 @@ public:
 
     void to_xml(RequestAttributes& att, PoolObjectSQL * object, string& str)
     {
-        static_cast<VirtualMachine *>(object)->to_xml_extended(str);
+        VirtualMachine * vm = static_cast<VirtualMachine *>(object);
+
+        static_cast<VirtualMachinePool *>(pool)->select_history(vm);
+
+        vm->to_xml_extended(str);
     };
 };
 
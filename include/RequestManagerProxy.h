@@ -37,10 +37,21 @@ public:
 
     void hide_argument(int arg);
 
+    /**
+     *  Names of the methods proxied to the master, they can be forwarded by
+     *  the XML-RPC server without executing this request
+     */
+    static const set<string>& get_methods()
+    {
+        return methods;
+    };
+
 private:
     Client *  client;
 
     string    method;
+
+    static set<string> methods;
 };
 
 #endif
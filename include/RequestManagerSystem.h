@@ -22,6 +22,8 @@
 
 using namespace std;
 
+extern "C" void * batch_call_loop(void *arg);
+
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
@@ -82,6 +84,88 @@ public:
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
 
+class SystemMetrics : public RequestManagerSystem
+{
+public:
+    SystemMetrics():
+        RequestManagerSystem("SystemMetrics",
+                          "Returns the oned internal metrics",
+                          "A:s")
+    {};
+
+    ~SystemMetrics(){};
+
+    void request_execute(xmlrpc_c::paramList const& _paramList,
+                         RequestAttributes& att);
+};
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+/**
+ *  Executes a list of calls with the session of the batch, that is
+ *  authenticated once. Each call is an array with the method name and its
+ *  parameters (without the session). The calls can be executed in parallel,
+ *  the result is the array with the response of each call, in order.
+ */
+class SystemBatch : public RequestManagerSystem
+{
+public:
+    SystemBatch():
+        RequestManagerSystem("SystemBatch",
+                          "Executes a list of calls with a single session",
+                          "A:sAb")
+    {};
+
+    ~SystemBatch(){};
+
+    void request_execute(xmlrpc_c::paramList const& _paramList,
+                         RequestAttributes& att);
+
+private:
+    friend void * batch_call_loop(void *arg);
+
+    /**
+     *  Max. number of threads used to execute the calls of a batch
+     */
+    static const unsigned int MAX_THREADS;
+
+    /**
+     *  A call of the batch
+     */
+    struct BatchCall
+    {
+        Request *           request;
+        xmlrpc_c::paramList params;
+        xmlrpc_c::value     result;
+        string              error;
+    };
+
+    /**
+     *  The calls of a batch, each thread takes the next one to execute
+     */
+    struct BatchState
+    {
+        SystemBatch *             batch;
+        vector<BatchCall>         calls;
+        const RequestAttributes * att;
+        unsigned int              next;
+    };
+
+    /**
+     *  Executes the calls of a batch, until all of them have been taken
+     */
+    void call_loop(BatchState * state);
+
+    /**
+     *  Builds the failure response of a call that can not be executed
+     */
+    static xmlrpc_c::value call_failure(const string& error);
+};
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
 class UserQuotaInfo : public RequestManagerSystem
 {
 public:
@@ -46,6 +46,21 @@ protected:
 
     virtual void request_execute(xmlrpc_c::paramList const& _paramList,
                                  RequestAttributes& att) = 0;
+
+    /**
+     *  Gets a copy of a VM template to instantiate it. The user attributes
+     *  are merged and the USE (and CREATE) operations are authorized. The
+     *  failure response is set on error.
+     *    @param id of the template
+     *    @param name of the new VMs, "" for the default one
+     *    @param str_uattrs user attributes to merge, in text or XML
+     *    @param att the specific request attributes
+     *    @return the template, 0 on failure. It MUST be freed by the caller
+     */
+    VirtualMachineTemplate * instantiate_template(int           id,
+                                                  const string& name,
+                                                  const string& str_uattrs,
+                                                  RequestAttributes& att);
 };
 
 /* ------------------------------------------------------------------------- */
@@ -68,6 +83,26 @@ public:
                          RequestAttributes& att);
 };
 
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+class VMTemplateInstantiateBulk : public RequestManagerVMTemplate
+{
+public:
+    VMTemplateInstantiateBulk():
+        RequestManagerVMTemplate("TemplateInstantiateBulk",
+                                 "Instantiates a number of virtual machines using a template",
+                                 "A:siisbs")
+    {
+        auth_op = AuthRequest::USE;
+    };
+
+    ~VMTemplateInstantiateBulk(){};
+
+    void request_execute(xmlrpc_c::paramList const& _paramList,
+                         RequestAttributes& att);
+};
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
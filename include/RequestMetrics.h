@@ -0,0 +1,253 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+
+#ifndef REQUEST_METRICS_H_
+#define REQUEST_METRICS_H_
+
+#include <pthread.h>
+#include <map>
+#include <string>
+#include <sstream>
+
+using namespace std;
+
+/**
+ *  Latency histogram with a fixed relative error. Values (in microseconds)
+ *  are stored in log-linear buckets: each power of two is split in
+ *  SUB_BUCKETS linear buckets, so the value reported for a percentile is
+ *  within 12.5% of the recorded one. Buckets are updated with atomic
+ *  operations, recording a value does not take any lock.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram()
+    {
+        reset();
+    };
+
+    ~LatencyHistogram(){};
+
+    /**
+     *  Records a value in the histogram
+     *    @param usec the latency in microseconds
+     */
+    void record(unsigned long long usec)
+    {
+        unsigned long long cur;
+
+        __sync_fetch_and_add(&buckets[bucket(usec)], 1);
+
+        __sync_fetch_and_add(&count, 1);
+        __sync_fetch_and_add(&sum, usec);
+
+        cur = max_value;
+
+        while ( usec > cur )
+        {
+            unsigned long long prev;
+
+            prev = __sync_val_compare_and_swap(&max_value, cur, usec);
+
+            if ( prev == cur )
+            {
+                break;
+            }
+
+            cur = prev;
+        }
+    };
+
+    /**
+     *  Clears the histogram, not thread safe
+     */
+    void reset();
+
+    /**
+     *  Number of values recorded
+     */
+    unsigned long long get_count() const
+    {
+        return count;
+    };
+
+    /**
+     *  Sum of the values recorded, in microseconds
+     */
+    unsigned long long get_sum() const
+    {
+        return sum;
+    };
+
+    /**
+     *  Maximum value recorded, in microseconds
+     */
+    unsigned long long get_max() const
+    {
+        return max_value;
+    };
+
+    /**
+     *  Computes a percentile of the recorded values
+     *    @param p the percentile in the [0,1] range, e.g. 0.99
+     *    @return the highest value of the bucket that holds the percentile
+     */
+    unsigned long long percentile(double p) const;
+
+private:
+    /**
+     *  Number of linear buckets per power of two (2^SUB_BITS)
+     */
+    static const int SUB_BITS    = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+
+    /**
+     *  Values up to 2^MAX_BITS us (~38h) are stored in its bucket, longer
+     *  ones are accounted in the last bucket
+     */
+    static const int MAX_BITS    = 37;
+    static const int NUM_BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+    unsigned long long buckets[NUM_BUCKETS];
+
+    unsigned long long count;
+    unsigned long long sum;
+    unsigned long long max_value;
+
+    /**
+     *  Gets the bucket for a value
+     */
+    static int bucket(unsigned long long usec)
+    {
+        int msb;
+
+        if ( usec < static_cast<unsigned long long>(SUB_BUCKETS) )
+        {
+            return static_cast<int>(usec);
+        }
+
+        msb = 63 - __builtin_clzll(usec);
+
+        if ( msb >= MAX_BITS )
+        {
+            return NUM_BUCKETS - 1;
+        }
+
+        return (msb - SUB_BITS + 1) * SUB_BUCKETS +
+            static_cast<int>((usec >> (msb - SUB_BITS)) - SUB_BUCKETS);
+    };
+
+    /**
+     *  Gets the highest value stored in a bucket
+     */
+    static unsigned long long bucket_max(int b);
+};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  The RequestMetrics class holds the latency histograms of a XML-RPC method,
+ *  for the whole call and for each of its phases. Metrics objects are
+ *  created when the Requests are registered and never freed, so Requests
+ *  keep a pointer to them and record values without locking.
+ */
+class RequestMetrics
+{
+public:
+    /**
+     *  Phases of a call
+     *    TOTAL: whole call execution, as seen by Request::execute
+     *    AUTHENTICATION: session check (UserPool::authenticate)
+     *    AUTHORIZATION: ACL checks, or ACL filter for pool requests
+     *    DB: database queries to dump the pool
+     *    RESPONSE: build of the XML-RPC response value
+     */
+    enum Phase
+    {
+        TOTAL          = 0,
+        AUTHENTICATION = 1,
+        AUTHORIZATION  = 2,
+        DB             = 3,
+        RESPONSE       = 4,
+        NUM_PHASES     = 5
+    };
+
+    /**
+     *  Gets the metrics of a method, creating them if needed
+     *    @param method the name of the method, as used in the Request logs
+     *    @return pointer to the metrics, never 0
+     */
+    static RequestMetrics * get(const string& method);
+
+    /**
+     *  Current time to measure the phases
+     *    @return monotonic time in microseconds
+     */
+    static unsigned long long now();
+
+    /**
+     *  Records the duration of a phase
+     *    @param phase of the call
+     *    @param start of the phase, as returned by now()
+     */
+    void record(Phase phase, unsigned long long start)
+    {
+        unsigned long long end = now();
+
+        if ( end < start )
+        {
+            end = start;
+        }
+
+        phases[phase].record(end - start);
+    };
+
+    /**
+     *  Prints the metrics of all the methods in XML format
+     *    @param oss the output stream
+     */
+    static void to_xml(ostringstream& oss);
+
+    /**
+     *  Prints the metrics of all the methods in the Prometheus text format
+     *    @param text the resulting string
+     *    @return a reference to the generated string
+     */
+    static string& to_prometheus(string& text);
+
+private:
+    RequestMetrics(){};
+
+    ~RequestMetrics(){};
+
+    LatencyHistogram phases[NUM_PHASES];
+
+    /**
+     *  Metrics of each method
+     */
+    static map<string, RequestMetrics *> methods;
+
+    /**
+     *  Mutex to create new metrics objects
+     */
+    static pthread_mutex_t mutex;
+
+    static const char * phase_names[];
+};
+
+#endif /*REQUEST_METRICS_H_*/
@@ -0,0 +1,361 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+
+#ifndef REQUEST_SERVER_H_
+#define REQUEST_SERVER_H_
+
+#include <pthread.h>
+#include <sys/time.h>
+
+#include <deque>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <xmlrpc-c/registry.hpp>
+
+#include "RequestForwarder.h"
+
+using namespace std;
+
+extern "C" void * rs_event_loop(void *arg);
+
+extern "C" void * rs_worker_loop(void *arg);
+
+/**
+ *  The RequestServer is the HTTP front end of the XML-RPC API. A single
+ *  thread accepts the connections and reads the requests using epoll. The
+ *  calls are then executed by a fixed pool of worker threads, using the
+ *  methods in the RequestManager registry.
+ *
+ *  The calls are admitted in two queues, one for the read-only methods
+ *  (info, monitoring, accounting...) and other for the calls that modify
+ *  objects. Each queue has a limit of workers running its calls and a
+ *  maximum size. Calls are rejected (HTTP 503) when its queue is full, so a
+ *  storm of pool dumps can not delay state changes indefinitely.
+ */
+class RequestServer
+{
+public:
+    /**
+     *  Class of a XML-RPC call, each class has its own queue
+     */
+    enum CallClass
+    {
+        READ  = 0,
+        WRITE = 1
+    };
+
+    static const int NUM_CLASSES = 2;
+
+    /**
+     *  @param _registry with the XML-RPC methods
+     *  @param _socket_fd bound server socket
+     *  @param _max_conn maximum number of simultaneous connections
+     *  @param _max_conn_backlog backlog of the listen socket
+     *  @param _keepalive_timeout seconds a connection can be idle between
+     *  calls
+     *  @param _keepalive_max_conn maximum number of calls per connection
+     *  @param _timeout seconds to receive a complete request
+     *  @param _threads number of worker threads
+     *  @param concurrency maximum workers running calls of each class
+     *  @param queue_size maximum calls waiting in the queue of each class
+     *  @param _log_file to log each HTTP request, empty to disable it
+     *  @param _prometheus serve the call metrics in GET /metrics
+     */
+    RequestServer(
+            xmlrpc_c::registry * _registry,
+            int                  _socket_fd,
+            int                  _max_conn,
+            int                  _max_conn_backlog,
+            int                  _keepalive_timeout,
+            int                  _keepalive_max_conn,
+            int                  _timeout,
+            int                  _threads,
+            const int            concurrency[],
+            const int            queue_size[],
+            const string&        _log_file,
+            bool                 _prometheus);
+
+    ~RequestServer();
+
+    /**
+     *  Starts listening in the server socket, the event loop and the
+     *  worker threads
+     *    @return 0 on success
+     */
+    int start();
+
+    /**
+     *  Stops the event loop and the worker threads, and closes all the
+     *  connections. Calls being executed are completed.
+     */
+    void stop();
+
+    /**
+     *  Prints the state of the call queues in XML format
+     *    @param xml the resulting XML string
+     *    @return a reference to the generated string
+     */
+    string& to_xml(string& xml);
+
+    /**
+     *  Sets the forwarder for the calls proxied to the federation master. It
+     *  has to be set before starting the server, that will free it.
+     *    @param _forwarder for the proxied calls
+     */
+    void set_forwarder(RequestForwarder * _forwarder)
+    {
+        forwarder = _forwarder;
+    };
+
+    /**
+     *  Completes a call forwarded to the master, the response is sent by the
+     *  event loop
+     *    @param conn_id of the connection of the call
+     *    @param response XML-RPC response of the call
+     */
+    void forward_done(int conn_id, const string& response);
+
+    /**
+     *  Gets the class of a XML-RPC method
+     *    @param method name, e.g. "one.vmpool.info"
+     *    @return READ for read-only methods, WRITE otherwise
+     */
+    static CallClass call_class(const string& method);
+
+private:
+    friend void * rs_event_loop(void *arg);
+
+    friend void * rs_worker_loop(void *arg);
+
+    /**
+     *  A client connection, only accessed by the event loop thread
+     */
+    struct Connection
+    {
+        int    id;
+        int    fd;
+        string peer;
+
+        string in;
+
+        string header;
+        string body;
+        size_t out_pos;
+
+        bool   busy;
+        bool   close;
+        bool   continue_sent;
+        int    calls;
+        time_t last_activity;
+
+        string request_line;
+    };
+
+    /**
+     *  A XML-RPC call, waiting or being executed
+     */
+    struct Call
+    {
+        int            conn_id;
+        CallClass      cclass;
+        string         body;
+        string         response;
+        struct timeval queued;
+    };
+
+    /**
+     *  Statistics and limits of a call queue
+     */
+    struct CallQueue
+    {
+        deque<Call *>      calls;
+
+        int                concurrency;
+        int                max_size;
+        int                active;
+
+        unsigned long long admitted;
+        unsigned long long rejected;
+        unsigned long long started;
+        unsigned long long queue_time;
+        unsigned long long max_queue_time;
+    };
+
+    // -------------------------------------------------------------------------
+    // Configuration
+    // -------------------------------------------------------------------------
+
+    xmlrpc_c::registry * registry;
+
+    int socket_fd;
+
+    int max_conn;
+
+    int max_conn_backlog;
+
+    int keepalive_timeout;
+
+    int keepalive_max_conn;
+
+    int timeout;
+
+    int threads;
+
+    string log_file;
+
+    bool prometheus;
+
+    /**
+     *  Forwarder of the proxied calls, 0 if not a federation slave
+     */
+    RequestForwarder * forwarder;
+
+    // -------------------------------------------------------------------------
+    // Event loop, connections are only accessed by this thread
+    // -------------------------------------------------------------------------
+
+    pthread_t loop_thread;
+
+    int epoll_fd;
+
+    /**
+     *  Pipe used by the workers to wake up the event loop when a call is
+     *  completed, and to stop it
+     */
+    int wake_fd[2];
+
+    /**
+     *  Connections by fd
+     */
+    map<int, Connection *> connections;
+
+    /**
+     *  Connections by id, the calls refer to the id as the fd can be reused
+     */
+    map<int, Connection *> connection_ids;
+
+    int next_id;
+
+    /**
+     *  False when max_conn connections are open, new connections wait in
+     *  the socket backlog
+     */
+    bool accepting;
+
+    /**
+     *  Log for the HTTP requests
+     */
+    ofstream log;
+
+    // -------------------------------------------------------------------------
+    // Call queues and workers, protected by mutex
+    // -------------------------------------------------------------------------
+
+    vector<pthread_t> worker_threads;
+
+    pthread_mutex_t mutex;
+
+    pthread_cond_t  cond;
+
+    CallQueue queues[NUM_CLASSES];
+
+    /**
+     *  Calls completed by the workers, pending to be sent by the event loop
+     */
+    vector<Call *> done;
+
+    /**
+     *  Number of open connections (for the metrics)
+     */
+    int num_connections;
+
+    bool end;
+
+    // -------------------------------------------------------------------------
+    // Event loop functions
+    // -------------------------------------------------------------------------
+
+    void event_loop();
+
+    void accept_connections();
+
+    /**
+     *  Reads the available data of a connection and admits the complete
+     *  requests
+     */
+    void read_connection(Connection * conn);
+
+    /**
+     *  Parses a request from the connection buffer. If it is complete the
+     *  call is admitted in its queue, or a response is sent.
+     */
+    void parse_request(Connection * conn);
+
+    /**
+     *  Parses the pipelined requests of a connection, till a call is
+     *  admitted, a response is being written or more data is needed
+     */
+    void process_requests(Connection * conn);
+
+    /**
+     *  Writes the pending response of a connection
+     */
+    void write_connection(Connection * conn);
+
+    /**
+     *  Sends the responses of the calls completed by the workers
+     */
+    void send_completed();
+
+    /**
+     *  Sets the HTTP response for a connection and starts writing it
+     */
+    void send_response(Connection * conn, int code, const string& reason,
+            const string& body,
+            const char * content_type = "text/xml; charset=\"utf-8\"");
+
+    /**
+     *  Sets the events of interest for a connection
+     */
+    void set_events(Connection * conn, unsigned int events);
+
+    void close_connection(Connection * conn);
+
+    /**
+     *  Closes the connections that have been idle for too long
+     */
+    void check_timeouts();
+
+    // -------------------------------------------------------------------------
+    // Worker functions
+    // -------------------------------------------------------------------------
+
+    void worker_loop();
+
+    /**
+     *  Gets the next call to execute. Calls that modify objects are served
+     *  first, the concurrency of each class is limited. Must be called with
+     *  the mutex locked.
+     *    @return the call or 0 if no call can be executed
+     */
+    Call * next_call();
+};
+
+#endif /*REQUEST_SERVER_H_*/
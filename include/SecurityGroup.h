@@ -18,7 +18,7 @@
 #define SECURITYGROUP_H_
 
 #include "PoolObjectSQL.h"
-#include "ObjectCollection.h"
+#include "ObjectCollectionSQL.h"
 
 using namespace std;
 
@@ -34,7 +34,10 @@ public:
      *  @param xml the resulting XML string
      *  @return a reference to the generated string
      */
-    string& to_xml(string& xml) const;
+    string& to_xml(string& xml) const
+    {
+        return to_xml(xml, true);
+    };
 
     /**
      *  Rebuilds the object from an xml formatted string
@@ -83,7 +86,7 @@ public:
      *  Returns how many VMs are using the security group.
      *    @return how many IDs are there in the set.
      */
-    int get_vms() const
+    int get_vms()
     {
         return vm_collection.get_collection_size();
     }
@@ -144,6 +147,19 @@ private:
 
     static const char * table;
 
+    static const char * vms_db_bootstrap;
+
+    static const char * vms_table;
+
+    /**
+     * Function to print the SecurityGroup object into a string in XML format
+     *  @param xml the resulting XML string
+     *  @param with_collections include the collections stored in relation
+     *  tables, or their empty elements as stored in the security group body
+     *  @return a reference to the generated string
+     */
+    string& to_xml(string& xml, bool with_collections) const;
+
     /**
      *  Execute an INSERT or REPLACE Sql query.
      *    @param db The SQL DB
@@ -159,9 +175,15 @@ private:
      */
     static int bootstrap(SqlDB * db)
     {
+        int rc;
+
         ostringstream oss(SecurityGroup::db_bootstrap);
+        ostringstream oss_vms(SecurityGroup::vms_db_bootstrap);
 
-        return db->exec(oss);
+        rc  = db->exec(oss);
+        rc += db->exec(oss_vms);
+
+        return rc;
     };
 
     /**
@@ -179,7 +201,13 @@ private:
     int update(SqlDB *db)
     {
         string error_str;
-        return insert_replace(db, true, error_str);
+
+        if ( insert_replace(db, true, error_str) != 0 )
+        {
+            return -1;
+        }
+
+        return update_collections(db);
     }
 
     /**
@@ -191,9 +219,10 @@ private:
     }
 
     /**
-     *  Stores a collection with the VMs using the security group
+     *  Stores a collection with the VMs using the security group, in the
+     *  secgroup_vms table
      */
-    ObjectCollection vm_collection;
+    ObjectCollectionSQL vm_collection;
 };
 
 #endif /*SECURITYGROUP_H_*/
@@ -20,6 +20,9 @@
 #include "PoolSQL.h"
 #include "SecurityGroup.h"
 
+#include <map>
+#include <vector>
+
 using namespace std;
 
 
@@ -28,7 +31,7 @@ class SecurityGroupPool : public PoolSQL
 public:
     SecurityGroupPool(SqlDB * db);
 
-    ~SecurityGroupPool(){};
+    ~SecurityGroupPool();
 
     /* ---------------------------------------------------------------------- */
     /* Methods for DB management                                              */
@@ -92,6 +95,36 @@ public:
      */
     int update(SecurityGroup * securitygroup);
 
+    /**
+     *  Drops the SecurityGroup from the DB and removes its cached rules
+     *    @param objsql a pointer to the SecurityGroup
+     *    @param error_msg Error reason, if any
+     *    @return 0 on success
+     */
+    int drop(PoolObjectSQL * objsql, string& error_msg);
+
+    /**
+     *  Expands the rules of a security group. Rules with a NETWORK_ID are
+     *  replaced by one rule for each address range of the network. The
+     *  expansion is cached and re-used while the group rules and the address
+     *  ranges of the referenced networks do not change.
+     *    @param sgid of the security group
+     *    @param sg_rules of the group, as returned by SecurityGroup::get_rules.
+     *    They are consumed (freed or moved to rules) by this function
+     *    @param rules the expanded rules are appended here, MUST be freed by
+     *    the caller
+     */
+    void expand_rules(int sgid, vector<VectorAttribute*>& sg_rules,
+            vector<VectorAttribute*>& rules);
+
+    /**
+     *  Invalidates the expanded rules that reference a virtual network. It
+     *  MUST be called when the address ranges of the network change, or when
+     *  it is dropped.
+     *    @param vnid of the virtual network
+     */
+    void invalidate_vnet(int vnid);
+
     /**
      *  Bootstraps the database table(s) associated to the SecurityGroup pool
      *    @return 0 on success
@@ -117,6 +150,65 @@ public:
 
 private:
 
+    /**
+     *  Expanded rules of a security group
+     */
+    struct RuleExpansion
+    {
+        /**
+         *  Marshalled rules of the group used for the expansion
+         */
+        string key;
+
+        /**
+         *  Generation of each referenced network at expansion time
+         */
+        map<int, unsigned long> vnets;
+
+        /**
+         *  Expanded rules
+         */
+        vector<VectorAttribute *> rules;
+
+        ~RuleExpansion();
+    };
+
+    /**
+     *  Rule expansion cache, by security group id
+     */
+    map<int, RuleExpansion *> rule_cache;
+
+    /**
+     *  Generation of each virtual network, it is increased every time its
+     *  address ranges change. Not present means 0.
+     */
+    map<int, unsigned long> vnet_generation;
+
+    /**
+     *  Mutex for the rule cache and network generations
+     */
+    pthread_mutex_t cache_mutex;
+
+    /**
+     *  Builds the cache key for a set of rules
+     */
+    static string rules_key(const vector<VectorAttribute*>& sg_rules);
+
+    /**
+     *  Gets the current generation of a network, cache_mutex MUST be locked
+     */
+    unsigned long get_generation(int vnid)
+    {
+        map<int, unsigned long>::iterator it = vnet_generation.find(vnid);
+
+        if ( it == vnet_generation.end() )
+        {
+            return 0;
+        }
+
+        return it->second;
+    };
+
     /**
      *  Factory method to produce objects
      *    @return a pointer to the new object
@@ -0,0 +1,151 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef SESSION_CACHE_H_
+#define SESSION_CACHE_H_
+
+#include <map>
+#include <set>
+#include <string>
+
+#include <time.h>
+#include <pthread.h>
+
+using namespace std;
+
+/**
+ *  The SessionCache class stores the result of successful authentications,
+ *  so the following requests with the same session string are authenticated
+ *  without getting (and locking) the user object. The cache is split in
+ *  shards by the hash of the session, each one protected by a rw lock, so
+ *  concurrent requests of the same user only share read locks.
+ */
+class SessionCache
+{
+public:
+
+    SessionCache();
+
+    ~SessionCache();
+
+    /**
+     *  Gets the authentication data of a session, if it has been cached and
+     *  has not expired
+     *    @param session, colon separated username and password string
+     *    @param password of the user
+     *    @param uid of the user
+     *    @param gid of the user
+     *    @param uname of the user
+     *    @param gname of the group
+     *    @param group_ids the user groups
+     *    @param umask of the user
+     *
+     *    @return true if the session is in the cache
+     */
+    bool get(const string& session,
+             string&       password,
+             int&          uid,
+             int&          gid,
+             string&       uname,
+             string&       gname,
+             set<int>&     group_ids,
+             int&          umask);
+
+    /**
+     *  Stores the authentication data of a session. The session is not
+     *  cached if any user was invalidated since the given generation, as the
+     *  data may be outdated.
+     *    @param session, colon separated username and password string
+     *    @param generation of the cache when the user was read
+     *    @param expiration time of the session token
+     *
+     *    (see get for the rest of the parameters)
+     */
+    void insert(const string&   session,
+                unsigned long   generation,
+                time_t          expiration,
+                const string&   password,
+                int             uid,
+                int             gid,
+                const string&   uname,
+                const string&   gname,
+                const set<int>& group_ids,
+                int             umask);
+
+    /**
+     *  Removes all the sessions of a user. It must be called when the
+     *  password, groups or state of the user change.
+     *    @param uid of the user
+     */
+    void invalidate(int uid);
+
+    /**
+     *  Gets the generation of the cache, it changes on each invalidate call
+     */
+    unsigned long get_generation()
+    {
+        return __sync_fetch_and_add(&generation, 0);
+    };
+
+private:
+
+    /**
+     *  Authentication data of a session
+     */
+    struct Session
+    {
+        time_t   expiration;
+
+        string   password;
+        int      uid;
+        int      gid;
+        string   uname;
+        string   gname;
+        set<int> group_ids;
+        int      umask;
+    };
+
+    /**
+     *  A shard of the cache, sessions are indexed by the session string
+     */
+    struct Shard
+    {
+        pthread_rwlock_t        rwlock;
+        map<string, Session>    sessions;
+    };
+
+    /**
+     *  Number of shards, and max sessions in a shard before expired ones
+     *  are purged
+     */
+    static const unsigned int NUM_SHARDS;
+
+    static const unsigned int MAX_SHARD_SIZE;
+
+    Shard * shards;
+
+    /**
+     *  Incremented each time a user is invalidated
+     */
+    unsigned long generation;
+
+    /**
+     *  Gets the shard for a session (FNV-1a hash)
+     */
+    Shard& shard(const string& session);
+};
+
+#endif /*SESSION_CACHE_H_*/
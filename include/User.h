@@ -224,13 +224,15 @@ public:
     UserQuotas quota;
 
     /**
-     *  Writes/updates the User quotas fields in the database.
+     *  Writes/updates the User quotas fields in the database. The quotas
+     *  are stored in memory and written in the next QuotaWriter flush,
+     *  except in a federation (see QuotasSQL::set_write_behind).
      *    @param db pointer to the db
      *    @return 0 on success
      */
     int update_quotas(SqlDB *db)
     {
-        return quota.update(oid, db);
+        return quota.update_deferred(oid, db);
     };
 
     // *************************************************************************
@@ -315,6 +317,16 @@ private:
      */
     int select(SqlDB * db, const string& name, int uid);
 
+    /**
+     *  Reads the quotas of a User rebuilt from its body.
+     *    @param db pointer to the db
+     *    @return 0 on success
+     */
+    int select_extra(SqlDB * db)
+    {
+        return quota.select(oid, db);
+    };
+
     /**
      *  Drops the user from the database
      *    @param db pointer to the db
@@ -18,6 +18,7 @@
 #define USER_POOL_H_
 
 #include "PoolSQL.h"
+#include "SessionCache.h"
 #include "User.h"
 #include "GroupPool.h"
 
@@ -45,7 +46,10 @@ public:
              const string&             remotes_location,
              bool                      is_federation_slave);
 
-    ~UserPool(){};
+    ~UserPool()
+    {
+        delete sessions;
+    };
 
     /**
      *  Function to allocate a new User object
@@ -116,6 +120,22 @@ public:
      */
     int update(User * user);
 
+    /**
+     *  Updates the object's data in the data base, and removes the cached
+     *  sessions of the user. The object mutex SHOULD be locked.
+     *    @param objsql a pointer to the User
+     *
+     *    @return 0 on success.
+     */
+    int update(PoolObjectSQL * objsql)
+    {
+        int rc = PoolSQL::update(objsql);
+
+        invalidate_sessions(objsql->get_oid());
+
+        return rc;
+    };
+
     /**
      * Update a particular User's Quotas
      *    @param user pointer to User
@@ -217,6 +237,24 @@ private:
      **/
     static time_t _session_expiration_time;
 
+    /**
+     *  Cache of authenticated sessions, not used by federation slaves as
+     *  the users are updated by the master
+     */
+    SessionCache * sessions;
+
+    /**
+     *  Removes the cached sessions of a user
+     *    @param uid of the user
+     */
+    void invalidate_sessions(int uid)
+    {
+        if ( sessions != 0 )
+        {
+            sessions->invalidate(uid);
+        }
+    };
+
     /**
      *  Function to authenticate internal (known) users
      */
@@ -228,7 +266,8 @@ private:
                                string&       uname,
                                string&       gname,
                                set<int>&     group_ids,
-                               int&          umask);
+                               int&          umask,
+                               time_t&       expiration);
 
     /**
      *  Function to authenticate internal users using a server driver
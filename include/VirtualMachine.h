@@ -1474,7 +1474,9 @@ private:
     History *   previous_history;
 
     /**
-     *  Complete set of history records for the VM
+     *  Complete set of history records for the VM. Only the current and
+     *  previous records are read when the VM is loaded, the older ones are
+     *  0 until select_history() is called.
      */
     vector<History *> history_records;
 
@@ -1571,6 +1573,19 @@ private:
             return -1;
     };
 
+    /**
+     *  Reads the older history records of the VM (the current and previous
+     *  ones are read by select) with a single query
+     *    @param db pointer to the db
+     *    @return 0 on success
+     */
+    int select_history(SqlDB * db);
+
+    /**
+     *  Callback to add the history records read by select_history
+     */
+    int select_history_cb(void *nil, int num, char **values, char **names);
+
     /**
      * Inserts the last monitoring, and deletes old monitoring entries.
      *
@@ -1768,6 +1783,14 @@ protected:
      */
     int select(SqlDB * db);
 
+    /**
+     *  Reads the previous history record, and sets up the VM directory and
+     *  log, for a VM rebuilt from its body.
+     *    @param db pointer to the db
+     *    @return 0 on success
+     */
+    int select_extra(SqlDB * db);
+
     /**
      *  Writes the Virtual Machine and its associated template in the database.
      *    @param db pointer to the db
@@ -17,6 +17,7 @@
 #ifndef VIRTUAL_MACHINE_HOOK_H_
 #define VIRTUAL_MACHINE_HOOK_H_
 
+#include <map>
 #include <vector>
 #include <string>
 
@@ -25,72 +26,13 @@
 
 using namespace std;
 
-/**
- *  This class provides basic functionality to store VM states for state Hooks.
- *  The state Map is shared by all the State hooks. A maintenance hook that
- *  updates the map should be added.
- */
-class VirtualMachineStateMapHook: public Hook
-{
-public:
-    virtual void do_hook(void *arg) = 0;
-
-protected:
-    // -------------------------------------------------------------------------
-    // Init the Map
-    // -------------------------------------------------------------------------
-    VirtualMachineStateMapHook(const string& name,
-                           const string& cmd,
-                           const string& args,
-                           bool          remote):
-        Hook(name, cmd, args, Hook::UPDATE | Hook::ALLOCATE, remote){};
-
-    virtual ~VirtualMachineStateMapHook(){};
-
-    // -------------------------------------------------------------------------
-    // Functions to handle the VM state map
-    // -------------------------------------------------------------------------
-    /**
-     *  Gets the state associated to the VM
-     *    @param id of the VM
-     *    @param lcm_state (previous) of the VM
-     *    @return 0 if the previous state for the VM has been recorded
-     */
-    int get_state(int id,
-                  VirtualMachine::LcmState &lcm_state,
-                  VirtualMachine::VmState  &vm_state);
-
-    /**
-     *  Updates the state associated to the VM
-     *    @param id of the VM
-     *    @param lcm_state (current) of the VM
-     */
-    void update_state (int                      id,
-                       VirtualMachine::LcmState lcm_state,
-                       VirtualMachine::VmState  vm_state);
-private:
-
-    struct VmStates
-    {
-        VmStates(VirtualMachine::LcmState _lcm, VirtualMachine::VmState _vm):
-            lcm(_lcm), vm(_vm){};
-
-        VirtualMachine::LcmState lcm;
-        VirtualMachine::VmState  vm;
-    };
-
-    /**
-     *  The state Map for the VMs
-     */
-    static map<int,VmStates> vm_states;
-};
-
 /**
  *  This class is a general VM State Hook that executes a command locally or
- *  remotelly when the VM gets into a given state (one shot). The VirtualMachine
- *  object is looked when the hook is invoked.
+ *  remotelly when the VM gets into a given state (one shot). State hooks are
+ *  not added to the pool, they are invoked by the VirtualMachineUpdateStateHook
+ *  when a VM enters their state.
  */
-class VirtualMachineStateHook : public VirtualMachineStateMapHook
+class VirtualMachineStateHook : public Hook
 {
 public:
     // -------------------------------------------------------------------------
@@ -109,25 +51,47 @@ public:
                             bool                     remote,
                             VirtualMachine::LcmState _lcm,
                             VirtualMachine::VmState  _vm):
-        VirtualMachineStateMapHook(name,cmd,args,remote), lcm(_lcm), vm(_vm){};
+        Hook(name, cmd, args, Hook::UPDATE | Hook::ALLOCATE, remote),
+        lcm(_lcm), vm(_vm){};
 
     ~VirtualMachineStateHook(){};
 
     // -------------------------------------------------------------------------
     // Hook methods
     // -------------------------------------------------------------------------
-    void do_hook(void *arg);
+    /**
+     *  State hooks are executed through execute(), when the VM state changes
+     */
+    void do_hook(void *arg){};
 
     /**
-     *  Parses the arguments of the hook using: $ID, $TEMPLATE, $PREV_DM_STATE
-     *  and $PREV_LCM_STATE
-     *    @param obj pointer to the object executing the hook for
-     *    @param the resulting parser arguments
+     *  Executes the hook for a VM that has just entered the hook state. The
+     *  arguments are parsed using: $ID, $TEMPLATE, $PREV_STATE and
+     *  $PREV_LCM_STATE
+     *    @param vm the VirtualMachine, it MUST be locked
+     *    @param prev_dm previous state of the VM
+     *    @param prev_lcm previous LCM state of the VM
      */
-    void parse_hook_arguments(PoolObjectSQL *          obj,
-                              VirtualMachine::VmState  prev_dm,
-                              VirtualMachine::LcmState prev_lcm,
-                              string&                  parsed);
+    void execute(VirtualMachine *         vm,
+                 VirtualMachine::VmState  prev_dm,
+                 VirtualMachine::LcmState prev_lcm);
+
+    /**
+     *  @return the target LCM state
+     */
+    VirtualMachine::LcmState get_lcm_state() const
+    {
+        return lcm;
+    };
+
+    /**
+     *  @return the target DM state
+     */
+    VirtualMachine::VmState get_state() const
+    {
+        return vm;
+    };
+
 private:
     /**
      *  The target LCM state
@@ -141,23 +105,84 @@ private:
 };
 
 /**
- *  This class implements a state Map updater, one hook of this type should be
- *  added in order to mantain the VM state map.
+ *  This class keeps the state of the VMs and dispatches the state hooks. One
+ *  hook of this type should be added, with the state hooks registered in it.
+ *  The hooks are indexed by (state, lcm_state), so only those that match the
+ *  new state of a VM are evaluated.
  */
-class VirtualMachineUpdateStateHook : public VirtualMachineStateMapHook
+class VirtualMachineUpdateStateHook : public Hook
 {
 public:
     // -------------------------------------------------------------------------
     // -------------------------------------------------------------------------
     VirtualMachineUpdateStateHook():
-        VirtualMachineStateMapHook("","","",false){};
+        Hook("","","",Hook::UPDATE | Hook::ALLOCATE,false)
+    {
+        pthread_mutex_init(&mutex, 0);
+    };
+
+    ~VirtualMachineUpdateStateHook();
+
+    /**
+     *  Registers a state hook
+     *    @param hook pointer to the hook, MUST be allocated in the HEAP. It
+     *    will be freed by this object
+     */
+    void add_state_hook(VirtualMachineStateHook * hook);
 
-    ~VirtualMachineUpdateStateHook(){};
+    /**
+     *  @return true if there are no state hooks registered
+     */
+    bool empty() const
+    {
+        return state_hooks.empty();
+    };
 
     // -------------------------------------------------------------------------
     // Hook methods
     // -------------------------------------------------------------------------
     void do_hook(void *arg);
+
+private:
+
+    struct VmStates
+    {
+        VmStates(VirtualMachine::LcmState _lcm, VirtualMachine::VmState _vm):
+            lcm(_lcm), vm(_vm){};
+
+        VirtualMachine::LcmState lcm;
+        VirtualMachine::VmState  vm;
+    };
+
+    /**
+     *  The state Map for the VMs
+     */
+    map<int,VmStates> vm_states;
+
+    /**
+     *  The state hooks, indexed by (state, lcm_state)
+     */
+    multimap<pair<int,int>, VirtualMachineStateHook *> state_hooks;
+
+    /**
+     *  Mutex for the state map, VMs are updated concurrently
+     */
+    pthread_mutex_t mutex;
+
+    /**
+     *  Updates the state associated to the VM
+     *    @param id of the VM
+     *    @param lcm_state (current) of the VM
+     *    @param vm_state (current) of the VM
+     *    @param prev_lcm previous LCM state of the VM
+     *    @param prev_vm previous state of the VM
+     *    @return 0 if the previous state for the VM has been recorded
+     */
+    int update_state(int                       id,
+                     VirtualMachine::LcmState  lcm_state,
+                     VirtualMachine::VmState   vm_state,
+                     VirtualMachine::LcmState& prev_lcm,
+                     VirtualMachine::VmState&  prev_vm);
 };
 
 #endif
@@ -160,6 +160,18 @@ public:
         return vm->update_previous_history(db);
     }
 
+    /**
+     *  Reads the complete set of history records of a VM, the vm's mutex
+     *  SHOULD be locked
+     *    @param vm pointer to the virtual machine object
+     *    @return 0 on success
+     */
+    int select_history(
+        VirtualMachine * vm)
+    {
+        return vm->select_history(db);
+    }
+
     /**
      * Inserts the last monitoring, and deletes old monitoring entries for this
      * VM
@@ -285,7 +297,8 @@ public:
 
     /**
      * Processes all the history records, and stores the monthly cost for each
-     * VM
+     * VM. If the start month is unset, only the records open or closed after
+     * the month of the last run are processed.
      *  @param start_month First month (+year) to process. January is 1.
      *  Use -1 to unset
      *  @param start_year First year (+month) to process. e.g. 2014.
@@ -329,6 +342,62 @@ private:
      * Callback used in calculate_showback
      */
     int min_stime_cb(void * _min_stime, int num, char **values, char **names);
+
+    /**
+     * Callback used in calculate_showback, to read the history records
+     */
+    int showback_cb(void * _records, int num, char **values, char **names);
+
+    /**
+     *  Name of the system attribute that stores the time of the last
+     *  showback run
+     */
+    static const char * showback_attr;
+
+    /**
+     *  Number of history records read in each query by calculate_showback
+     */
+    static const int SHOWBACK_PAGE_SIZE;
+
+    /**
+     *  Number of showback records written in each REPLACE statement
+     */
+    static const int SHOWBACK_BATCH_SIZE;
+
+    /**
+     *  Gets the time of the last showback run
+     *    @return the time, or -1 if showback has not been computed yet
+     */
+    time_t get_showback_last_run();
+
+    /**
+     *  Stores the time of the last showback run
+     *    @param last_run the time
+     *    @return 0 on success
+     */
+    int set_showback_last_run(time_t last_run);
+
+    /**
+     *  Adds the showback records of a VM to the current REPLACE statement,
+     *  the statement is executed every SHOWBACK_BATCH_SIZE records. The
+     *  totals of the VM are reset.
+     *    @param vid of the VM, -1 to do nothing
+     *    @param slots the monthly time slots
+     *    @param totals per slot <total_cost, n_hours>
+     *    @param used slots with a total for this VM
+     *    @param oss the REPLACE statement
+     *    @param n_entries number of records in the statement
+     *    @param error_str Returns the error reason, if any
+     *    @return 0 on success
+     */
+    int add_showback(
+            int                              vid,
+            const vector<time_t>&            slots,
+            vector<pair<float, float> >&     totals,
+            vector<bool>&                    used,
+            ostringstream&                   oss,
+            int&                             n_entries,
+            string&                          error_str);
 };
 
 #endif /*VIRTUAL_MACHINE_POOL_H_*/
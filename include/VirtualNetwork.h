@@ -109,6 +109,8 @@ public:
      */
     int add_ar(AddressRange * rar)
     {
+        invalidate_security_rules();
+
         return ar_pool.add_ar(rar);
     }
 
@@ -540,6 +542,20 @@ private:
      */
     int insert(SqlDB * db, string& error_str);
 
+    /**
+     *  Drops the Virtual Network from the database, the security group rules
+     *  expanded with its address ranges are invalidated
+     *    @param db pointer to the db
+     *    @return 0 on success
+     */
+    int drop(SqlDB * db);
+
+    /**
+     *  Invalidates the security group rules expanded with the address ranges
+     *  of this network. Called each time the address ranges change.
+     */
+    void invalidate_security_rules();
+
     /**
      *  Writes/updates the Virtual Network data fields in the database.
      *    @param db pointer to the db
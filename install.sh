@@ -1219,11 +1219,14 @@ ONEDB_SHARED_MIGRATOR_FILES="src/onedb/shared/2.0_to_2.9.80.rb \
                              src/onedb/shared/4.3.90_to_4.4.0.rb \
                              src/onedb/shared/4.4.0_to_4.4.1.rb \
                              src/onedb/shared/4.4.1_to_4.5.80.rb\
-                             src/onedb/shared/4.5.80_to_4.6.0.rb"
+                             src/onedb/shared/4.5.80_to_4.6.0.rb \
+                             src/onedb/shared/4.6.0_to_4.11.80.rb \
+                             src/onedb/shared/4.11.80_to_4.11.85.rb"
 
 ONEDB_LOCAL_MIGRATOR_FILES="src/onedb/local/4.5.80_to_4.7.80.rb \
                             src/onedb/local/4.7.80_to_4.9.80.rb \
-                            src/onedb/local/4.9.80_to_4.11.80.rb"
+                            src/onedb/local/4.9.80_to_4.11.80.rb \
+                            src/onedb/local/4.11.80_to_4.11.85.rb"
 
 #-------------------------------------------------------------------------------
 # Configuration files for OpenNebula, to be installed under $ETC_LOCATION
@@ -51,9 +51,10 @@ int AclManager::init_cb(void *nil, int num, char **values, char **names)
 AclManager::AclManager(
     SqlDB * _db,
     int     _zone_id,
+    bool    _is_federation_enabled,
     bool    _is_federation_slave,
     time_t  _timer_period)
-        :zone_id(_zone_id), db(_db), lastOID(-1),
+        :zone_id(_zone_id), db(_db), lastOID(-1), change_log(0), last_seq(0),
         is_federation_slave(_is_federation_slave), timer_period(_timer_period)
 {
     ostringstream oss;
@@ -71,6 +72,11 @@ AclManager::AclManager(
 
     am.addListener(this);
 
+    if (_is_federation_enabled)
+    {
+        change_log = new ChangeLog(db, table);
+    }
+
     //Federation slaves do not need to init the pool
     if (is_federation_slave)
     {
@@ -189,6 +195,8 @@ AclManager::~AclManager()
     unlock();
 
     pthread_mutex_destroy(&mutex);
+
+    delete change_log;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -576,6 +584,11 @@ int AclManager::add_rule(long long user, long long resource, long long rights,
 
     update_lastOID();
 
+    if ( change_log != 0 )
+    {
+        change_log->log(rule->oid);
+    }
+
     unlock();
 
     return lastOID;
@@ -691,6 +704,11 @@ int AclManager::del_rule(int oid, string& error_str)
         return -1;
     }
 
+    if ( change_log != 0 )
+    {
+        change_log->log(oid);
+    }
+
     rule = it->second;
 
     acl_rules.erase( it );
@@ -1078,8 +1096,10 @@ void AclManager::update_lastOID()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int AclManager::select_cb(void *nil, int num, char **values, char **names)
+int AclManager::select_cb(void *_rules, int num, char **values, char **names)
 {
+    map<int, AclRule *> * rules = static_cast<map<int, AclRule *> *>(_rules);
+
     if ( (num != 5)   ||
          (!values[0]) ||
          (!values[1]) ||
@@ -1095,7 +1115,7 @@ int AclManager::select_cb(void *nil, int num, char **values, char **names)
 
     int oid = atoi(values[0]);
 
-    long long rule_values[3];
+    long long rule_values[4];
 
     for ( int i = 0; i < 4; i++ )
     {
@@ -1120,8 +1140,7 @@ int AclManager::select_cb(void *nil, int num, char **values, char **names)
     oss << "Loading ACL Rule " << rule->to_str();
     NebulaLog::log("ACL",Log::DDEBUG,oss);
 
-    acl_rules.insert( make_pair(rule->user, rule) );
-    acl_rules_oids.insert( make_pair(rule->oid, rule) );
+    rules->insert( make_pair(rule->oid, rule) );
 
     return 0;
 }
@@ -1134,22 +1153,178 @@ int AclManager::select()
     ostringstream   oss;
     int             rc;
 
+    map<int, AclRule *>            tmp_oids;
+    multimap<long long, AclRule *> tmp_rules;
+
+    map<int, AclRule *>::iterator  it;
+
+    // Changes done while the rules are loaded will be applied again by reload
+    if ( is_federation_slave && change_log != 0 )
+    {
+        change_log->get_last(last_seq);
+    }
+
     oss << "SELECT " << db_names << " FROM " << table;
 
-    set_callback(static_cast<Callbackable::Callback>(&AclManager::select_cb));
+    set_callback(static_cast<Callbackable::Callback>(&AclManager::select_cb),
+                 static_cast<void *>(&tmp_oids));
+
+    rc = db->exec(oss,this);
+
+    unset_callback();
+
+    if ( rc != 0 )
+    {
+        for ( it = tmp_oids.begin(); it != tmp_oids.end(); it++ )
+        {
+            delete it->second;
+        }
+
+        return rc;
+    }
+
+    for ( it = tmp_oids.begin(); it != tmp_oids.end(); it++ )
+    {
+        tmp_rules.insert( make_pair(it->second->user, it->second) );
+    }
 
     lock();
 
-    acl_rules.clear();
-    acl_rules_oids.clear();
+    acl_rules.swap(tmp_rules);
+    acl_rules_oids.swap(tmp_oids);
+
+    unlock();
+
+    // tmp_oids holds now the previous rule set
+    for ( it = tmp_oids.begin(); it != tmp_oids.end(); it++ )
+    {
+        delete it->second;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int AclManager::reload()
+{
+    ostringstream   oss;
+    int             rc;
+
+    map<int, long long>            changes;
+    map<int, long long>::iterator  ch_it;
+
+    map<int, AclRule *>            tmp_oids;
+    map<int, AclRule *>::iterator  it;
+
+    multimap<long long, AclRule *>::iterator        rit;
+    pair<multimap<long long, AclRule *>::iterator,
+         multimap<long long, AclRule *>::iterator>  index;
+
+    vector<AclRule *>              old_rules;
+    vector<AclRule *>::iterator    old_it;
+
+    long long seq = last_seq;
+
+    if ( change_log == 0 )
+    {
+        return select();
+    }
+
+    rc = change_log->get_changes(last_seq, changes);
+
+    if ( rc != 0 || changes.empty() )
+    {
+        return rc;
+    }
+
+    oss << "SELECT " << db_names << " FROM " << table << " WHERE oid IN (";
+
+    for ( ch_it = changes.begin(); ch_it != changes.end(); ch_it++ )
+    {
+        if ( ch_it != changes.begin() )
+        {
+            oss << ",";
+        }
+
+        oss << ch_it->first;
+
+        if ( ch_it->second > seq )
+        {
+            seq = ch_it->second;
+        }
+    }
+
+    oss << ")";
+
+    set_callback(static_cast<Callbackable::Callback>(&AclManager::select_cb),
+                 static_cast<void *>(&tmp_oids));
 
     rc = db->exec(oss,this);
 
+    unset_callback();
+
+    if ( rc != 0 )
+    {
+        for ( it = tmp_oids.begin(); it != tmp_oids.end(); it++ )
+        {
+            delete it->second;
+        }
+
+        return rc;
+    }
+
+    // Changed rules are removed, and loaded again unless they were deleted
+    lock();
+
+    for ( ch_it = changes.begin(); ch_it != changes.end(); ch_it++ )
+    {
+        it = acl_rules_oids.find(ch_it->first);
+
+        if ( it != acl_rules_oids.end() )
+        {
+            index = acl_rules.equal_range( it->second->user );
+
+            for ( rit = index.first; rit != index.second; rit++ )
+            {
+                if ( rit->second == it->second )
+                {
+                    acl_rules.erase(rit);
+                    break;
+                }
+            }
+
+            old_rules.push_back(it->second);
+
+            acl_rules_oids.erase(it);
+        }
+
+        it = tmp_oids.find(ch_it->first);
+
+        if ( it != tmp_oids.end() )
+        {
+            acl_rules.insert( make_pair(it->second->user, it->second) );
+            acl_rules_oids.insert( make_pair(it->second->oid, it->second) );
+        }
+    }
+
     unlock();
 
-    unset_callback();
+    last_seq = seq;
 
-    return rc;
+    for ( old_it = old_rules.begin(); old_it != old_rules.end(); old_it++ )
+    {
+        delete *old_it;
+    }
+
+    oss.str("");
+
+    oss << "Reloaded " << changes.size() << " changed ACL rules";
+
+    NebulaLog::log("ACL",Log::DEBUG,oss);
+
+    return 0;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -1222,7 +1397,7 @@ void AclManager::do_action(const string &action, void * arg)
 {
     if (action == ACTION_TIMER)
     {
-        select();
+        reload();
     }
     else if (action == ACTION_FINALIZE)
     {
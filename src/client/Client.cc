@@ -28,6 +28,7 @@
 #include <sstream>
 
 #include <unistd.h>
+#include <stdarg.h>
 #include <sys/types.h>
 
 /* -------------------------------------------------------------------------- */
@@ -135,3 +136,148 @@ void Client::set_one_endpoint(string endpoint)
 
 
 
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+Client::~Client()
+{
+    vector<Connection *>::iterator it;
+
+    for (it = connections.begin(); it != connections.end(); it++)
+    {
+        delete *it;
+    }
+
+    pthread_mutex_destroy(&mutex);
+
+    pthread_cond_destroy(&cond);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+Client::Connection * Client::get_connection()
+{
+    Connection * connection = 0;
+
+    pthread_mutex_lock(&mutex);
+
+    while (connections.empty() && num_connections >= max_connections)
+    {
+        pthread_cond_wait(&cond, &mutex);
+    }
+
+    if (!connections.empty())
+    {
+        connection = connections.back();
+
+        connections.pop_back();
+    }
+    else
+    {
+        num_connections++;
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    if ( connection == 0 ) // Create the connection out of the lock
+    {
+        connection = new Connection();
+    }
+
+    return connection;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void Client::release_connection(Connection * connection)
+{
+    pthread_mutex_lock(&mutex);
+
+    connections.push_back(connection);
+
+    pthread_cond_signal(&cond);
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Client::call(const string& endpoint, const string& method,
+        const xmlrpc_c::paramList& plist, xmlrpc_c::value * const result)
+{
+    xmlrpc_c::carriageParm_curl0 carriage(endpoint);
+    xmlrpc_c::rpcPtr             rpc(method, plist);
+
+    Connection * connection = get_connection();
+
+    try
+    {
+        rpc->call(&(connection->client), &carriage);
+    }
+    catch (...)
+    {
+        release_connection(connection);
+        throw;
+    }
+
+    release_connection(connection);
+
+    *result = rpc->getResult();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void Client::call(const string& endpoint, const string& method,
+        const string& format, xmlrpc_c::value * const result, ...)
+{
+    va_list        args;
+    xmlrpc_env     env;
+    xmlrpc_value * array;
+    const char *   tail;
+
+    xmlrpc_c::paramList plist;
+
+    string array_format = "(" + format + ")";
+
+    xmlrpc_env_init(&env);
+
+    va_start(args, result);
+
+    xmlrpc_build_value_va(&env, array_format.c_str(), args, &array, &tail);
+
+    va_end(args);
+
+    if (env.fault_occurred)
+    {
+        string error = env.fault_string;
+
+        xmlrpc_env_clean(&env);
+
+        throw runtime_error("Wrong arguments for " + method + ": " + error);
+    }
+
+    int num = xmlrpc_array_size(&env, array);
+
+    for (int i = 0; i < num && !env.fault_occurred; i++)
+    {
+        xmlrpc_value * param;
+
+        xmlrpc_array_read_item(&env, array, i, &param);
+
+        if (!env.fault_occurred)
+        {
+            plist.add(xmlrpc_c::value(param));
+
+            xmlrpc_DECREF(param);
+        }
+    }
+
+    xmlrpc_DECREF(array);
+
+    xmlrpc_env_clean(&env);
+
+    call(endpoint, method, plist, result);
+}
@@ -34,6 +34,24 @@ const char * Cluster::db_bootstrap = "CREATE TABLE IF NOT EXISTS cluster_pool ("
     "gid INTEGER, owner_u INTEGER, group_u INTEGER, other_u INTEGER, "
     "UNIQUE(name))";
 
+const char * Cluster::hosts_table = "cluster_hosts";
+
+const char * Cluster::hosts_db_bootstrap = "CREATE TABLE IF NOT EXISTS "
+    "cluster_hosts (cluster_oid INTEGER, host_oid INTEGER, "
+    "PRIMARY KEY(cluster_oid, host_oid))";
+
+const char * Cluster::datastores_table = "cluster_datastores";
+
+const char * Cluster::datastores_db_bootstrap = "CREATE TABLE IF NOT EXISTS "
+    "cluster_datastores (cluster_oid INTEGER, datastore_oid INTEGER, "
+    "PRIMARY KEY(cluster_oid, datastore_oid))";
+
+const char * Cluster::vnets_table = "cluster_vnets";
+
+const char * Cluster::vnets_db_bootstrap = "CREATE TABLE IF NOT EXISTS "
+    "cluster_vnets (cluster_oid INTEGER, vnet_oid INTEGER, "
+    "PRIMARY KEY(cluster_oid, vnet_oid))";
+
 /* ************************************************************************** */
 /* Cluster :: Constructor/Destructor                                          */
 /* ************************************************************************** */
@@ -43,10 +61,15 @@ Cluster::Cluster(
         const string& name,
         ClusterTemplate*  cl_template):
             PoolObjectSQL(id,CLUSTER,name,-1,-1,"","",table),
-            hosts("HOSTS"),
-            datastores("DATASTORES"),
-            vnets("VNETS")
+            hosts("HOSTS", hosts_table, "cluster_oid", "host_oid"),
+            datastores("DATASTORES", datastores_table, "cluster_oid",
+                       "datastore_oid"),
+            vnets("VNETS", vnets_table, "cluster_oid", "vnet_oid")
 {
+    collections.push_back(&hosts);
+    collections.push_back(&datastores);
+    collections.push_back(&vnets);
+
     if (cl_template != 0)
     {
         obj_template = cl_template;
@@ -208,7 +231,7 @@ int Cluster::insert_replace(SqlDB *db, bool replace, string& error_str)
         goto error_name;
     }
 
-    sql_xml = db->escape_str(to_xml(xml_body).c_str());
+    sql_xml = db->escape_str(to_xml(xml_body, false).c_str());
 
     if ( sql_xml == 0 )
     {
@@ -273,7 +296,7 @@ error_common:
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-string& Cluster::to_xml(string& xml) const
+string& Cluster::to_xml(string& xml, bool with_collections) const
 {
     ostringstream   oss;
     string          host_collection_xml;
@@ -281,13 +304,26 @@ string& Cluster::to_xml(string& xml) const
     string          vnet_collection_xml;
     string          template_xml;
 
+    if ( with_collections )
+    {
+        hosts.to_xml(host_collection_xml);
+        datastores.to_xml(ds_collection_xml);
+        vnets.to_xml(vnet_collection_xml);
+    }
+    else
+    {
+        hosts.to_xml_db(host_collection_xml);
+        datastores.to_xml_db(ds_collection_xml);
+        vnets.to_xml_db(vnet_collection_xml);
+    }
+
     oss <<
     "<CLUSTER>"  <<
         "<ID>"          << oid          << "</ID>"          <<
         "<NAME>"        << name         << "</NAME>"        <<
-        hosts.to_xml(host_collection_xml)    <<
-        datastores.to_xml(ds_collection_xml) <<
-        vnets.to_xml(vnet_collection_xml)    <<
+        host_collection_xml                  <<
+        ds_collection_xml                    <<
+        vnet_collection_xml                  <<
         obj_template->to_xml(template_xml)   <<
     "</CLUSTER>";
 
@@ -317,54 +353,6 @@ int Cluster::from_xml(const string& xml)
     // Set the Cluster ID as the cluster it belongs to
     set_group(oid, name);
 
-    // -------------------------------------------------------------------------
-    // Get associated hosts
-    // -------------------------------------------------------------------------
-    ObjectXML::get_nodes("/CLUSTER/HOSTS", content);
-
-    if (content.empty())
-    {
-        return -1;
-    }
-
-    // Set of IDs
-    rc += hosts.from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
-    content.clear();
-
-    // -------------------------------------------------------------------------
-    // Get associated datastores
-    // -------------------------------------------------------------------------
-    ObjectXML::get_nodes("/CLUSTER/DATASTORES", content);
-
-    if (content.empty())
-    {
-        return -1;
-    }
-
-    // Set of IDs
-    rc += datastores.from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
-    content.clear();
-
-    // -------------------------------------------------------------------------
-    // Get associated vnets
-    // -------------------------------------------------------------------------
-    ObjectXML::get_nodes("/CLUSTER/VNETS", content);
-
-    if (content.empty())
-    {
-        return -1;
-    }
-
-    // Set of IDs
-    rc += vnets.from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
-    content.clear();
-
     // Get associated classes
     ObjectXML::get_nodes("/CLUSTER/TEMPLATE", content);
 
@@ -0,0 +1,619 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "NebulaUtil.h"
+
+#include <string>
+
+/* -------------------------------------------------------------------------- */
+/* Vector implementations are only built for x86 with a compiler supporting   */
+/* per-function target attributes (GCC >= 4.9, clang). The scalar codec is    */
+/* used everywhere else and for the tail of each buffer.                      */
+/* -------------------------------------------------------------------------- */
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (__GNUC__ > 4) || \
+     (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define BASE64_SIMD
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/* -------------------------------------------------------------------------- */
+/* Scalar codec                                                               */
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+    const char ENCODE_TABLE[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    /* Decode table values: 0-63 alphabet, B64_WS whitespace (skipped),     */
+    /* B64_PAD padding and B64_BAD for any other character                  */
+    const unsigned char B64_BAD = 0xFF;
+    const unsigned char B64_WS  = 0xFE;
+    const unsigned char B64_PAD = 0xFD;
+
+    class DecodeTable
+    {
+    public:
+        DecodeTable()
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                table[i] = B64_BAD;
+            }
+
+            for (int i = 0; i < 64; i++)
+            {
+                table[(unsigned char) ENCODE_TABLE[i]] = i;
+            }
+
+            table[(unsigned char) ' ']  = B64_WS;
+            table[(unsigned char) '\t'] = B64_WS;
+            table[(unsigned char) '\r'] = B64_WS;
+            table[(unsigned char) '\n'] = B64_WS;
+
+            table[(unsigned char) '='] = B64_PAD;
+        };
+
+        unsigned char table[256];
+    };
+
+    const DecodeTable DECODE;
+
+    /* ---------------------------------------------------------------------- */
+
+    size_t encode_scalar(const unsigned char * in, size_t len, char * out)
+    {
+        char * start = out;
+        size_t i;
+
+        for (i = 0; i + 3 <= len; i += 3)
+        {
+            unsigned int v = (in[i] << 16) | (in[i+1] << 8) | in[i+2];
+
+            *out++ = ENCODE_TABLE[(v >> 18) & 0x3F];
+            *out++ = ENCODE_TABLE[(v >> 12) & 0x3F];
+            *out++ = ENCODE_TABLE[(v >> 6)  & 0x3F];
+            *out++ = ENCODE_TABLE[v & 0x3F];
+        }
+
+        switch (len - i)
+        {
+            case 1:
+            {
+                unsigned int v = in[i] << 16;
+
+                *out++ = ENCODE_TABLE[(v >> 18) & 0x3F];
+                *out++ = ENCODE_TABLE[(v >> 12) & 0x3F];
+                *out++ = '=';
+                *out++ = '=';
+                break;
+            }
+            case 2:
+            {
+                unsigned int v = (in[i] << 16) | (in[i+1] << 8);
+
+                *out++ = ENCODE_TABLE[(v >> 18) & 0x3F];
+                *out++ = ENCODE_TABLE[(v >> 12) & 0x3F];
+                *out++ = ENCODE_TABLE[(v >> 6)  & 0x3F];
+                *out++ = '=';
+                break;
+            }
+        }
+
+        return out - start;
+    }
+
+    /* ---------------------------------------------------------------------- */
+
+    /**
+     *  Decodes in to out, whitespace is ignored and decoding stops at the
+     *  first padding character.
+     *    @return 0 on success -1 if a invalid character or a truncated
+     *    quantum is found
+     */
+    int decode_scalar(const unsigned char * in, size_t len, char * out,
+            size_t& out_len)
+    {
+        unsigned int  acc = 0;
+        int           n   = 0;
+        size_t        i;
+
+        out_len = 0;
+
+        for (i = 0; i < len; i++)
+        {
+            unsigned char c = DECODE.table[in[i]];
+
+            if ( c < 64 )
+            {
+                acc = (acc << 6) | c;
+
+                if ( ++n == 4 )
+                {
+                    out[out_len++] = (acc >> 16) & 0xFF;
+                    out[out_len++] = (acc >> 8)  & 0xFF;
+                    out[out_len++] = acc & 0xFF;
+
+                    acc = 0;
+                    n   = 0;
+                }
+            }
+            else if ( c == B64_PAD )
+            {
+                break;
+            }
+            else if ( c != B64_WS )
+            {
+                return -1;
+            }
+        }
+
+        switch (n)
+        {
+            case 0:
+                break;
+
+            case 2:
+                out[out_len++] = (acc >> 4) & 0xFF;
+                break;
+
+            case 3:
+                out[out_len++] = (acc >> 10) & 0xFF;
+                out[out_len++] = (acc >> 2)  & 0xFF;
+                break;
+
+            default:
+                return -1;
+        }
+
+        for (; i < len; i++) //Only padding or whitespace after padding
+        {
+            unsigned char c = DECODE.table[in[i]];
+
+            if ( c != B64_PAD && c != B64_WS )
+            {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* SSSE3 & AVX2 codecs. Both process the input in blocks (12->16 bytes for    */
+/* SSSE3 and 24->32 for AVX2) and return the number of input bytes consumed,  */
+/* the remaining data is handled by the scalar codec. Decoding stops at the   */
+/* first block with a non-alphabet character (padding, whitespace...)         */
+/* -------------------------------------------------------------------------- */
+
+#ifdef BASE64_SIMD
+
+namespace
+{
+    /* ------------------------------ SSSE3 --------------------------------- */
+
+    __attribute__((target("ssse3")))
+    inline __m128i enc_reshuffle_128(__m128i in)
+    {
+        in = _mm_shuffle_epi8(in, _mm_set_epi8(
+                10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+        const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+        const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+        const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+
+        return _mm_or_si128(t1, t3);
+    }
+
+    __attribute__((target("ssse3")))
+    inline __m128i enc_translate_128(const __m128i in)
+    {
+        const __m128i lut = _mm_setr_epi8(
+                'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                '/' - 63, 'A', 0, 0);
+
+        __m128i idx = _mm_subs_epu8(in, _mm_set1_epi8(51));
+        __m128i lt  = _mm_cmpgt_epi8(_mm_set1_epi8(26), in);
+
+        idx = _mm_or_si128(idx, _mm_and_si128(lt, _mm_set1_epi8(13)));
+
+        return _mm_add_epi8(_mm_shuffle_epi8(lut, idx), in);
+    }
+
+    __attribute__((target("ssse3")))
+    size_t encode_ssse3(const unsigned char * in, size_t len, char * out)
+    {
+        size_t i = 0;
+
+        // 16 bytes are loaded for each 12 bytes block
+        for (; i + 16 <= len; i += 12, out += 16)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+
+            v = enc_translate_128(enc_reshuffle_128(v));
+
+            _mm_storeu_si128((__m128i *) out, v);
+        }
+
+        return i;
+    }
+
+    __attribute__((target("ssse3")))
+    inline bool dec_translate_128(__m128i& v)
+    {
+        const __m128i hi_nibble = _mm_and_si128(_mm_srli_epi32(v, 4),
+                _mm_set1_epi8(0x0f));
+
+        const __m128i lower_lut = _mm_setr_epi8(1, 1, 0x2b, 0x30, 0x41, 0x50,
+                0x61, 0x70, 1, 1, 1, 1, 1, 1, 1, 1);
+        const __m128i upper_lut = _mm_setr_epi8(0, 0, 0x2b, 0x39, 0x4f, 0x5a,
+                0x6f, 0x7a, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i shift_lut = _mm_setr_epi8(0, 0, 0x3e - 0x2b,
+                0x34 - 0x30, 0x00 - 0x41, 0x0f - 0x50, 0x1a - 0x61,
+                0x29 - 0x70, 0, 0, 0, 0, 0, 0, 0, 0);
+
+        const __m128i lower = _mm_shuffle_epi8(lower_lut, hi_nibble);
+        const __m128i upper = _mm_shuffle_epi8(upper_lut, hi_nibble);
+        const __m128i slash = _mm_cmpeq_epi8(v, _mm_set1_epi8(0x2f));
+
+        const __m128i outside = _mm_andnot_si128(slash, _mm_or_si128(
+                _mm_cmplt_epi8(v, lower), _mm_cmpgt_epi8(v, upper)));
+
+        if ( _mm_movemask_epi8(outside) != 0 )
+        {
+            return false;
+        }
+
+        v = _mm_add_epi8(v, _mm_shuffle_epi8(shift_lut, hi_nibble));
+        v = _mm_add_epi8(v, _mm_and_si128(slash, _mm_set1_epi8(-3)));
+
+        return true;
+    }
+
+    __attribute__((target("ssse3")))
+    inline __m128i dec_pack_128(__m128i v)
+    {
+        v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+        v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+
+        return _mm_shuffle_epi8(v, _mm_setr_epi8(
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    }
+
+    __attribute__((target("ssse3")))
+    size_t decode_ssse3(const unsigned char * in, size_t len, char * out,
+            size_t& out_len)
+    {
+        size_t i = 0;
+
+        out_len = 0;
+
+        // 16 bytes are stored for each 12 bytes block, keep the last 8 input
+        // bytes (6 decoded) for the scalar codec so out is not overflowed
+        for (; i + 24 <= len; i += 16, out_len += 12)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+
+            if (!dec_translate_128(v))
+            {
+                break;
+            }
+
+            _mm_storeu_si128((__m128i *) (out + out_len), dec_pack_128(v));
+        }
+
+        return i;
+    }
+
+    /* ------------------------------- AVX2 --------------------------------- */
+
+    __attribute__((target("avx2")))
+    size_t encode_avx2(const unsigned char * in, size_t len, char * out)
+    {
+        const __m256i shuf = _mm256_setr_epi8(
+                1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+        const __m256i lut = _mm256_setr_epi8(
+                'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                '/' - 63, 'A', 0, 0,
+                'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                '/' - 63, 'A', 0, 0);
+
+        size_t i = 0;
+
+        // Two 16 bytes loads (at i and i+12) for each 24 bytes block
+        for (; i + 28 <= len; i += 24, out += 32)
+        {
+            __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                    _mm_loadu_si128((const __m128i *) (in + i))),
+                    _mm_loadu_si128((const __m128i *) (in + i + 12)), 1);
+
+            v = _mm256_shuffle_epi8(v, shuf);
+
+            const __m256i t0 = _mm256_and_si256(v,_mm256_set1_epi32(0x0fc0fc00));
+            const __m256i t1 = _mm256_mulhi_epu16(t0,
+                    _mm256_set1_epi32(0x04000040));
+            const __m256i t2 = _mm256_and_si256(v,_mm256_set1_epi32(0x003f03f0));
+            const __m256i t3 = _mm256_mullo_epi16(t2,
+                    _mm256_set1_epi32(0x01000010));
+
+            v = _mm256_or_si256(t1, t3);
+
+            __m256i idx = _mm256_subs_epu8(v, _mm256_set1_epi8(51));
+            __m256i lt  = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), v);
+
+            idx = _mm256_or_si256(idx, _mm256_and_si256(lt,
+                    _mm256_set1_epi8(13)));
+
+            v = _mm256_add_epi8(_mm256_shuffle_epi8(lut, idx), v);
+
+            _mm256_storeu_si256((__m256i *) out, v);
+        }
+
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    size_t decode_avx2(const unsigned char * in, size_t len, char * out,
+            size_t& out_len)
+    {
+        const __m256i lower_lut = _mm256_setr_epi8(
+                1, 1, 0x2b, 0x30, 0x41, 0x50, 0x61, 0x70, 1, 1, 1, 1, 1, 1, 1, 1,
+                1, 1, 0x2b, 0x30, 0x41, 0x50, 0x61, 0x70, 1, 1, 1, 1, 1, 1, 1, 1);
+        const __m256i upper_lut = _mm256_setr_epi8(
+                0, 0, 0x2b, 0x39, 0x4f, 0x5a, 0x6f, 0x7a, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 0x2b, 0x39, 0x4f, 0x5a, 0x6f, 0x7a, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m256i shift_lut = _mm256_setr_epi8(
+                0, 0, 0x3e - 0x2b, 0x34 - 0x30, 0x00 - 0x41, 0x0f - 0x50,
+                0x1a - 0x61, 0x29 - 0x70, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 0x3e - 0x2b, 0x34 - 0x30, 0x00 - 0x41, 0x0f - 0x50,
+                0x1a - 0x61, 0x29 - 0x70, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m256i pack = _mm256_setr_epi8(
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+        size_t i = 0;
+
+        out_len = 0;
+
+        // 32 bytes are stored for each 24 bytes block, keep the last 12 input
+        // bytes (9 decoded) for the scalar codec so out is not overflowed
+        for (; i + 44 <= len; i += 32, out_len += 24)
+        {
+            __m256i v = _mm256_loadu_si256((const __m256i *) (in + i));
+
+            const __m256i hi_nibble = _mm256_and_si256(
+                    _mm256_srli_epi32(v, 4), _mm256_set1_epi8(0x0f));
+
+            const __m256i lower = _mm256_shuffle_epi8(lower_lut, hi_nibble);
+            const __m256i upper = _mm256_shuffle_epi8(upper_lut, hi_nibble);
+            const __m256i slash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x2f));
+
+            const __m256i outside = _mm256_andnot_si256(slash, _mm256_or_si256(
+                    _mm256_cmpgt_epi8(lower, v), _mm256_cmpgt_epi8(v, upper)));
+
+            if ( _mm256_movemask_epi8(outside) != 0 )
+            {
+                break;
+            }
+
+            v = _mm256_add_epi8(v, _mm256_shuffle_epi8(shift_lut, hi_nibble));
+            v = _mm256_add_epi8(v, _mm256_and_si256(slash,
+                    _mm256_set1_epi8(-3)));
+
+            v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+            v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+            v = _mm256_shuffle_epi8(v, pack);
+            v = _mm256_permutevar8x32_epi32(v,
+                    _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+            _mm256_storeu_si256((__m256i *) (out + out_len), v);
+        }
+
+        return i;
+    }
+
+    /* ---------------------------------------------------------------------- */
+
+    enum SimdLevel
+    {
+        SIMD_NONE  = 0,
+        SIMD_SSSE3 = 1,
+        SIMD_AVX2  = 2
+    };
+
+    SimdLevel detect_simd()
+    {
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return SIMD_AVX2;
+        }
+        else if (__builtin_cpu_supports("ssse3"))
+        {
+            return SIMD_SSSE3;
+        }
+
+        return SIMD_NONE;
+    }
+
+    const SimdLevel SIMD_LEVEL = detect_simd();
+}
+
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* Public interface                                                           */
+/* -------------------------------------------------------------------------- */
+
+size_t one_util::base64_encode_size(size_t len)
+{
+    return ((len + 2) / 3) * 4;
+}
+
+/* -------------------------------------------------------------------------- */
+
+size_t one_util::base64_decode_size(size_t len)
+{
+    return ((len + 3) / 4) * 3;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+size_t one_util::base64_encode(const char * in, size_t len, char * out)
+{
+    const unsigned char * uin = reinterpret_cast<const unsigned char *>(in);
+
+    size_t i = 0;
+
+#ifdef BASE64_SIMD
+    switch (SIMD_LEVEL)
+    {
+        case SIMD_AVX2:
+            i = encode_avx2(uin, len, out);
+            break;
+
+        case SIMD_SSSE3:
+            i = encode_ssse3(uin, len, out);
+            break;
+
+        case SIMD_NONE:
+            break;
+    }
+#endif
+
+    size_t out_len = (i / 3) * 4;
+
+    return out_len + encode_scalar(uin + i, len - i, out + out_len);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int one_util::base64_decode(const char * in, size_t len, char * out,
+        size_t& out_len)
+{
+    const unsigned char * uin = reinterpret_cast<const unsigned char *>(in);
+
+    size_t i = 0;
+    size_t tail_len;
+
+    out_len = 0;
+
+#ifdef BASE64_SIMD
+    switch (SIMD_LEVEL)
+    {
+        case SIMD_AVX2:
+            i = decode_avx2(uin, len, out, out_len);
+            break;
+
+        case SIMD_SSSE3:
+            i = decode_ssse3(uin, len, out, out_len);
+            break;
+
+        case SIMD_NONE:
+            break;
+    }
+#endif
+
+    if ( decode_scalar(uin + i, len - i, out + out_len, tail_len) != 0 )
+    {
+        return -1;
+    }
+
+    out_len += tail_len;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void one_util::base64_encode(const string& in, string& out)
+{
+    out.resize(base64_encode_size(in.length()));
+
+    if ( out.empty() )
+    {
+        return;
+    }
+
+    base64_encode(in.data(), in.length(), &out[0]);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int one_util::base64_decode(const string& in, string& out)
+{
+    size_t out_len;
+
+    out.resize(base64_decode_size(in.length()));
+
+    if ( out.empty() )
+    {
+        return 0;
+    }
+
+    if ( base64_decode(in.data(), in.length(), &out[0], out_len) != 0 )
+    {
+        out.clear();
+        return -1;
+    }
+
+    out.resize(out_len);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+string * one_util::base64_encode(const string& in)
+{
+    string * encoded = new string;
+
+    base64_encode(in, *encoded);
+
+    return encoded;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+string * one_util::base64_decode(const string& in)
+{
+    string * decoded = new string;
+
+    if ( base64_decode(in, *decoded) != 0 )
+    {
+        delete decoded;
+        return 0;
+    }
+
+    return decoded;
+}
@@ -19,8 +19,6 @@
 #include <openssl/sha.h>
 #include <openssl/hmac.h>
 #include <openssl/evp.h>
-#include <openssl/bio.h>
-#include <openssl/buffer.h>
 #include <openssl/aes.h>
 
 #include <string>
@@ -77,81 +75,6 @@ string one_util::log_time()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-string * one_util::base64_encode(const string& in)
-{
-    BIO *     bio_mem;
-    BIO *     bio_64;
-
-    char *    encoded_c;
-    long int  size;
-
-    bio_64  = BIO_new(BIO_f_base64());
-    bio_mem = BIO_new(BIO_s_mem());
-
-    BIO_push(bio_64, bio_mem);
-
-    BIO_set_flags(bio_64, BIO_FLAGS_BASE64_NO_NL);
-
-    BIO_write(bio_64, in.c_str(), in.length());
-
-    if (BIO_flush(bio_64) != 1)
-    {
-        return 0;
-    }
-
-    size = BIO_get_mem_data(bio_mem,&encoded_c);
-
-    string * encoded = new string(encoded_c,size);
-
-    BIO_free_all(bio_64);
-
-    return encoded;
-}
-
-/* -------------------------------------------------------------------------- */
-/* -------------------------------------------------------------------------- */
-
-string * one_util::base64_decode(const string& in)
-{
-    BIO *  bio_mem_in;
-    BIO *  bio_mem_out;
-    BIO *  bio_64;
-
-    char inbuf[512];
-    int  inlen;
-
-    char *   decoded_c;
-    long int size;
-
-    bio_64  = BIO_new(BIO_f_base64());
-
-    bio_mem_in  = BIO_new(BIO_s_mem());
-    bio_mem_out = BIO_new(BIO_s_mem());
-
-    bio_64 = BIO_push(bio_64, bio_mem_in);
-
-    BIO_set_flags(bio_64, BIO_FLAGS_BASE64_NO_NL);
-
-    BIO_write(bio_mem_in, in.c_str(), in.length());
-
-    while((inlen = BIO_read(bio_64, inbuf, 512)) > 0)
-    {
-        BIO_write(bio_mem_out, inbuf, inlen);
-    }
-
-    size = BIO_get_mem_data(bio_mem_out, &decoded_c);
-
-    string * decoded = new string(decoded_c, size);
-
-    BIO_free_all(bio_64);
-    BIO_free_all(bio_mem_out);
-
-    return decoded;
-}
-
-/* -------------------------------------------------------------------------- */
-/* -------------------------------------------------------------------------- */
-
 string one_util::sha1_digest(const string& in)
 {
     EVP_MD_CTX     mdctx;
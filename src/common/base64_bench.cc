@@ -0,0 +1,309 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "NebulaUtil.h"
+
+#include <openssl/bio.h>
+#include <openssl/buffer.h>
+#include <openssl/evp.h>
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+using namespace std;
+
+/* -------------------------------------------------------------------------- */
+/* Reference implementation, previous one_util codec based on OpenSSL BIOs    */
+/* -------------------------------------------------------------------------- */
+
+static string * bio_base64_encode(const string& in)
+{
+    BIO *     bio_mem;
+    BIO *     bio_64;
+
+    char *    encoded_c;
+    long int  size;
+
+    bio_64  = BIO_new(BIO_f_base64());
+    bio_mem = BIO_new(BIO_s_mem());
+
+    BIO_push(bio_64, bio_mem);
+
+    BIO_set_flags(bio_64, BIO_FLAGS_BASE64_NO_NL);
+
+    BIO_write(bio_64, in.c_str(), in.length());
+
+    if (BIO_flush(bio_64) != 1)
+    {
+        return 0;
+    }
+
+    size = BIO_get_mem_data(bio_mem,&encoded_c);
+
+    string * encoded = new string(encoded_c,size);
+
+    BIO_free_all(bio_64);
+
+    return encoded;
+}
+
+static string * bio_base64_decode(const string& in)
+{
+    BIO *  bio_mem_in;
+    BIO *  bio_mem_out;
+    BIO *  bio_64;
+
+    char inbuf[512];
+    int  inlen;
+
+    char *   decoded_c;
+    long int size;
+
+    bio_64  = BIO_new(BIO_f_base64());
+
+    bio_mem_in  = BIO_new(BIO_s_mem());
+    bio_mem_out = BIO_new(BIO_s_mem());
+
+    bio_64 = BIO_push(bio_64, bio_mem_in);
+
+    BIO_set_flags(bio_64, BIO_FLAGS_BASE64_NO_NL);
+
+    BIO_write(bio_mem_in, in.c_str(), in.length());
+
+    while((inlen = BIO_read(bio_64, inbuf, 512)) > 0)
+    {
+        BIO_write(bio_mem_out, inbuf, inlen);
+    }
+
+    size = BIO_get_mem_data(bio_mem_out, &decoded_c);
+
+    string * decoded = new string(decoded_c, size);
+
+    BIO_free_all(bio_64);
+    BIO_free_all(bio_mem_out);
+
+    return decoded;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Payload generation                                                         */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Builds a host monitor message like the ones sent by the KVM IM probes,
+ *  with host capacity, datastore and VM poll information.
+ *    @param num_vms number of VM_POLL entries
+ */
+static string monitor_payload(int num_vms)
+{
+    ostringstream oss;
+
+    oss << "HYPERVISOR=kvm\n"
+        << "TOTALCPU=3200\nCPUSPEED=2600\nTOTALMEMORY=263855652\n"
+        << "USEDMEMORY=45612348\nFREEMEMORY=218243304\nFREECPU=2940\n"
+        << "USEDCPU=260\nNETRX=92367128337\nNETTX=10257763519\n"
+        << "DS_LOCATION_USED_MB=412876\nDS_LOCATION_TOTAL_MB=1876411\n"
+        << "DS_LOCATION_FREE_MB=1463535\n"
+        << "DS = [\n  ID = 0,\n  USED_MB = 412876,\n  TOTAL_MB = 1876411,\n"
+        << "  FREE_MB = 1463535\n]\n"
+        << "HOSTNAME=node01.cloud.example.com\nVM_POLL=YES\n";
+
+    for (int i = 0; i < num_vms; i++)
+    {
+        ostringstream poll;
+
+        poll << "STATE=a CPU=" << (i * 7) % 100 << ".5 MEMORY=" << 524288 + i
+             << " NETRX=" << 1234567 * (i + 1) << " NETTX=" << 765432 * (i + 1)
+             << " DISK_SIZE=[ ID=0, SIZE=" << 2048 + i << " ]";
+
+        string * poll64 = one_util::base64_encode(poll.str());
+
+        oss << "VM=[\n  ID=" << 1000 + i << ",\n  DEPLOY_ID=one-" << 1000 + i
+            << ",\n  POLL=\"" << *poll64 << "\" ]\n";
+
+        delete poll64;
+    }
+
+    return oss.str();
+}
+
+/* -------------------------------------------------------------------------- */
+/* Timing helpers                                                             */
+/* -------------------------------------------------------------------------- */
+
+static double now()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, 0);
+
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void report(const string& name, size_t bytes, int iterations,
+        double secs)
+{
+    cout << "  " << left << setw(26) << name << right << fixed
+         << setprecision(3) << setw(10) << secs * 1e6 / iterations << " us/op"
+         << setprecision(1) << setw(10)
+         << (bytes * (double) iterations) / secs / (1024 * 1024) << " MB/s"
+         << endl;
+}
+
+static void print_usage(const char * name)
+{
+    cout << "Usage: " << name << " [-i iterations] [-v vms]\n"
+         << "  -i: number of encode/decode operations per payload (10000)\n"
+         << "  -v: comma separated list of VMs in the monitor payloads\n"
+         << "      (0,10,100,1000)\n";
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char ** argv)
+{
+    int    iterations = 10000;
+    string vms_list   = "0,10,100,1000";
+    int    opt;
+
+    while ((opt = getopt(argc, argv, "i:v:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'i':
+                iterations = atoi(optarg);
+                break;
+            case 'v':
+                vms_list = optarg;
+                break;
+            default:
+                print_usage(argv[0]);
+                return -1;
+        }
+    }
+
+    vector<int>    vms;
+    vector<string> parts = one_util::split(vms_list, ',');
+
+    for (vector<string>::iterator it = parts.begin(); it != parts.end(); it++)
+    {
+        vms.push_back(atoi(it->c_str()));
+    }
+
+    for (vector<int>::iterator it = vms.begin(); it != vms.end(); it++)
+    {
+        string payload = monitor_payload(*it);
+        string encoded;
+        string decoded;
+
+        double start;
+
+        one_util::base64_encode(payload, encoded);
+
+        if (one_util::base64_decode(encoded, decoded) != 0 || decoded != payload)
+        {
+            cerr << "Error: decoded payload does not match the original\n";
+            return -1;
+        }
+
+        string * bio_encoded = bio_base64_encode(payload);
+
+        if (bio_encoded == 0 || *bio_encoded != encoded)
+        {
+            cerr << "Error: encoded payload differs from OpenSSL BIO\n";
+            return -1;
+        }
+
+        delete bio_encoded;
+
+        cout << "Monitor payload: " << *it << " VMs, " << payload.length()
+             << " bytes (" << encoded.length() << " encoded)" << endl;
+
+        // ---------------------------------------------------------------------
+        // Encoding
+        // ---------------------------------------------------------------------
+        start = now();
+
+        for (int i = 0; i < iterations; i++)
+        {
+            delete bio_base64_encode(payload);
+        }
+
+        report("encode BIO", payload.length(), iterations, now() - start);
+
+        start = now();
+
+        for (int i = 0; i < iterations; i++)
+        {
+            delete one_util::base64_encode(payload);
+        }
+
+        report("encode one_util (string*)", payload.length(), iterations,
+                now() - start);
+
+        start = now();
+
+        for (int i = 0; i < iterations; i++)
+        {
+            one_util::base64_encode(payload, encoded);
+        }
+
+        report("encode one_util (buffer)", payload.length(), iterations,
+                now() - start);
+
+        // ---------------------------------------------------------------------
+        // Decoding
+        // ---------------------------------------------------------------------
+        start = now();
+
+        for (int i = 0; i < iterations; i++)
+        {
+            delete bio_base64_decode(encoded);
+        }
+
+        report("decode BIO", encoded.length(), iterations, now() - start);
+
+        start = now();
+
+        for (int i = 0; i < iterations; i++)
+        {
+            delete one_util::base64_decode(encoded);
+        }
+
+        report("decode one_util (string*)", encoded.length(), iterations,
+                now() - start);
+
+        start = now();
+
+        for (int i = 0; i < iterations; i++)
+        {
+            one_util::base64_decode(encoded, decoded);
+        }
+
+        report("decode one_util (buffer)", encoded.length(), iterations,
+                now() - start);
+    }
+
+    return 0;
+}
@@ -30,6 +30,12 @@ const char * Datastore::db_bootstrap =
     "gid INTEGER, owner_u INTEGER, group_u INTEGER, other_u INTEGER, "
     "cid INTEGER, UNIQUE(name))";
 
+const char * Datastore::images_table = "datastore_images";
+
+const char * Datastore::images_db_bootstrap = "CREATE TABLE IF NOT EXISTS "
+    "datastore_images (datastore_oid INTEGER, image_oid INTEGER, "
+    "PRIMARY KEY(datastore_oid, image_oid))";
+
 /* ************************************************************************ */
 /* Datastore :: Constructor/Destructor                                      */
 /* ************************************************************************ */
@@ -44,7 +50,6 @@ Datastore::Datastore(
         int                 cluster_id,
         const string&       cluster_name):
             PoolObjectSQL(-1,DATASTORE,"",uid,gid,uname,gname,table),
-            ObjectCollection("IMAGES"),
             Clusterable(cluster_id, cluster_name),
             ds_mad(""),
             tm_mad(""),
@@ -52,8 +57,11 @@ Datastore::Datastore(
             type(IMAGE_DS),
             total_mb(0),
             free_mb(0),
-            used_mb(0)
+            used_mb(0),
+            images("IMAGES", images_table, "datastore_oid", "image_oid")
 {
+    collections.push_back(&images);
+
     if (ds_template != 0)
     {
         obj_template = ds_template;
@@ -406,7 +414,7 @@ int Datastore::insert_replace(SqlDB *db, bool replace, string& error_str)
         goto error_name;
     }
 
-    sql_xml = db->escape_str(to_xml(xml_body).c_str());
+    sql_xml = db->escape_str(to_xml(xml_body, false).c_str());
 
     if ( sql_xml == 0 )
     {
@@ -472,14 +480,21 @@ error_common:
 /* ------------------------------------------------------------------------ */
 /* ------------------------------------------------------------------------ */
 
-string& Datastore::to_xml(string& xml) const
+string& Datastore::to_xml(string& xml, bool with_collections) const
 {
     ostringstream   oss;
     string          collection_xml;
     string          template_xml;
     string          perms_xml;
 
-    ObjectCollection::to_xml(collection_xml);
+    if ( with_collections )
+    {
+        images.to_xml(collection_xml);
+    }
+    else
+    {
+        images.to_xml_db(collection_xml);
+    }
 
     oss <<
     "<DATASTORE>"               <<
@@ -548,20 +563,6 @@ int Datastore::from_xml(const string& xml)
     disk_type = static_cast<Image::DiskType>(int_disk_type);
     type      = static_cast<Datastore::DatastoreType>(int_ds_type);
 
-    // Get associated classes
-    ObjectXML::get_nodes("/DATASTORE/IMAGES", content);
-
-    if (content.empty())
-    {
-        return -1;
-    }
-
-    // Set of IDs
-    rc += ObjectCollection::from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
-    content.clear();
-
     // Get associated classes
     ObjectXML::get_nodes("/DATASTORE/TEMPLATE", content);
 
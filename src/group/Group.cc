@@ -33,6 +33,12 @@ const char * Group::db_bootstrap = "CREATE TABLE IF NOT EXISTS group_pool ("
     "gid INTEGER, owner_u INTEGER, group_u INTEGER, other_u INTEGER, "
     "UNIQUE(name))";
 
+const char * Group::users_table = "group_users";
+
+const char * Group::users_db_bootstrap = "CREATE TABLE IF NOT EXISTS "
+    "group_users (group_oid INTEGER, user_oid INTEGER, "
+    "PRIMARY KEY(group_oid, user_oid))";
+
 /* ************************************************************************ */
 /* Group :: Database Access Functions                                       */
 /* ************************************************************************ */
@@ -129,7 +135,7 @@ int Group::insert_replace(SqlDB *db, bool replace, string& error_str)
         goto error_name;
     }
 
-    sql_xml = db->escape_str(to_xml(xml_body).c_str());
+    sql_xml = db->escape_str(to_xml_extended(xml_body, false, false).c_str());
 
     if ( sql_xml == 0 )
     {
@@ -196,7 +202,7 @@ error_common:
 
 string& Group::to_xml(string& xml) const
 {
-    return to_xml_extended(xml, false);
+    return to_xml_extended(xml, false, true);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -204,13 +210,14 @@ string& Group::to_xml(string& xml) const
 
 string& Group::to_xml_extended(string& xml) const
 {
-    return to_xml_extended(xml, true);
+    return to_xml_extended(xml, true, true);
 }
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-string& Group::to_xml_extended(string& xml, bool extended) const
+string& Group::to_xml_extended(string& xml, bool extended,
+        bool with_collections) const
 {
     ostringstream   oss;
     string          collection_xml;
@@ -218,7 +225,14 @@ string& Group::to_xml_extended(string& xml, bool extended) const
 
     set<pair<int,int> >::const_iterator it;
 
-    ObjectCollection::to_xml(collection_xml);
+    if ( with_collections )
+    {
+        users.to_xml(collection_xml);
+    }
+    else
+    {
+        users.to_xml_db(collection_xml);
+    }
 
     oss <<
     "<GROUP>"    <<
@@ -274,19 +288,6 @@ int Group::from_xml(const string& xml)
     // Set the Group ID as the group it belongs to
     set_group(oid, name);
 
-    // Set of IDs
-    ObjectXML::get_nodes("/GROUP/USERS", content);
-
-    if (content.empty())
-    {
-        return -1;
-    }
-
-    rc += ObjectCollection::from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
-    content.clear();
-
     // Get associated metadata for the group
     ObjectXML::get_nodes("/GROUP/TEMPLATE", content);
 
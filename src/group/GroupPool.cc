@@ -19,6 +19,7 @@
 #include "NebulaLog.h"
 
 #include <stdexcept>
+#include <stdlib.h>
 
 /* -------------------------------------------------------------------------- */
 /* There are two default groups boostrapped by the core:                      */
@@ -41,11 +42,20 @@ GroupPool::GroupPool(SqlDB * db,
                      vector<const Attribute *> hook_mads,
                      const string&             remotes_location,
                      bool                      is_federation_slave)
-    :PoolSQL(db, Group::table, !is_federation_slave, true)
+    :PoolSQL(db, Group::table, true, true)
 {
     ostringstream oss;
     string        error_str;
 
+    // Slaves check the cached groups against the changes done by the master
+    if (Nebula::instance().is_federation_enabled())
+    {
+        enable_change_log(is_federation_slave);
+
+        // Quota usage is written by every zone, and cached with the group
+        GroupQuotas::set_change_log(GroupQuotas::db_table, get_change_log());
+    }
+
     //Federation slaves do not need to init the pool
     if (is_federation_slave)
     {
@@ -163,7 +173,14 @@ int GroupPool::update(Group * group)
         return -1;
     }
 
-    return group->update(db);
+    int rc = group->update(db);
+
+    if ( rc == 0 )
+    {
+        log_change(group->get_oid());
+    }
+
+    return rc;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -171,6 +188,8 @@ int GroupPool::update(Group * group)
 
 int GroupPool::update_quotas(Group * group)
 {
+    // The change is recorded in the change log (master and slaves) by
+    // QuotasSQL, once the quotas are written in the DB
     return group->update_quotas(db);
 }
 
@@ -219,6 +238,8 @@ int GroupPool::drop(PoolObjectSQL * objsql, string& error_msg)
     }
     else
     {
+        log_change(group->get_oid());
+
         do_hooks(objsql, Hook::REMOVE);
     }
 
@@ -235,7 +256,12 @@ int GroupPool::dump(ostringstream& oss, const string& where, const string& limit
 
     ostringstream cmd;
 
-    cmd << "SELECT " << Group::table << ".body, "
+    vector<pair<int, pair<string, string> > >           rows;
+    vector<pair<int, pair<string, string> > >::iterator it;
+
+    vector<pair<int, string> > bodies;
+
+    cmd << "SELECT " << Group::table << ".oid, " << Group::table << ".body, "
         << GroupQuotas::db_table << ".body" << " FROM " << Group::table
         << " LEFT JOIN " << GroupQuotas::db_table << " ON "
         << Group::table << ".oid=" << GroupQuotas::db_table << ".group_oid";
@@ -252,15 +278,38 @@ int GroupPool::dump(ostringstream& oss, const string& where, const string& limit
         cmd << " LIMIT " << limit;
     }
 
-    oss << "<GROUP_POOL>";
-
     set_callback(static_cast<Callbackable::Callback>(&GroupPool::dump_cb),
-                 static_cast<void *>(&oss));
+                 static_cast<void *>(&rows));
 
     rc = db->exec(cmd, this);
 
     unset_callback();
 
+    if ( rc != 0 )
+    {
+        return rc;
+    }
+
+    // The users of each group are added to the XML of the group body
+    for (it = rows.begin(); it != rows.end(); it++)
+    {
+        bodies.push_back(make_pair(it->first, it->second.first));
+    }
+
+    rc = rebuild_xml(bodies, where.empty() && limit.empty());
+
+    if ( rc != 0 )
+    {
+        return rc;
+    }
+
+    oss << "<GROUP_POOL>";
+
+    for (unsigned int i = 0; i < rows.size(); i++)
+    {
+        oss << bodies[i].second << rows[i].second.second;
+    }
+
     oss << Nebula::instance().get_default_group_quota().to_xml(def_quota_xml);
 
     oss << "</GROUP_POOL>";
@@ -271,24 +320,27 @@ int GroupPool::dump(ostringstream& oss, const string& where, const string& limit
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int GroupPool::dump_cb(void * _oss, int num, char **values, char **names)
+int GroupPool::dump_cb(void * _rows, int num, char **values, char **names)
 {
-    ostringstream * oss;
+    vector<pair<int, pair<string, string> > > * rows;
+
+    string quota_body;
 
-    oss = static_cast<ostringstream *>(_oss);
+    rows = static_cast<vector<pair<int, pair<string, string> > > *>(_rows);
 
-    if ( (!values[0]) || (num != 2) )
+    if ( (!values[0]) || (!values[1]) || (num != 3) )
     {
         return -1;
     }
 
-    *oss << values[0];
-
-    if (values[1] != NULL)
+    if (values[2] != NULL)
     {
-        *oss << values[1];
+        quota_body = values[2];
     }
 
+    rows->push_back(make_pair(atoi(values[0]),
+                              make_pair(string(values[1]), quota_body)));
+
     return 0;
 }
 
@@ -16,6 +16,7 @@
 
 #include "Hook.h"
 #include "Nebula.h"
+#include "NebulaUtil.h"
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
@@ -23,52 +24,76 @@
 void AllocateRemoveHook::do_hook(void *arg)
 {
     PoolObjectSQL * obj = static_cast<PoolObjectSQL *>(arg);
-    string          parsed_args = args;
+    HookExecution * he;
 
     if ( obj == 0 )
     {
         return;
     }
 
-    parse_hook_arguments(obj, parsed_args);
+    he = new_execution(obj);
 
-    Nebula& ne                    = Nebula::instance();
-    HookManager * hm              = ne.get_hm();
-    const HookManagerDriver * hmd = hm->get();
+    if ( remote == true )
+    {
+        remote_host(obj, he->hostname);
+    }
+
+    execute(he);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+HookExecution * Hook::new_execution(PoolObjectSQL * obj)
+{
+    HookExecution * he = new HookExecution();
+
+    he->oid    = obj->get_oid();
+    he->name   = name;
+    he->cmd    = cmd;
+    he->args   = args;
+    he->remote = remote;
 
-    if ( hmd != 0 )
+    if ( args.find("$TEMPLATE") != string::npos )
     {
-        if ( remote == true )
-        {
-            string hostname;
-
-            hmd->execute(obj->get_oid(),
-                         name,
-                         remote_host(obj, hostname),
-                         cmd,
-                         parsed_args);
-        }
-        else
-        {
-            hmd->execute(obj->get_oid(), name, cmd, parsed_args);
-        }
+        obj->to_xml(he->xml);
     }
+
+    return he;
 }
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-void Hook::parse_hook_arguments(PoolObjectSQL *obj,
-                                string&       parsed)
+void Hook::execute(HookExecution * he)
+{
+    Nebula& ne       = Nebula::instance();
+    HookManager * hm = ne.get_hm();
+
+    if ( hm == 0 )
+    {
+        delete he;
+        return;
+    }
+
+    hm->trigger_execute(he);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+string& HookExecution::parse_arguments(string& parsed) const
 {
     size_t  found;
 
+    parsed = args;
+
     found = parsed.find("$ID");
 
     if ( found !=string::npos )
     {
         ostringstream oss;
-        oss << obj->get_oid();
+        oss << oid;
 
         parsed.replace(found, 3, oss.str());
     }
@@ -77,7 +102,31 @@ void Hook::parse_hook_arguments(PoolObjectSQL *obj,
 
     if ( found != string::npos )
     {
-        string templ;
-        parsed.replace(found, 9, obj->to_xml64(templ));
+        string xml64;
+
+        one_util::base64_encode(xml, xml64);
+
+        parsed.replace(found, 9, xml64);
+    }
+
+    if ( prev_state.empty() ) // Not a VM state hook
+    {
+        return parsed;
     }
+
+    found = parsed.find("$PREV_STATE");
+
+    if ( found != string::npos )
+    {
+        parsed.replace(found, 11, prev_state);
+    }
+
+    found = parsed.find("$PREV_LCM_STATE");
+
+    if ( found != string::npos )
+    {
+        parsed.replace(found, 15, prev_lcm_state);
+    }
+
+    return parsed;
 }
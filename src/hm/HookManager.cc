@@ -114,7 +114,15 @@ int HookManager::start()
 
 void HookManager::do_action(const string &action, void * arg)
 {
-    if (action == ACTION_FINALIZE)
+    if (action == "EXECUTE")
+    {
+        HookExecution * he = static_cast<HookExecution *>(arg);
+
+        execute_action(he);
+
+        delete he;
+    }
+    else if (action == ACTION_FINALIZE)
     {
         NebulaLog::log("HKM",Log::INFO,"Stopping Hook Manager...");
 
@@ -132,3 +140,27 @@ void HookManager::do_action(const string &action, void * arg)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void HookManager::execute_action(HookExecution * he)
+{
+    const HookManagerDriver * hmd = get();
+    string                    parsed_args;
+
+    if ( hmd == 0 || he == 0 )
+    {
+        return;
+    }
+
+    he->parse_arguments(parsed_args);
+
+    if ( he->remote )
+    {
+        hmd->execute(he->oid, he->name, he->hostname, he->cmd, parsed_args);
+    }
+    else
+    {
+        hmd->execute(he->oid, he->name, he->cmd, parsed_args);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
@@ -42,8 +42,10 @@ Host::Host(
         vmm_mad_name(_vmm_mad_name),
         vnm_mad_name(_vnm_mad_name),
         last_monitored(0),
-        vm_collection("VMS")
+        vm_collection("VMS", vms_table, "host_oid", "vm_oid")
 {
+    collections.push_back(&vm_collection);
+
     string default_cpu; //TODO - Get these two from oned.conf
     string default_mem;
 
@@ -80,6 +82,11 @@ const char * Host::monit_db_names = "hid, last_mon_time, body";
 const char * Host::monit_db_bootstrap = "CREATE TABLE IF NOT EXISTS "
     "host_monitoring (hid INTEGER, last_mon_time INTEGER, body MEDIUMTEXT, "
     "PRIMARY KEY(hid, last_mon_time))";
+
+const char * Host::vms_table = "host_vms";
+
+const char * Host::vms_db_bootstrap = "CREATE TABLE IF NOT EXISTS host_vms ("
+    "host_oid INTEGER, vm_oid INTEGER, PRIMARY KEY(host_oid, vm_oid))";
 /* ------------------------------------------------------------------------ */
 /* ------------------------------------------------------------------------ */
 
@@ -106,7 +113,7 @@ int Host::insert_replace(SqlDB *db, bool replace, string& error_str)
         goto error_hostname;
     }
 
-    sql_xml = db->escape_str(to_xml(xml_body).c_str());
+    sql_xml = db->escape_str(to_xml(xml_body, false).c_str());
 
     if ( sql_xml == 0 )
     {
@@ -551,7 +558,7 @@ bool Host::is_public_cloud() const
 /* Host :: Misc                                                             */
 /* ************************************************************************ */
 
-string& Host::to_xml(string& xml) const
+string& Host::to_xml(string& xml, bool with_collections) const
 {
     string template_xml;
     string share_xml;
@@ -559,6 +566,15 @@ string& Host::to_xml(string& xml) const
     ostringstream oss;
     string        vm_collection_xml;
 
+    if ( with_collections )
+    {
+        vm_collection.to_xml(vm_collection_xml);
+    }
+    else
+    {
+        vm_collection.to_xml_db(vm_collection_xml);
+    }
+
     oss <<
     "<HOST>"
        "<ID>"               << oid              << "</ID>"              <<
@@ -571,7 +587,7 @@ string& Host::to_xml(string& xml) const
        "<CLUSTER_ID>"       << cluster_id       << "</CLUSTER_ID>"      <<
        "<CLUSTER>"          << cluster          << "</CLUSTER>"         <<
        host_share.to_xml(share_xml)  <<
-       vm_collection.to_xml(vm_collection_xml) <<
+       vm_collection_xml <<
        obj_template->to_xml(template_xml) <<
     "</HOST>";
 
@@ -641,21 +657,6 @@ int Host::from_xml(const string& xml)
 
     ObjectXML::free_nodes(content);
 
-    content.clear();
-
-    // ------------ VMS collection ---------------
-
-    ObjectXML::get_nodes("/HOST/VMS", content);
-
-    if (content.empty())
-    {
-        return -1;
-    }
-
-    rc += vm_collection.from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
-
     if (rc != 0)
     {
         return -1;
@@ -21,99 +21,114 @@
 // -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
 
-map<int,Host::HostState> HostStateMapHook::host_states;
+void merge_state(Host::HostState &state)
+{
+    if (state == Host::MONITORING_ERROR)
+    {
+        state = Host::ERROR;
+    }
+    else if (state == Host::MONITORING_DISABLED)
+    {
+        state = Host::DISABLED;
+    }
+}
 
+// -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
 
-int HostStateMapHook::get_state(int id, Host::HostState &state)
+void HostStateHook::execute(Host * host)
 {
-    map<int,Host::HostState>::iterator it;
+    HookExecution * he = new_execution(host);
 
-    it = host_states.find(id);
-
-    if ( it == host_states.end() )
+    if ( remote == true )
     {
-        return -1;
+        he->hostname = host->get_name();
     }
 
-    state = it->second;
-
-    return 0;
+    Hook::execute(he);
 }
 
 // -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
 
-void HostStateMapHook::update_state (int id, Host::HostState state)
+HostUpdateStateHook::~HostUpdateStateHook()
 {
-    map<int,Host::HostState>::iterator it;
-
-    it = host_states.find(id);
+    multimap<int, HostStateHook *>::iterator it;
 
-    if ( it == host_states.end() )
+    for (it = state_hooks.begin(); it != state_hooks.end(); ++it)
     {
-        host_states.insert(make_pair(id,state));
-    }
-    else
-    {
-        it->second = state;
+        delete it->second;
     }
+
+    pthread_mutex_destroy(&mutex);
 }
 
 // -----------------------------------------------------------------------------
 
-void HostStateMapHook::remove_host (int id)
+void HostUpdateStateHook::add_state_hook(HostStateHook * hook)
 {
-    map<int,Host::HostState>::iterator it;
+    Host::HostState state = hook->get_state();
 
-    it = host_states.find(id);
+    merge_state(state);
 
-    if ( it != host_states.end() )
-    {
-        host_states.erase(it);
-    }
+    state_hooks.insert(make_pair(static_cast<int>(state), hook));
 }
 
 // -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
 
-void merge_state(Host::HostState &state)
+int HostUpdateStateHook::update_state(int id, Host::HostState state,
+        Host::HostState& prev)
 {
-    if (state == Host::MONITORING_ERROR)
+    map<int,Host::HostState>::iterator it;
+    int rc = 0;
+
+    pthread_mutex_lock(&mutex);
+
+    it = host_states.find(id);
+
+    if ( it == host_states.end() )
     {
-        state = Host::ERROR;
+        host_states.insert(make_pair(id,state));
+
+        rc = -1;
     }
-    else if (state == Host::MONITORING_DISABLED)
+    else
     {
-        state = Host::DISABLED;
+        prev       = it->second;
+        it->second = state;
     }
+
+    pthread_mutex_unlock(&mutex);
+
+    return rc;
 }
 
+// -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
 
-void HostStateHook::do_hook(void *arg)
+void HostUpdateStateHook::do_hook(void *arg)
 {
-    Host * host;
-    int    rc;
+    Host * host = static_cast<Host *>(arg);
 
     Host::HostState prev_state, cur_state;
 
-    host = static_cast<Host *>(arg);
+    multimap<int, HostStateHook *>::iterator it;
+    pair<multimap<int, HostStateHook *>::iterator,
+         multimap<int, HostStateHook *>::iterator> range;
 
     if ( host == 0 )
     {
         return;
     }
 
-    rc = get_state(host->get_oid(), prev_state);
+    cur_state = host->get_state();
 
-    if ( rc != 0 )
+    if ( update_state(host->get_oid(), cur_state, prev_state) != 0 )
     {
         return;
     }
 
-    cur_state = host->get_state();
-
     merge_state(prev_state);
     merge_state(cur_state);
 
@@ -122,48 +137,12 @@ void HostStateHook::do_hook(void *arg)
         return;
     }
 
-    if ( cur_state == this->state )
-    {
-        string  parsed_args = args;
-
-        parse_hook_arguments(host, parsed_args);
-
-        Nebula& ne        = Nebula::instance();
-        HookManager * hm  = ne.get_hm();
-
-        const HookManagerDriver * hmd = hm->get();
-
-        if ( hmd != 0 )
-        {
-            if ( remote == true)
-            {
-                hmd->execute(host->get_oid(),
-                             name,
-                             host->get_name(),
-                             cmd,
-                             parsed_args);
-            }
-            else
-            {
-                hmd->execute(host->get_oid(),name,cmd,parsed_args);
-            }
-        }
-    }
-}
-
-// -----------------------------------------------------------------------------
-// -----------------------------------------------------------------------------
-
-void HostUpdateStateHook::do_hook(void *arg)
-{
-    Host * host = static_cast<Host *>(arg);
+    range = state_hooks.equal_range(static_cast<int>(cur_state));
 
-    if ( host == 0 )
+    for (it = range.first; it != range.second; ++it)
     {
-        return;
+        it->second->execute(host);
     }
-
-    update_state(host->get_oid(), host->get_state());
 }
 
 // -----------------------------------------------------------------------------
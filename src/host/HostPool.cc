@@ -61,7 +61,7 @@ HostPool::HostPool(SqlDB*                    db,
     string arg;
     bool   remote;
 
-    bool state_hook = false;
+    HostUpdateStateHook * state_hooks = new HostUpdateStateHook();
 
     for (unsigned int i = 0 ; i < hook_mads.size() ; i++ )
     {
@@ -121,9 +121,7 @@ HostPool::HostPool(SqlDB*                    db,
 
             hook = new HostStateHook(name, cmd, arg, remote, Host::DISABLED);
 
-            add_hook(hook);
-
-            state_hook = true;
+            state_hooks->add_state_hook(hook);
         }
         else if ( on == "ERROR" )
         {
@@ -131,19 +129,17 @@ HostPool::HostPool(SqlDB*                    db,
 
             hook = new HostStateHook(name, cmd, arg, remote, Host::ERROR);
 
-            add_hook(hook);
-
-            state_hook = true;
+            state_hooks->add_state_hook(hook);
         }
     }
 
-    if ( state_hook )
+    if ( state_hooks->empty() )
     {
-        HostUpdateStateHook * hook;
-
-        hook = new HostUpdateStateHook();
-
-        add_hook(hook);
+        delete state_hooks;
+    }
+    else
+    {
+        add_hook(state_hooks);
     }
 }
 
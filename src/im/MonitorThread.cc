@@ -66,13 +66,23 @@ void MonitorThread::do_message()
     // -------------------------------------------------------------------------
     // Decode from base64
     // -------------------------------------------------------------------------
-    string* hinfo = one_util::base64_decode(hinfo64);
+    string hinfo;
+
+    if ( one_util::base64_decode(hinfo64, hinfo) != 0 )
+    {
+        ostringstream oss;
+
+        oss << "Error monitoring host " << host_id << ". Bad monitor data: "
+            << hinfo64;
+
+        NebulaLog::log("ImM", Log::ERROR, oss);
+        return;
+    }
 
     Host* host    = hpool->get(host_id,true);
 
     if ( host == 0 )
     {
-        delete hinfo;
         return;
     }
 
@@ -83,15 +93,13 @@ void MonitorThread::do_message()
     {
         set<int> vm_ids;
 
-        host->error_info(*hinfo, vm_ids);
+        host->error_info(hinfo, vm_ids);
 
         for (set<int>::iterator it = vm_ids.begin(); it != vm_ids.end(); it++)
         {
             lcm->trigger(LifeCycleManager::MONITOR_DONE, *it);
         }
 
-        delete hinfo;
-
         hpool->update(host);
 
         host->unlock();
@@ -110,7 +118,7 @@ void MonitorThread::do_message()
 
     set<int>    non_shared_ds;
 
-    int rc  = host->extract_ds_info(*hinfo, tmpl, datastores);
+    int rc  = host->extract_ds_info(hinfo, tmpl, datastores);
 
     int cid = host->get_cluster_id();
 
@@ -118,8 +126,6 @@ void MonitorThread::do_message()
 
     long long reserved_mem = 0;
 
-    delete hinfo;
-
     host->unlock();
 
     if (rc != 0)
@@ -258,7 +264,7 @@ void MonitorThread::do_message()
 /* -------------------------------------------------------------------------- */
 
 MonitorThreadPool::MonitorThreadPool(int max_thr):concurrent_threads(max_thr),
-    running_threads(0)
+    running_threads(0), processed(0), superseded(0)
 {
     //Initialize the MonitorThread constants
     MonitorThread::dspool = Nebula::instance().get_dspool();
@@ -278,36 +284,58 @@ MonitorThreadPool::MonitorThreadPool(int max_thr):concurrent_threads(max_thr),
 
     //Initialize concurrency variables
     pthread_mutex_init(&mutex,0);
-
-    pthread_cond_init(&cond,0);
 };
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-void MonitorThreadPool::do_message(int hid, const string& result,
-    const string& hinfo)
+void MonitorThreadPool::start_thread(MonitorThread * mt)
 {
     pthread_attr_t attr;
     pthread_t id;
 
-    pthread_mutex_lock(&mutex);
-
-    while (running_threads >= concurrent_threads)
-    {
-        pthread_cond_wait(&cond, &mutex);
-    }
-
     pthread_attr_init(&attr);
     pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
 
-    MonitorThread * mt = new MonitorThread(hid, result, hinfo);
-
     running_threads++;
 
+    processed++;
+
     pthread_create(&id, &attr, do_message_thread, (void *)mt);
 
     pthread_attr_destroy(&attr);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void MonitorThreadPool::do_message(int hid, const string& result,
+    const string& hinfo)
+{
+    map<int, MonitorThread *>::iterator it;
+
+    pthread_mutex_lock(&mutex);
+
+    it = waiting.find(hid);
+
+    if ( it != waiting.end() )
+    {
+        // Older sample of the host not processed yet, replace it
+        it->second->result  = result;
+        it->second->hinfo64 = hinfo;
+
+        superseded++;
+    }
+    else if ( running_threads < concurrent_threads )
+    {
+        start_thread(new MonitorThread(hid, result, hinfo));
+    }
+    else
+    {
+        waiting.insert(make_pair(hid, new MonitorThread(hid, result, hinfo)));
+
+        waiting_order.push_back(hid);
+    }
 
     pthread_mutex_unlock(&mutex);
 };
@@ -321,7 +349,44 @@ void MonitorThreadPool::exit_monitor_thread()
 
     running_threads--;
 
-    pthread_cond_signal(&cond);
+    if ( !waiting_order.empty() )
+    {
+        int hid = waiting_order.front();
+
+        waiting_order.pop_front();
+
+        map<int, MonitorThread *>::iterator it = waiting.find(hid);
+
+        MonitorThread * mt = it->second;
+
+        waiting.erase(it);
+
+        start_thread(mt);
+    }
+
+    pthread_mutex_unlock(&mutex);
+};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+string& MonitorThreadPool::to_xml(string& xml)
+{
+    ostringstream oss;
+
+    pthread_mutex_lock(&mutex);
+
+    oss << "<MONITOR>"
+        <<   "<THREADS>"    << concurrent_threads << "</THREADS>"
+        <<   "<RUNNING>"    << running_threads    << "</RUNNING>"
+        <<   "<WAITING>"    << waiting.size()     << "</WAITING>"
+        <<   "<PROCESSED>"  << processed          << "</PROCESSED>"
+        <<   "<SUPERSEDED>" << superseded         << "</SUPERSEDED>"
+        << "</MONITOR>";
 
     pthread_mutex_unlock(&mutex);
+
+    xml = oss.str();
+
+    return xml;
 };
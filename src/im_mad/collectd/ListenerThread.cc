@@ -16,33 +16,191 @@
 
 #include "ListenerThread.h"
 
+#include <sstream>
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-const size_t ListenerThread::MESSAGE_SIZE = 100000;
-const size_t ListenerThread::BUFFER_SIZE  = 100;
+const size_t ListenerThread::MESSAGE_SIZE = 65536;
+const int    ListenerThread::RECV_BATCH   = 16;
+const size_t ListenerThread::SLAB_SIZE    = 1048576;
+const int    ListenerThread::MAX_SLABS    = 16;
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+ListenerThread::ListenerThread(int _socket, ListenerPool * _pool):
+    socket(_socket), pool(_pool), num_slabs(2)
+{
+    pthread_mutex_init(&mutex,0);
+
+    recv_buffer = new char[RECV_BATCH * MESSAGE_SIZE];
+
+    current = new MessageSlab(SLAB_SIZE);
+
+    free_slabs.push_back(new MessageSlab(SLAB_SIZE));
+}
+
+/* -------------------------------------------------------------------------- */
+
+ListenerThread::~ListenerThread()
+{
+    std::vector<MessageSlab *>::iterator it;
+
+    for (it = full.begin(); it != full.end(); ++it)
+    {
+        delete *it;
+    }
+
+    for (it = free_slabs.begin(); it != free_slabs.end(); ++it)
+    {
+        delete *it;
+    }
 
+    delete current;
+
+    delete [] recv_buffer;
+
+    pthread_mutex_destroy(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
+
+int ListenerThread::host_id(const char * message, size_t size)
+{
+    static const char   prefix[] = "MONITOR ";
+    static const size_t plen     = sizeof(prefix) - 1;
+
+    size_t i;
+
+    if ( size <= plen || memcmp(message, prefix, plen) != 0 )
+    {
+        return -1;
+    }
+
+    for (i = plen; i < size && message[i] != ' '; i++); // Skip result
+
+    if ( i + 1 >= size || message[i+1] < '0' || message[i+1] > '9' )
+    {
+        return -1;
+    }
+
+    return atoi(message + i + 1);
+}
+
 /* -------------------------------------------------------------------------- */
 
-void ListenerThread::flush_buffer(int fd)
+bool ListenerThread::store(const char * message, size_t size,
+        unsigned long long seq)
+{
+    if ( current->size + size > current->capacity )
+    {
+        MessageSlab * next;
+
+        if ( !free_slabs.empty() )
+        {
+            next = free_slabs.back();
+            free_slabs.pop_back();
+        }
+        else if ( num_slabs < MAX_SLABS )
+        {
+            next = new MessageSlab(SLAB_SIZE);
+            num_slabs++;
+        }
+        else
+        {
+            return false;
+        }
+
+        full.push_back(current);
+
+        current = next;
+
+        pool->slab_full();
+    }
+
+    MessageEntry entry;
+
+    entry.offset  = current->size;
+    entry.size    = size;
+    entry.host_id = host_id(message, size);
+    entry.seq     = seq;
+
+    current->entries.push_back(entry);
+
+    memcpy(current->data + current->size, message, size);
+
+    current->size += size;
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ListenerThread::get_slabs(std::vector<MessageSlab *>& slabs)
 {
     lock();
 
-    std::vector<std::string>::iterator it;
+    slabs.insert(slabs.end(), full.begin(), full.end());
+
+    full.clear();
 
-    for(it = monitor_data.begin() ; it != monitor_data.end(); ++it)
+    if ( current->size > 0 )
     {
-        size_t size = (*it).size();
-        const char * message = (*it).c_str();
+        slabs.push_back(current);
 
-        write(fd, message, size);
+        if ( !free_slabs.empty() )
+        {
+            current = free_slabs.back();
+            free_slabs.pop_back();
+        }
+        else
+        {
+            current = new MessageSlab(SLAB_SIZE);
+            num_slabs++;
+        }
     }
 
-    monitor_data.clear();
+    unlock();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ListenerThread::put_slabs(std::vector<MessageSlab *>& slabs)
+{
+    std::vector<MessageSlab *>::iterator it;
+
+    lock();
+
+    for (it = slabs.begin(); it != slabs.end(); ++it)
+    {
+        (*it)->clear();
+
+        free_slabs.push_back(*it);
+    }
+
+    unlock();
+
+    slabs.clear();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ListenerThread::get_counters(ListenerCounters& _counters)
+{
+    lock();
+
+    _counters = counters;
 
     unlock();
 }
@@ -52,26 +210,83 @@ void ListenerThread::flush_buffer(int fd)
 
 void ListenerThread::monitor_loop()
 {
-    char   buffer[MESSAGE_SIZE];
-    size_t rc;
+    struct mmsghdr msgs[RECV_BATCH];
+    struct iovec   iovs[RECV_BATCH];
 
-    struct sockaddr addr;
-    socklen_t addr_size = sizeof(struct sockaddr);
+#ifdef SO_RXQ_OVFL
+    char control[RECV_BATCH][CMSG_SPACE(sizeof(uint32_t))];
+#endif
+
+    int rc;
+
+    memset(msgs, 0, sizeof(msgs));
+
+    for (int i = 0; i < RECV_BATCH; i++)
+    {
+        iovs[i].iov_base = recv_buffer + i * MESSAGE_SIZE;
+        iovs[i].iov_len  = MESSAGE_SIZE;
+
+        msgs[i].msg_hdr.msg_iov    = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
 
     while(true)
     {
-        rc = recvfrom(socket, buffer, MESSAGE_SIZE, 0, &addr, &addr_size);
+        for (int i = 0; i < RECV_BATCH; i++)
+        {
+            msgs[i].msg_hdr.msg_flags = 0;
+#ifdef SO_RXQ_OVFL
+            msgs[i].msg_hdr.msg_control    = control[i];
+            msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+#endif
+        }
+
+        // Blocks till one message is available, then gets the queued ones
+        rc = recvmmsg(socket, msgs, RECV_BATCH, MSG_WAITFORONE, 0);
 
-        if (rc > 0 && rc < MESSAGE_SIZE)
+        if ( rc <= 0 )
         {
-            std::string message(buffer, rc);
+            continue;
+        }
 
-            lock();
+        unsigned long long seq = pool->next_seq(rc);
 
-            monitor_data.push_back(message);
+        lock();
 
-            unlock();
+        for (int i = 0; i < rc; i++)
+        {
+            size_t size = msgs[i].msg_len;
+
+#ifdef SO_RXQ_OVFL
+            struct cmsghdr * cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+
+            for (; cmsg != 0; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg))
+            {
+                if ( cmsg->cmsg_level == SOL_SOCKET &&
+                     cmsg->cmsg_type == SO_RXQ_OVFL )
+                {
+                    memcpy(&counters.socket_drops, CMSG_DATA(cmsg),
+                            sizeof(uint32_t));
+                }
+            }
+#endif
+            if ( (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) || size == 0 )
+            {
+                counters.truncated++;
+                continue;
+            }
+
+            if ( !store(recv_buffer + i * MESSAGE_SIZE, size, seq + i) )
+            {
+                counters.full++;
+                continue;
+            }
+
+            counters.messages++;
+            counters.bytes += size;
         }
+
+        unlock();
     }
 }
 
@@ -90,14 +305,36 @@ extern "C" void * listener_main(void *arg)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+ListenerPool::ListenerPool(int fd, const std::vector<int>& sockets):
+    out_fd(fd), pending_flush(false), seq(0), superseded(0),
+    last_superseded(0), last_time(time(0))
+{
+    std::vector<int>::const_iterator it;
+
+    pthread_mutex_init(&mutex, 0);
+    pthread_cond_init(&cond, 0);
+
+    for (it = sockets.begin(); it != sockets.end(); ++it)
+    {
+        listeners.push_back(new ListenerThread(*it, this));
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
 ListenerPool::~ListenerPool()
 {
-    std::vector<ListenerThread>::iterator it;
+    std::vector<ListenerThread *>::iterator it;
 
     for(it = listeners.begin() ; it != listeners.end(); ++it)
     {
-        pthread_cancel((*it).thread_id());
+        pthread_cancel((*it)->thread_id());
+
+        delete *it;
     }
+
+    pthread_mutex_destroy(&mutex);
+    pthread_cond_destroy(&cond);
 };
 
 /* -------------------------------------------------------------------------- */
@@ -108,16 +345,16 @@ void ListenerPool::start_pool()
     pthread_attr_t attr;
     pthread_t id;
 
-    std::vector<ListenerThread>::iterator it;
+    std::vector<ListenerThread *>::iterator it;
 
     pthread_attr_init(&attr);
     pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
 
     for(it = listeners.begin() ; it != listeners.end(); ++it)
     {
-        pthread_create(&id, &attr, listener_main, (void *)&(*it));
+        pthread_create(&id, &attr, listener_main, (void *)(*it));
 
-        (*it).thread_id(id);
+        (*it)->thread_id(id);
     }
 
     pthread_attr_destroy(&attr);
@@ -126,12 +363,257 @@ void ListenerPool::start_pool()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void ListenerPool::slab_full()
+{
+    pthread_mutex_lock(&mutex);
+
+    pending_flush = true;
+
+    pthread_cond_signal(&cond);
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ListenerPool::wait_flush(int period)
+{
+    struct timeval  now;
+    struct timespec timeout;
+
+    gettimeofday(&now, 0);
+
+    timeout.tv_sec  = now.tv_sec + period;
+    timeout.tv_nsec = now.tv_usec * 1000;
+
+    pthread_mutex_lock(&mutex);
+
+    while ( !pending_flush )
+    {
+        if ( pthread_cond_timedwait(&cond, &mutex, &timeout) == ETIMEDOUT )
+        {
+            break;
+        }
+    }
+
+    pending_flush = false;
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
 void ListenerPool::flush_pool()
 {
-    std::vector<ListenerThread>::iterator it;
+    std::vector<std::vector<MessageSlab *> > slabs(listeners.size());
+    std::vector<struct iovec>                iov;
 
-    for(it = listeners.begin() ; it != listeners.end(); ++it)
+    std::map<int, unsigned long long> latest;
+    std::map<int, unsigned long long>::iterator lit;
+
+    for (unsigned int i = 0; i < listeners.size(); i++)
+    {
+        listeners[i]->get_slabs(slabs[i]);
+    }
+
+    // -------------------------------------------------------------------------
+    // Last message of each host in this flush window
+    // -------------------------------------------------------------------------
+    for (unsigned int i = 0; i < slabs.size(); i++)
+    {
+        for (unsigned int j = 0; j < slabs[i].size(); j++)
+        {
+            std::vector<MessageEntry>& entries = slabs[i][j]->entries;
+
+            for (unsigned int k = 0; k < entries.size(); k++)
+            {
+                if ( entries[k].host_id == -1 )
+                {
+                    continue;
+                }
+
+                lit = latest.find(entries[k].host_id);
+
+                if ( lit == latest.end() )
+                {
+                    latest.insert(std::make_pair(entries[k].host_id,
+                                entries[k].seq));
+                }
+                else
+                {
+                    if ( entries[k].seq > lit->second )
+                    {
+                        lit->second = entries[k].seq;
+                    }
+
+                    superseded++;
+                }
+            }
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Messages to write, contiguous ones are merged in the same iovec
+    // -------------------------------------------------------------------------
+    for (unsigned int i = 0; i < slabs.size(); i++)
+    {
+        for (unsigned int j = 0; j < slabs[i].size(); j++)
+        {
+            MessageSlab *              slab    = slabs[i][j];
+            std::vector<MessageEntry>& entries = slab->entries;
+
+            bool merge = false;
+
+            for (unsigned int k = 0; k < entries.size(); k++)
+            {
+                const MessageEntry& e = entries[k];
+
+                if ( e.host_id != -1 && latest[e.host_id] != e.seq )
+                {
+                    merge = false;
+                    continue;
+                }
+
+                if ( merge )
+                {
+                    iov.back().iov_len += e.size;
+                }
+                else
+                {
+                    struct iovec v;
+
+                    v.iov_base = slab->data + e.offset;
+                    v.iov_len  = e.size;
+
+                    iov.push_back(v);
+                }
+
+                merge = true;
+            }
+        }
+    }
+
+    // writev may write part of a message, continue from that point
+    size_t pos = 0;
+
+    while ( pos < iov.size() )
+    {
+        int     cnt = iov.size() - pos;
+        ssize_t rc;
+
+        if ( cnt > IOV_MAX )
+        {
+            cnt = IOV_MAX;
+        }
+
+        rc = writev(out_fd, &iov[pos], cnt);
+
+        if ( rc < 0 )
+        {
+            if ( errno == EINTR )
+            {
+                continue;
+            }
+
+            break; // oned closed the pipe
+        }
+
+        while ( rc > 0 && pos < iov.size() )
+        {
+            if ( static_cast<size_t>(rc) >= iov[pos].iov_len )
+            {
+                rc -= iov[pos].iov_len;
+                pos++;
+            }
+            else
+            {
+                iov[pos].iov_base = static_cast<char *>(iov[pos].iov_base) + rc;
+                iov[pos].iov_len -= rc;
+
+                rc = 0;
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < listeners.size(); i++)
     {
-        (*it).flush_buffer(out_fd);
+        listeners[i]->put_slabs(slabs[i]);
     }
 }
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void ListenerPool::stats(std::string& message)
+{
+    ListenerCounters total;
+    ListenerCounters lc;
+
+    std::map<int, uint32_t> socket_drops;
+    std::map<int, uint32_t>::iterator it;
+
+    std::ostringstream oss;
+
+    time_t the_time = time(0);
+    time_t elapsed  = the_time - last_time;
+
+    for (unsigned int i = 0; i < listeners.size(); i++)
+    {
+        listeners[i]->get_counters(lc);
+
+        total.messages  += lc.messages;
+        total.bytes     += lc.bytes;
+        total.truncated += lc.truncated;
+        total.full      += lc.full;
+
+        // Listeners sharing a socket get the same kernel counter
+        uint32_t& drops = socket_drops[listeners[i]->get_socket()];
+
+        if ( lc.socket_drops > drops )
+        {
+            drops = lc.socket_drops;
+        }
+    }
+
+    for (it = socket_drops.begin(); it != socket_drops.end(); ++it)
+    {
+        total.socket_drops += it->second;
+    }
+
+    unsigned long long messages  = total.messages - last.messages;
+    unsigned long long bytes     = total.bytes - last.bytes;
+    unsigned long long truncated = total.truncated - last.truncated;
+    unsigned long long full      = total.full - last.full;
+    uint32_t           kdrops    = total.socket_drops - last.socket_drops;
+
+    unsigned long long dropped = truncated + full + kdrops;
+
+    last      = total;
+    last_time = the_time;
+
+    unsigned long long coalesced = superseded - last_superseded;
+
+    last_superseded = superseded;
+
+    message.clear();
+
+    if ( messages == 0 && dropped == 0 )
+    {
+        return;
+    }
+
+    if ( elapsed <= 0 )
+    {
+        elapsed = 1;
+    }
+
+    oss << "LOG " << (dropped > 0 ? "E" : "I") << " -1 collectd: "
+        << messages << " messages (" << messages / elapsed << "/s, "
+        << bytes / elapsed / 1024 << " KB/s) in " << elapsed << "s, "
+        << dropped << " dropped (truncated: " << truncated
+        << ", buffers full: " << full << ", socket overflow: " << kdrops
+        << "), " << coalesced << " superseded by a newer message of the "
+        << "same host\n";
+
+    message = oss.str();
+}
@@ -16,45 +16,118 @@
 
 #include <string>
 #include <vector>
+#include <map>
 
 #include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ *  Position of a message in a slab, and the host that sent it
+ */
+struct MessageEntry
+{
+    size_t             offset;
+    size_t             size;
+    int                host_id; /**< -1 if not a MONITOR message */
+    unsigned long long seq;     /**< Order of arrival */
+};
+
+/**
+ *  Buffer of monitor messages. The messages (each one ends with a new line)
+ *  are stored one after the other, so the slab is written to oned as is.
+ *  Slabs are allocated once and reused after each flush.
+ */
+struct MessageSlab
+{
+    MessageSlab(size_t _capacity):size(0), capacity(_capacity)
+    {
+        data = new char[capacity];
+    };
+
+    ~MessageSlab()
+    {
+        delete [] data;
+    };
+
+    void clear()
+    {
+        size = 0;
+
+        entries.clear();
+    };
+
+    char * data;
+    size_t size;
+    size_t capacity;
+
+    std::vector<MessageEntry> entries;
+};
+
+/**
+ *  Counters of a listener
+ */
+struct ListenerCounters
+{
+    ListenerCounters():messages(0), bytes(0), truncated(0), full(0),
+        socket_drops(0){};
+
+    unsigned long long messages;  /**< Messages received */
+    unsigned long long bytes;     /**< Bytes received */
+    unsigned long long truncated; /**< Messages larger than MESSAGE_SIZE */
+    unsigned long long full;      /**< Dropped, all the slabs were full */
+    uint32_t socket_drops;        /**< Dropped by the kernel (SO_RXQ_OVFL) */
+};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+class ListenerPool;
 
 /**
  *  This class implements a listener thread for the IM collector. It receives
- *  messages from a UDP port and stores it in a BUFFER. The class is controlled
- *  by two parameters
- *    - BUFFER_SIZE the number of pre-allocated capacity to store monitor
- *      messages. It should be roughly equal to the number of hosts per thread
- *    - MESSAGE_SIZE the size of each monitor message (100K by default). Each VM
- *      needs ~100bytes so ~1000VMs per host
+ *  batches of messages from a UDP socket (recvmmsg) and stores them in
+ *  message slabs, that are written to oned by the flush thread. The class is
+ *  controlled by:
+ *    - MESSAGE_SIZE the maximum size of a monitor message (a UDP datagram).
+ *      Each VM needs ~100bytes so ~600VMs per host
+ *    - RECV_BATCH the number of messages received in each system call
+ *    - SLAB_SIZE the capacity of each slab, and MAX_SLABS the number of slabs
+ *      that can be allocated by a listener, messages are dropped when all of
+ *      them are full (i.e. oned does not read them fast enough)
  */
 class ListenerThread
 {
 public:
     /**
      *  @param _socket descriptor to listen for messages
+     *  @param _pool of the listener, notified when a slab is full
      */
-    ListenerThread(int _socket):socket(_socket)
-    {
-        pthread_mutex_init(&mutex,0);
+    ListenerThread(int _socket, ListenerPool * _pool);
 
-        monitor_data.reserve(BUFFER_SIZE);
-    };
+    ~ListenerThread();
 
-    ~ListenerThread()
-    {
-        pthread_mutex_destroy(&mutex);
-    };
+    /**
+     *  Gets the slabs with messages, the current one included. They must be
+     *  returned with put_slabs once written.
+     *    @param slabs vector to append the slabs with messages
+     */
+    void get_slabs(std::vector<MessageSlab *>& slabs);
+
+    /**
+     *  Returns written slabs to the listener
+     *    @param slabs to be reused, they are removed from the vector
+     */
+    void put_slabs(std::vector<MessageSlab *>& slabs);
 
     /**
-     *  Write the contents of the message buffer to a descriptor. Buffer is
-     *  cleared
-     *    @param fd file descriptor to send monitor data.
+     *  Gets the counters of the listener
+     *    @param counters of the listener
      */
-    void flush_buffer(int fd);
+    void get_counters(ListenerCounters& counters);
 
     /**
-     *  Waits for UDP messages in a loop and store them in a buffer
+     *  Waits for UDP messages in a loop and store them in the slabs
      */
     void monitor_loop();
 
@@ -74,17 +147,57 @@ public:
         return _thread_id;
     }
 
+    /**
+     *  Get the socket of the listener
+     */
+    int get_socket()
+    {
+        return socket;
+    }
+
 private:
-    static const size_t MESSAGE_SIZE; /**< Monitor message size */
-    static const size_t BUFFER_SIZE;  /**< Pre-allocated capacoty */
+    static const size_t MESSAGE_SIZE; /**< Maximum monitor message size */
+    static const int    RECV_BATCH;   /**< Messages per recvmmsg call */
+    static const size_t SLAB_SIZE;    /**< Capacity of a message slab */
+    static const int    MAX_SLABS;    /**< Maximum slabs per listener */
 
     pthread_mutex_t mutex;
     pthread_t       _thread_id;
 
-    std::vector<std::string> monitor_data;
-
     int socket;
 
+    ListenerPool * pool;
+
+    /**
+     *  Buffer for a batch of messages (RECV_BATCH * MESSAGE_SIZE)
+     */
+    char * recv_buffer;
+
+    /**
+     *  Slab being filled, full ones waiting to be written and free ones
+     */
+    MessageSlab *              current;
+    std::vector<MessageSlab *> full;
+    std::vector<MessageSlab *> free_slabs;
+
+    int num_slabs;
+
+    ListenerCounters counters;
+
+    /**
+     *  Stores a message in the current slab, a new one is used if full.
+     *  Must be called with the mutex locked.
+     *    @param seq order of arrival of the message
+     *    @return false if the message was dropped
+     */
+    bool store(const char * message, size_t size, unsigned long long seq);
+
+    /**
+     *  Gets the host id of a "MONITOR <result> <id> <info>" message
+     *    @return the host id, -1 for other messages
+     */
+    static int host_id(const char * message, size_t size);
+
     void lock()
     {
         pthread_mutex_lock(&mutex);
@@ -113,21 +226,76 @@ class ListenerPool
 public:
     /**
      *  @param fd descriptor to flush the data
-     *  @param sock socket for the UDP connections
-     *  @param num number of threads in the pool
+     *  @param sockets for the UDP messages, one listener thread is created for
+     *  each socket
      */
-    ListenerPool(int fd, int sock, size_t num)
-        :listeners(num, ListenerThread(sock)), out_fd(fd), socket(sock){};
+    ListenerPool(int fd, const std::vector<int>& sockets);
 
     ~ListenerPool();
 
     void start_pool();
 
+    /**
+     *  Writes the messages of all the listeners with a single writev (for
+     *  each IOV_MAX messages). Only the last message of each host in the
+     *  flush window is written, the older ones are superseded by it.
+     */
     void flush_pool();
 
+    /**
+     *  Gets the sequence numbers for a batch of messages
+     *    @param num of messages in the batch
+     *    @return the sequence number of the first message
+     */
+    unsigned long long next_seq(int num)
+    {
+        return __sync_fetch_and_add(&seq, num);
+    };
+
+    /**
+     *  Waits till the next flush period, or a listener has a full slab
+     *    @param period in seconds
+     */
+    void wait_flush(int period);
+
+    /**
+     *  Notifies the flush thread that there is a full slab
+     */
+    void slab_full();
+
+    /**
+     *  Builds a message with the ingest rate and drop counters of the pool,
+     *  since the last call
+     *    @param message LOG message for oned, empty if nothing was received
+     */
+    void stats(std::string& message);
+
 private:
-    std::vector<ListenerThread> listeners;
+    std::vector<ListenerThread *> listeners;
 
     int out_fd;
-    int socket;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+
+    bool pending_flush;
+
+    /**
+     *  Sequence number for the next message
+     */
+    unsigned long long seq;
+
+    /**
+     *  Messages not written as a newer one from the same host was received,
+     *  only accessed by the flush thread
+     */
+    unsigned long long superseded;
+
+    unsigned long long last_superseded;
+
+    /**
+     *  Totals at the time of the last stats message
+     */
+    ListenerCounters last;
+    time_t           last_time;
 };
@@ -24,6 +24,8 @@
 #include <netinet/in.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
+#include <vector>
 
 #include "OpenNebulaDriver.h"
 #include "ListenerThread.h"
@@ -31,6 +33,12 @@
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+const int IMCollectorDriver::RECV_BUFFER_SIZE = 8388608;
+const int IMCollectorDriver::STATS_PERIOD     = 60;
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int OpenNebulaDriver::read_one(std::string& message)
 {
     fd_set             in_pipes;
@@ -117,14 +125,19 @@ void OpenNebulaDriver::driver_loop()
 int IMCollectorDriver::init_collector()
 {
     struct sockaddr_in im_server;
-    int rc;
+    std::vector<int>   sockets;
 
-    int sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    int rc;
+    int rcvbuf = RECV_BUFFER_SIZE;
 
-    if ( sock < 0 )
+    if ( _threads <= 0 )
     {
-        std::cerr << strerror(errno);
-        return -1;
+        _threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+        if ( _threads <= 0 )
+        {
+            _threads = 1;
+        }
     }
 
     im_server.sin_family = AF_INET;
@@ -140,15 +153,67 @@ int IMCollectorDriver::init_collector()
         return -1;
     }
 
-    rc = bind(sock, (struct sockaddr *) &im_server, sizeof(struct sockaddr_in));
-
-    if ( rc < 0 )
+    // -------------------------------------------------------------------------
+    // One socket per listener thread (SO_REUSEPORT), so the kernel spreads
+    // the messages among them. If not supported all the threads share one.
+    // -------------------------------------------------------------------------
+    for (int i = 0; i < _threads; i++)
     {
-        std::cerr << strerror(errno);
-        return -1;
+        int sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+        if ( sock < 0 )
+        {
+            std::cerr << strerror(errno);
+            return -1;
+        }
+
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(int));
+
+#ifdef SO_RXQ_OVFL
+        int yes = 1;
+
+        setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &yes, sizeof(int));
+#endif
+
+        bool reuseport = false;
+
+#ifdef SO_REUSEPORT
+        int on = 1;
+
+        reuseport = setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on,
+                sizeof(int)) == 0;
+#endif
+
+        rc = bind(sock, (struct sockaddr *) &im_server,
+                sizeof(struct sockaddr_in));
+
+        if ( rc < 0 )
+        {
+            close(sock);
+
+            if ( i > 0 ) // Use the sockets already bound
+            {
+                break;
+            }
+
+            std::cerr << strerror(errno);
+            return -1;
+        }
+
+        sockets.push_back(sock);
+
+        if ( !reuseport )
+        {
+            for (int j = 1; j < _threads; j++)
+            {
+                sockets.push_back(sock);
+            }
+
+            break;
+        }
     }
 
-    pool = new ListenerPool(1, sock, _threads);
+    pool = new ListenerPool(1, sockets);
 
     return 0;
 }
@@ -191,10 +256,25 @@ extern "C" void * flush_thread(void *arg)
 
 void IMCollectorDriver::flush_loop()
 {
+    std::string stats;
+    time_t      last_stats = time(0);
+
     while(true)
     {
-        sleep(_flush_period);
+        pool->wait_flush(_flush_period);
 
         pool->flush_pool();
+
+        if ( time(0) - last_stats >= STATS_PERIOD )
+        {
+            pool->stats(stats);
+
+            if ( !stats.empty() )
+            {
+                write2one(stats);
+            }
+
+            last_stats = time(0);
+        }
     }
 };
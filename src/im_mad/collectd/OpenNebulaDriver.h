@@ -94,6 +94,9 @@ public:
 private:
     void driver_action(const std::string& action, std::istringstream &is){};
 
+    static const int RECV_BUFFER_SIZE; /**< SO_RCVBUF of the UDP sockets */
+    static const int STATS_PERIOD;     /**< Seconds between stats messages */
+
     std::string _address;
 
     int _port;
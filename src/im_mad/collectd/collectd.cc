@@ -33,7 +33,8 @@ static const char * usage =
 "\t-a\tAddress to bind the collectd sockect\n"
 "\t-p\tUDP port to listen for monitor information\n"
 "\t-f\tInterval in seconds to flush collected information\n"
-"\t-t\tNumber of threads for the server\n";
+"\t-t\tNumber of threads for the server, each one with its own socket.\n"
+"\t\tBy default (0) one per CPU\n";
 
 // -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
@@ -63,7 +64,7 @@ int main(int argc, char ** argv)
 
     std::string address = "0.0.0.0";
     int port    = 4124;
-    int threads = 50;
+    int threads = 0;
     int flush   = 5;
 
     std::istringstream iss;
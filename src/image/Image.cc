@@ -55,9 +55,11 @@ Image::Image(int             _uid,
         cloning_id(-1),
         ds_id(-1),
         ds_name(""),
-        vm_collection("VMS"),
+        vm_collection("VMS", vms_table, "image_oid", "vm_oid"),
         img_clone_collection("CLONES")
 {
+    collections.push_back(&vm_collection);
+
     if (_image_template != 0)
     {
         obj_template = _image_template;
@@ -89,6 +91,11 @@ const char * Image::db_bootstrap = "CREATE TABLE IF NOT EXISTS image_pool ("
     "gid INTEGER, owner_u INTEGER, group_u INTEGER, other_u INTEGER, "
     "UNIQUE(name,uid) )";
 
+const char * Image::vms_table = "image_vms";
+
+const char * Image::vms_db_bootstrap = "CREATE TABLE IF NOT EXISTS image_vms ("
+    "image_oid INTEGER, vm_oid INTEGER, PRIMARY KEY(image_oid, vm_oid))";
+
 /* ------------------------------------------------------------------------ */
 /* ------------------------------------------------------------------------ */
 
@@ -241,7 +248,16 @@ error_common:
 int Image::update(SqlDB *db)
 {
     string error_str;
-    return insert_replace(db, true, error_str);
+    int    rc;
+
+    rc = insert_replace(db, true, error_str);
+
+    if ( rc != 0 )
+    {
+        return rc;
+    }
+
+    return update_collections(db);
 }
 
 /* ------------------------------------------------------------------------ */
@@ -267,7 +283,7 @@ int Image::insert_replace(SqlDB *db, bool replace, string& error_str)
         goto error_name;
     }
 
-    sql_xml = db->escape_str(to_xml(xml_body).c_str());
+    sql_xml = db->escape_str(to_xml(xml_body, false).c_str());
 
     if ( sql_xml == 0 )
     {
@@ -332,7 +348,7 @@ error_common:
 /* Image :: Misc                                                             */
 /* ************************************************************************ */
 
-string& Image::to_xml(string& xml) const
+string& Image::to_xml(string& xml, bool with_collections) const
 {
     string          template_xml;
     string          perms_xml;
@@ -340,6 +356,15 @@ string& Image::to_xml(string& xml) const
     string          vm_collection_xml;
     string          clone_collection_xml;
 
+    if ( with_collections )
+    {
+        vm_collection.to_xml(vm_collection_xml);
+    }
+    else
+    {
+        vm_collection.to_xml_db(vm_collection_xml);
+    }
+
     oss <<
         "<IMAGE>" <<
             "<ID>"             << oid             << "</ID>"          <<
@@ -363,7 +388,7 @@ string& Image::to_xml(string& xml) const
             "<CLONING_ID>"     << cloning_id      << "</CLONING_ID>"  <<
             "<DATASTORE_ID>"   << ds_id           << "</DATASTORE_ID>"<<
             "<DATASTORE>"      << ds_name         << "</DATASTORE>"   <<
-            vm_collection.to_xml(vm_collection_xml)                   <<
+            vm_collection_xml                                         <<
             img_clone_collection.to_xml(clone_collection_xml)         <<
             obj_template->to_xml(template_xml)                        <<
         "</IMAGE>";
@@ -438,19 +463,6 @@ int Image::from_xml(const string& xml)
 
     content.clear();
 
-    ObjectXML::get_nodes("/IMAGE/VMS", content);
-
-    if (content.empty())
-    {
-        return -1;
-    }
-
-    rc += vm_collection.from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
-
-    content.clear();
-
     ObjectXML::get_nodes("/IMAGE/CLONES", content);
 
     if (content.empty())
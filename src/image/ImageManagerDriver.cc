@@ -582,7 +582,7 @@ static void monitor_action(istringstream& is,
                            const string&  result)
 {
     string  dsinfo64;
-    string *dsinfo = 0;
+    string  dsinfo;
 
     ostringstream oss;
 
@@ -597,9 +597,7 @@ static void monitor_action(istringstream& is,
         return;
     }
 
-    dsinfo = one_util::base64_decode(dsinfo64);
-
-    if (dsinfo == 0)
+    if (one_util::base64_decode(dsinfo64, dsinfo) != 0)
     {
         oss << "Error monitoring datastore " << id << ". Bad monitor data: "
             << dsinfo64;
@@ -610,33 +608,29 @@ static void monitor_action(istringstream& is,
 
     if (result != "SUCCESS")
     {
-        oss << "Error monitoring datastore " << id << ": " << *dsinfo;
+        oss << "Error monitoring datastore " << id << ": " << dsinfo;
         NebulaLog::log("ImM", Log::ERROR, oss);
 
-        delete dsinfo;
         return;
     }
 
     Template monitor_data;
 
     char*  error_msg;
-    int    rc = monitor_data.parse(*dsinfo, &error_msg);
+    int    rc = monitor_data.parse(dsinfo, &error_msg);
 
     if ( rc != 0 )
     {
         oss << "Error parsing datastore information: " << error_msg
-            << ". Monitoring information: " << endl << *dsinfo;
+            << ". Monitoring information: " << endl << dsinfo;
 
         NebulaLog::log("ImM", Log::ERROR, oss);
 
-        delete dsinfo;
         free(error_msg);
 
         return;
     }
 
-    delete dsinfo;
-
     float  total, free, used;
     string ds_name;
 
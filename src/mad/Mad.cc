@@ -21,7 +21,9 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/uio.h>
 #include <string.h> 
+#include <stdlib.h>
 
 #include "Mad.h"
 #include "NebulaLog.h"
@@ -34,29 +36,328 @@
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-Mad::~Mad()
+unsigned int    Mad::queue_limit  = 1024;
+
+Mad::QueuePolicy Mad::queue_policy = Mad::BLOCK;
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void MadShard::write(const string& str)
 {
-    char    buf[]="FINALIZE\n";
-    int     status;
-    pid_t   rp;
-    
-    if ( pid==-1)
+    ssize_t rc;
+    size_t  offset = 0;
+    bool    wake;
+
+    pthread_mutex_lock(&queue_mutex);
+
+    if ( pid == -1 )
     {
+        dropped++;
+
+        pthread_mutex_unlock(&queue_mutex);
         return;
     }
-    
-    // Finish the driver
-    ::write(nebula_mad_pipe, buf, strlen(buf));
 
-    close(mad_nebula_pipe);
-    close(nebula_mad_pipe);
+    if ( queue.empty() )
+    {
+        do
+        {
+            rc = ::write(nebula_mad_pipe, str.c_str(), str.size());
+        }
+        while ( rc == -1 && errno == EINTR );
+
+        if ( rc == static_cast<ssize_t>(str.size()) )
+        {
+            written++;
 
-    rp = waitpid(pid, &status, WNOHANG);
+            pthread_mutex_unlock(&queue_mutex);
+            return;
+        }
+        else if ( rc > 0 ) // Partial write, the rest MUST go first
+        {
+            offset = rc;
+        }
+    }
 
-    if ( rp == 0 )
+    if ( offset == 0 && Mad::queue_limit != 0 )
+    {
+        if ( Mad::queue_policy == Mad::BLOCK &&
+             !pthread_equal(pthread_self(), listener_thread) )
+        {
+            while ( queue.size() >= Mad::queue_limit && pid != -1 )
+            {
+                pthread_cond_wait(&queue_cond, &queue_mutex);
+            }
+
+            if ( pid == -1 ) // Instance finalized while waiting
+            {
+                dropped++;
+
+                pthread_mutex_unlock(&queue_mutex);
+                return;
+            }
+        }
+        else if ( queue.size() >= Mad::queue_limit )
+        {
+            ostringstream oss;
+
+            dropped++;
+
+            pthread_mutex_unlock(&queue_mutex);
+
+            oss << "Driver queue full (" << Mad::queue_limit << " messages), "
+                << "dropping message: " << str.substr(0, str.find('\n'));
+
+            NebulaLog::log("MAD", Log::ERROR, oss);
+            return;
+        }
+    }
+
+    wake = queue.empty();
+
+    if ( wake )
+    {
+        queue_offset = offset;
+    }
+
+    queue.push_back(str);
+
+    queue_bytes += str.size() - offset;
+
+    if ( queue.size() > max_depth )
+    {
+        max_depth = queue.size();
+    }
+
+    pthread_mutex_unlock(&queue_mutex);
+
+    if ( wake && wake_pipe != -1 )
+    {
+        char buf = 'W';
+
+        ::write(wake_pipe, &buf, sizeof(char));
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int MadShard::flush()
+{
+    struct iovec  iov[64];
+    int           iovcnt;
+    ssize_t       rc = 0;
+
+    deque<string>::const_iterator it;
+
+    pthread_mutex_lock(&queue_mutex);
+
+    while ( !queue.empty() )
+    {
+        iovcnt = 0;
+
+        for (it = queue.begin(); it != queue.end() && iovcnt < 64; ++it)
+        {
+            iov[iovcnt].iov_base = const_cast<char *>(it->c_str());
+            iov[iovcnt].iov_len  = it->size();
+
+            iovcnt++;
+        }
+
+        iov[0].iov_base = static_cast<char *>(iov[0].iov_base) + queue_offset;
+        iov[0].iov_len -= queue_offset;
+
+        rc = writev(nebula_mad_pipe, iov, iovcnt);
+
+        if ( rc == -1 )
+        {
+            if ( errno == EINTR )
+            {
+                continue;
+            }
+
+            break;
+        }
+
+        queue_bytes -= rc;
+        rc          += queue_offset;
+
+        while ( !queue.empty() && rc >= static_cast<ssize_t>(queue.front().size()) )
+        {
+            rc -= queue.front().size();
+
+            queue.pop_front();
+
+            written++;
+        }
+
+        queue_offset = rc;
+        rc           = 0;
+
+        if ( !queue.empty() ) // Pipe is full
+        {
+            break;
+        }
+    }
+
+    if ( rc == -1 && errno != EAGAIN && errno != EWOULDBLOCK )
+    {
+        // Broken pipe, the listener will reload the driver
+        dropped += queue.size();
+
+        queue.clear();
+
+        queue_bytes  = 0;
+        queue_offset = 0;
+    }
+    else
+    {
+        rc = 0;
+    }
+
+    pthread_cond_broadcast(&queue_cond);
+
+    pthread_mutex_unlock(&queue_mutex);
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void MadShard::clear_queue()
+{
+    pthread_mutex_lock(&queue_mutex);
+
+    dropped += queue.size();
+
+    queue.clear();
+
+    queue_bytes  = 0;
+    queue_offset = 0;
+
+    pthread_cond_broadcast(&queue_cond);
+
+    pthread_mutex_unlock(&queue_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void MadShard::to_xml(ostringstream& oss, const string& name)
+{
+    pthread_mutex_lock(&queue_mutex);
+
+    oss << "<DRIVER>"
+        << "<NAME>"        << name         << "</NAME>"
+        << "<INSTANCE>"    << index        << "</INSTANCE>"
+        << "<PID>"         << pid          << "</PID>"
+        << "<RESTARTS>"    << restarts     << "</RESTARTS>"
+        << "<QUEUE>"       << queue.size() << "</QUEUE>"
+        << "<QUEUE_BYTES>" << queue_bytes  << "</QUEUE_BYTES>"
+        << "<MAX_QUEUE>"   << max_depth    << "</MAX_QUEUE>"
+        << "<WRITTEN>"     << written      << "</WRITTEN>"
+        << "<DROPPED>"     << dropped      << "</DROPPED>"
+        << "</DRIVER>";
+
+    pthread_mutex_unlock(&queue_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+pid_t MadShard::finalize()
+{
+    char    buf[]="FINALIZE\n";
+    pid_t   driver_pid;
+
+    // Pending messages are lost, the driver is recovered once restarted
+    clear_queue();
+
+    pthread_mutex_lock(&queue_mutex);
+
+    driver_pid = pid;
+
+    if ( pid != -1 )
+    {
+        // Finish the driver
+        ::write(nebula_mad_pipe, buf, strlen(buf));
+
+        close(mad_nebula_pipe);
+        close(nebula_mad_pipe);
+
+        pid             = -1;
+        mad_nebula_pipe = -1;
+        nebula_mad_pipe = -1;
+    }
+
+    pthread_cond_broadcast(&queue_cond);
+
+    pthread_mutex_unlock(&queue_mutex);
+
+    return driver_pid;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Waits for a set of finalized driver processes, giving them one second to
+ *  exit.
+ *    @param pids of the drivers
+ */
+static void wait_drivers(const vector<pid_t>& pids)
+{
+    int   status;
+    bool  running = false;
+
+    vector<pid_t>::const_iterator it;
+
+    for (it = pids.begin(); it != pids.end(); ++it)
+    {
+        if ( waitpid(*it, &status, WNOHANG) == 0 )
+        {
+            running = true;
+        }
+    }
+
+    if ( running )
     {
         sleep(1);
-        waitpid(pid, &status, WNOHANG);
+
+        for (it = pids.begin(); it != pids.end(); ++it)
+        {
+            waitpid(*it, &status, WNOHANG);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+Mad::~Mad()
+{
+    vector<pid_t> pids;
+    pid_t         driver_pid;
+
+    vector<MadShard *>::iterator it;
+
+    for (it = shards.begin(); it != shards.end(); ++it)
+    {
+        driver_pid = (*it)->finalize();
+
+        if ( driver_pid != -1 )
+        {
+            pids.push_back(driver_pid);
+        }
+    }
+
+    wait_drivers(pids);
+
+    for (it = shards.begin(); it != shards.end(); ++it)
+    {
+        delete *it;
     }
 }
 
@@ -64,6 +365,41 @@ Mad::~Mad()
 /* -------------------------------------------------------------------------- */
 
 int Mad::start()
+{
+    int instances = 1;
+
+    map<string,string>::iterator it = attributes.find("INSTANCES");
+
+    if ( it != attributes.end() )
+    {
+        instances = atoi(it->second.c_str());
+
+        if ( instances < 1 )
+        {
+            instances = 1;
+        }
+    }
+
+    for (int i = shards.size(); i < instances; i++)
+    {
+        shards.push_back(new MadShard(i, wake_pipe, listener_thread));
+    }
+
+    for (unsigned int i = 0; i < shards.size(); i++)
+    {
+        if ( start(shards[i]) != 0 )
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int Mad::start(MadShard * shard)
 {
     int                            ne_mad_pipe[2];
     int                            mad_ne_pipe[2];
@@ -139,9 +475,9 @@ int Mad::start()
 
     //Create a new process for the driver
 
-    pid = fork();
+    shard->pid = fork();
 
-    switch (pid)
+    switch (shard->pid)
     {
     case -1: // Error
         goto error_fork;
@@ -181,33 +517,38 @@ int Mad::start()
         close(ne_mad_pipe[0]);
         close(mad_ne_pipe[1]);
 
-        nebula_mad_pipe = ne_mad_pipe[1];
-        mad_nebula_pipe = mad_ne_pipe[0];
+        shard->nebula_mad_pipe = ne_mad_pipe[1];
+        shard->mad_nebula_pipe = mad_ne_pipe[0];
 
         // Close pipes in other MADs
 
-        fcntl(nebula_mad_pipe, F_SETFD, FD_CLOEXEC);
-        fcntl(mad_nebula_pipe, F_SETFD, FD_CLOEXEC);
+        fcntl(shard->nebula_mad_pipe, F_SETFD, FD_CLOEXEC);
+        fcntl(shard->mad_nebula_pipe, F_SETFD, FD_CLOEXEC);
 
-        ::write(nebula_mad_pipe, buf, strlen(buf));
+        // Writes never block, messages are queued if the pipe is full
+
+        fcntl(shard->nebula_mad_pipe, F_SETFL,
+                fcntl(shard->nebula_mad_pipe, F_GETFL) | O_NONBLOCK);
+
+        ::write(shard->nebula_mad_pipe, buf, strlen(buf));
                     
         do
         {
             FD_ZERO(&rfds);
-            FD_SET(mad_nebula_pipe, &rfds);
+            FD_SET(shard->mad_nebula_pipe, &rfds);
 
             // Wait up to 30 seconds
             tv.tv_sec  = 30;
             tv.tv_usec = 0;
 
-            rc = select(mad_nebula_pipe+1,&rfds,0,0, &tv);
+            rc = select(shard->mad_nebula_pipe+1,&rfds,0,0, &tv);
                         
             if ( rc <= 0 ) // MAD did not answered
             {
                 goto error_mad_init;
             }
                                     
-            rc = read(mad_nebula_pipe, (void *) &c, sizeof(char));
+            rc = read(shard->mad_nebula_pipe, (void *) &c, sizeof(char));
             mstream.put(c);            
         }
         while ( rc > 0 && c != '\n');
@@ -283,34 +624,141 @@ error_pipes:
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int Mad::reload()
+int Mad::reload(MadShard * shard)
 {
-    char    buf[]="FINALIZE\n";
-    int     status;
-    int     rc;
-    pid_t   rp;
+    vector<pid_t> pids;
+    pid_t         driver_pid;
+
+    driver_pid = shard->finalize();
 
-    // Finish the driver
-    ::write(nebula_mad_pipe, buf, strlen(buf));
+    if ( driver_pid != -1 )
+    {
+        pids.push_back(driver_pid);
+    }
 
-    close(nebula_mad_pipe);
-    close(mad_nebula_pipe);
+    wait_drivers(pids);
 
-    rp = waitpid(pid, &status, WNOHANG);
+    shard->restarts++;
 
-    if ( rp == 0 )
+    // Start the MAD instance again
+
+    if ( start(shard) != 0 )
     {
-        sleep(1);
-        waitpid(pid, &status, WNOHANG);
+        pids.clear();
+
+        driver_pid = shard->finalize();
+
+        if ( driver_pid != -1 )
+        {
+            pids.push_back(driver_pid);
+        }
+
+        wait_drivers(pids);
+
+        return -1;
     }
 
-    // Start the MAD again
+    return 0;
+}
 
-    rc = start();
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
 
-    return rc;
+MadShard * Mad::route(const string& msg) const
+{
+    unsigned int num = shards.size();
+    unsigned int first;
+    long         id = 0;
+
+    size_t pos;
+
+    if ( num == 0 )
+    {
+        return 0;
+    }
+    else if ( num == 1 )
+    {
+        return shards[0];
+    }
+
+    pos = msg.find(' ');
+
+    if ( pos != string::npos )
+    {
+        id = strtol(msg.c_str() + pos + 1, 0, 10);
+    }
+
+    if ( id < 0 )
+    {
+        id = -id;
+    }
+
+    first = id % num;
+
+    for (unsigned int i = 0; i < num; i++)
+    {
+        MadShard * shard = shards[(first + i) % num];
+
+        if ( shard->pid != -1 )
+        {
+            return shard;
+        }
+    }
+
+    return shards[first];
 }
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int Mad::running() const
+{
+    int num = 0;
+
+    for (unsigned int i = 0; i < shards.size(); i++)
+    {
+        if ( shards[i]->pid != -1 )
+        {
+            num++;
+        }
+    }
+
+    return num;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Mad::write(ostringstream& os) const
+{
+    string     str   = os.str();
+    MadShard * shard = route(str);
+
+    if ( shard == 0 )
+    {
+        NebulaLog::log("MAD", Log::ERROR, "Driver not started, dropping message");
+        return;
+    }
+
+    shard->write(str);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Mad::to_xml(ostringstream& oss) const
+{
+    string name;
+
+    map<string,string>::const_iterator it = attributes.find("NAME");
+
+    if ( it != attributes.end() )
+    {
+        name = it->second;
+    }
+
+    for (unsigned int i = 0; i < shards.size(); i++)
+    {
+        shards[i]->to_xml(oss, name);
+    }
+}
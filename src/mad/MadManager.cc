@@ -22,6 +22,7 @@
 #include <sstream>
 
 #include "MadManager.h"
+#include "NebulaLog.h"
 #include "SyncRequest.h"
 
 /* -------------------------------------------------------------------------- */
@@ -58,7 +59,8 @@ extern "C" void * mad_manager_listener(
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-void MadManager::mad_manager_system_init()
+void MadManager::mad_manager_system_init(unsigned int queue_size,
+                                         const string& queue_policy)
 {
     struct sigaction  act;
 
@@ -67,6 +69,17 @@ void MadManager::mad_manager_system_init()
     sigemptyset(&act.sa_mask);
 
     sigaction(SIGPIPE,&act,NULL);
+
+    Mad::queue_limit = queue_size;
+
+    if ( queue_policy == "DROP" )
+    {
+        Mad::queue_policy = Mad::DROP;
+    }
+    else
+    {
+        Mad::queue_policy = Mad::BLOCK;
+    }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -92,7 +105,7 @@ int MadManager::start()
     fcntl(pipe_r, F_SETFD, FD_CLOEXEC);
     fcntl(pipe_w, F_SETFD, FD_CLOEXEC);
 
-    fds.push_back(pipe_r);
+    update_fds();
 
     rc = pthread_create(&listener_thread,
                         0,
@@ -156,6 +169,9 @@ int MadManager::add(Mad *mad)
 
     lock();
 
+    mad->wake_pipe       = pipe_w;
+    mad->listener_thread = listener_thread;
+
     rc = mad->start();
 
     if ( rc != 0 )
@@ -211,6 +227,37 @@ const Mad * MadManager::get(
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void MadManager::update_fds()
+{
+    fds.clear();
+    fd_mads.clear();
+    fd_shards.clear();
+
+    fds.push_back(pipe_r);
+    fd_mads.push_back(0);
+    fd_shards.push_back(0);
+
+    for (unsigned int i=0; i<mads.size(); i++)
+    {
+        for (unsigned int j=0; j<mads[i]->shards.size(); j++)
+        {
+            MadShard * shard = mads[i]->shards[j];
+
+            if ( shard->pid == -1 )
+            {
+                continue;
+            }
+
+            fds.push_back(shard->mad_nebula_pipe);
+            fd_mads.push_back(mads[i]);
+            fd_shards.push_back(shard);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void MadManager::listener()
 {
     int             greater;
@@ -220,11 +267,17 @@ void MadManager::listener()
     char            c;
 
     Mad *           mad;
+    MadShard *      shard;
     int             fd;
     fd_set          in_pipes;
+    fd_set          out_pipes;
     fd_set          rfds;
     struct timeval  tv;
 
+    ostringstream   oss;
+
+    vector<Mad *>::iterator it;
+
     pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, 0);
 
     pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED,0);
@@ -234,6 +287,7 @@ void MadManager::listener()
         lock();
 
         FD_ZERO(&in_pipes);
+        FD_ZERO(&out_pipes);
 
         for (i=0,greater=0; i < fds.size() ; i++)
         {
@@ -245,102 +299,149 @@ void MadManager::listener()
             }
         }
 
+        for (i=0; i < mads.size() ; i++) // Drivers with queued messages
+        {
+            for (j=0; j < mads[i]->shards.size(); j++)
+            {
+                shard = mads[i]->shards[j];
+
+                if ( shard->pid != -1 && shard->pending() )
+                {
+                    FD_SET(shard->nebula_mad_pipe, &out_pipes);
+
+                    if ( shard->nebula_mad_pipe > greater )
+                    {
+                        greater = shard->nebula_mad_pipe;
+                    }
+                }
+            }
+        }
+
         unlock();
 
-        // Wait for a message
-        rc = select(greater+1, &in_pipes, NULL, NULL, NULL);
+        // Wait for a message, or for a driver to read its pipe
+        rc = select(greater+1, &in_pipes, &out_pipes, NULL, NULL);
 
         if ( rc <= 0 )
         {
             continue;
         }
 
+        lock();
+
+        for (i=0; i < mads.size() ; i++)
+        {
+            for (j=0; j < mads[i]->shards.size(); j++)
+            {
+                shard = mads[i]->shards[j];
+
+                if ( shard->pid != -1 &&
+                     FD_ISSET(shard->nebula_mad_pipe, &out_pipes) )
+                {
+                    shard->flush();
+                }
+            }
+        }
+
+        unlock();
+
         for (i=0; i< fds.size(); i++)
         {
             fd  = fds[i];
 
             if ( FD_ISSET(fd, &in_pipes) )
             {
-                if ( fd == pipe_r ) // Driver added, update the fd vector
+                if ( fd == pipe_r ) // Driver added or messages queued
                 {
                     read(fd, (void *) &c, sizeof(char));
 
-                    lock();
-
-                    fds.clear();
-
-                    fds.push_back(pipe_r);
-
-                    for (j=0;j<mads.size();j++)
+                    if ( c != 'A' )
                     {
-                        fds.push_back(mads[j]->mad_nebula_pipe);
+                        continue;
                     }
 
+                    lock();
+
+                    update_fds();
+
                     unlock();
 
                     continue;
                 }
 
-                mad = mads[i-1];
+                mad   = fd_mads[i];
+                shard = fd_shards[i];
 
                 buffer.str("");
 
                 do
                 {
                     FD_ZERO(&rfds);
-                    FD_SET(mad->mad_nebula_pipe, &rfds);
+                    FD_SET(shard->mad_nebula_pipe, &rfds);
 
                     tv.tv_sec  = 0;
                     tv.tv_usec = 25000;
 
-                    rc = select(mad->mad_nebula_pipe+1,&rfds,0,0,&tv);
+                    rc = select(shard->mad_nebula_pipe+1,&rfds,0,0,&tv);
 
                     if ( rc <= 0 )
                     {
                         break;
                     }
 
-                    rc = read(mad->mad_nebula_pipe,(void *) &c,sizeof(char));
+                    rc = read(shard->mad_nebula_pipe,(void *) &c,sizeof(char));
                     buffer.put(c);
                 }
                 while ( rc > 0 && c != '\n');
 
-                if ( rc <= 0 ) // Error reload the driver and recover
+                if ( rc <= 0 ) // Error reload the driver instance and recover
                 {
-                    mrc = mad->reload();
+                    mrc = mad->reload(shard);
 
                     if ( mrc == 0 )
                     {
                         mad->recover();
                     }
+                    else if ( mad->running() > 0 )
+                    {
+                        // Messages are sent to the other instances
+
+                        oss.str("");
+                        oss << "Driver instance " << shard->index << " could "
+                            << "not be restarted, " << mad->running()
+                            << " instances still running";
+
+                        NebulaLog::log("MAD", Log::ERROR, oss);
+                    }
                     else
                     {
                         lock();
 
-                        mads.erase(mads.begin() + i - 1);
+                        for (it = mads.begin(); it != mads.end(); ++it)
+                        {
+                            if ( *it == mad )
+                            {
+                                mads.erase(it);
+                                break;
+                            }
+                        }
 
                         delete mad;
 
                         unlock();
-
                     }
 
                     // Update the fd vector with the new pipe's
 
                     lock();
 
-                    fds.clear();
-
-                    fds.push_back(pipe_r);
-
-                    for (j=0;j<mads.size();j++)
-                    {
-                        fds.push_back(mads[j]->mad_nebula_pipe);
-                    }
+                    update_fds();
 
                     unlock();
 
-                    continue;
+                    // The fd vector changed, wait for new messages
+
+                    break;
                 }
                 else //MAD specific protocol
                 {
@@ -459,3 +560,24 @@ void MadManager::notify_request(int id, bool result, const string& message)
 
     ar->notify();
 }
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+string& MadManager::drivers_to_xml(string& xml)
+{
+    ostringstream oss;
+
+    lock();
+
+    for (unsigned int i=0; i < mads.size(); i++)
+    {
+        mads[i]->to_xml(oss);
+    }
+
+    unlock();
+
+    xml = oss.str();
+
+    return xml;
+}
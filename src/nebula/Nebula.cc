@@ -19,6 +19,7 @@
 #include "VirtualMachine.h"
 #include "SqliteDB.h"
 #include "MySqlDB.h"
+#include "QuotasSQL.h"
 
 #include <stdlib.h>
 #include <stdexcept>
@@ -52,6 +53,7 @@ void Nebula::start(bool bootstrap_only)
     int             signal;
     char            hn[80];
     string          scripts_remote_dir;
+    bool            cache_prefetch;
 
     if ( gethostname(hn,79) != 0 )
     {
@@ -129,17 +131,6 @@ void Nebula::start(bool bootstrap_only)
         os << "Log level:" << clevel << " [0=ERROR,1=WARNING,2=INFO,3=DEBUG]";
 
         NebulaLog::log("ONE",Log::INFO,os);
-
-        os.str("");
-        os << "Support for xmlrpc-c > 1.31: ";
-
-#ifdef OLD_XMLRPC
-        os << "no. MAX_CONN and MAX_CONN_BACKLOG configuration will not be used";
-#else
-        os << "yes";
-#endif
-
-        NebulaLog::log("ONE",Log::INFO,os);
     }
     catch(runtime_error&)
     {
@@ -367,6 +358,7 @@ void Nebula::start(bool bootstrap_only)
             rc += UserPool::bootstrap(db);
             rc += AclManager::bootstrap(db);
             rc += ZonePool::bootstrap(db);
+            rc += ChangeLog::bootstrap(db);
 
             // Create the system tables only if bootstrap went well
             if ( rc == 0 )
@@ -423,7 +415,15 @@ void Nebula::start(bool bootstrap_only)
     //Managers
     // -----------------------------------------------------------
 
-    MadManager::mad_manager_system_init();
+    unsigned int driver_queue_size;
+    string       driver_queue_policy;
+
+    nebula_configuration->get("DRIVER_QUEUE_SIZE", driver_queue_size);
+    nebula_configuration->get("DRIVER_QUEUE_POLICY", driver_queue_policy);
+
+    one_util::toupper(driver_queue_policy);
+
+    MadManager::mad_manager_system_init(driver_queue_size, driver_queue_policy);
 
     time_t timer_period;
     time_t monitor_period;
@@ -434,7 +434,8 @@ void Nebula::start(bool bootstrap_only)
     // ---- ACL Manager ----
     try
     {
-        aclm = new AclManager(db, zone_id, is_federation_slave(), timer_period);
+        aclm = new AclManager(db, zone_id, is_federation_enabled(),
+                              is_federation_slave(), timer_period);
     }
     catch (bad_alloc&)
     {
@@ -448,6 +449,24 @@ void Nebula::start(bool bootstrap_only)
        throw runtime_error("Could not start the ACL Manager");
     }
 
+    // ---- Quota Writer ----
+    try
+    {
+        // Quotas updated by requests are written in the DB every second
+        quotaw = new QuotaWriter(db, 1);
+    }
+    catch (bad_alloc&)
+    {
+        throw;
+    }
+
+    rc = quotaw->start();
+
+    if ( rc != 0 )
+    {
+       throw runtime_error("Could not start the Quota Writer");
+    }
+
     // -----------------------------------------------------------
     // Pools
     // -----------------------------------------------------------
@@ -529,6 +548,9 @@ void Nebula::start(bool bootstrap_only)
                                         remotes_location,
                                         inherit_vnet_attrs);
 
+        // Zones of a federation share the quotas, written synchronously
+        QuotasSQL::set_write_behind(!is_federation_enabled());
+
         gpool  = new GroupPool(db, group_hooks,
                             remotes_location, is_federation_slave());
 
@@ -566,6 +588,15 @@ void Nebula::start(bool bootstrap_only)
         throw;
     }
 
+    // ---- Cache prefetch ----
+
+    nebula_configuration->get("CACHE_PREFETCH", cache_prefetch);
+
+    if ( cache_prefetch )
+    {
+        prefetch_pools();
+    }
+
 
     // ---- Virtual Machine Manager ----
     try
@@ -822,7 +853,14 @@ void Nebula::start(bool bootstrap_only)
         int  keepalive_timeout;
         int  keepalive_max_conn;
         int  timeout;
+        int  rpc_threads;
+        int  concurrency[RequestServer::NUM_CLASSES];
+        int  queue_size[RequestServer::NUM_CLASSES];
         bool rpc_log;
+        bool rpc_prometheus;
+        int  proxy_connections;
+        int  proxy_pipeline;
+        int  proxy_timeout;
         string log_call_format;
         string rpc_filename = "";
 
@@ -832,7 +870,20 @@ void Nebula::start(bool bootstrap_only)
         nebula_configuration->get("KEEPALIVE_TIMEOUT", keepalive_timeout);
         nebula_configuration->get("KEEPALIVE_MAX_CONN", keepalive_max_conn);
         nebula_configuration->get("TIMEOUT", timeout);
+        nebula_configuration->get("RPC_THREADS", rpc_threads);
+        nebula_configuration->get("RPC_READ_CONCURRENCY",
+                concurrency[RequestServer::READ]);
+        nebula_configuration->get("RPC_READ_QUEUE",
+                queue_size[RequestServer::READ]);
+        nebula_configuration->get("RPC_WRITE_CONCURRENCY",
+                concurrency[RequestServer::WRITE]);
+        nebula_configuration->get("RPC_WRITE_QUEUE",
+                queue_size[RequestServer::WRITE]);
         nebula_configuration->get("RPC_LOG", rpc_log);
+        nebula_configuration->get("RPC_PROMETHEUS", rpc_prometheus);
+        nebula_configuration->get("RPC_PROXY_CONNECTIONS", proxy_connections);
+        nebula_configuration->get("RPC_PROXY_PIPELINE", proxy_pipeline);
+        nebula_configuration->get("RPC_PROXY_TIMEOUT", proxy_timeout);
         nebula_configuration->get("LOG_CALL_FORMAT", log_call_format);
 
         if (rpc_log)
@@ -841,8 +892,9 @@ void Nebula::start(bool bootstrap_only)
         }
 
         rm = new RequestManager(rm_port, max_conn, max_conn_backlog,
-            keepalive_timeout, keepalive_max_conn, timeout, rpc_filename,
-            log_call_format);
+            keepalive_timeout, keepalive_max_conn, timeout, rpc_threads,
+            concurrency, queue_size, rpc_filename, log_call_format,
+            rpc_prometheus, proxy_connections, proxy_pipeline, proxy_timeout);
     }
     catch (bad_alloc&)
     {
@@ -901,6 +953,25 @@ void Nebula::start(bool bootstrap_only)
         pthread_join(aclm->get_thread_id(),0);
     }
 
+    // Quotas are written once all the managers are stopped
+    quotaw->finalize();
+
+    pthread_join(quotaw->get_thread_id(),0);
+
+    // Last synchronous write, for the quotas updated after the writer flush
+    // or that failed to be written by it
+    for (int i = 0; QuotasSQL::flush(db) != 0; i++)
+    {
+        if ( i == 2 )
+        {
+            NebulaLog::log("ONE", Log::ERROR, "Could not write the pending "
+                "quotas, run onedb fsck to recompute the quota usage.");
+            break;
+        }
+
+        sleep(1);
+    }
+
     //XML Library
     xmlCleanupParser();
 
@@ -913,3 +984,81 @@ error_mad:
     throw runtime_error("Could not load an OpenNebula driver");
 }
 
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Nebula::prefetch_pools()
+{
+    unsigned int  num_threads;
+    ostringstream oss;
+
+    time_t start = time(0);
+    int    total = 0;
+    int    rc;
+
+    nebula_configuration->get("CACHE_PREFETCH_THREADS", num_threads);
+
+    if ( num_threads == 0 )
+    {
+        long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        num_threads = ncpus > 0 ? ncpus : 1;
+    }
+
+    oss << "Prefetching pool caches with " << num_threads << " threads.";
+    NebulaLog::log("ONE", Log::INFO, oss);
+
+    oss.str("");
+    oss << "state <> " << Host::DISABLED;
+
+    string host_where = oss.str();
+
+    oss.str("");
+    oss << "state <> " << VirtualMachine::DONE;
+
+    string vm_where = oss.str();
+
+    struct
+    {
+        const char *  name;
+        PoolSQL *     pool;
+        const string* where;
+    } pools[] = {
+        { "clusters",         clpool, 0 },
+        { "hosts",            hpool,  &host_where },
+        { "datastores",       dspool, 0 },
+        { "virtual networks", vnpool, 0 },
+        { "virtual machines", vmpool, &vm_where }
+    };
+
+    for (unsigned int i = 0; i < sizeof(pools)/sizeof(pools[0]); i++)
+    {
+        time_t pstart = time(0);
+
+        rc = pools[i].pool->prefetch(
+                pools[i].where != 0 ? *pools[i].where : "", num_threads);
+
+        oss.str("");
+
+        if ( rc < 0 )
+        {
+            oss << "Could not prefetch " << pools[i].name << ", they will be "
+                << "loaded on demand.";
+            NebulaLog::log("ONE", Log::WARNING, oss);
+
+            continue;
+        }
+
+        total += rc;
+
+        oss << "Prefetched " << rc << " " << pools[i].name << " in "
+            << time(0) - pstart << "s.";
+        NebulaLog::log("ONE", Log::INFO, oss);
+    }
+
+    oss.str("");
+    oss << "Pool caches prefetched, " << total << " objects in "
+        << time(0) - start << "s.";
+    NebulaLog::log("ONE", Log::INFO, oss);
+}
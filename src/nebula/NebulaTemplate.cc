@@ -94,6 +94,18 @@ void OpenNebulaTemplate::set_conf_default()
 
     attribute = new SingleAttribute("MANAGER_TIMER",value);
     conf_default.insert(make_pair(attribute->name(),attribute));
+
+    // DRIVER_QUEUE_SIZE
+    value = "1024";
+
+    attribute = new SingleAttribute("DRIVER_QUEUE_SIZE",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
+    // DRIVER_QUEUE_POLICY
+    value = "BLOCK";
+
+    attribute = new SingleAttribute("DRIVER_QUEUE_POLICY",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
 /*
 #*******************************************************************************
 # Daemon configuration attributes
@@ -110,6 +122,9 @@ void OpenNebulaTemplate::set_conf_default()
 #  VNC_BASE_PORT
 #  SCRIPTS_REMOTE_DIR
 #  VM_SUBMIT_ON_HOLD
+#  MAX_INSTANTIATE_VMS
+#  CACHE_PREFETCH
+#  CACHE_PREFETCH_THREADS
 #*******************************************************************************
 */
     // MONITORING_INTERVAL
@@ -190,6 +205,24 @@ void OpenNebulaTemplate::set_conf_default()
     attribute = new SingleAttribute("VM_SUBMIT_ON_HOLD",value);
     conf_default.insert(make_pair(attribute->name(),attribute));
 
+    // MAX_INSTANTIATE_VMS
+    value = "100";
+
+    attribute = new SingleAttribute("MAX_INSTANTIATE_VMS",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
+    // CACHE_PREFETCH
+    value = "NO";
+
+    attribute = new SingleAttribute("CACHE_PREFETCH",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
+    // CACHE_PREFETCH_THREADS
+    value = "0";
+
+    attribute = new SingleAttribute("CACHE_PREFETCH_THREADS",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
     // LOG CONFIGURATION
     vvalue.clear();
     vvalue.insert(make_pair("SYSTEM","file"));
@@ -224,7 +257,16 @@ void OpenNebulaTemplate::set_conf_default()
 #  KEEPALIVE_TIMEOUT
 #  KEEPALIVE_MAX_CONN
 #  TIMEOUT
+#  RPC_THREADS
+#  RPC_READ_CONCURRENCY
+#  RPC_READ_QUEUE
+#  RPC_WRITE_CONCURRENCY
+#  RPC_WRITE_QUEUE
 #  RPC_LOG
+#  RPC_PROMETHEUS
+#  RPC_PROXY_CONNECTIONS
+#  RPC_PROXY_PIPELINE
+#  RPC_PROXY_TIMEOUT
 #  MESSAGE_SIZE
 #  LOG_CALL_FORMAT
 #*******************************************************************************
@@ -259,12 +301,66 @@ void OpenNebulaTemplate::set_conf_default()
     attribute = new SingleAttribute("TIMEOUT",value);
     conf_default.insert(make_pair(attribute->name(),attribute));
 
+    // RPC_THREADS
+    value = "16";
+
+    attribute = new SingleAttribute("RPC_THREADS",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
+    // RPC_READ_CONCURRENCY
+    value = "8";
+
+    attribute = new SingleAttribute("RPC_READ_CONCURRENCY",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
+    // RPC_READ_QUEUE
+    value = "256";
+
+    attribute = new SingleAttribute("RPC_READ_QUEUE",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
+    // RPC_WRITE_CONCURRENCY
+    value = "16";
+
+    attribute = new SingleAttribute("RPC_WRITE_CONCURRENCY",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
+    // RPC_WRITE_QUEUE
+    value = "1024";
+
+    attribute = new SingleAttribute("RPC_WRITE_QUEUE",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
     // RPC_LOG
     value = "NO";
 
     attribute = new SingleAttribute("RPC_LOG",value);
     conf_default.insert(make_pair(attribute->name(),attribute));
 
+    // RPC_PROMETHEUS
+    value = "NO";
+
+    attribute = new SingleAttribute("RPC_PROMETHEUS",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
+    // RPC_PROXY_CONNECTIONS
+    value = "4";
+
+    attribute = new SingleAttribute("RPC_PROXY_CONNECTIONS",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
+    // RPC_PROXY_PIPELINE
+    value = "4";
+
+    attribute = new SingleAttribute("RPC_PROXY_PIPELINE",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
+    // RPC_PROXY_TIMEOUT
+    value = "60";
+
+    attribute = new SingleAttribute("RPC_PROXY_TIMEOUT",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
     //MESSAGE_SIZE
     value = "1073741824";
 
@@ -0,0 +1,717 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Synthetic load benchmark for oned. It drives an oned instance (SQLite or
+ *  MySQL backend) configured with the dummy IM, VMM and TM drivers, and
+ *  measures at increasing pool sizes:
+ *    - VM allocate, deploy and shutdown throughput
+ *    - Latency percentiles of one.vm.info and one.vmpool.info
+ *    - The VM pool cache hit ratio (one.system.metrics)
+ *  and the host monitoring ingest rate. Results are written in JSON.
+ *
+ *  The benchmark creates a system datastore, hosts and VMs that are not
+ *  removed, it is meant to be used with a scratch oned database.
+ */
+
+#include "Client.h"
+#include "ObjectXML.h"
+#include "NebulaUtil.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <set>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+using namespace std;
+
+/* -------------------------------------------------------------------------- */
+/* XML-RPC helpers                                                            */
+/* -------------------------------------------------------------------------- */
+
+static Client * client;
+
+static double now()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, 0);
+
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ *  @return a parameter list with the session string
+ */
+static xmlrpc_c::paramList session()
+{
+    xmlrpc_c::paramList params;
+
+    params.add(xmlrpc_c::value_string(client->get_oneauth()));
+
+    return params;
+}
+
+/**
+ *  Calls an oned method
+ *    @param method name
+ *    @param params of the call, including the session
+ *    @param response the body of the response (or the error message)
+ *    @param latency of the call, in seconds
+ *    @return 0 on success
+ */
+static int call(const char * method, const xmlrpc_c::paramList& params,
+        string& response, double& latency)
+{
+    xmlrpc_c::value result;
+    double          start = now();
+
+    try
+    {
+        client->call(client->get_endpoint(), method, params, &result);
+
+        latency = now() - start;
+
+        vector<xmlrpc_c::value> values =
+                        xmlrpc_c::value_array(result).vectorValueValue();
+
+        bool success = xmlrpc_c::value_boolean(values[0]);
+
+        if ( values[1].type() == xmlrpc_c::value::TYPE_INT )
+        {
+            ostringstream oss;
+
+            oss << static_cast<int>(xmlrpc_c::value_int(values[1]));
+
+            response = oss.str();
+        }
+        else
+        {
+            response = xmlrpc_c::value_string(values[1]);
+        }
+
+        return success ? 0 : -1;
+    }
+    catch (exception const& e)
+    {
+        latency  = now() - start;
+        response = e.what();
+
+        return -1;
+    }
+}
+
+static int call(const char * method, const xmlrpc_c::paramList& params,
+        string& response)
+{
+    double latency;
+
+    return call(method, params, response, latency);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Results                                                                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Latency samples of a method, in seconds
+ */
+class Latency
+{
+public:
+    void add(double latency)
+    {
+        samples.push_back(latency);
+    };
+
+    double percentile(double p)
+    {
+        if ( samples.empty() )
+        {
+            return 0;
+        }
+
+        sort(samples.begin(), samples.end());
+
+        size_t i = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+
+        return samples[i];
+    };
+
+    void to_json(ostream& os)
+    {
+        os << fixed << setprecision(3)
+           << "{\"calls\": " << samples.size()
+           << ", \"p50_ms\": " << percentile(0.50) * 1e3
+           << ", \"p90_ms\": " << percentile(0.90) * 1e3
+           << ", \"p99_ms\": " << percentile(0.99) * 1e3
+           << ", \"max_ms\": " << percentile(1) * 1e3 << "}";
+    };
+
+private:
+    vector<double> samples;
+};
+
+/**
+ *  Throughput of an operation
+ */
+struct Throughput
+{
+    Throughput():ops(0), errors(0), seconds(0){};
+
+    int    ops;
+    int    errors;
+    double seconds;
+
+    void to_json(ostream& os)
+    {
+        os << fixed << setprecision(3)
+           << "{\"ops\": " << ops << ", \"errors\": " << errors
+           << ", \"seconds\": " << seconds
+           << ", \"ops_per_second\": " << (seconds > 0 ? ops / seconds : 0)
+           << "}";
+    };
+};
+
+/**
+ *  Cache statistics of the VM pool
+ */
+struct CacheStats
+{
+    CacheStats():hits(0), misses(0){};
+
+    unsigned long hits;
+    unsigned long misses;
+
+    int get()
+    {
+        string metrics;
+
+        if ( call("one.system.metrics", session(), metrics) != 0 )
+        {
+            cerr << "Error getting the oned metrics: " << metrics << endl;
+            return -1;
+        }
+
+        ObjectXML xml(metrics);
+
+        vector<string> h = xml["/METRICS/POOL_CACHE/POOL[NAME='VM']/HITS"];
+        vector<string> m = xml["/METRICS/POOL_CACHE/POOL[NAME='VM']/MISSES"];
+
+        if ( h.empty() || m.empty() )
+        {
+            return -1;
+        }
+
+        hits   = strtoul(h[0].c_str(), 0, 10);
+        misses = strtoul(m[0].c_str(), 0, 10);
+
+        return 0;
+    };
+
+    void to_json(ostream& os, const CacheStats& start)
+    {
+        unsigned long h = hits - start.hits;
+        unsigned long m = misses - start.misses;
+
+        os << fixed << setprecision(4)
+           << "{\"hits\": " << h << ", \"misses\": " << m
+           << ", \"hit_ratio\": " << (h + m > 0 ? h / (double)(h + m) : 0)
+           << "}";
+    };
+};
+
+/* -------------------------------------------------------------------------- */
+/* Benchmark phases                                                           */
+/* -------------------------------------------------------------------------- */
+
+static int ds_id;
+
+static vector<int> host_ids;
+
+static vector<int> vm_ids;
+
+/**
+ *  Index in vm_ids of the next VM to deploy
+ */
+static unsigned int next_deploy = 0;
+
+static int set_up(int num_hosts)
+{
+    string  response;
+    ostringstream oss;
+
+    xmlrpc_c::paramList ds_params = session();
+
+    oss << "NAME=\"bench_system_" << getpid() << "\"\n"
+        << "TYPE=SYSTEM_DS\nTM_MAD=dummy\n";
+
+    ds_params.add(xmlrpc_c::value_string(oss.str()));
+    ds_params.add(xmlrpc_c::value_int(-1));
+
+    if ( call("one.datastore.allocate", ds_params, response) != 0 )
+    {
+        cerr << "Error creating the system datastore: " << response << endl;
+        return -1;
+    }
+
+    ds_id = atoi(response.c_str());
+
+    for (int i = 0; i < num_hosts; i++)
+    {
+        xmlrpc_c::paramList params = session();
+
+        oss.str("");
+        oss << "bench-" << getpid() << "-" << i;
+
+        params.add(xmlrpc_c::value_string(oss.str()));
+        params.add(xmlrpc_c::value_string("dummy"));
+        params.add(xmlrpc_c::value_string("dummy"));
+        params.add(xmlrpc_c::value_string("dummy"));
+        params.add(xmlrpc_c::value_int(-1));
+
+        if ( call("one.host.allocate", params, response) != 0 )
+        {
+            cerr << "Error creating host: " << response << endl;
+            return -1;
+        }
+
+        host_ids.push_back(atoi(response.c_str()));
+    }
+
+    return 0;
+}
+
+/**
+ *  Allocates VMs (on hold) till the pool has the given size
+ */
+static void allocate(unsigned int size, Throughput& tp, Latency& lt)
+{
+    static const char * vm_template = "NAME=bench\nCPU=0.01\nMEMORY=1\n";
+
+    string response;
+    double latency;
+    double start = now();
+
+    while ( vm_ids.size() < size )
+    {
+        xmlrpc_c::paramList params = session();
+
+        params.add(xmlrpc_c::value_string(vm_template));
+        params.add(xmlrpc_c::value_boolean(true));
+
+        if ( call("one.vm.allocate", params, response, latency) != 0 )
+        {
+            if ( ++tp.errors > 100 )
+            {
+                cerr << "Too many errors allocating VMs: " << response << endl;
+                break;
+            }
+
+            continue;
+        }
+
+        vm_ids.push_back(atoi(response.c_str()));
+
+        lt.add(latency);
+        tp.ops++;
+    }
+
+    tp.seconds = now() - start;
+}
+
+/**
+ *  Gets random VMs
+ */
+static void vm_info(int calls, Latency& lt)
+{
+    string response;
+    double latency;
+
+    for (int i = 0; i < calls; i++)
+    {
+        xmlrpc_c::paramList params = session();
+
+        params.add(xmlrpc_c::value_int(vm_ids[rand() % vm_ids.size()]));
+
+        if ( call("one.vm.info", params, response, latency) == 0 )
+        {
+            lt.add(latency);
+        }
+    }
+}
+
+/**
+ *  Lists windows of VMs starting in a random VM
+ */
+static void vmpool_info(int calls, int window, Latency& lt)
+{
+    string response;
+    double latency;
+
+    for (int i = 0; i < calls; i++)
+    {
+        xmlrpc_c::paramList params = session();
+
+        int start_id = vm_ids[rand() % vm_ids.size()];
+
+        params.add(xmlrpc_c::value_int(-2));
+        params.add(xmlrpc_c::value_int(start_id));
+        params.add(xmlrpc_c::value_int(start_id + window - 1));
+        params.add(xmlrpc_c::value_int(-2));
+
+        if ( call("one.vmpool.info", params, response, latency) == 0 )
+        {
+            lt.add(latency);
+        }
+    }
+}
+
+/**
+ *  Waits for a set of VMs to reach a state
+ *    @param vms the VM ids
+ *    @param xpath to the ids of the VMs in the target state
+ *    @param timeout in seconds
+ *    @return number of VMs in the target state
+ */
+static unsigned int wait_vms(const set<int>& vms, const string& xpath,
+        int timeout)
+{
+    string response;
+    double start = now();
+
+    unsigned int done = 0;
+
+    while ( done < vms.size() && now() - start < timeout )
+    {
+        xmlrpc_c::paramList params = session();
+
+        params.add(xmlrpc_c::value_int(-2));
+        params.add(xmlrpc_c::value_int(*vms.begin()));
+        params.add(xmlrpc_c::value_int(*vms.rbegin()));
+        params.add(xmlrpc_c::value_int(-2));
+
+        done = 0;
+
+        if ( call("one.vmpool.info", params, response) == 0 )
+        {
+            ObjectXML      xml(response);
+            vector<string> ids = xml[xpath.c_str()];
+
+            for (unsigned int i = 0; i < ids.size(); i++)
+            {
+                if ( vms.count(atoi(ids[i].c_str())) > 0 )
+                {
+                    done++;
+                }
+            }
+        }
+
+        if ( done < vms.size() )
+        {
+            usleep(100000);
+        }
+    }
+
+    return done;
+}
+
+/**
+ *  Deploys and then shuts down VMs, the time includes the driver operations
+ *  till the VMs are RUNNING and DONE
+ */
+static void deploy_shutdown(int num_vms, int timeout, Throughput& deploy,
+        Throughput& shutdown)
+{
+    string   response;
+    set<int> vms;
+    double   start = now();
+
+    for (int i = 0; i < num_vms && next_deploy < vm_ids.size(); i++)
+    {
+        xmlrpc_c::paramList params = session();
+
+        int vid = vm_ids[next_deploy++];
+
+        params.add(xmlrpc_c::value_int(vid));
+        params.add(xmlrpc_c::value_int(host_ids[i % host_ids.size()]));
+        params.add(xmlrpc_c::value_boolean(false));
+        params.add(xmlrpc_c::value_int(ds_id));
+
+        if ( call("one.vm.deploy", params, response) != 0 )
+        {
+            deploy.errors++;
+            continue;
+        }
+
+        vms.insert(vid);
+    }
+
+    if ( vms.empty() )
+    {
+        return;
+    }
+
+    deploy.ops     = wait_vms(vms, "/VM_POOL/VM[LCM_STATE=3]/ID", timeout);
+    deploy.seconds = now() - start;
+
+    start = now();
+
+    for (set<int>::iterator it = vms.begin(); it != vms.end(); it++)
+    {
+        xmlrpc_c::paramList params = session();
+
+        params.add(xmlrpc_c::value_string("shutdown"));
+        params.add(xmlrpc_c::value_int(*it));
+
+        if ( call("one.vm.action", params, response) != 0 )
+        {
+            shutdown.errors++;
+        }
+    }
+
+    shutdown.ops     = wait_vms(vms, "/VM_POOL/VM[STATE=6]/ID", timeout);
+    shutdown.seconds = now() - start;
+}
+
+/**
+ *  Counts the host monitoring records stored by oned in a time window
+ */
+static void monitoring(int seconds, Throughput& tp)
+{
+    string response;
+    time_t start = time(0);
+
+    sleep(seconds);
+
+    if ( call("one.hostpool.monitoring", session(), response) != 0 )
+    {
+        cerr << "Error getting the host monitoring: " << response << endl;
+        tp.errors++;
+        return;
+    }
+
+    ObjectXML xml(response);
+
+    vector<string> ids;
+    ostringstream  oss;
+
+    oss << "/MONITORING_DATA/HOST[LAST_MON_TIME > " << start << "]/ID";
+
+    ids = xml[oss.str().c_str()];
+
+    for (unsigned int i = 0; i < ids.size(); i++)
+    {
+        int hid = atoi(ids[i].c_str());
+
+        if ( find(host_ids.begin(), host_ids.end(), hid) != host_ids.end() )
+        {
+            tp.ops++;
+        }
+    }
+
+    tp.seconds = seconds;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+static void print_usage(const char * name)
+{
+    cout << "Usage: " << name << " [-s scales] [-H hosts] [-r calls] "
+         << "[-w window] [-d vms]\n"
+         << "         [-m seconds] [-t timeout] [-e endpoint] [-o file]\n"
+         << "  -s: comma separated list of VM pool sizes (1000,10000,100000)\n"
+         << "  -H: number of dummy hosts (10)\n"
+         << "  -r: number of one.vm.info calls per pool size (1000)\n"
+         << "  -w: VMs listed in each one.vmpool.info call (100)\n"
+         << "  -d: VMs deployed and shut down per pool size (100)\n"
+         << "  -m: seconds to measure the host monitoring ingest rate (30)\n"
+         << "  -t: timeout for deploy and shutdown operations (600)\n"
+         << "  -e: oned endpoint (ONE_XMLRPC or http://localhost:2633/RPC2)\n"
+         << "  -o: write the JSON results to this file (stdout)\n"
+         << "Credentials are read from ONE_AUTH, oned must be configured with "
+         << "the dummy\nIM, VMM and TM drivers.\n";
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char ** argv)
+{
+    string scales_list = "1000,10000,100000";
+    string endpoint;
+    string out_file;
+
+    int num_hosts = 10;
+    int calls     = 1000;
+    int window    = 100;
+    int deploys   = 100;
+    int mon_time  = 30;
+    int timeout   = 600;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:H:r:w:d:m:t:e:o:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 's': scales_list = optarg; break;
+            case 'H': num_hosts   = atoi(optarg); break;
+            case 'r': calls       = atoi(optarg); break;
+            case 'w': window      = atoi(optarg); break;
+            case 'd': deploys     = atoi(optarg); break;
+            case 'm': mon_time    = atoi(optarg); break;
+            case 't': timeout     = atoi(optarg); break;
+            case 'e': endpoint    = optarg; break;
+            case 'o': out_file    = optarg; break;
+            default:
+                print_usage(argv[0]);
+                return -1;
+        }
+    }
+
+    if ( num_hosts < 1 || calls < 1 || window < 1 )
+    {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    vector<string> scales = one_util::split(scales_list, ',');
+
+    NebulaLog::init_log_system(NebulaLog::CERR,
+                               Log::ERROR,
+                               0,
+                               ios_base::trunc,
+                               "oned_bench");
+    try
+    {
+        client = new Client("", endpoint, 1073741824);
+    }
+    catch (exception const& e)
+    {
+        cerr << "Error creating the XML-RPC client: " << e.what() << endl;
+        return -1;
+    }
+
+    xmlInitParser();
+
+    srand(getpid());
+
+    if ( set_up(num_hosts) != 0 )
+    {
+        return -1;
+    }
+
+    ostringstream oss;
+
+    oss << "{\n  \"endpoint\": \"" << client->get_endpoint() << "\",\n"
+        << "  \"hosts\": " << num_hosts << ",\n  \"scales\": [";
+
+    for (unsigned int i = 0; i < scales.size(); i++)
+    {
+        unsigned int size = strtoul(scales[i].c_str(), 0, 10);
+
+        Throughput alloc_tp, deploy_tp, shutdown_tp;
+        Latency    alloc_lt, info_lt, pool_lt;
+        CacheStats cache_start, cache_end;
+
+        cerr << "Pool size " << size << ": allocating VMs..." << endl;
+
+        allocate(size, alloc_tp, alloc_lt);
+
+        if ( vm_ids.empty() )
+        {
+            cerr << "No VMs could be allocated" << endl;
+            return -1;
+        }
+
+        cerr << "Pool size " << size << ": info calls..." << endl;
+
+        cache_start.get();
+
+        vm_info(calls, info_lt);
+
+        cache_end.get();
+
+        vmpool_info(calls / 10 > 0 ? calls / 10 : 1, window, pool_lt);
+
+        cerr << "Pool size " << size << ": deploy and shutdown..." << endl;
+
+        deploy_shutdown(deploys, timeout, deploy_tp, shutdown_tp);
+
+        oss << (i == 0 ? "\n" : ",\n")
+            << "    {\n      \"vms\": " << vm_ids.size() << ",\n"
+            << "      \"allocate\": ";
+        alloc_tp.to_json(oss);
+
+        oss << ",\n      \"allocate_latency\": ";
+        alloc_lt.to_json(oss);
+
+        oss << ",\n      \"deploy\": ";
+        deploy_tp.to_json(oss);
+
+        oss << ",\n      \"shutdown\": ";
+        shutdown_tp.to_json(oss);
+
+        oss << ",\n      \"vm_info\": ";
+        info_lt.to_json(oss);
+
+        oss << ",\n      \"vmpool_info\": ";
+        pool_lt.to_json(oss);
+
+        oss << ",\n      \"vm_cache\": ";
+        cache_end.to_json(oss, cache_start);
+
+        oss << "\n    }";
+    }
+
+    Throughput mon_tp;
+
+    cerr << "Measuring host monitoring for " << mon_time << "s..." << endl;
+
+    monitoring(mon_time, mon_tp);
+
+    oss << "\n  ],\n  \"monitoring\": ";
+    mon_tp.to_json(oss);
+    oss << "\n}\n";
+
+    if ( out_file.empty() )
+    {
+        cout << oss.str();
+    }
+    else
+    {
+        ofstream file(out_file.c_str());
+
+        file << oss.str();
+    }
+
+    xmlCleanupParser();
+
+    delete client;
+
+    NebulaLog::finalize_log_system();
+
+    return 0;
+}
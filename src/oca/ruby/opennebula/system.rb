@@ -29,7 +29,9 @@ module OpenNebula
             :groupquotainfo     => "groupquota.info",
             :groupquotaupdate   => "groupquota.update",
             :version            => "system.version",
-            :config             => "system.config"
+            :config             => "system.config",
+            :metrics            => "system.metrics",
+            :batch              => "system.batch"
         }
 
         #######################################################################
@@ -86,6 +88,47 @@ module OpenNebula
             return config
         end
 
+        # Gets the oned internal metrics
+        #
+        # @return [XMLElement, OpenNebula::Error] the oned metrics in case
+        #   of success, Error otherwise
+        def get_metrics()
+            rc = @client.call(SYSTEM_METHODS[:metrics])
+
+            if OpenNebula.is_error?(rc)
+                return rc
+            end
+
+            metrics = XMLElement.new
+            metrics.initialize_xml(rc, 'METRICS')
+
+            return metrics
+        end
+
+        # Executes a list of calls in a single request, authenticating the
+        # session only once
+        #
+        # @param calls [Array] each call is an Array with the method name,
+        #   without the "one." prefix and the session, and its parameters.
+        #   e.g. [["vm.action", "resume", 3], ["vm.action", "resume", 4]]
+        # @param parallel [true, false] execute the calls concurrently
+        #
+        # @return [Array, OpenNebula::Error] the result of each call, the
+        #   call response or an Error, in case of success, Error otherwise
+        def batch(calls, parallel=false)
+            calls = calls.map { |c| ["one."+c[0]] + c[1..-1] }
+
+            rc = @client.call(SYSTEM_METHODS[:batch], calls, parallel)
+
+            if OpenNebula.is_error?(rc)
+                return rc
+            end
+
+            return rc.map { |r|
+                r[0] == false ? Error.new(r[1], r[2]) : r[1]
+            }
+        end
+
         # Gets the default user quota limits
         #
         # @return [XMLElement, OpenNebula::Error] the default user quota in case
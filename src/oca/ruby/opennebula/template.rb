@@ -27,6 +27,7 @@ module OpenNebula
         TEMPLATE_METHODS = {
             :allocate    => "template.allocate",
             :instantiate => "template.instantiate",
+            :instantiate_bulk => "template.instantiatebulk",
             :info        => "template.info",
             :update      => "template.update",
             :delete      => "template.delete",
@@ -110,6 +111,33 @@ module OpenNebula
             return rc
         end
 
+        # Creates a number of VM instances from a Template in a single call
+        #
+        # @param number [Integer] Number of VMs to create
+        # @param name [String] Name for the VM instances, "%i" is replaced by
+        #   the index of each VM. If it is an empty string OpenNebula will set
+        #   a default name
+        # @param hold [true,false] false to create the VMs in pending state,
+        #   true to create them on hold
+        # @param template [String] User provided Template to merge with the
+        #   one being instantiated
+        #
+        # @return [String, OpenNebula::Error] XML with the ID of the new VMs,
+        #   and an ERROR element for each VM that could not be created. Error
+        #   if no VM was created
+        def instantiate_bulk(number, name="", hold=false, template="")
+            return Error.new('ID not defined') if !@pe_id
+
+            name ||= ""
+            hold = false if hold.nil?
+            template ||= ""
+
+            rc = @client.call(TEMPLATE_METHODS[:instantiate_bulk], @pe_id,
+                number.to_i, name, hold, template)
+
+            return rc
+        end
+
         # Replaces the template contents
         #
         # @param new_template [String] New template contents
@@ -22,8 +22,8 @@ require 'set'
 require 'nokogiri'
 
 module OneDBFsck
-    VERSION = "4.6.0"
-    LOCAL_VERSION = "4.11.80"
+    VERSION = "4.11.85"
+    LOCAL_VERSION = "4.11.85"
 
     def check_db_version()
         db_version = read_db_version()
@@ -284,39 +284,42 @@ EOT
 
         if !db_version[:is_slave]
             @db.run "CREATE TABLE group_pool_new (oid INTEGER PRIMARY KEY, name VARCHAR(128), body MEDIUMTEXT, uid INTEGER, gid INTEGER, owner_u INTEGER, group_u INTEGER, other_u INTEGER, UNIQUE(name));"
+            @db.run "CREATE TABLE group_users_new (group_oid INTEGER, user_oid INTEGER, PRIMARY KEY(group_oid, user_oid));"
         end
 
+        group_users = read_collection("group_users", :group_oid, :user_oid)
+
         @db.transaction do
             @db.fetch("SELECT * from group_pool") do |row|
                 gid = row[:oid]
                 doc = Nokogiri::XML(row[:body]){|c| c.default_xml.noblanks}
 
-                users_elem = doc.root.at_xpath("USERS")
-                users_elem.remove if !users_elem.nil?
-
-                users_new_elem = doc.create_element("USERS")
-                doc.root.add_child(users_new_elem)
+                # re-do list of user IDs, stored in the group_users table
+                users = group_users[gid] || Set.new
 
                 error_found = false
 
                 group[gid].each do |id|
-                    id_elem = users_elem.at_xpath("ID[.=#{id}]")
-
-                    if id_elem.nil?
+                    if users.delete?(id).nil?
                         log_error("User #{id} is missing from Group #{gid} users id list")
                         error_found = true
-                    else
-                        id_elem.remove
                     end
 
-                    users_new_elem.add_child(doc.create_element("ID")).content = id.to_s
+                    if !db_version[:is_slave]
+                        @db[:group_users_new].insert(
+                            :group_oid  => gid,
+                            :user_oid   => id)
+                    end
                 end
 
-                users_elem.xpath("ID").each do |id_elem|
-                    log_error("User #{id_elem.text} is in Group #{gid} users id list, but it should not")
+                users.each do |id|
+                    log_error("User #{id} is in Group #{gid} users id list, but it should not")
                     error_found = true
                 end
 
+                doc.root.xpath("USERS").each { |e| e.remove }
+                doc.root.add_child(doc.create_element("USERS"))
+
                 row[:body] = doc.root.to_s
 
                 if !db_version[:is_slave]
@@ -332,6 +335,9 @@ EOT
             # Rename table
             @db.run("DROP TABLE group_pool")
             @db.run("ALTER TABLE group_pool_new RENAME TO group_pool")
+
+            @db.run("DROP TABLE group_users")
+            @db.run("ALTER TABLE group_users_new RENAME TO group_users")
         end
 
         log_time()
@@ -523,71 +529,81 @@ EOT
         log_time()
 
         @db.run "CREATE TABLE cluster_pool_new (oid INTEGER PRIMARY KEY, name VARCHAR(128), body MEDIUMTEXT, uid INTEGER, gid INTEGER, owner_u INTEGER, group_u INTEGER, other_u INTEGER, UNIQUE(name));"
+        @db.run "CREATE TABLE cluster_hosts_new (cluster_oid INTEGER, host_oid INTEGER, PRIMARY KEY(cluster_oid, host_oid));"
+        @db.run "CREATE TABLE cluster_datastores_new (cluster_oid INTEGER, datastore_oid INTEGER, PRIMARY KEY(cluster_oid, datastore_oid));"
+        @db.run "CREATE TABLE cluster_vnets_new (cluster_oid INTEGER, vnet_oid INTEGER, PRIMARY KEY(cluster_oid, vnet_oid));"
+
+        cluster_hosts = read_collection("cluster_hosts", :cluster_oid, :host_oid)
+        cluster_ds    = read_collection("cluster_datastores", :cluster_oid, :datastore_oid)
+        cluster_vnets = read_collection("cluster_vnets", :cluster_oid, :vnet_oid)
 
         @db.transaction do
             @db.fetch("SELECT * from cluster_pool") do |row|
                 cluster_id = row[:oid]
                 doc = Document.new(row[:body])
 
-                # Hosts
-                hosts_elem = doc.root.elements.delete("HOSTS")
-
-                hosts_new_elem = doc.root.add_element("HOSTS")
+                # Hosts, stored in the cluster_hosts table
+                hosts = cluster_hosts[cluster_id] || Set.new
 
                 cluster[cluster_id][:hosts].each do |id|
-                    id_elem = hosts_elem.elements.delete("ID[.=#{id}]")
-
-                    if id_elem.nil?
+                    if hosts.delete?(id).nil?
                         log_error("Host #{id} is missing from Cluster #{cluster_id} host id list")
                     end
 
-                    hosts_new_elem.add_element("ID").text = id.to_s
+                    @db[:cluster_hosts_new].insert(
+                        :cluster_oid    => cluster_id,
+                        :host_oid       => id)
                 end
 
-                hosts_elem.each_element("ID") do |id_elem|
-                    log_error("Host #{id_elem.text} is in Cluster #{cluster_id} host id list, but it should not")
+                hosts.each do |id|
+                    log_error("Host #{id} is in Cluster #{cluster_id} host id list, but it should not")
                 end
 
+                doc.root.elements.delete("HOSTS")
+                doc.root.add_element("HOSTS")
 
-                # Datastores
-                ds_elem = doc.root.elements.delete("DATASTORES")
 
-                ds_new_elem = doc.root.add_element("DATASTORES")
+                # Datastores, stored in the cluster_datastores table
+                datastores = cluster_ds[cluster_id] || Set.new
 
                 cluster[cluster_id][:datastores].each do |id|
-                    id_elem = ds_elem.elements.delete("ID[.=#{id}]")
-
-                    if id_elem.nil?
+                    if datastores.delete?(id).nil?
                         log_error("Datastore #{id} is missing from Cluster #{cluster_id} datastore id list")
                     end
 
-                    ds_new_elem.add_element("ID").text = id.to_s
+                    @db[:cluster_datastores_new].insert(
+                        :cluster_oid    => cluster_id,
+                        :datastore_oid  => id)
                 end
 
-                ds_elem.each_element("ID") do |id_elem|
-                    log_error("Datastore #{id_elem.text} is in Cluster #{cluster_id} datastore id list, but it should not")
+                datastores.each do |id|
+                    log_error("Datastore #{id} is in Cluster #{cluster_id} datastore id list, but it should not")
                 end
 
+                doc.root.elements.delete("DATASTORES")
+                doc.root.add_element("DATASTORES")
 
-                # VNets
-                vnets_elem = doc.root.elements.delete("VNETS")
 
-                vnets_new_elem = doc.root.add_element("VNETS")
+                # VNets, stored in the cluster_vnets table
+                vnets = cluster_vnets[cluster_id] || Set.new
 
                 cluster[cluster_id][:vnets].each do |id|
-                    id_elem = vnets_elem.elements.delete("ID[.=#{id}]")
-
-                    if id_elem.nil?
+                    if vnets.delete?(id).nil?
                         log_error("VNet #{id} is missing from Cluster #{cluster_id} vnet id list")
                     end
 
-                    vnets_new_elem.add_element("ID").text = id.to_s
+                    @db[:cluster_vnets_new].insert(
+                        :cluster_oid    => cluster_id,
+                        :vnet_oid       => id)
                 end
 
-                vnets_elem.each_element("ID") do |id_elem|
-                    log_error("VNet #{id_elem.text} is in Cluster #{cluster_id} vnet id list, but it should not")
+                vnets.each do |id|
+                    log_error("VNet #{id} is in Cluster #{cluster_id} vnet id list, but it should not")
                 end
 
+                doc.root.elements.delete("VNETS")
+                doc.root.add_element("VNETS")
+
 
                 row[:body] = doc.root.to_s
 
@@ -602,6 +618,15 @@ EOT
         @db.run("DROP TABLE cluster_pool")
         @db.run("ALTER TABLE cluster_pool_new RENAME TO cluster_pool")
 
+        @db.run("DROP TABLE cluster_hosts")
+        @db.run("ALTER TABLE cluster_hosts_new RENAME TO cluster_hosts")
+
+        @db.run("DROP TABLE cluster_datastores")
+        @db.run("ALTER TABLE cluster_datastores_new RENAME TO cluster_datastores")
+
+        @db.run("DROP TABLE cluster_vnets")
+        @db.run("ALTER TABLE cluster_vnets_new RENAME TO cluster_vnets")
+
 
         ########################################################################
         # Datastore
@@ -663,34 +688,39 @@ EOT
         log_time()
 
         @db.run "CREATE TABLE datastore_pool_new (oid INTEGER PRIMARY KEY, name VARCHAR(128), body MEDIUMTEXT, uid INTEGER, gid INTEGER, owner_u INTEGER, group_u INTEGER, other_u INTEGER, cid INTEGER, UNIQUE(name));"
+        @db.run "CREATE TABLE datastore_images_new (datastore_oid INTEGER, image_oid INTEGER, PRIMARY KEY(datastore_oid, image_oid));"
+
+        datastore_images = read_collection("datastore_images",
+            :datastore_oid, :image_oid)
 
         @db.transaction do
             @db.fetch("SELECT * from datastore_pool") do |row|
                 ds_id = row[:oid]
                 doc = Document.new(row[:body])
 
-                images_elem = doc.root.elements.delete("IMAGES")
-
-                images_new_elem = doc.root.add_element("IMAGES")
+                # re-do list of image IDs, stored in the datastore_images table
+                images = datastore_images[ds_id] || Set.new
 
                 datastore[ds_id][:images].each do |id|
-                    id_elem = images_elem.elements.delete("ID[.=#{id}]")
-
-                    if id_elem.nil?
+                    if images.delete?(id).nil?
                         log_error(
                             "Image #{id} is missing from Datastore #{ds_id} "<<
                             "image id list")
                     end
 
-                    images_new_elem.add_element("ID").text = id.to_s
+                    @db[:datastore_images_new].insert(
+                        :datastore_oid  => ds_id,
+                        :image_oid      => id)
                 end
 
-                images_elem.each_element("ID") do |id_elem|
+                images.each do |id|
                     log_error(
-                        "Image #{id_elem.text} is in Cluster #{ds_id} "<<
+                        "Image #{id} is in Datastore #{ds_id} "<<
                         "image id list, but it should not")
                 end
 
+                doc.root.elements.delete("IMAGES")
+                doc.root.add_element("IMAGES")
 
                 row[:body] = doc.root.to_s
 
@@ -703,6 +733,9 @@ EOT
         @db.run("DROP TABLE datastore_pool")
         @db.run("ALTER TABLE datastore_pool_new RENAME TO datastore_pool")
 
+        @db.run("DROP TABLE datastore_images")
+        @db.run("ALTER TABLE datastore_images_new RENAME TO datastore_images")
+
         log_time()
 
         ########################################################################
@@ -887,6 +920,9 @@ EOT
                 "last_mon_time INTEGER, uid INTEGER, gid INTEGER, " <<
                 "owner_u INTEGER, group_u INTEGER, other_u INTEGER, " <<
                 "cid INTEGER, UNIQUE(name));"
+        @db.run "CREATE TABLE host_vms_new (host_oid INTEGER, vm_oid INTEGER, PRIMARY KEY(host_oid, vm_oid));"
+
+        host_vms = read_collection("host_vms", :host_oid, :vm_oid)
 
         # Calculate the host's xml and write them to host_pool_new
         @db.transaction do
@@ -911,28 +947,29 @@ EOT
                 }
 
 
-                # re-do list of VM IDs 
-                vms_elem = host_doc.root.elements.delete("VMS")
-
-                vms_new_elem = host_doc.root.add_element("VMS")
+                # re-do list of VM IDs, stored in the host_vms table
+                vms = host_vms[hid] || Set.new
 
                 counters_host[:rvms].each do |id|
-                    id_elem = vms_elem.elements.delete("ID[.=#{id}]")
-
-                    if id_elem.nil?
+                    if vms.delete?(id).nil?
                         log_error(
                             "VM #{id} is missing from Host #{hid} VM id list")
                     end
 
-                    vms_new_elem.add_element("ID").text = id.to_s
+                    @db[:host_vms_new].insert(
+                        :host_oid   => hid,
+                        :vm_oid     => id)
                 end
 
-                vms_elem.each_element("ID") do |id_elem|
+                vms.each do |id|
                     log_error(
-                        "VM #{id_elem.text} is in Host #{hid} VM id list, "<<
+                        "VM #{id} is in Host #{hid} VM id list, "<<
                         "but it should not")
                 end
 
+                host_doc.root.elements.delete("VMS")
+                host_doc.root.add_element("VMS")
+
 
                 # rewrite cpu
                 host_doc.root.each_element("HOST_SHARE/CPU_USAGE") {|e|
@@ -964,6 +1001,9 @@ EOT
         @db.run("DROP TABLE host_pool")
         @db.run("ALTER TABLE host_pool_new RENAME TO host_pool")
 
+        @db.run("DROP TABLE host_vms")
+        @db.run("ALTER TABLE host_vms_new RENAME TO host_vms")
+
         log_time()
 
         ########################################################################
@@ -982,6 +1022,9 @@ EOT
 
         # Create a new empty table where we will store the new calculated values
         @db.run "CREATE TABLE image_pool_new (oid INTEGER PRIMARY KEY, name VARCHAR(128), body MEDIUMTEXT, uid INTEGER, gid INTEGER, owner_u INTEGER, group_u INTEGER, other_u INTEGER, UNIQUE(name,uid) );"
+        @db.run "CREATE TABLE image_vms_new (image_oid INTEGER, vm_oid INTEGER, PRIMARY KEY(image_oid, vm_oid));"
+
+        image_vms = read_collection("image_vms", :image_oid, :vm_oid)
 
         @db.transaction do
             @db[:image_pool].each do |row|
@@ -1003,25 +1046,26 @@ EOT
                     end
                 }
 
-                # re-do list of VM IDs 
-                vms_elem = doc.root.elements.delete("VMS")
-
-                vms_new_elem = doc.root.add_element("VMS")
+                # re-do list of VM IDs, stored in the image_vms table
+                vms = image_vms[oid] || Set.new
 
                 counters[:image][oid][:vms].each do |id|
-                    id_elem = vms_elem.elements.delete("ID[.=#{id}]")
-
-                    if id_elem.nil?
+                    if vms.delete?(id).nil?
                         log_error("VM #{id} is missing from Image #{oid} VM id list")
                     end
 
-                    vms_new_elem.add_element("ID").text = id.to_s
+                    @db[:image_vms_new].insert(
+                        :image_oid  => oid,
+                        :vm_oid     => id)
                 end
 
-                vms_elem.each_element("ID") do |id_elem|
-                    log_error("VM #{id_elem.text} is in Image #{oid} VM id list, but it should not")
+                vms.each do |id|
+                    log_error("VM #{id} is in Image #{oid} VM id list, but it should not")
                 end
 
+                doc.root.elements.delete("VMS")
+                doc.root.add_element("VMS")
+
 
                 if ( persistent && rvms > 0 )
                     n_cloning_ops = 0
@@ -1100,6 +1144,9 @@ EOT
         @db.run("DROP TABLE image_pool")
         @db.run("ALTER TABLE image_pool_new RENAME TO image_pool")
 
+        @db.run("DROP TABLE image_vms")
+        @db.run("ALTER TABLE image_vms_new RENAME TO image_vms")
+
         log_time()
 
         ########################################################################
@@ -1213,6 +1260,19 @@ EOT
         puts "Total errors found: #{@errors}"
     end
 
+    # Reads a relation table with the IDs of a collection
+    # @return [Hash] a Set of IDs for each object oid
+    def read_collection(table, oid_column, id_column)
+        collection = {}
+
+        @db.fetch("SELECT #{oid_column}, #{id_column} FROM #{table}") do |row|
+            collection[row[oid_column]] ||= Set.new
+            collection[row[oid_column]] << row[id_column]
+        end
+
+        return collection
+    end
+
 
 
     def calculate_quotas(doc, where_filter, resource)
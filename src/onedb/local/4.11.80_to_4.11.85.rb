@@ -0,0 +1,123 @@
+# -------------------------------------------------------------------------- #
+# Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        #
+#                                                                            #
+# Licensed under the Apache License, Version 2.0 (the "License"); you may    #
+# not use this file except in compliance with the License. You may obtain    #
+# a copy of the License at                                                   #
+#                                                                            #
+# http://www.apache.org/licenses/LICENSE-2.0                                 #
+#                                                                            #
+# Unless required by applicable law or agreed to in writing, software        #
+# distributed under the License is distributed on an "AS IS" BASIS,          #
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   #
+# See the License for the specific language governing permissions and        #
+# limitations under the License.                                             #
+#--------------------------------------------------------------------------- #
+
+
+require 'nokogiri'
+
+module Migrator
+    def db_version
+        "4.11.85"
+    end
+
+    def one_version
+        "OpenNebula 4.11.85"
+    end
+
+    def up
+
+        init_log_time()
+
+        ########################################################################
+        # Image VMs, moved from the image body to the image_vms table
+        ########################################################################
+
+        @db.run "CREATE TABLE image_vms (image_oid INTEGER, vm_oid INTEGER, PRIMARY KEY(image_oid, vm_oid));"
+
+        @db.run "ALTER TABLE image_pool RENAME TO old_image_pool;"
+        @db.run "CREATE TABLE image_pool (oid INTEGER PRIMARY KEY, name VARCHAR(128), body MEDIUMTEXT, uid INTEGER, gid INTEGER, owner_u INTEGER, group_u INTEGER, other_u INTEGER, UNIQUE(name,uid) );"
+
+        @db.transaction do
+            @db.fetch("SELECT * FROM old_image_pool") do |row|
+                doc = Nokogiri::XML(row[:body]){|c| c.default_xml.noblanks}
+
+                doc.root.xpath("VMS/ID").each do |e|
+                    @db[:image_vms].insert(
+                        :image_oid  => row[:oid],
+                        :vm_oid     => e.text.to_i)
+
+                    e.remove
+                end
+
+                @db[:image_pool].insert(
+                    :oid        => row[:oid],
+                    :name       => row[:name],
+                    :body       => doc.root.to_s,
+                    :uid        => row[:uid],
+                    :gid        => row[:gid],
+                    :owner_u    => row[:owner_u],
+                    :group_u    => row[:group_u],
+                    :other_u    => row[:other_u])
+            end
+        end
+
+        @db.run "DROP TABLE old_image_pool;"
+
+        log_time()
+
+        ########################################################################
+        # Host VMs, Security Group VMs, Datastore Images and Cluster Hosts,
+        # Datastores and VNets, moved from the body to their own tables
+        ########################################################################
+
+        move_collection(:host_pool, "VMS", :host_vms, :host_oid, :vm_oid)
+
+        move_collection(:secgroup_pool, "VMS", :secgroup_vms,
+            :secgroup_oid, :vm_oid)
+
+        move_collection(:datastore_pool, "IMAGES", :datastore_images,
+            :datastore_oid, :image_oid)
+
+        move_collection(:cluster_pool, "HOSTS", :cluster_hosts,
+            :cluster_oid, :host_oid)
+
+        move_collection(:cluster_pool, "DATASTORES", :cluster_datastores,
+            :cluster_oid, :datastore_oid)
+
+        move_collection(:cluster_pool, "VNETS", :cluster_vnets,
+            :cluster_oid, :vnet_oid)
+
+        log_time()
+
+        return true
+    end
+
+    # Moves the IDs of the collection element of each object body to a
+    # relation table. The empty element is kept in the body.
+    def move_collection(pool, element, table, oid_column, id_column)
+        @db.run "CREATE TABLE #{table} (#{oid_column} INTEGER, #{id_column} INTEGER, PRIMARY KEY(#{oid_column}, #{id_column}));"
+
+        @db.transaction do
+            @db.fetch("SELECT oid, body FROM #{pool}").all.each do |row|
+                doc = Nokogiri::XML(row[:body]){|c| c.default_xml.noblanks}
+
+                ids = doc.root.xpath("#{element}/ID")
+
+                next if ids.empty?
+
+                ids.each do |e|
+                    @db[table].insert(
+                        oid_column  => row[:oid],
+                        id_column   => e.text.to_i)
+
+                    e.remove
+                end
+
+                @db[pool].where(:oid => row[:oid]).update(
+                    :body => doc.root.to_s)
+            end
+        end
+    end
+end
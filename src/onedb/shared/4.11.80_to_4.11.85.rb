@@ -0,0 +1,72 @@
+# -------------------------------------------------------------------------- #
+# Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        #
+#                                                                            #
+# Licensed under the Apache License, Version 2.0 (the "License"); you may    #
+# not use this file except in compliance with the License. You may obtain    #
+# a copy of the License at                                                   #
+#                                                                            #
+# http://www.apache.org/licenses/LICENSE-2.0                                 #
+#                                                                            #
+# Unless required by applicable law or agreed to in writing, software        #
+# distributed under the License is distributed on an "AS IS" BASIS,          #
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   #
+# See the License for the specific language governing permissions and        #
+# limitations under the License.                                             #
+#--------------------------------------------------------------------------- #
+
+
+require 'nokogiri'
+
+module Migrator
+    def db_version
+        "4.11.85"
+    end
+
+    def one_version
+        "OpenNebula 4.11.85"
+    end
+
+    def up
+
+        init_log_time()
+
+        ########################################################################
+        # Group users, moved from the group body to the group_users table
+        ########################################################################
+
+        @db.run "CREATE TABLE group_users (group_oid INTEGER, user_oid INTEGER, PRIMARY KEY(group_oid, user_oid));"
+
+        @db.run "ALTER TABLE group_pool RENAME TO old_group_pool;"
+        @db.run "CREATE TABLE group_pool (oid INTEGER PRIMARY KEY, name VARCHAR(128), body MEDIUMTEXT, uid INTEGER, gid INTEGER, owner_u INTEGER, group_u INTEGER, other_u INTEGER, UNIQUE(name));"
+
+        @db.transaction do
+            @db.fetch("SELECT * FROM old_group_pool") do |row|
+                doc = Nokogiri::XML(row[:body]){|c| c.default_xml.noblanks}
+
+                doc.root.xpath("USERS/ID").each do |e|
+                    @db[:group_users].insert(
+                        :group_oid  => row[:oid],
+                        :user_oid   => e.text.to_i)
+
+                    e.remove
+                end
+
+                @db[:group_pool].insert(
+                    :oid        => row[:oid],
+                    :name       => row[:name],
+                    :body       => doc.root.to_s,
+                    :uid        => row[:uid],
+                    :gid        => row[:gid],
+                    :owner_u    => row[:owner_u],
+                    :group_u    => row[:group_u],
+                    :other_u    => row[:other_u])
+            end
+        end
+
+        @db.run "DROP TABLE old_group_pool;"
+
+        log_time()
+
+        return true
+    end
+end
@@ -0,0 +1,38 @@
+# -------------------------------------------------------------------------- #
+# Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        #
+#                                                                            #
+# Licensed under the Apache License, Version 2.0 (the "License"); you may    #
+# not use this file except in compliance with the License. You may obtain    #
+# a copy of the License at                                                   #
+#                                                                            #
+# http://www.apache.org/licenses/LICENSE-2.0                                 #
+#                                                                            #
+# Unless required by applicable law or agreed to in writing, software        #
+# distributed under the License is distributed on an "AS IS" BASIS,          #
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   #
+# See the License for the specific language governing permissions and        #
+# limitations under the License.                                             #
+#--------------------------------------------------------------------------- #
+
+module Migrator
+    def db_version
+        "4.11.80"
+    end
+
+    def one_version
+        "OpenNebula 4.11.80"
+    end
+
+    def up
+
+        ########################################################################
+        # Change log, used by the slaves to validate the cached objects
+        ########################################################################
+
+        @db.run "CREATE TABLE IF NOT EXISTS change_log (tablename VARCHAR(32), oid INTEGER, seq BIGINT, PRIMARY KEY(tablename, oid));"
+
+        @db.run "CREATE INDEX change_log_seq ON change_log (tablename, seq);"
+
+        return true
+    end
+end
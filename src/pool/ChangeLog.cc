@@ -0,0 +1,188 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "ChangeLog.h"
+#include "Nebula.h"
+
+#include <stdlib.h>
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+const char * ChangeLog::table = "change_log";
+
+const long long ChangeLog::MAX_ZONES = 1024;
+
+const char * ChangeLog::db_names = "tablename, oid, seq";
+
+const char * ChangeLog::db_bootstrap = "CREATE TABLE IF NOT EXISTS change_log "
+    "(tablename VARCHAR(32), oid INTEGER, seq BIGINT, "
+    "PRIMARY KEY(tablename, oid))";
+
+const char * ChangeLog::db_index =
+    "CREATE INDEX change_log_seq ON change_log (tablename, seq)";
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+ChangeLog::ChangeLog(SqlDB * _db, const char * _tablename):
+    db(_db), tablename(_tablename), last_seq(0)
+{
+    long long seq;
+
+    pthread_mutex_init(&mutex, 0);
+
+    zone_id = Nebula::instance().get_zone_id() % MAX_ZONES;
+
+    if ( get_last(seq) == 0 )
+    {
+        last_seq = seq / MAX_ZONES;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int ChangeLog::log(int oid)
+{
+    ostringstream oss;
+    int           rc;
+
+    pthread_mutex_lock(&mutex);
+
+    oss << "REPLACE INTO " << table << " (" << db_names << ") VALUES ('"
+        << tablename << "'," << oid << "," << next_seq() << ")";
+
+    rc = db->exec(oss);
+
+    pthread_mutex_unlock(&mutex);
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int ChangeLog::seq_cb(void * _seq, int num, char **values, char **names)
+{
+    long long * seq = static_cast<long long *>(_seq);
+
+    if ( num > 0 && values[0] != 0 )
+    {
+        *seq = strtoll(values[0], 0, 10);
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ChangeLog::get_version(int oid, long long& version)
+{
+    ostringstream oss;
+    int           rc;
+
+    version = 0;
+
+    set_callback(static_cast<Callbackable::Callback>(&ChangeLog::seq_cb),
+                 static_cast<void *>(&version));
+
+    oss << "SELECT seq FROM " << table << " WHERE tablename='" << tablename
+        << "' AND oid=" << oid;
+
+    rc = db->exec(oss, this);
+
+    unset_callback();
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ChangeLog::get_last(long long& seq)
+{
+    ostringstream oss;
+    int           rc;
+
+    seq = 0;
+
+    set_callback(static_cast<Callbackable::Callback>(&ChangeLog::seq_cb),
+                 static_cast<void *>(&seq));
+
+    oss << "SELECT MAX(seq) FROM " << table << " WHERE tablename='"
+        << tablename << "'";
+
+    rc = db->exec(oss, this);
+
+    unset_callback();
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int ChangeLog::changes_cb(void * _changes, int num, char **values,
+        char **names)
+{
+    map<int, long long> * changes = static_cast<map<int, long long> *>(_changes);
+
+    if ( num != 2 || values[0] == 0 || values[1] == 0 )
+    {
+        return -1;
+    }
+
+    changes->insert(make_pair(atoi(values[0]), strtoll(values[1], 0, 10)));
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ChangeLog::get_changes(long long seq, map<int, long long>& changes)
+{
+    ostringstream oss;
+    int           rc;
+
+    set_callback(static_cast<Callbackable::Callback>(&ChangeLog::changes_cb),
+                 static_cast<void *>(&changes));
+
+    oss << "SELECT oid, seq FROM " << table << " WHERE tablename='"
+        << tablename << "' AND seq > " << seq;
+
+    rc = db->exec(oss, this);
+
+    unset_callback();
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int ChangeLog::bootstrap(SqlDB * _db)
+{
+    ostringstream oss(db_bootstrap);
+    int           rc;
+
+    rc = _db->exec(oss);
+
+    oss.str(db_index);
+
+    rc += _db->exec(oss);
+
+    return rc;
+}
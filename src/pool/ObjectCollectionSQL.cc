@@ -0,0 +1,290 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "ObjectCollectionSQL.h"
+#include "NebulaLog.h"
+
+#include <stdlib.h>
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int ObjectCollectionSQL::select_cb(void * _ids, int num, char **values,
+        char **names)
+{
+    set<int> * ids = static_cast<set<int> *>(_ids);
+
+    if ( num != 1 || values[0] == 0 )
+    {
+        return -1;
+    }
+
+    ids->insert(atoi(values[0]));
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ObjectCollectionSQL::load()
+{
+    ostringstream oss;
+    set<int>      ids;
+    int           rc;
+
+    map<int, bool>::iterator it;
+
+    if ( loaded )
+    {
+        return 0;
+    }
+
+    set_callback(static_cast<Callbackable::Callback>(
+                &ObjectCollectionSQL::select_cb), static_cast<void *>(&ids));
+
+    oss << "SELECT " << id_column << " FROM " << table
+        << " WHERE " << oid_column << " = " << oid;
+
+    rc = db->exec(oss, this);
+
+    unset_callback();
+
+    if ( rc != 0 )
+    {
+        oss.str("");
+
+        oss << "Error reading the " << collection_name << " of object "
+            << oid << " from " << table;
+
+        NebulaLog::log("ONE", Log::ERROR, oss);
+
+        return rc;
+    }
+
+    for ( it = changes.begin(); it != changes.end(); it++ )
+    {
+        if ( it->second )
+        {
+            ids.insert(it->first);
+        }
+        else
+        {
+            ids.erase(it->first);
+        }
+    }
+
+    collection_set = ids;
+
+    loaded = true;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool ObjectCollectionSQL::contains(int id)
+{
+    ostringstream oss;
+    set<int>      ids;
+
+    map<int, bool>::iterator it = changes.find(id);
+
+    if ( it != changes.end() )
+    {
+        return it->second;
+    }
+
+    set_callback(static_cast<Callbackable::Callback>(
+                &ObjectCollectionSQL::select_cb), static_cast<void *>(&ids));
+
+    oss << "SELECT " << id_column << " FROM " << table
+        << " WHERE " << oid_column << " = " << oid
+        << " AND " << id_column << " = " << id;
+
+    db->exec(oss, this);
+
+    unset_callback();
+
+    return !ids.empty();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int ObjectCollectionSQL::add_collection_id(int id)
+{
+    if ( loaded )
+    {
+        if ( ObjectCollection::add_collection_id(id) != 0 )
+        {
+            return -1;
+        }
+    }
+    else if ( contains(id) )
+    {
+        return -1;
+    }
+
+    changes[id] = true;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ObjectCollectionSQL::del_collection_id(int id)
+{
+    if ( loaded )
+    {
+        if ( ObjectCollection::del_collection_id(id) != 0 )
+        {
+            return -1;
+        }
+    }
+    else if ( !contains(id) )
+    {
+        return -1;
+    }
+
+    changes[id] = false;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+string& ObjectCollectionSQL::to_xml(string& xml) const
+{
+    // The IDs are read the first time the XML is generated, the owner is
+    // locked by the caller
+    const_cast<ObjectCollectionSQL *>(this)->load();
+
+    return ObjectCollection::to_xml(xml);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void ObjectCollectionSQL::select(SqlDB * _db, int _oid)
+{
+    db  = _db;
+    oid = _oid;
+
+    collection_set.clear();
+    changes.clear();
+
+    loaded = false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ObjectCollectionSQL::update(SqlDB * _db, int _oid)
+{
+    ostringstream oss;
+    int           rc = 0;
+
+    map<int, bool>::iterator it = changes.begin();
+
+    db  = _db;
+    oid = _oid;
+
+    while ( it != changes.end() )
+    {
+        oss.str("");
+
+        if ( it->second )
+        {
+            oss << "REPLACE INTO " << table << " (" << oid_column << ", "
+                << id_column << ") VALUES (" << oid << "," << it->first << ")";
+        }
+        else
+        {
+            oss << "DELETE FROM " << table << " WHERE " << oid_column << " = "
+                << oid << " AND " << id_column << " = " << it->first;
+        }
+
+        rc = db->exec(oss);
+
+        if ( rc != 0 )
+        {
+            break;
+        }
+
+        changes.erase(it++);
+    }
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ObjectCollectionSQL::drop(SqlDB * _db)
+{
+    ostringstream oss;
+
+    oss << "DELETE FROM " << table << " WHERE " << oid_column << " = " << oid;
+
+    collection_set.clear();
+    changes.clear();
+
+    loaded = true;
+
+    return _db->exec(oss);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int ObjectCollectionSQL::select_ids_cb(void * _ids, int num, char **values,
+        char **names)
+{
+    map<int, set<int> > * ids = static_cast<map<int, set<int> > *>(_ids);
+
+    if ( num != 2 || values[0] == 0 || values[1] == 0 )
+    {
+        return -1;
+    }
+
+    (*ids)[atoi(values[0])].insert(atoi(values[1]));
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ObjectCollectionSQL::select_ids(SqlDB * _db, const string& oids,
+        map<int, set<int> >& ids)
+{
+    ostringstream oss;
+    int           rc;
+
+    set_callback(static_cast<Callbackable::Callback>(
+                &ObjectCollectionSQL::select_ids_cb), static_cast<void *>(&ids));
+
+    oss << "SELECT " << oid_column << ", " << id_column << " FROM " << table;
+
+    if ( !oids.empty() )
+    {
+        oss << " WHERE " << oid_column << " IN (" << oids << ")";
+    }
+
+    rc = _db->exec(oss, this);
+
+    unset_callback();
+
+    return rc;
+}
@@ -16,6 +16,7 @@
 
 #include "PoolObjectSQL.h"
 #include "PoolObjectAuth.h"
+#include "ObjectCollectionSQL.h"
 #include "NebulaUtil.h"
 #include "Nebula.h"
 #include "Clusterable.h"
@@ -27,15 +28,11 @@ const string PoolObjectSQL::INVALID_NAME_CHARS = "&|:\\\";/'#{}$<>";
 
 string& PoolObjectSQL::to_xml64(string &xml64)
 {
-    string *str64;
+    string xml;
 
-    to_xml(xml64);
+    to_xml(xml);
 
-    str64 = one_util::base64_encode(xml64);
-
-    xml64 = *str64;
-
-    delete str64;
+    one_util::base64_encode(xml, xml64);
 
     return xml64;
 }
@@ -66,6 +63,8 @@ int PoolObjectSQL::select(SqlDB *db)
         return -1;
     }
 
+    select_collections(db);
+
     return 0;
 }
 
@@ -110,6 +109,8 @@ int PoolObjectSQL::select(SqlDB *db, const string& _name, int _uid)
         return -1;
     }
 
+    select_collections(db);
+
     return 0;
 }
 
@@ -128,6 +129,36 @@ int PoolObjectSQL::drop(SqlDB *db)
     if ( rc == 0 )
     {
         set_valid(false);
+
+        for (unsigned int i = 0; i < collections.size(); i++)
+        {
+            rc += collections[i]->drop(db);
+        }
+    }
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolObjectSQL::select_collections(SqlDB *db)
+{
+    for (unsigned int i = 0; i < collections.size(); i++)
+    {
+        collections[i]->select(db, oid);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+int PoolObjectSQL::update_collections(SqlDB *db)
+{
+    int rc = 0;
+
+    for (unsigned int i = 0; i < collections.size(); i++)
+    {
+        rc += collections[i]->update(db, oid);
     }
 
     return rc;
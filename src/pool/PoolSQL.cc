@@ -21,7 +21,9 @@
 #include <algorithm>
 
 #include "PoolSQL.h"
+#include "ObjectCollectionSQL.h"
 #include "RequestManagerPoolInfoFilter.h"
+#include "NebulaLog.h"
 
 #include <errno.h>
 
@@ -34,6 +36,8 @@
 
 const unsigned int PoolSQL::MAX_POOL_SIZE = 15000;
 
+const unsigned int PoolSQL::PREFETCH_RANGE = 1000;
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
@@ -52,7 +56,9 @@ int PoolSQL::init_cb(void *nil, int num, char **values, char **names)
 /* -------------------------------------------------------------------------- */
 
 PoolSQL::PoolSQL(SqlDB * _db, const char * _table, bool _cache, bool cache_by_name):
-    db(_db), lastOID(-1), table(_table), cache(_cache), uses_name_pool(cache_by_name)
+    db(_db), lastOID(-1), table(_table), cache(_cache),
+    uses_name_pool(cache_by_name), cache_hits(0), cache_misses(0),
+    change_log(0), check_versions(false)
 {
     ostringstream   oss;
 
@@ -86,6 +92,17 @@ PoolSQL::~PoolSQL()
     pthread_mutex_unlock(&mutex);
 
     pthread_mutex_destroy(&mutex);
+
+    delete change_log;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::enable_change_log(bool slave)
+{
+    change_log     = new ChangeLog(db, table.c_str());
+    check_versions = slave;
 }
 
 
@@ -167,6 +184,7 @@ PoolObjectSQL * PoolSQL::get(
     map<int,PoolObjectSQL *>::iterator  index;
     PoolObjectSQL *                     objectsql;
     int                                 rc;
+    long long                           version = 0;
 
     if ( oid < 0 )
     {
@@ -180,6 +198,12 @@ PoolObjectSQL * PoolSQL::get(
     {
         flush_cache(oid);
     }
+    else if ( check_versions )
+    {
+        change_log->get_version(oid, version);
+
+        validate_cache(oid, version);
+    }
 
     index = pool.find(oid);
 
@@ -191,6 +215,8 @@ PoolObjectSQL * PoolSQL::get(
         }
         else
         {
+            cache_hits++;
+
             objectsql = index->second;
 
             if ( olock == true )
@@ -211,6 +237,8 @@ PoolObjectSQL * PoolSQL::get(
     }
     else
     {
+        cache_misses++;
+
         objectsql = create();
 
         objectsql->oid = oid;
@@ -243,6 +271,7 @@ PoolObjectSQL * PoolSQL::get(
 
                 name_pool.erase(okey);
                 pool.erase(tmp_ptr->oid);
+                versions.erase(tmp_ptr->oid);
 
                 delete tmp_ptr;
             }
@@ -252,6 +281,11 @@ PoolObjectSQL * PoolSQL::get(
 
         pool.insert(make_pair(objectsql->oid,objectsql));
 
+        if ( check_versions )
+        {
+            versions[objectsql->oid] = version;
+        }
+
         if ( olock == true )
         {
             objectsql->lock();
@@ -283,6 +317,7 @@ PoolObjectSQL * PoolSQL::get(const string& name, int ouid, bool olock)
     PoolObjectSQL *  objectsql;
     int              rc;
     string           name_key;
+    long long        version = 0;
 
     if ( uses_name_pool == false )
     {
@@ -297,11 +332,24 @@ PoolObjectSQL * PoolSQL::get(const string& name, int ouid, bool olock)
     {
         flush_cache(name_key);
     }
+    else if ( check_versions )
+    {
+        index = name_pool.find(name_key);
+
+        if ( index != name_pool.end() )
+        {
+            change_log->get_version(index->second->oid, version);
+
+            validate_cache(index->second->oid, version);
+        }
+    }
 
     index = name_pool.find(name_key);
 
     if ( index != name_pool.end() && index->second->isValid() == true )
     {
+        cache_hits++;
+
         objectsql = index->second;
 
         if ( olock == true )
@@ -330,14 +378,35 @@ PoolObjectSQL * PoolSQL::get(const string& name, int ouid, bool olock)
 
             pool.erase(tmp_ptr->oid);
             name_pool.erase(tmp_okey);
+            versions.erase(tmp_ptr->oid);
 
             delete tmp_ptr;
         }
 
+        cache_misses++;
+
         objectsql = create();
 
         rc = objectsql->select(db,name,ouid);
 
+        if ( rc == 0 && check_versions )
+        {
+            // The version is read after the object was loaded, so it may be
+            // newer than the object. Load it again to not cache a stale copy
+            int oid = objectsql->oid;
+
+            change_log->get_version(oid, version);
+
+            validate_cache(oid, version);
+
+            delete objectsql;
+
+            objectsql      = create();
+            objectsql->oid = oid;
+
+            rc = objectsql->select(db);
+        }
+
         if ( rc != 0 )
         {
             delete objectsql;
@@ -352,6 +421,11 @@ PoolObjectSQL * PoolSQL::get(const string& name, int ouid, bool olock)
         pool.insert(make_pair(objectsql->oid, objectsql));
         name_pool.insert(make_pair(okey, objectsql));
 
+        if ( check_versions )
+        {
+            versions[objectsql->oid] = version;
+        }
+
         if ( olock == true )
         {
             objectsql->lock();
@@ -446,6 +520,7 @@ void PoolSQL::replace()
             PoolObjectSQL * tmp_ptr = index->second;
 
             pool.erase(index);
+            versions.erase(oid);
 
             if ( uses_name_pool )
             {
@@ -464,6 +539,51 @@ void PoolSQL::replace()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void PoolSQL::validate_cache(int oid, long long version)
+{
+    map<int,PoolObjectSQL *>::iterator  index;
+    map<int,long long>::iterator        vindex;
+
+    PoolObjectSQL * tmp_ptr;
+
+    index = pool.find(oid);
+
+    if ( index == pool.end() )
+    {
+        return;
+    }
+
+    vindex = versions.find(oid);
+
+    if ( vindex != versions.end() && vindex->second == version )
+    {
+        return;
+    }
+
+    tmp_ptr = index->second;
+
+    // The object has been changed by the master, wait until it is unlocked
+    tmp_ptr->lock();
+
+    pool.erase(index);
+
+    if ( vindex != versions.end() )
+    {
+        versions.erase(vindex);
+    }
+
+    if ( uses_name_pool )
+    {
+        string okey = key(tmp_ptr->name,tmp_ptr->uid);
+        name_pool.erase(okey);
+    }
+
+    delete tmp_ptr;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void PoolSQL::flush_cache(int oid)
 {
     int  rc;
@@ -568,6 +688,22 @@ void PoolSQL::clean()
 
     pool.clear();
     name_pool.clear();
+    versions.clear();
+
+    unlock();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::get_cache_stats(unsigned long& hits, unsigned long& misses,
+                              unsigned int& size)
+{
+    lock();
+
+    hits   = cache_hits;
+    misses = cache_misses;
+    size   = pool.size();
 
     unlock();
 }
@@ -575,6 +711,226 @@ void PoolSQL::clean()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+extern "C" void * pool_prefetch_loop(void *arg)
+{
+    PoolSQL::PrefetchBatch * batch;
+
+    if ( arg == 0 )
+    {
+        return 0;
+    }
+
+    batch = static_cast<PoolSQL::PrefetchBatch *>(arg);
+
+    batch->pool->prefetch_loop(batch);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::prefetch_loop(PrefetchBatch * batch)
+{
+    unsigned int i;
+
+    while ((i = __sync_fetch_and_add(&(batch->next), 1)) < batch->bodies.size())
+    {
+        PoolObjectSQL * objectsql = create();
+
+        if ( objectsql->from_xml(batch->bodies[i]) != 0 )
+        {
+            delete objectsql;
+            objectsql = 0;
+        }
+
+        batch->objects[i] = objectsql;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+int PoolSQL::prefetch_cb(void * _batch, int num, char **values, char **names)
+{
+    PrefetchBatch * batch = static_cast<PrefetchBatch *>(_batch);
+
+    if ( num != 2 || values[0] == 0 || values[1] == 0 )
+    {
+        return -1;
+    }
+
+    batch->last_oid = atoi(values[0]);
+
+    batch->bodies.push_back(values[1]);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int PoolSQL::prefetch(const string& where, unsigned int num_threads)
+{
+    ostringstream     oss;
+    PrefetchBatch     batch;
+    vector<pthread_t> threads;
+    pthread_attr_t    pattr;
+
+    int  loaded = 0;
+    int  rc;
+    bool full;
+
+    if ( !cache || check_versions )
+    {
+        return 0;
+    }
+
+    batch.pool     = this;
+    batch.last_oid = -1;
+
+    do
+    {
+        lock();
+
+        full = pool.size() >= MAX_POOL_SIZE;
+
+        unlock();
+
+        if ( full )
+        {
+            break;
+        }
+
+        // ---------------------------------------------------------------------
+        // Read the next range of objects
+        // ---------------------------------------------------------------------
+        batch.bodies.clear();
+        batch.objects.clear();
+
+        batch.next = 0;
+
+        oss.str("");
+
+        oss << "SELECT oid, body FROM " << table << " WHERE oid > "
+            << batch.last_oid;
+
+        if ( !where.empty() )
+        {
+            oss << " AND (" << where << ")";
+        }
+
+        oss << " ORDER BY oid LIMIT " << PREFETCH_RANGE;
+
+        set_callback(static_cast<Callbackable::Callback>(&PoolSQL::prefetch_cb),
+                     static_cast<void *>(&batch));
+
+        rc = db->exec(oss, this);
+
+        unset_callback();
+
+        if ( rc != 0 )
+        {
+            return -1;
+        }
+
+        batch.objects.resize(batch.bodies.size(), 0);
+
+        // ---------------------------------------------------------------------
+        // Parse the objects, using the calling thread if only one is needed
+        // ---------------------------------------------------------------------
+        unsigned int nthreads = num_threads;
+
+        if ( nthreads > batch.bodies.size() )
+        {
+            nthreads = batch.bodies.size();
+        }
+
+        threads.clear();
+
+        if ( nthreads > 1 )
+        {
+            pthread_attr_init(&pattr);
+            pthread_attr_setdetachstate(&pattr, PTHREAD_CREATE_JOINABLE);
+
+            for (unsigned int i = 1; i < nthreads; i++)
+            {
+                pthread_t id;
+
+                if (pthread_create(&id, &pattr, pool_prefetch_loop,
+                        (void *) &batch) != 0)
+                {
+                    NebulaLog::log("ONE", Log::ERROR,
+                            "Could not create prefetch thread");
+                    break;
+                }
+
+                threads.push_back(id);
+            }
+
+            pthread_attr_destroy(&pattr);
+        }
+
+        prefetch_loop(&batch); //Also parse objects in this thread
+
+        for (unsigned int i = 0; i < threads.size(); i++)
+        {
+            pthread_join(threads[i], 0);
+        }
+
+        // ---------------------------------------------------------------------
+        // Complete the objects and add them to the cache
+        // ---------------------------------------------------------------------
+        for (unsigned int i = 0; i < batch.objects.size(); i++)
+        {
+            PoolObjectSQL * objectsql = batch.objects[i];
+
+            if ( objectsql == 0 )
+            {
+                continue;
+            }
+
+            objectsql->select_collections(db);
+
+            if ( objectsql->select_extra(db) != 0 )
+            {
+                delete objectsql;
+                continue;
+            }
+
+            lock();
+
+            string okey = key(objectsql->name, objectsql->uid);
+
+            if ( pool.size() >= MAX_POOL_SIZE ||
+                 pool.find(objectsql->oid) != pool.end() ||
+                 (uses_name_pool && name_pool.find(okey) != name_pool.end()) )
+            {
+                unlock();
+
+                delete objectsql;
+                continue;
+            }
+
+            pool.insert(make_pair(objectsql->oid, objectsql));
+
+            if ( uses_name_pool )
+            {
+                name_pool.insert(make_pair(okey, objectsql));
+            }
+
+            oid_queue.push(objectsql->oid);
+
+            unlock();
+
+            loaded++;
+        }
+    }
+    while ( batch.bodies.size() == PREFETCH_RANGE );
+
+    return loaded;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int PoolSQL::dump_cb(void * _oss, int num, char **values, char **names)
 {
     ostringstream * oss;
@@ -592,6 +948,114 @@ int PoolSQL::dump_cb(void * _oss, int num, char **values, char **names)
 
 /* -------------------------------------------------------------------------- */
 
+int PoolSQL::dump_body_cb(void * _bodies, int num, char **values,
+        char **names)
+{
+    vector<pair<int, string> > * bodies;
+
+    bodies = static_cast<vector<pair<int, string> > *>(_bodies);
+
+    if ( num < 2 || values[0] == 0 || values[1] == 0 )
+    {
+        return -1;
+    }
+
+    bodies->push_back(make_pair(atoi(values[0]), string(values[1])));
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool PoolSQL::has_collections()
+{
+    PoolObjectSQL * objectsql = create();
+
+    bool collections = !objectsql->collections.empty();
+
+    delete objectsql;
+
+    return collections;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int PoolSQL::rebuild_xml(vector<pair<int, string> >& bodies, bool all)
+{
+    PoolObjectSQL * objectsql;
+    ostringstream   oids;
+    int             rc = 0;
+
+    vector<pair<int, string> >::iterator it;
+    map<int, set<int> >::iterator        ids_it;
+
+    if ( bodies.empty() )
+    {
+        return 0;
+    }
+
+    if ( !all )
+    {
+        for (it = bodies.begin(); it != bodies.end(); it++)
+        {
+            if ( it != bodies.begin() )
+            {
+                oids << ",";
+            }
+
+            oids << it->first;
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Collections of the objects, a query for each relation table
+    // -------------------------------------------------------------------------
+    objectsql = create();
+
+    vector<map<int, set<int> > > ids(objectsql->collections.size());
+
+    for (unsigned int i = 0; i < objectsql->collections.size() && rc == 0; i++)
+    {
+        rc = objectsql->collections[i]->select_ids(db, oids.str(), ids[i]);
+    }
+
+    delete objectsql;
+
+    if ( rc != 0 )
+    {
+        return rc;
+    }
+
+    // -------------------------------------------------------------------------
+    // Build the objects from their bodies to generate the complete XML
+    // -------------------------------------------------------------------------
+    for (it = bodies.begin(); it != bodies.end(); it++)
+    {
+        objectsql = create();
+
+        if ( objectsql->from_xml(it->second) == 0 )
+        {
+            for (unsigned int i = 0; i < objectsql->collections.size(); i++)
+            {
+                ids_it = ids[i].find(it->first);
+
+                if ( ids_it != ids[i].end() )
+                {
+                    objectsql->collections[i]->set_collection(ids_it->second);
+                }
+            }
+
+            objectsql->to_xml(it->second);
+        }
+
+        delete objectsql;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
 int PoolSQL::dump(ostringstream& oss,
                   const string& elem_name,
                   const char * table,
@@ -600,6 +1064,58 @@ int PoolSQL::dump(ostringstream& oss,
 {
     ostringstream   cmd;
 
+    if ( has_collections() )
+    {
+        vector<pair<int, string> >           bodies;
+        vector<pair<int, string> >::iterator it;
+
+        int rc;
+
+        cmd << "SELECT oid, body FROM " << table;
+
+        if ( !where.empty() )
+        {
+            cmd << " WHERE " << where;
+        }
+
+        cmd << " ORDER BY oid";
+
+        if ( !limit.empty() )
+        {
+            cmd << " LIMIT " << limit;
+        }
+
+        set_callback(static_cast<Callbackable::Callback>(&PoolSQL::dump_body_cb),
+                     static_cast<void *>(&bodies));
+
+        rc = db->exec(cmd, this);
+
+        unset_callback();
+
+        if ( rc == 0 )
+        {
+            rc = rebuild_xml(bodies, where.empty() && limit.empty());
+        }
+
+        if ( rc != 0 )
+        {
+            return rc;
+        }
+
+        oss << "<" << elem_name << ">";
+
+        for (it = bodies.begin(); it != bodies.end(); it++)
+        {
+            oss << it->second;
+        }
+
+        add_extra_xml(oss);
+
+        oss << "</" << elem_name << ">";
+
+        return 0;
+    }
+
     cmd << "SELECT body FROM " << table;
 
     if ( !where.empty() )
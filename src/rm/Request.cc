@@ -38,6 +38,8 @@ void Request::execute(
     Nebula& nd = Nebula::instance();
     UserPool* upool = nd.get_upool();
 
+    unsigned long long start = RequestMetrics::now();
+
     bool authenticated = upool->authenticate(att.session,
                                              att.password,
                                              att.uid,
@@ -47,6 +49,8 @@ void Request::execute(
                                              att.group_ids,
                                              att.umask);
 
+    metrics->record(RequestMetrics::AUTHENTICATION, start);
+
     log_method_invoked(att, _paramList);
 
     if ( authenticated == false )
@@ -59,6 +63,41 @@ void Request::execute(
     }
 
     log_result(att);
+
+    metrics->record(RequestMetrics::TOTAL, start);
+};
+
+/* -------------------------------------------------------------------------- */
+
+void Request::execute(
+        xmlrpc_c::paramList const& _paramList,
+        const RequestAttributes&   auth,
+        xmlrpc_c::value *   const  _retval)
+{
+    RequestAttributes att;
+
+    att.uid       = auth.uid;
+    att.gid       = auth.gid;
+    att.uname     = auth.uname;
+    att.gname     = auth.gname;
+    att.password  = auth.password;
+    att.group_ids = auth.group_ids;
+    att.umask     = auth.umask;
+
+    att.retval  = _retval;
+    att.session = auth.session;
+
+    att.req_id = (reinterpret_cast<uintptr_t>(this) * rand()) % 10000;
+
+    unsigned long long start = RequestMetrics::now();
+
+    log_method_invoked(att, _paramList);
+
+    request_execute(_paramList, att);
+
+    log_result(att);
+
+    metrics->record(RequestMetrics::TOTAL, start);
 };
 
 /* -------------------------------------------------------------------------- */
@@ -291,7 +330,13 @@ bool Request::basic_authorization(int oid,
 
     ar.add_auth(op, perms);
 
-    if (UserPool::authorize(ar) == -1)
+    unsigned long long start = RequestMetrics::now();
+
+    int rc = UserPool::authorize(ar);
+
+    metrics->record(RequestMetrics::AUTHORIZATION, start);
+
+    if (rc == -1)
     {
         failure_response(AUTHORIZATION,
                          authorization_error(ar.message, att),
@@ -327,6 +372,7 @@ bool Request::user_quota_authorization (Template * tmpl,
 
     DefaultQuotas default_user_quotas = nd.get_default_user_quota();
 
+    // Check and add under the user lock, the DB write is deferred
     rc = user->quota.quota_check(qtype, tmpl, default_user_quotas, error_str);
 
     if (rc == true)
@@ -371,6 +417,7 @@ bool Request::group_quota_authorization (Template * tmpl,
 
     DefaultQuotas default_group_quotas = nd.get_default_group_quota();
 
+    // Check and add under the group lock, the DB write is deferred
     rc = group->quota.quota_check(qtype, tmpl, default_group_quotas, error_str);
 
     if (rc == true)
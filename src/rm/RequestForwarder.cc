@@ -0,0 +1,1006 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+
+#include "RequestForwarder.h"
+#include "RequestServer.h"
+#include "RequestMetrics.h"
+#include "Request.h"
+#include "NebulaLog.h"
+
+#include <sstream>
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Events read in each epoll_wait call
+ */
+static const int RF_MAX_EVENTS = 64;
+
+/**
+ *  Size of the buffer used to read from the master
+ */
+static const size_t RF_READ_BUFFER_SIZE = 65536;
+
+/**
+ *  Maximum size of the status line and headers of a response
+ */
+static const size_t RF_MAX_HEADER_SIZE = 65536;
+
+/**
+ *  Seconds a connection to the master can be idle, it has to be lower than
+ *  the KEEPALIVE_TIMEOUT of the master
+ */
+static const time_t RF_IDLE_TIMEOUT = 10;
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+extern "C" void * rf_loop(void *arg)
+{
+    RequestForwarder * rf;
+
+    if ( arg == 0 )
+    {
+        return 0;
+    }
+
+    rf = static_cast<RequestForwarder *>(arg);
+
+    rf->loop();
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+RequestForwarder::RequestForwarder(
+        const string&      _endpoint,
+        const set<string>& _methods,
+        int                _connections,
+        int                _pipeline,
+        int                _timeout,
+        int                _max_pending):
+            endpoint(_endpoint),
+            methods(_methods),
+            pipeline(_pipeline),
+            timeout(_timeout),
+            max_pending(_max_pending),
+            server(0),
+            epoll_fd(-1),
+            forwarded(0),
+            rejected(0),
+            failed(0),
+            max_pending_time(0),
+            inflight(0),
+            end(false)
+{
+    wake_fd[0] = -1;
+    wake_fd[1] = -1;
+
+    if ( _connections < 1 )
+    {
+        _connections = 1;
+    }
+
+    if ( pipeline < 1 )
+    {
+        pipeline = 1;
+    }
+
+    upstreams.resize(_connections);
+
+    for (unsigned int i = 0; i < upstreams.size(); i++)
+    {
+        upstreams[i].fd            = -1;
+        upstreams[i].connected     = false;
+        upstreams[i].out_pos       = 0;
+        upstreams[i].last_activity = 0;
+    }
+
+    pthread_mutex_init(&mutex, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+
+RequestForwarder::~RequestForwarder()
+{
+    for (unsigned int i = 0; i < upstreams.size(); i++)
+    {
+        Upstream& up = upstreams[i];
+
+        if ( up.fd != -1 )
+        {
+            close(up.fd);
+        }
+
+        for (unsigned int j = 0; j < up.inflight.size(); j++)
+        {
+            delete up.inflight[j];
+        }
+    }
+
+    for (unsigned int i = 0; i < pending.size(); i++)
+    {
+        delete pending[i];
+    }
+
+    if ( epoll_fd != -1 )
+    {
+        close(epoll_fd);
+    }
+
+    if ( wake_fd[0] != -1 )
+    {
+        close(wake_fd[0]);
+        close(wake_fd[1]);
+    }
+
+    pthread_mutex_destroy(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int RequestForwarder::parse_endpoint()
+{
+    static const string scheme = "http://";
+
+    string::size_type pos;
+    string            hostport;
+
+    if ( endpoint.compare(0, scheme.size(), scheme) != 0 )
+    {
+        return -1;
+    }
+
+    hostport = endpoint.substr(scheme.size());
+
+    pos = hostport.find('/');
+
+    if ( pos == string::npos )
+    {
+        path = "/RPC2";
+    }
+    else
+    {
+        path     = hostport.substr(pos);
+        hostport = hostport.substr(0, pos);
+    }
+
+    pos = hostport.rfind(':');
+
+    if ( pos == string::npos )
+    {
+        host = hostport;
+        port = "80";
+    }
+    else
+    {
+        host = hostport.substr(0, pos);
+        port = hostport.substr(pos + 1);
+    }
+
+    if ( host.empty() )
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int RequestForwarder::resolve_endpoint()
+{
+    struct addrinfo   hints;
+    struct addrinfo * result;
+
+    int rc;
+
+    memset(&hints, 0, sizeof(hints));
+
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+
+    if ( rc != 0 )
+    {
+        ostringstream oss;
+
+        oss << "Cannot resolve master " << host << ": " << gai_strerror(rc);
+        NebulaLog::log("ReM", Log::ERROR, oss);
+
+        return -1;
+    }
+
+    memcpy(&addr, result->ai_addr, result->ai_addrlen);
+
+    addr_len = result->ai_addrlen;
+
+    freeaddrinfo(result);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int RequestForwarder::start(RequestServer * _server)
+{
+    struct epoll_event ev;
+    pthread_attr_t     pattr;
+    ostringstream      oss;
+
+    server = _server;
+
+    if ( parse_endpoint() != 0 )
+    {
+        oss << "Cannot forward calls to " << endpoint << ", only http "
+            << "endpoints are supported.";
+        NebulaLog::log("ReM", Log::ERROR, oss);
+
+        return -1;
+    }
+
+    if ( resolve_endpoint() != 0 )
+    {
+        return -1;
+    }
+
+    if ( pipe(wake_fd) == -1 )
+    {
+        oss << "Cannot create the RPC forwarder pipe: " << strerror(errno);
+        NebulaLog::log("ReM", Log::ERROR, oss);
+
+        return -1;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        fcntl(wake_fd[i], F_SETFL, fcntl(wake_fd[i], F_GETFL) | O_NONBLOCK);
+        fcntl(wake_fd[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    epoll_fd = epoll_create(upstreams.size() + 1);
+
+    if ( epoll_fd == -1 )
+    {
+        oss << "Cannot create the RPC forwarder epoll: " << strerror(errno);
+        NebulaLog::log("ReM", Log::ERROR, oss);
+
+        return -1;
+    }
+
+    fcntl(epoll_fd, F_SETFD, FD_CLOEXEC);
+
+    memset(&ev, 0, sizeof(ev));
+
+    ev.events   = EPOLLIN;
+    ev.data.u32 = upstreams.size(); // Index past the connections: wake pipe
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd[0], &ev);
+
+    pthread_attr_init(&pattr);
+    pthread_attr_setdetachstate(&pattr, PTHREAD_CREATE_JOINABLE);
+
+    pthread_create(&thread, &pattr, rf_loop, (void *) this);
+
+    oss << "Forwarding calls to the master " << endpoint << ", "
+        << upstreams.size() << " connections, " << pipeline
+        << " calls per connection.";
+
+    NebulaLog::log("ReM", Log::INFO, oss);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestForwarder::stop()
+{
+    pthread_mutex_lock(&mutex);
+
+    end = true;
+
+    pthread_mutex_unlock(&mutex);
+
+    if ( write(wake_fd[1], "s", 1) == -1 && errno != EAGAIN )
+    {
+        NebulaLog::log("ReM", Log::ERROR, "Cannot stop the RPC forwarder");
+    }
+
+    pthread_join(thread, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int RequestForwarder::forward(int conn_id, const string& method,
+        const string& body)
+{
+    Forward * fw = new Forward;
+
+    fw->conn_id = conn_id;
+    fw->method  = method;
+    fw->queued  = RequestMetrics::now();
+
+    pthread_mutex_lock(&mutex);
+
+    if ( static_cast<int>(pending.size()) >= max_pending )
+    {
+        rejected++;
+
+        pthread_mutex_unlock(&mutex);
+
+        delete fw;
+
+        return -1;
+    }
+
+    ostringstream oss;
+
+    oss << "POST " << path << " HTTP/1.1\r\n"
+        << "Host: " << host << ":" << port << "\r\n"
+        << "User-Agent: OpenNebula\r\n"
+        << "Content-Type: text/xml\r\n"
+        << "Content-Length: " << body.size() << "\r\n\r\n";
+
+    fw->body = oss.str();
+    fw->body.append(body);
+
+    pending.push_back(fw);
+
+    pthread_mutex_unlock(&mutex);
+
+    if ( write(wake_fd[1], "f", 1) == -1 && errno != EAGAIN )
+    {
+        NebulaLog::log("ReM", Log::ERROR, "Cannot wake the RPC forwarder");
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+string& RequestForwarder::to_xml(string& xml)
+{
+    ostringstream oss;
+
+    pthread_mutex_lock(&mutex);
+
+    oss << "<FORWARD>"
+        <<   "<ENDPOINT>"         << endpoint         << "</ENDPOINT>"
+        <<   "<CONNECTIONS>"      << upstreams.size() << "</CONNECTIONS>"
+        <<   "<PIPELINE>"         << pipeline         << "</PIPELINE>"
+        <<   "<PENDING>"          << pending.size()   << "</PENDING>"
+        <<   "<INFLIGHT>"         << inflight         << "</INFLIGHT>"
+        <<   "<FORWARDED>"        << forwarded        << "</FORWARDED>"
+        <<   "<REJECTED>"         << rejected         << "</REJECTED>"
+        <<   "<FAILED>"           << failed           << "</FAILED>"
+        <<   "<PENDING_TIME_MAX>" << max_pending_time << "</PENDING_TIME_MAX>"
+        << "</FORWARD>";
+
+    pthread_mutex_unlock(&mutex);
+
+    xml = oss.str();
+
+    return xml;
+}
+
+/* ************************************************************************** */
+/* Forwarder thread                                                           */
+/* ************************************************************************** */
+
+void RequestForwarder::loop()
+{
+    struct epoll_event events[RF_MAX_EVENTS];
+
+    time_t last_check = time(0);
+
+    while (true)
+    {
+        int n = epoll_wait(epoll_fd, events, RF_MAX_EVENTS, 1000);
+
+        for (int i = 0; i < n; i++)
+        {
+            unsigned int index = events[i].data.u32;
+
+            if ( index == upstreams.size() )
+            {
+                char buffer[256];
+                bool _end;
+
+                while ( read(wake_fd[0], buffer, sizeof(buffer)) > 0 );
+
+                pthread_mutex_lock(&mutex);
+
+                _end = end;
+
+                pthread_mutex_unlock(&mutex);
+
+                if ( _end )
+                {
+                    return;
+                }
+
+                continue;
+            }
+
+            Upstream& up = upstreams[index];
+
+            if ( up.fd == -1 )
+            {
+                continue;
+            }
+
+            if ( events[i].events & EPOLLOUT )
+            {
+                if ( !up.connected )
+                {
+                    int       error = 0;
+                    socklen_t len   = sizeof(error);
+
+                    getsockopt(up.fd, SOL_SOCKET, SO_ERROR, &error, &len);
+
+                    if ( error != 0 )
+                    {
+                        close_upstream(up, strerror(error));
+                        continue;
+                    }
+
+                    up.connected = true;
+                }
+
+                write_upstream(up);
+            }
+
+            if ( up.fd != -1 &&
+                 (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) )
+            {
+                read_upstream(up);
+            }
+        }
+
+        dispatch();
+
+        time_t the_time = time(0);
+
+        if ( the_time != last_check )
+        {
+            check_timeouts();
+
+            last_check = the_time;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+int RequestForwarder::connect_upstream(Upstream& up)
+{
+    struct epoll_event ev;
+
+    int rc;
+    int yes = 1;
+
+    up.fd = socket(addr.ss_family, SOCK_STREAM, 0);
+
+    if ( up.fd == -1 )
+    {
+        return -1;
+    }
+
+    fcntl(up.fd, F_SETFL, fcntl(up.fd, F_GETFL) | O_NONBLOCK);
+    fcntl(up.fd, F_SETFD, FD_CLOEXEC);
+
+    setsockopt(up.fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(int));
+
+    rc = connect(up.fd, (struct sockaddr *) &addr, addr_len);
+
+    if ( rc == -1 && errno != EINPROGRESS )
+    {
+        ostringstream oss;
+
+        oss << "Cannot connect to master " << endpoint << ": "
+            << strerror(errno);
+        NebulaLog::log("ReM", Log::ERROR, oss);
+
+        close(up.fd);
+        up.fd = -1;
+
+        return -1;
+    }
+
+    up.connected     = (rc == 0);
+    up.out_pos       = 0;
+    up.last_activity = time(0);
+
+    up.out.clear();
+    up.in.clear();
+
+    memset(&ev, 0, sizeof(ev));
+
+    ev.events   = EPOLLIN | EPOLLOUT;
+    ev.data.u32 = &up - &upstreams[0];
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, up.fd, &ev);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestForwarder::close_upstream(Upstream& up, const string& error)
+{
+    ostringstream oss;
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, up.fd, 0);
+
+    close(up.fd);
+
+    up.fd        = -1;
+    up.connected = false;
+    up.out_pos   = 0;
+
+    up.out.clear();
+    up.in.clear();
+
+    if ( up.inflight.empty() )
+    {
+        return;
+    }
+
+    oss << "Connection to the master " << endpoint << " failed with "
+        << up.inflight.size() << " calls in flight: " << error;
+
+    NebulaLog::log("ReM", Log::ERROR, oss);
+
+    // The master may have executed the calls, they can not be retried
+    for (unsigned int i = 0; i < up.inflight.size(); i++)
+    {
+        complete(up.inflight[i], error, false);
+    }
+
+    up.inflight.clear();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestForwarder::dispatch()
+{
+    vector<Forward *> ready;
+
+    unsigned long long the_time = RequestMetrics::now();
+
+    pthread_mutex_lock(&mutex);
+
+    while ( !pending.empty() )
+    {
+        Upstream * best = 0;
+
+        for (unsigned int i = 0; i < upstreams.size(); i++)
+        {
+            Upstream& up = upstreams[i];
+
+            if ( static_cast<int>(up.inflight.size()) >= pipeline )
+            {
+                continue;
+            }
+
+            if ( best == 0 || up.inflight.size() < best->inflight.size() ||
+                 (best->fd == -1 && up.fd != -1 &&
+                  up.inflight.size() == best->inflight.size()) )
+            {
+                best = &up;
+            }
+        }
+
+        if ( best == 0 ) // All the connections are full
+        {
+            break;
+        }
+
+        if ( best->fd == -1 && connect_upstream(*best) != 0 )
+        {
+            break;
+        }
+
+        Forward * fw = pending.front();
+
+        pending.pop_front();
+
+        if ( best->inflight.empty() )
+        {
+            best->last_activity = time(0);
+        }
+
+        if ( the_time - fw->queued > max_pending_time )
+        {
+            max_pending_time = the_time - fw->queued;
+        }
+
+        // The call is kept till its response is read, it is sent again if the
+        // master closes the connection before answering it
+        best->out.append(fw->body);
+
+        best->inflight.push_back(fw);
+
+        inflight++;
+
+        ready.push_back(fw);
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    if ( ready.empty() )
+    {
+        return;
+    }
+
+    for (unsigned int i = 0; i < upstreams.size(); i++)
+    {
+        Upstream& up = upstreams[i];
+
+        if ( up.fd != -1 && up.connected && up.out_pos < up.out.size() )
+        {
+            write_upstream(up);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestForwarder::set_events(Upstream& up)
+{
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+
+    ev.events   = EPOLLIN;
+    ev.data.u32 = &up - &upstreams[0];
+
+    if ( !up.connected || up.out_pos < up.out.size() )
+    {
+        ev.events |= EPOLLOUT;
+    }
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, up.fd, &ev);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestForwarder::write_upstream(Upstream& up)
+{
+    while ( up.out_pos < up.out.size() )
+    {
+        ssize_t rc = send(up.fd, up.out.data() + up.out_pos,
+                up.out.size() - up.out_pos, MSG_NOSIGNAL);
+
+        if ( rc >= 0 )
+        {
+            up.out_pos += rc;
+            continue;
+        }
+
+        if ( errno == EINTR )
+        {
+            continue;
+        }
+
+        if ( errno == EAGAIN || errno == EWOULDBLOCK )
+        {
+            break;
+        }
+
+        close_upstream(up, strerror(errno));
+        return;
+    }
+
+    if ( up.out_pos == up.out.size() )
+    {
+        up.out.clear();
+        up.out_pos = 0;
+    }
+
+    set_events(up);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestForwarder::read_upstream(Upstream& up)
+{
+    char    buffer[RF_READ_BUFFER_SIZE];
+    ssize_t rc;
+
+    while (true)
+    {
+        rc = recv(up.fd, buffer, sizeof(buffer), 0);
+
+        if ( rc > 0 )
+        {
+            up.in.append(buffer, rc);
+            continue;
+        }
+
+        if ( rc == -1 && (errno == EAGAIN || errno == EWOULDBLOCK) )
+        {
+            break;
+        }
+
+        if ( rc == -1 && errno == EINTR )
+        {
+            continue;
+        }
+
+        // Closed by the master (e.g. keep-alive timeout) or error
+        if ( parse_responses(up) && up.fd != -1 )
+        {
+            close_upstream(up, rc == 0 ? "Connection closed by the master" :
+                    strerror(errno));
+        }
+
+        return;
+    }
+
+    up.last_activity = time(0);
+
+    parse_responses(up);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool RequestForwarder::parse_responses(Upstream& up)
+{
+    while ( !up.in.empty() )
+    {
+        string::size_type hend = up.in.find("\r\n\r\n");
+
+        if ( hend == string::npos )
+        {
+            if ( up.in.size() > RF_MAX_HEADER_SIZE )
+            {
+                close_upstream(up, "Wrong response from the master");
+                return false;
+            }
+
+            return true;
+        }
+
+        string headers = up.in.substr(0, hend + 2);
+
+        transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+
+        // ---------------------------------------------------------------------
+        // Status line, 1xx responses are skipped
+        // ---------------------------------------------------------------------
+        string version;
+        int    code = 0;
+
+        istringstream iss(headers);
+
+        iss >> version >> code;
+
+        if ( code >= 100 && code < 200 )
+        {
+            up.in.erase(0, hend + 4);
+            continue;
+        }
+
+        // ---------------------------------------------------------------------
+        // Body, only Content-Length delimited bodies are supported
+        // ---------------------------------------------------------------------
+        string::size_type cl = headers.find("\r\ncontent-length:");
+
+        if ( cl == string::npos )
+        {
+            close_upstream(up, "Wrong response from the master");
+            return false;
+        }
+
+        size_t length = strtoul(headers.c_str() + cl + 17, 0, 10);
+
+        if ( up.in.size() < hend + 4 + length )
+        {
+            return true;
+        }
+
+        bool close_conn = headers.find("\r\nconnection: close") != string::npos;
+
+        string body = up.in.substr(hend + 4, length);
+
+        up.in.erase(0, hend + 4 + length);
+
+        if ( up.inflight.empty() )
+        {
+            close_upstream(up, "Unexpected response from the master");
+            return false;
+        }
+
+        Forward * fw = up.inflight.front();
+
+        up.inflight.pop_front();
+
+        if ( code == 200 )
+        {
+            complete(fw, body, true);
+        }
+        else
+        {
+            ostringstream oss;
+
+            oss << "HTTP error " << code << " from the master";
+
+            complete(fw, oss.str(), false);
+        }
+
+        if ( close_conn )
+        {
+            // The master does not read the calls pipelined after the close,
+            // they are forwarded again in a new connection
+            pthread_mutex_lock(&mutex);
+
+            for (int i = up.inflight.size() - 1; i >= 0; i--)
+            {
+                Forward * retry = up.inflight[i];
+
+                pending.push_front(retry);
+
+                inflight--;
+            }
+
+            pthread_mutex_unlock(&mutex);
+
+            up.inflight.clear();
+
+            close_upstream(up, "");
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestForwarder::complete(Forward * fw, const string& response,
+        bool success)
+{
+    string        body;
+    ostringstream oss;
+
+    unsigned long long the_time = RequestMetrics::now();
+
+    RequestMetrics::get("RequestManagerProxy." + fw->method)->record(
+            RequestMetrics::TOTAL, fw->queued);
+
+    if ( success )
+    {
+        body = response;
+    }
+    else
+    {
+        // Same response than RequestManagerProxy if it can not reach the
+        // master, the message has no XML special characters
+        oss << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+            << "<methodResponse>\r\n<params>\r\n<param><value><array><data>\r\n"
+            << "<value><boolean>0</boolean></value>\r\n"
+            << "<value><string>[RequestManagerProxy." << fw->method
+            << "] Could not connect to the federation master oned</string>"
+            << "</value>\r\n"
+            << "<value><i4>" << Request::INTERNAL << "</i4></value>\r\n"
+            << "</data></array></value></param>\r\n</params>\r\n"
+            << "</methodResponse>\r\n";
+
+        body = oss.str();
+
+        oss.str("");
+    }
+
+    pthread_mutex_lock(&mutex);
+
+    inflight--;
+
+    if ( success )
+    {
+        forwarded++;
+    }
+    else
+    {
+        failed++;
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    oss << "Forwarded " << fw->method << " to the master in "
+        << (the_time - fw->queued) / 1000 << "ms";
+
+    if ( !success )
+    {
+        oss << ", failed: " << response;
+    }
+
+    NebulaLog::log("ReM", success ? Log::DDEBUG : Log::ERROR, oss);
+
+    server->forward_done(fw->conn_id, body);
+
+    delete fw;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestForwarder::check_timeouts()
+{
+    time_t the_time = time(0);
+
+    vector<Forward *> expired;
+
+    unsigned long long limit = RequestMetrics::now() - timeout * 1000000ULL;
+
+    pthread_mutex_lock(&mutex);
+
+    while ( !pending.empty() && pending.front()->queued < limit )
+    {
+        expired.push_back(pending.front());
+
+        pending.pop_front();
+
+        inflight++; // Accounted as in flight till completed
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    for (unsigned int i = 0; i < expired.size(); i++)
+    {
+        complete(expired[i], "Timeout waiting for a connection", false);
+    }
+
+    for (unsigned int i = 0; i < upstreams.size(); i++)
+    {
+        Upstream& up = upstreams[i];
+
+        if ( up.fd == -1 )
+        {
+            continue;
+        }
+
+        if ( !up.inflight.empty() && the_time - up.last_activity > timeout )
+        {
+            close_upstream(up, "Timeout waiting for the master");
+        }
+        else if ( up.inflight.empty() &&
+                  the_time - up.last_activity > RF_IDLE_TIMEOUT )
+        {
+            // Close before the master does, to not send a call in a
+            // connection being closed
+            close_upstream(up, "");
+        }
+    }
+}
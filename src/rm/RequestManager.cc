@@ -60,8 +60,15 @@ RequestManager::RequestManager(
         int _keepalive_timeout,
         int _keepalive_max_conn,
         int _timeout,
+        int _threads,
+        const int _concurrency[],
+        const int _queue_size[],
         const string _xml_log_file,
-        const string call_log_format):
+        const string call_log_format,
+        bool _prometheus,
+        int _proxy_connections,
+        int _proxy_pipeline,
+        int _proxy_timeout):
             port(_port),
             socket_fd(-1),
             max_conn(_max_conn),
@@ -69,8 +76,20 @@ RequestManager::RequestManager(
             keepalive_timeout(_keepalive_timeout),
             keepalive_max_conn(_keepalive_max_conn),
             timeout(_timeout),
-            xml_log_file(_xml_log_file)
+            threads(_threads),
+            xml_log_file(_xml_log_file),
+            prometheus(_prometheus),
+            proxy_connections(_proxy_connections),
+            proxy_pipeline(_proxy_pipeline),
+            proxy_timeout(_proxy_timeout),
+            server(0)
 {
+    for (int i = 0; i < RequestServer::NUM_CLASSES; i++)
+    {
+        concurrency[i] = _concurrency[i];
+        queue_size[i]  = _queue_size[i];
+    }
+
     Request::set_call_log_format(call_log_format);
 
     am.addListener(this);
@@ -103,53 +122,6 @@ extern "C" void * rm_action_loop(void *arg)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-extern "C" void * rm_xml_server_loop(void *arg)
-{
-    RequestManager *    rm;
-
-    if ( arg == 0 )
-    {
-        return 0;
-    }
-
-    rm = static_cast<RequestManager *>(arg);
-
-    // Set cancel state for the thread
-
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE,0);
-
-    pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS,0);
-
-    //Start the server
-
-    xmlrpc_c::serverAbyss::constrOpt opt = xmlrpc_c::serverAbyss::constrOpt();
-
-    opt.registryP(&rm->RequestManagerRegistry);
-    opt.keepaliveTimeout(rm->keepalive_timeout);
-    opt.keepaliveMaxConn(rm->keepalive_max_conn);
-    opt.timeout(rm->timeout);
-    opt.socketFd(rm->socket_fd);
-
-    if (!rm->xml_log_file.empty())
-    {
-        opt.logFileName(rm->xml_log_file);
-    }
-
-#ifndef OLD_XMLRPC
-    opt.maxConn(rm->max_conn);
-    opt.maxConnBacklog(rm->max_conn_backlog);
-#endif
-
-    rm->AbyssServer = new xmlrpc_c::serverAbyss(opt);
-
-    rm->AbyssServer->run();
-
-    return 0;
-}
-
-/* -------------------------------------------------------------------------- */
-/* -------------------------------------------------------------------------- */
-
 int RequestManager::setup_socket()
 {
     int                 rc;
@@ -224,18 +196,38 @@ int RequestManager::start()
 
     register_xml_methods();
 
-    pthread_attr_init (&pattr);
-    pthread_attr_setdetachstate (&pattr, PTHREAD_CREATE_JOINABLE);
+    oss << "Starting XML-RPC server, port " << port << " ...";
+    NebulaLog::log("ReM",Log::INFO,oss);
 
-    pthread_create(&rm_thread,&pattr,rm_action_loop,(void *)this);
+    server = new RequestServer(&RequestManagerRegistry, socket_fd, max_conn,
+            max_conn_backlog, keepalive_timeout, keepalive_max_conn, timeout,
+            threads, concurrency, queue_size, xml_log_file, prometheus);
+
+    Nebula& nd = Nebula::instance();
+
+    if ( nd.is_federation_slave() && proxy_connections > 0 )
+    {
+        server->set_forwarder(new RequestForwarder(nd.get_master_oned(),
+                RequestManagerProxy::get_methods(), proxy_connections,
+                proxy_pipeline, proxy_timeout,
+                queue_size[RequestServer::WRITE]));
+    }
+
+    if ( server->start() != 0 )
+    {
+        delete server;
+        server = 0;
+
+        close(socket_fd);
+        socket_fd = -1;
+
+        return -1;
+    }
 
     pthread_attr_init (&pattr);
     pthread_attr_setdetachstate (&pattr, PTHREAD_CREATE_JOINABLE);
 
-    oss << "Starting XML-RPC server, port " << port << " ...";
-    NebulaLog::log("ReM",Log::INFO,oss);
-
-    pthread_create(&rm_xml_server_thread,&pattr,rm_xml_server_loop,(void *)this);
+    pthread_create(&rm_thread,&pattr,rm_action_loop,(void *)this);
 
     return 0;
 }
@@ -251,13 +243,13 @@ void RequestManager::do_action(
     {
         NebulaLog::log("ReM",Log::INFO,"Stopping Request Manager...");
 
-        pthread_cancel(rm_xml_server_thread);
-
-        pthread_join(rm_xml_server_thread,0);
+        server->stop();
 
         NebulaLog::log("ReM",Log::INFO,"XML-RPC server stopped.");
 
-        delete AbyssServer;
+        delete server;
+
+        server = 0;
 
         if ( socket_fd != -1 )
         {
@@ -276,12 +268,28 @@ void RequestManager::do_action(
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void RequestRegistry::addMethod(const string& name, xmlrpc_c::methodPtr method)
+{
+    Request * request = dynamic_cast<Request *>(method.operator->());
+
+    if ( request != 0 )
+    {
+        requests[name] = request;
+    }
+
+    xmlrpc_c::registry::addMethod(name, method);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void RequestManager::register_xml_methods()
 {
     Nebula& nebula = Nebula::instance();
 
     // VMTemplate Methods
     xmlrpc_c::methodPtr template_instantiate(new VMTemplateInstantiate());
+    xmlrpc_c::methodPtr template_instantiate_bulk(new VMTemplateInstantiateBulk());
 
     // VirtualMachine Methods
     xmlrpc_c::methodPtr vm_deploy(new VirtualMachineDeploy());
@@ -413,6 +421,8 @@ void RequestManager::register_xml_methods()
     // System Methods
     xmlrpc_c::methodPtr system_version(new SystemVersion());
     xmlrpc_c::methodPtr system_config(new SystemConfig());
+    xmlrpc_c::methodPtr system_metrics(new SystemMetrics());
+    xmlrpc_c::methodPtr system_batch(new SystemBatch());
 
     // Rename Methods
     xmlrpc_c::methodPtr vm_rename(new VirtualMachineRename());
@@ -456,6 +466,7 @@ void RequestManager::register_xml_methods()
     /* VM Template related methods*/
     RequestManagerRegistry.addMethod("one.template.update", template_update);
     RequestManagerRegistry.addMethod("one.template.instantiate",template_instantiate);
+    RequestManagerRegistry.addMethod("one.template.instantiatebulk",template_instantiate_bulk);
     RequestManagerRegistry.addMethod("one.template.allocate",template_allocate);
     RequestManagerRegistry.addMethod("one.template.delete", template_delete);
     RequestManagerRegistry.addMethod("one.template.info", template_info);
@@ -751,6 +762,8 @@ void RequestManager::register_xml_methods()
     /* System related methods */
     RequestManagerRegistry.addMethod("one.system.version", system_version);
     RequestManagerRegistry.addMethod("one.system.config", system_config);
+    RequestManagerRegistry.addMethod("one.system.metrics", system_metrics);
+    RequestManagerRegistry.addMethod("one.system.batch", system_batch);
 };
 
 /* -------------------------------------------------------------------------- */
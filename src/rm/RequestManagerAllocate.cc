@@ -79,6 +79,8 @@ bool VirtualMachineAllocate::allocate_authorization(
 
     VirtualMachineTemplate * ttmpl = static_cast<VirtualMachineTemplate *>(tmpl);
 
+    ttmpl->erase("VMS"); // Number of VMs for the quotas, set by oned
+
     // ------------ Check template for restricted attributes -------------------
 
     if ( att.uid != 0 && att.gid != GroupPool::ONEADMIN_ID )
@@ -438,6 +438,8 @@ void RequestManagerPoolInfoFilter::dump(
     string        where_string, limit_clause;
     int           rc;
 
+    unsigned long long start;
+
     if ( filter_flag < MINE )
     {
         failure_response(XML_RPC_API,
@@ -446,6 +448,8 @@ void RequestManagerPoolInfoFilter::dump(
         return;
     }
 
+    start = RequestMetrics::now();
+
     where_filter(att,
                  filter_flag,
                  start_id,
@@ -457,6 +461,8 @@ void RequestManagerPoolInfoFilter::dump(
                  false,
                  where_string);
 
+    metrics->record(RequestMetrics::AUTHORIZATION, start);
+
     if ( end_id < -1 )
     {
         oss << start_id << "," << -end_id;
@@ -464,16 +470,24 @@ void RequestManagerPoolInfoFilter::dump(
         oss.str("");
     }
 
+    start = RequestMetrics::now();
+
     rc = pool->dump(oss, where_string, limit_clause);
 
+    metrics->record(RequestMetrics::DB, start);
+
     if ( rc != 0 )
     {
         failure_response(INTERNAL,request_error("Internal Error",""), att);
         return;
     }
 
+    start = RequestMetrics::now();
+
     success_response(oss.str(), att);
 
+    metrics->record(RequestMetrics::RESPONSE, start);
+
     return;
 }
 
@@ -20,6 +20,11 @@
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+set<string> RequestManagerProxy::methods;
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 RequestManagerProxy::RequestManagerProxy(string _method)
     :Request("RequestManagerProxy", "?",
             "Forwards the request to another OpenNebula")
@@ -27,14 +32,22 @@ RequestManagerProxy::RequestManagerProxy(string _method)
     Nebula& nd = Nebula::instance();
 
     long long msg_size;
+    long long max_conn;
     const string& master_endpoint = nd.get_master_oned();
 
     nd.get_configuration_attribute("MESSAGE_SIZE", msg_size);
 
+    // Forwarded calls are concurrent up to the number of server connections
+    nd.get_configuration_attribute("MAX_CONN", max_conn);
+
     method = _method;
-    client = new Client("none", master_endpoint, msg_size);
+    client = new Client("none", master_endpoint, msg_size, max_conn);
 
     method_name = ("RequestManagerProxy." + method);
+
+    metrics = RequestMetrics::get(method_name);
+
+    methods.insert(method);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -57,6 +57,320 @@ void SystemConfig::request_execute(xmlrpc_c::paramList const& paramList,
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
 
+/**
+ *  Adds the cache statistics of a pool to the metrics document
+ *    @param oss the metrics document
+ *    @param name of the pool
+ *    @param pool
+ */
+static void pool_cache_to_xml(ostringstream& oss, const char * name,
+        PoolSQL * pool)
+{
+    unsigned long hits;
+    unsigned long misses;
+    unsigned int  size;
+
+    pool->get_cache_stats(hits, misses, size);
+
+    oss << "<POOL>"
+        <<   "<NAME>"   << name   << "</NAME>"
+        <<   "<SIZE>"   << size   << "</SIZE>"
+        <<   "<HITS>"   << hits   << "</HITS>"
+        <<   "<MISSES>" << misses << "</MISSES>"
+        << "</POOL>";
+}
+
+/**
+ *  Adds the outbound queue statistics of the drivers of a manager to the
+ *  metrics document
+ *    @param oss the metrics document
+ *    @param name of the manager
+ *    @param mm the manager, may be 0 if not in use
+ */
+static void drivers_to_xml(ostringstream& oss, const char * name,
+        MadManager * mm)
+{
+    string xml;
+
+    if ( mm == 0 )
+    {
+        return;
+    }
+
+    oss << "<MANAGER>"
+        <<   "<NAME>" << name << "</NAME>"
+        <<   mm->drivers_to_xml(xml)
+        << "</MANAGER>";
+}
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+void SystemMetrics::request_execute(xmlrpc_c::paramList const& paramList,
+                                 RequestAttributes& att)
+{
+    Nebula& nd = Nebula::instance();
+
+    ostringstream oss;
+    string        server_xml;
+    string        monitor_xml;
+
+    if ( att.gid != GroupPool::ONEADMIN_ID )
+    {
+        failure_response(AUTHORIZATION,
+            "The oned metrics can only be retrieved by users in the oneadmin group",
+            att);
+        return;
+    }
+
+    oss << "<METRICS><POOL_CACHE>";
+
+    pool_cache_to_xml(oss, "VM",            nd.get_vmpool());
+    pool_cache_to_xml(oss, "HOST",          nd.get_hpool());
+    pool_cache_to_xml(oss, "VNET",          nd.get_vnpool());
+    pool_cache_to_xml(oss, "USER",          nd.get_upool());
+    pool_cache_to_xml(oss, "IMAGE",         nd.get_ipool());
+    pool_cache_to_xml(oss, "GROUP",         nd.get_gpool());
+    pool_cache_to_xml(oss, "TEMPLATE",      nd.get_tpool());
+    pool_cache_to_xml(oss, "DATASTORE",     nd.get_dspool());
+    pool_cache_to_xml(oss, "CLUSTER",       nd.get_clpool());
+    pool_cache_to_xml(oss, "DOCUMENT",      nd.get_docpool());
+    pool_cache_to_xml(oss, "ZONE",          nd.get_zonepool());
+    pool_cache_to_xml(oss, "SECURITY_GROUP",nd.get_secgrouppool());
+
+    oss << "</POOL_CACHE>";
+
+    oss << nd.get_rm()->server_to_xml(server_xml);
+
+    RequestMetrics::to_xml(oss);
+
+    oss << nd.get_im()->monitor_to_xml(monitor_xml);
+
+    oss << "<DRIVERS>";
+
+    drivers_to_xml(oss, "VMM",   nd.get_vmm());
+    drivers_to_xml(oss, "TM",    nd.get_tm());
+    drivers_to_xml(oss, "IM",    nd.get_im());
+    drivers_to_xml(oss, "HOOK",  nd.get_hm());
+    drivers_to_xml(oss, "IMAGE", nd.get_imagem());
+    drivers_to_xml(oss, "AUTH",  nd.get_authm());
+
+    oss << "</DRIVERS>";
+
+    oss << "</METRICS>";
+
+    success_response(oss.str(), att);
+
+    return;
+}
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+const unsigned int SystemBatch::MAX_THREADS = 8;
+
+/* ------------------------------------------------------------------------- */
+
+extern "C" void * batch_call_loop(void *arg)
+{
+    SystemBatch::BatchState * state;
+
+    if ( arg == 0 )
+    {
+        return 0;
+    }
+
+    state = static_cast<SystemBatch::BatchState *>(arg);
+
+    state->batch->call_loop(state);
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+xmlrpc_c::value SystemBatch::call_failure(const string& error)
+{
+    vector<xmlrpc_c::value> arrayData;
+
+    arrayData.push_back(xmlrpc_c::value_boolean(false));
+    arrayData.push_back(xmlrpc_c::value_string(error));
+    arrayData.push_back(xmlrpc_c::value_int(XML_RPC_API));
+
+    return xmlrpc_c::value_array(arrayData);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void SystemBatch::call_loop(BatchState * state)
+{
+    unsigned int i;
+
+    while ((i = __sync_fetch_and_add(&(state->next), 1)) < state->calls.size())
+    {
+        BatchCall& call = state->calls[i];
+
+        if ( call.request == 0 )
+        {
+            call.result = call_failure(call.error);
+            continue;
+        }
+
+        try
+        {
+            call.request->execute(call.params, *(state->att), &call.result);
+        }
+        catch (exception& e)
+        {
+            call.result = call_failure(e.what());
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+void SystemBatch::request_execute(xmlrpc_c::paramList const& paramList,
+                                  RequestAttributes& att)
+{
+    vector<xmlrpc_c::value> calls = paramList.getArray(1);
+    bool                    parallel = false; //Optional XML-RPC argument
+
+    RequestManager * rm = Nebula::instance().get_rm();
+
+    BatchState        state;
+    vector<pthread_t> threads;
+    pthread_attr_t    pattr;
+
+    vector<xmlrpc_c::value> results;
+    vector<xmlrpc_c::value> arrayData;
+
+    unsigned int num_threads = 1;
+
+    if ( paramList.size() > 2 )
+    {
+        parallel = xmlrpc_c::value_boolean(paramList.getBoolean(2));
+    }
+
+    // -------------------------------------------------------------------------
+    // Look up the request of each call, and add the session to its parameters
+    // -------------------------------------------------------------------------
+
+    state.batch = this;
+    state.att   = &att;
+    state.next  = 0;
+
+    state.calls.resize(calls.size());
+
+    for (unsigned int i = 0; i < calls.size(); i++)
+    {
+        BatchCall& call = state.calls[i];
+
+        call.request = 0;
+
+        if ( calls[i].type() != xmlrpc_c::value::TYPE_ARRAY )
+        {
+            call.error = "Each call must be an array with the method name and "
+                "its parameters";
+            continue;
+        }
+
+        vector<xmlrpc_c::value> cparams =
+            xmlrpc_c::value_array(calls[i]).vectorValueValue();
+
+        if ( cparams.empty() || cparams[0].type()!=xmlrpc_c::value::TYPE_STRING )
+        {
+            call.error = "Each call must be an array with the method name and "
+                "its parameters";
+            continue;
+        }
+
+        string method = static_cast<string>(xmlrpc_c::value_string(cparams[0]));
+
+        call.request = rm->get_request(method);
+
+        if ( call.request == 0 )
+        {
+            call.error = "Unknown method " + method;
+            continue;
+        }
+        else if ( call.request == this )
+        {
+            call.request = 0;
+            call.error   = "Batch calls can not be nested";
+            continue;
+        }
+
+        call.params.add(xmlrpc_c::value_string(att.session));
+
+        for (unsigned int j = 1; j < cparams.size(); j++)
+        {
+            call.params.add(cparams[j]);
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Execute the calls, using the calling thread if only one is needed
+    // -------------------------------------------------------------------------
+
+    if ( parallel )
+    {
+        num_threads = MAX_THREADS;
+
+        if ( num_threads > state.calls.size() )
+        {
+            num_threads = state.calls.size();
+        }
+    }
+
+    if ( num_threads > 1 )
+    {
+        pthread_attr_init(&pattr);
+        pthread_attr_setdetachstate(&pattr, PTHREAD_CREATE_JOINABLE);
+
+        for (unsigned int i = 1; i < num_threads; i++)
+        {
+            pthread_t id;
+
+            if (pthread_create(&id, &pattr, batch_call_loop,
+                    (void *) &state) != 0)
+            {
+                NebulaLog::log("ReM", Log::ERROR,
+                        "Could not create batch call thread");
+                break;
+            }
+
+            threads.push_back(id);
+        }
+
+        pthread_attr_destroy(&pattr);
+    }
+
+    call_loop(&state); //Also execute calls in this thread
+
+    for (unsigned int i = 0; i < threads.size(); i++)
+    {
+        pthread_join(threads[i], 0);
+    }
+
+    // -------------------------------------------------------------------------
+    // Return the response of each call, in order
+    // -------------------------------------------------------------------------
+
+    for (unsigned int i = 0; i < state.calls.size(); i++)
+    {
+        results.push_back(state.calls[i].result);
+    }
+
+    arrayData.push_back(xmlrpc_c::value_boolean(true));
+    arrayData.push_back(xmlrpc_c::value_array(results));
+    arrayData.push_back(xmlrpc_c::value_int(SUCCESS));
+
+    *(att.retval) = xmlrpc_c::value_array(arrayData);
+}
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
 void UserQuotaInfo::request_execute(xmlrpc_c::paramList const& paramList,
                                  RequestAttributes& att)
 {
@@ -18,28 +18,24 @@
 #include "PoolObjectAuth.h"
 #include "Nebula.h"
 
+#include <limits.h>
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-void VMTemplateInstantiate::request_execute(xmlrpc_c::paramList const& paramList,
-                                            RequestAttributes& att)
+VirtualMachineTemplate * RequestManagerVMTemplate::instantiate_template(
+        int                 id,
+        const string&       name,
+        const string&       str_uattrs,
+        RequestAttributes&  att)
 {
-    int    id   = xmlrpc_c::value_int(paramList.getInt(1));
-    string name = xmlrpc_c::value_string(paramList.getString(2));
-    bool   on_hold = false; //Optional XML-RPC argument
-    string str_uattrs;      //Optional XML-RPC argument
-
-    int  rc;
-    int  vid;
+    int rc;
 
     ostringstream sid;
 
     PoolObjectAuth perms;
 
-    Nebula& nd = Nebula::instance();
-
-    VirtualMachinePool* vmpool  = nd.get_vmpool();
-    VMTemplatePool *    tpool   = static_cast<VMTemplatePool *>(pool);
+    VMTemplatePool * tpool = static_cast<VMTemplatePool *>(pool);
 
     VirtualMachineTemplate * tmpl;
     VirtualMachineTemplate   uattrs;
@@ -50,13 +46,6 @@ void VMTemplateInstantiate::request_execute(xmlrpc_c::paramList const& paramList
 
     string tmpl_name;
 
-    if ( paramList.size() > 3 )
-    {
-        on_hold = xmlrpc_c::value_boolean(paramList.getBoolean(3));
-
-        str_uattrs = xmlrpc_c::value_string(paramList.getString(4));
-    }
-
     /* ---------------------------------------------------------------------- */
     /* Get, check and clone the template                                      */
     /* ---------------------------------------------------------------------- */
@@ -69,7 +58,7 @@ void VMTemplateInstantiate::request_execute(xmlrpc_c::paramList const& paramList
                 get_error(object_name(auth_object),id),
                 att);
 
-        return;
+        return 0;
     }
 
     tmpl_name = rtmpl->get_name();
@@ -93,7 +82,7 @@ void VMTemplateInstantiate::request_execute(xmlrpc_c::paramList const& paramList
                     att);
 
             delete tmpl;
-            return;
+            return 0;
         }
     }
 
@@ -106,7 +95,7 @@ void VMTemplateInstantiate::request_execute(xmlrpc_c::paramList const& paramList
         {
             failure_response(INTERNAL, error_str, att);
             delete tmpl;
-            return;
+            return 0;
         }
 
         if (att.uid!=UserPool::ONEADMIN_ID && att.gid!=GroupPool::ONEADMIN_ID)
@@ -122,7 +111,7 @@ void VMTemplateInstantiate::request_execute(xmlrpc_c::paramList const& paramList
                         att);
 
                 delete tmpl;
-                return;
+                return 0;
             }
         }
 
@@ -132,7 +121,7 @@ void VMTemplateInstantiate::request_execute(xmlrpc_c::paramList const& paramList
         {
             failure_response(INTERNAL, error_str, att);
             delete tmpl;
-            return;
+            return 0;
         }
     }
 
@@ -142,6 +131,7 @@ void VMTemplateInstantiate::request_execute(xmlrpc_c::paramList const& paramList
     tmpl->erase("NAME");
     tmpl->erase("TEMPLATE_NAME");
     tmpl->erase("TEMPLATE_ID");
+    tmpl->erase("VMS"); // Number of VMs for the quotas, set by oned
 
     sid << id;
 
@@ -178,9 +168,51 @@ void VMTemplateInstantiate::request_execute(xmlrpc_c::paramList const& paramList
                     att);
 
             delete tmpl;
-            return;
+            return 0;
         }
+    }
+
+    return tmpl;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void VMTemplateInstantiate::request_execute(xmlrpc_c::paramList const& paramList,
+                                            RequestAttributes& att)
+{
+    int    id   = xmlrpc_c::value_int(paramList.getInt(1));
+    string name = xmlrpc_c::value_string(paramList.getString(2));
+    bool   on_hold = false; //Optional XML-RPC argument
+    string str_uattrs;      //Optional XML-RPC argument
+
+    int  rc;
+    int  vid;
+
+    Nebula& nd = Nebula::instance();
 
+    VirtualMachinePool* vmpool  = nd.get_vmpool();
+
+    VirtualMachineTemplate * tmpl;
+
+    string error_str;
+
+    if ( paramList.size() > 3 )
+    {
+        on_hold = xmlrpc_c::value_boolean(paramList.getBoolean(3));
+
+        str_uattrs = xmlrpc_c::value_string(paramList.getString(4));
+    }
+
+    tmpl = instantiate_template(id, name, str_uattrs, att);
+
+    if ( tmpl == 0 )
+    {
+        return;
+    }
+
+    if ( att.uid != 0 )
+    {
         if ( quota_authorization(tmpl, Quotas::VIRTUALMACHINE, att) == false )
         {
             delete tmpl;
@@ -210,3 +242,204 @@ void VMTemplateInstantiate::request_execute(xmlrpc_c::paramList const& paramList
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+/**
+ *  Builds the quota usage of a number of VMs created from the same template.
+ *  MEMORY and CPU are added up, and the NICs and DISKs are replicated so the
+ *  leases, images and volatile disks of every VM are counted.
+ *    @param tmpl of the VMs
+ *    @param number of VMs
+ *    @param qtmpl the quota template
+ *    @param error_str Returns the error reason, if any
+ *    @return 0 on success, -1 if the total usage can not be represented
+ */
+static int bulk_quota_template(VirtualMachineTemplate * tmpl,
+                               int                      number,
+                               Template&                qtmpl,
+                               string&                  error_str)
+{
+    int   memory;
+    float cpu;
+
+    vector<Attribute *> nics;
+    vector<Attribute *> disks;
+
+    if ( tmpl->get("MEMORY", memory) )
+    {
+        long long total = static_cast<long long>(memory) * number;
+
+        if ( total < 0 || total > INT_MAX )
+        {
+            error_str = "Total MEMORY of the VMs out of range";
+            return -1;
+        }
+
+        qtmpl.add("MEMORY", static_cast<int>(total));
+    }
+
+    if ( tmpl->get("CPU", cpu) )
+    {
+        qtmpl.add("CPU", cpu * number);
+    }
+
+    qtmpl.add("VMS", number);
+
+    tmpl->get("NIC", nics);
+    tmpl->get("DISK", disks);
+
+    for (int i = 0; i < number; i++)
+    {
+        for (vector<Attribute *>::iterator it = nics.begin(); it != nics.end(); it++)
+        {
+            qtmpl.set((*it)->clone());
+        }
+
+        for (vector<Attribute *>::iterator it = disks.begin(); it != disks.end(); it++)
+        {
+            qtmpl.set((*it)->clone());
+        }
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void VMTemplateInstantiateBulk::request_execute(
+        xmlrpc_c::paramList const& paramList,
+        RequestAttributes&         att)
+{
+    int    id     = xmlrpc_c::value_int(paramList.getInt(1));
+    int    number = xmlrpc_c::value_int(paramList.getInt(2));
+    string name   = xmlrpc_c::value_string(paramList.getString(3));
+    bool   on_hold = false; //Optional XML-RPC argument
+    string str_uattrs;      //Optional XML-RPC argument
+
+    int  rc;
+    int  vid;
+    int  allocated = 0;
+
+    long long max_vms;
+
+    Nebula& nd = Nebula::instance();
+
+    VirtualMachinePool* vmpool  = nd.get_vmpool();
+
+    VirtualMachineTemplate * tmpl;
+
+    ostringstream oss;
+    string        error_str;
+    string        last_error;
+
+    if ( paramList.size() > 4 )
+    {
+        on_hold = xmlrpc_c::value_boolean(paramList.getBoolean(4));
+
+        str_uattrs = xmlrpc_c::value_string(paramList.getString(5));
+    }
+
+    nd.get_configuration_attribute("MAX_INSTANTIATE_VMS", max_vms);
+
+    if ( number <= 0 || number > max_vms )
+    {
+        oss << "The number of VMs must be between 1 and " << max_vms
+            << " (MAX_INSTANTIATE_VMS)";
+
+        failure_response(ACTION, request_error(oss.str(),""), att);
+        return;
+    }
+
+    tmpl = instantiate_template(id, name, str_uattrs, att);
+
+    if ( tmpl == 0 )
+    {
+        return;
+    }
+
+    /* ---------------------------------------------------------------------- */
+    /* Reserve the quota of all the VMs at once                               */
+    /* ---------------------------------------------------------------------- */
+
+    if ( att.uid != 0 )
+    {
+        Template qtmpl;
+
+        if ( bulk_quota_template(tmpl, number, qtmpl, error_str) != 0 )
+        {
+            failure_response(ACTION, request_error(error_str,""), att);
+
+            delete tmpl;
+            return;
+        }
+
+        if ( quota_authorization(&qtmpl, Quotas::VIRTUALMACHINE, att) == false )
+        {
+            delete tmpl;
+            return;
+        }
+    }
+
+    /* ---------------------------------------------------------------------- */
+    /* Allocate the VMs, the quota of the failed ones is returned             */
+    /* ---------------------------------------------------------------------- */
+
+    oss << "<INSTANTIATE>";
+
+    for (int i = 0; i < number; i++)
+    {
+        VirtualMachineTemplate * vm_tmpl = new VirtualMachineTemplate(*tmpl);
+
+        if (!name.empty())
+        {
+            ostringstream idx;
+            string        vm_name = name;
+
+            idx << i;
+
+            for (string::size_type pos = vm_name.find("%i");
+                 pos != string::npos;
+                 pos = vm_name.find("%i", pos + idx.str().length()))
+            {
+                vm_name.replace(pos, 2, idx.str());
+            }
+
+            vm_tmpl->replace("NAME", vm_name);
+        }
+
+        rc = vmpool->allocate(att.uid, att.gid, att.uname, att.gname,
+                att.umask, vm_tmpl, &vid, error_str, on_hold);
+
+        if ( rc < 0 )
+        {
+            last_error = error_str;
+
+            oss << "<ERROR><INDEX>" << i << "</INDEX><MESSAGE><![CDATA["
+                << error_str << "]]></MESSAGE></ERROR>";
+
+            quota_rollback(tmpl, Quotas::VIRTUALMACHINE, att);
+
+            error_str.clear();
+            continue;
+        }
+
+        oss << "<ID>" << vid << "</ID>";
+
+        allocated++;
+    }
+
+    oss << "</INSTANTIATE>";
+
+    delete tmpl;
+
+    if ( allocated == 0 )
+    {
+        failure_response(INTERNAL,
+                allocate_error(PoolObjectSQL::VM, last_error),
+                att);
+        return;
+    }
+
+    success_response(oss.str(), att);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
@@ -0,0 +1,259 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+
+#include "RequestMetrics.h"
+
+#include <ctype.h>
+#include <string.h>
+#include <time.h>
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void LatencyHistogram::reset()
+{
+    memset(buckets, 0, sizeof(buckets));
+
+    count     = 0;
+    sum       = 0;
+    max_value = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+unsigned long long LatencyHistogram::bucket_max(int b)
+{
+    int msb;
+    int sub;
+
+    if ( b < SUB_BUCKETS )
+    {
+        return b;
+    }
+
+    msb = b / SUB_BUCKETS + SUB_BITS - 1;
+    sub = b % SUB_BUCKETS;
+
+    return ((static_cast<unsigned long long>(SUB_BUCKETS + sub + 1))
+                << (msb - SUB_BITS)) - 1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+unsigned long long LatencyHistogram::percentile(double p) const
+{
+    unsigned long long total = 0;
+    unsigned long long target;
+    unsigned long long acc = 0;
+
+    // Buckets may be updated while reading them, use their own total
+    for (int i = 0; i < NUM_BUCKETS; i++)
+    {
+        total += buckets[i];
+    }
+
+    if ( total == 0 )
+    {
+        return 0;
+    }
+
+    target = static_cast<unsigned long long>(p * total + 0.5);
+
+    if ( target == 0 )
+    {
+        target = 1;
+    }
+
+    for (int i = 0; i < NUM_BUCKETS; i++)
+    {
+        acc += buckets[i];
+
+        if ( acc >= target )
+        {
+            unsigned long long value = bucket_max(i);
+
+            return value < max_value ? value : max_value;
+        }
+    }
+
+    return max_value;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+map<string, RequestMetrics *> RequestMetrics::methods;
+
+pthread_mutex_t RequestMetrics::mutex = PTHREAD_MUTEX_INITIALIZER;
+
+const char * RequestMetrics::phase_names[] = {
+    "TOTAL", "AUTHENTICATION", "AUTHORIZATION", "DB", "RESPONSE"};
+
+/* -------------------------------------------------------------------------- */
+
+RequestMetrics * RequestMetrics::get(const string& method)
+{
+    RequestMetrics * metrics;
+
+    pthread_mutex_lock(&mutex);
+
+    map<string, RequestMetrics *>::iterator it = methods.find(method);
+
+    if ( it != methods.end() )
+    {
+        metrics = it->second;
+    }
+    else
+    {
+        metrics = new RequestMetrics();
+
+        methods.insert(make_pair(method, metrics));
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    return metrics;
+}
+
+/* -------------------------------------------------------------------------- */
+
+unsigned long long RequestMetrics::now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return static_cast<unsigned long long>(ts.tv_sec) * 1000000 +
+        ts.tv_nsec / 1000;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void RequestMetrics::to_xml(ostringstream& oss)
+{
+    map<string, RequestMetrics *>::iterator it;
+
+    oss << "<RPC_METHODS>";
+
+    pthread_mutex_lock(&mutex);
+
+    for (it = methods.begin(); it != methods.end(); it++)
+    {
+        const LatencyHistogram * phases = it->second->phases;
+
+        if ( phases[TOTAL].get_count() == 0 )
+        {
+            continue;
+        }
+
+        oss << "<METHOD><NAME>" << it->first << "</NAME>";
+
+        for (int i = 0; i < NUM_PHASES; i++)
+        {
+            const LatencyHistogram& h = phases[i];
+
+            if ( h.get_count() == 0 )
+            {
+                continue;
+            }
+
+            oss << "<PHASE>"
+                <<   "<NAME>"  << phase_names[i]      << "</NAME>"
+                <<   "<COUNT>" << h.get_count()       << "</COUNT>"
+                <<   "<SUM>"   << h.get_sum()         << "</SUM>"
+                <<   "<MAX>"   << h.get_max()         << "</MAX>"
+                <<   "<P50>"   << h.percentile(0.50)  << "</P50>"
+                <<   "<P90>"   << h.percentile(0.90)  << "</P90>"
+                <<   "<P99>"   << h.percentile(0.99)  << "</P99>"
+                << "</PHASE>";
+        }
+
+        oss << "</METHOD>";
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    oss << "</RPC_METHODS>";
+}
+
+/* -------------------------------------------------------------------------- */
+
+string& RequestMetrics::to_prometheus(string& text)
+{
+    static const double quantiles[] = { 0.5, 0.9, 0.99 };
+    static const char * qlabels[]   = { "0.5", "0.9", "0.99" };
+
+    static const char * metric = "opennebula_rpc_duration_seconds";
+
+    map<string, RequestMetrics *>::iterator it;
+
+    ostringstream oss;
+
+    oss.precision(6);
+    oss << fixed;
+
+    oss << "# HELP " << metric << " Duration of the XML-RPC calls by method "
+        << "and phase.\n"
+        << "# TYPE " << metric << " summary\n";
+
+    pthread_mutex_lock(&mutex);
+
+    for (it = methods.begin(); it != methods.end(); it++)
+    {
+        const LatencyHistogram * phases = it->second->phases;
+
+        for (int i = 0; i < NUM_PHASES; i++)
+        {
+            const LatencyHistogram& h = phases[i];
+
+            if ( h.get_count() == 0 )
+            {
+                continue;
+            }
+
+            string phase = phase_names[i];
+
+            for (string::size_type j = 0; j < phase.size(); j++)
+            {
+                phase[j] = tolower(phase[j]);
+            }
+
+            ostringstream labels;
+
+            labels << "method=\"" << it->first << "\",phase=\"" << phase << "\"";
+
+            for (int j = 0; j < 3; j++)
+            {
+                oss << metric << "{" << labels.str() << ",quantile=\""
+                    << qlabels[j] << "\"} "
+                    << h.percentile(quantiles[j]) / 1e6 << "\n";
+            }
+
+            oss << metric << "_sum{" << labels.str() << "} "
+                << h.get_sum() / 1e6 << "\n"
+                << metric << "_count{" << labels.str() << "} "
+                << h.get_count() << "\n";
+        }
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    text = oss.str();
+
+    return text;
+}
@@ -0,0 +1,1315 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+
+#include "RequestServer.h"
+#include "NebulaLog.h"
+#include "RequestMetrics.h"
+
+#include <sstream>
+#include <algorithm>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Maximum size of the HTTP request line and headers
+ */
+static const size_t MAX_HEADER_SIZE = 65536;
+
+/**
+ *  Events read in each epoll_wait call
+ */
+static const int MAX_EVENTS = 128;
+
+/**
+ *  Size of the buffer used to read from the connections
+ */
+static const size_t READ_BUFFER_SIZE = 65536;
+
+/**
+ *  Checks if the input buffered for a connection reached its limit: the
+ *  headers (MAX_HEADER_SIZE) and, once they are complete, a request body of
+ *  up to the XML-RPC size limit
+ *    @param in the input buffer
+ *    @return true if no more data should be read
+ */
+static bool input_limit(const string& in)
+{
+    if ( in.size() <= MAX_HEADER_SIZE )
+    {
+        return false;
+    }
+
+    string::size_type hend = in.find("\r\n\r\n");
+
+    if ( hend == string::npos || hend > MAX_HEADER_SIZE )
+    {
+        return true;
+    }
+
+    return in.size() > hend + 4 + xmlrpc_limit_get(XMLRPC_XML_SIZE_LIMIT_ID);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+extern "C" void * rs_event_loop(void *arg)
+{
+    RequestServer * rs;
+
+    if ( arg == 0 )
+    {
+        return 0;
+    }
+
+    rs = static_cast<RequestServer *>(arg);
+
+    rs->event_loop();
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+extern "C" void * rs_worker_loop(void *arg)
+{
+    RequestServer * rs;
+
+    if ( arg == 0 )
+    {
+        return 0;
+    }
+
+    rs = static_cast<RequestServer *>(arg);
+
+    rs->worker_loop();
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+RequestServer::RequestServer(
+        xmlrpc_c::registry * _registry,
+        int                  _socket_fd,
+        int                  _max_conn,
+        int                  _max_conn_backlog,
+        int                  _keepalive_timeout,
+        int                  _keepalive_max_conn,
+        int                  _timeout,
+        int                  _threads,
+        const int            concurrency[],
+        const int            queue_size[],
+        const string&        _log_file,
+        bool                 _prometheus):
+            registry(_registry),
+            socket_fd(_socket_fd),
+            max_conn(_max_conn),
+            max_conn_backlog(_max_conn_backlog),
+            keepalive_timeout(_keepalive_timeout),
+            keepalive_max_conn(_keepalive_max_conn),
+            timeout(_timeout),
+            threads(_threads),
+            log_file(_log_file),
+            prometheus(_prometheus),
+            forwarder(0),
+            epoll_fd(-1),
+            next_id(0),
+            accepting(true),
+            num_connections(0),
+            end(false)
+{
+    wake_fd[0] = -1;
+    wake_fd[1] = -1;
+
+    if ( threads < 1 )
+    {
+        threads = 1;
+    }
+
+    for (int i = 0; i < NUM_CLASSES; i++)
+    {
+        queues[i].concurrency    = concurrency[i];
+        queues[i].max_size       = queue_size[i];
+        queues[i].active         = 0;
+        queues[i].admitted       = 0;
+        queues[i].rejected       = 0;
+        queues[i].started        = 0;
+        queues[i].queue_time     = 0;
+        queues[i].max_queue_time = 0;
+
+        if ( queues[i].concurrency < 1 || queues[i].concurrency > threads )
+        {
+            queues[i].concurrency = threads;
+        }
+    }
+
+    pthread_mutex_init(&mutex, 0);
+
+    pthread_cond_init(&cond, 0);
+};
+
+/* -------------------------------------------------------------------------- */
+
+RequestServer::~RequestServer()
+{
+    map<int, Connection *>::iterator it;
+
+    for (it = connections.begin(); it != connections.end(); it++)
+    {
+        close(it->second->fd);
+        delete it->second;
+    }
+
+    for (int i = 0; i < NUM_CLASSES; i++)
+    {
+        for (unsigned int j = 0; j < queues[i].calls.size(); j++)
+        {
+            delete queues[i].calls[j];
+        }
+    }
+
+    for (unsigned int i = 0; i < done.size(); i++)
+    {
+        delete done[i];
+    }
+
+    if ( epoll_fd != -1 )
+    {
+        close(epoll_fd);
+    }
+
+    if ( wake_fd[0] != -1 )
+    {
+        close(wake_fd[0]);
+        close(wake_fd[1]);
+    }
+
+    delete forwarder;
+
+    pthread_mutex_destroy(&mutex);
+
+    pthread_cond_destroy(&cond);
+};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int RequestServer::start()
+{
+    struct epoll_event ev;
+    pthread_attr_t     pattr;
+    ostringstream      oss;
+
+    if ( listen(socket_fd, max_conn_backlog) == -1 )
+    {
+        oss << "Cannot listen in server socket: " << strerror(errno);
+        NebulaLog::log("ReM", Log::ERROR, oss);
+
+        return -1;
+    }
+
+    fcntl(socket_fd, F_SETFL, fcntl(socket_fd, F_GETFL) | O_NONBLOCK);
+
+    if ( pipe(wake_fd) == -1 )
+    {
+        oss << "Cannot create the RPC server pipe: " << strerror(errno);
+        NebulaLog::log("ReM", Log::ERROR, oss);
+
+        return -1;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        fcntl(wake_fd[i], F_SETFL, fcntl(wake_fd[i], F_GETFL) | O_NONBLOCK);
+        fcntl(wake_fd[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    epoll_fd = epoll_create(max_conn + 2);
+
+    if ( epoll_fd == -1 )
+    {
+        oss << "Cannot create the RPC server epoll: " << strerror(errno);
+        NebulaLog::log("ReM", Log::ERROR, oss);
+
+        return -1;
+    }
+
+    fcntl(epoll_fd, F_SETFD, FD_CLOEXEC);
+
+    memset(&ev, 0, sizeof(ev));
+
+    ev.events  = EPOLLIN;
+    ev.data.fd = socket_fd;
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_fd, &ev);
+
+    ev.data.fd = wake_fd[0];
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd[0], &ev);
+
+    if ( !log_file.empty() )
+    {
+        log.open(log_file.c_str(), ios_base::app);
+    }
+
+    if ( forwarder != 0 && forwarder->start(this) != 0 )
+    {
+        NebulaLog::log("ReM", Log::WARNING, "Calls to the master will be "
+            "forwarded by the RPC worker threads.");
+
+        delete forwarder;
+
+        forwarder = 0;
+    }
+
+    pthread_attr_init(&pattr);
+    pthread_attr_setdetachstate(&pattr, PTHREAD_CREATE_JOINABLE);
+
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_t worker;
+
+        pthread_create(&worker, &pattr, rs_worker_loop, (void *) this);
+
+        worker_threads.push_back(worker);
+    }
+
+    pthread_create(&loop_thread, &pattr, rs_event_loop, (void *) this);
+
+    oss << "XML-RPC server started, " << threads << " threads. Concurrency"
+        << " (queue size) read: " << queues[READ].concurrency << " ("
+        << queues[READ].max_size << "), write: " << queues[WRITE].concurrency
+        << " (" << queues[WRITE].max_size << ").";
+
+    NebulaLog::log("ReM", Log::INFO, oss);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestServer::stop()
+{
+    if ( forwarder != 0 )
+    {
+        forwarder->stop();
+    }
+
+    pthread_mutex_lock(&mutex);
+
+    end = true;
+
+    pthread_cond_broadcast(&cond);
+
+    pthread_mutex_unlock(&mutex);
+
+    if ( write(wake_fd[1], "s", 1) == -1 && errno != EAGAIN )
+    {
+        NebulaLog::log("ReM", Log::ERROR, "Cannot stop the RPC event loop");
+    }
+
+    pthread_join(loop_thread, 0);
+
+    for (unsigned int i = 0; i < worker_threads.size(); i++)
+    {
+        pthread_join(worker_threads[i], 0);
+    }
+
+    if ( log.is_open() )
+    {
+        log.close();
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+RequestServer::CallClass RequestServer::call_class(const string& method)
+{
+    static const char * read_methods[] = { "info", "monitoring", "accounting",
+        "showback", "version", "config", "metrics", 0 };
+
+    string::size_type pos = method.rfind('.');
+    string            name;
+
+    if ( pos == string::npos )
+    {
+        name = method;
+    }
+    else
+    {
+        name = method.substr(pos + 1);
+    }
+
+    for (int i = 0; read_methods[i] != 0; i++)
+    {
+        if ( name == read_methods[i] )
+        {
+            return READ;
+        }
+    }
+
+    return WRITE;
+}
+
+/* -------------------------------------------------------------------------- */
+
+string& RequestServer::to_xml(string& xml)
+{
+    static const char * names[] = { "READ", "WRITE" };
+
+    ostringstream oss;
+
+    pthread_mutex_lock(&mutex);
+
+    oss << "<RPC_SERVER>"
+        <<   "<THREADS>"     << threads         << "</THREADS>"
+        <<   "<CONNECTIONS>" << num_connections << "</CONNECTIONS>";
+
+    for (int i = 0; i < NUM_CLASSES; i++)
+    {
+        const CallQueue& q = queues[i];
+
+        unsigned long long avg = 0;
+
+        if ( q.started > 0 )
+        {
+            avg = q.queue_time / q.started;
+        }
+
+        oss << "<QUEUE>"
+            <<   "<NAME>"           << names[i]         << "</NAME>"
+            <<   "<CONCURRENCY>"    << q.concurrency    << "</CONCURRENCY>"
+            <<   "<MAX_SIZE>"       << q.max_size       << "</MAX_SIZE>"
+            <<   "<SIZE>"           << q.calls.size()   << "</SIZE>"
+            <<   "<ACTIVE>"         << q.active         << "</ACTIVE>"
+            <<   "<ADMITTED>"       << q.admitted       << "</ADMITTED>"
+            <<   "<REJECTED>"       << q.rejected       << "</REJECTED>"
+            <<   "<QUEUE_TIME_AVG>" << avg              << "</QUEUE_TIME_AVG>"
+            <<   "<QUEUE_TIME_MAX>" << q.max_queue_time << "</QUEUE_TIME_MAX>"
+            << "</QUEUE>";
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    if ( forwarder != 0 )
+    {
+        string fw_xml;
+
+        oss << forwarder->to_xml(fw_xml);
+    }
+
+    oss << "</RPC_SERVER>";
+
+    xml = oss.str();
+
+    return xml;
+}
+
+/* ************************************************************************** */
+/* Event loop                                                                 */
+/* ************************************************************************** */
+
+void RequestServer::event_loop()
+{
+    struct epoll_event events[MAX_EVENTS];
+
+    time_t last_check = time(0);
+
+    while (true)
+    {
+        int n = epoll_wait(epoll_fd, events, MAX_EVENTS, 1000);
+
+        if ( n == -1 && errno != EINTR )
+        {
+            ostringstream oss;
+
+            oss << "Error waiting for RPC connections: " << strerror(errno);
+            NebulaLog::log("ReM", Log::ERROR, oss);
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            int fd = events[i].data.fd;
+
+            if ( fd == socket_fd )
+            {
+                accept_connections();
+            }
+            else if ( fd == wake_fd[0] )
+            {
+                char buffer[256];
+                bool _end;
+
+                while ( read(wake_fd[0], buffer, sizeof(buffer)) > 0 );
+
+                pthread_mutex_lock(&mutex);
+
+                _end = end;
+
+                pthread_mutex_unlock(&mutex);
+
+                if ( _end )
+                {
+                    return;
+                }
+
+                send_completed();
+            }
+            else
+            {
+                map<int, Connection *>::iterator it = connections.find(fd);
+
+                if ( it == connections.end() )
+                {
+                    continue;
+                }
+
+                Connection * conn = it->second;
+                int          id   = conn->id;
+
+                if ( events[i].events & EPOLLOUT )
+                {
+                    write_connection(conn);
+
+                    if ( connection_ids.count(id) == 0 )
+                    {
+                        continue;
+                    }
+
+                    process_requests(conn); // Pipelined requests
+
+                    if ( connection_ids.count(id) == 0 )
+                    {
+                        continue;
+                    }
+                }
+
+                if ( events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR) )
+                {
+                    read_connection(conn);
+                }
+            }
+        }
+
+        time_t the_time = time(0);
+
+        if ( the_time != last_check )
+        {
+            check_timeouts();
+
+            last_check = the_time;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestServer::accept_connections()
+{
+    struct sockaddr_in addr;
+    socklen_t          addr_len;
+    int                fd;
+    int                yes = 1;
+
+    while ( static_cast<int>(connections.size()) < max_conn )
+    {
+        addr_len = sizeof(addr);
+
+        fd = accept(socket_fd, (struct sockaddr *) &addr, &addr_len);
+
+        if ( fd == -1 )
+        {
+            if ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+            {
+                ostringstream oss;
+
+                oss << "Error accepting RPC connection: " << strerror(errno);
+                NebulaLog::log("ReM", Log::ERROR, oss);
+            }
+
+            return;
+        }
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(int));
+
+        Connection * conn = new Connection;
+
+        conn->id            = next_id++;
+        conn->fd            = fd;
+        conn->peer          = inet_ntoa(addr.sin_addr);
+        conn->out_pos       = 0;
+        conn->busy          = false;
+        conn->close         = false;
+        conn->continue_sent = false;
+        conn->calls         = 0;
+        conn->last_activity = time(0);
+
+        connections.insert(make_pair(fd, conn));
+        connection_ids.insert(make_pair(conn->id, conn));
+
+        struct epoll_event ev;
+
+        memset(&ev, 0, sizeof(ev));
+
+        ev.events  = EPOLLIN;
+        ev.data.fd = fd;
+
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+
+        __sync_fetch_and_add(&num_connections, 1);
+    }
+
+    // Too many connections, stop accepting till one is closed
+
+    if ( accepting )
+    {
+        struct epoll_event ev;
+
+        memset(&ev, 0, sizeof(ev));
+
+        ev.events  = 0;
+        ev.data.fd = socket_fd;
+
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, socket_fd, &ev);
+
+        accepting = false;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestServer::close_connection(Connection * conn)
+{
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn->fd, 0);
+
+    close(conn->fd);
+
+    connections.erase(conn->fd);
+    connection_ids.erase(conn->id);
+
+    delete conn;
+
+    __sync_fetch_and_sub(&num_connections, 1);
+
+    if ( !accepting )
+    {
+        struct epoll_event ev;
+
+        memset(&ev, 0, sizeof(ev));
+
+        ev.events  = EPOLLIN;
+        ev.data.fd = socket_fd;
+
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, socket_fd, &ev);
+
+        accepting = true;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestServer::set_events(Connection * conn, unsigned int events)
+{
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+
+    ev.events  = events;
+    ev.data.fd = conn->fd;
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestServer::check_timeouts()
+{
+    time_t the_time = time(0);
+
+    vector<Connection *> expired;
+
+    map<int, Connection *>::iterator it;
+
+    for (it = connections.begin(); it != connections.end(); it++)
+    {
+        Connection * conn = it->second;
+        time_t       idle = the_time - conn->last_activity;
+
+        if ( conn->busy )
+        {
+            continue;
+        }
+
+        if ( conn->in.empty() && conn->header.empty() )
+        {
+            if ( idle > keepalive_timeout )
+            {
+                expired.push_back(conn);
+            }
+        }
+        else if ( idle > timeout )
+        {
+            expired.push_back(conn);
+        }
+    }
+
+    for (unsigned int i = 0; i < expired.size(); i++)
+    {
+        close_connection(expired[i]);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void RequestServer::read_connection(Connection * conn)
+{
+    char    buffer[READ_BUFFER_SIZE];
+    ssize_t rc;
+
+    if ( conn->busy ) // Only errors are reported for busy connections
+    {
+        close_connection(conn);
+        return;
+    }
+
+    while (true)
+    {
+        rc = recv(conn->fd, buffer, sizeof(buffer), 0);
+
+        if ( rc > 0 )
+        {
+            conn->in.append(buffer, rc);
+
+            if ( input_limit(conn->in) ) // parse_request replies 431/413
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        if ( rc == -1 && (errno == EAGAIN || errno == EWOULDBLOCK) )
+        {
+            break;
+        }
+
+        if ( rc == -1 && errno == EINTR )
+        {
+            continue;
+        }
+
+        close_connection(conn); // closed by the client or error
+        return;
+    }
+
+    conn->last_activity = time(0);
+
+    process_requests(conn);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestServer::process_requests(Connection * conn)
+{
+    int    id = conn->id;
+    size_t size;
+
+    // Requests pipelined after the last one of the connection are not parsed
+    do
+    {
+        size = conn->in.size();
+
+        parse_request(conn);
+
+        if ( connection_ids.count(id) == 0 ) // Closed after the response
+        {
+            return;
+        }
+    }
+    while ( !conn->busy && conn->header.empty() && !conn->close &&
+            conn->in.size() < size );
+}
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Gets the value of a HTTP header
+ *    @param headers of the request, each header ends with \r\n
+ *    @param name of the header in lower case
+ *    @return the value, empty if not found
+ */
+static string header_value(const string& headers, const string& name)
+{
+    string::size_type start = headers.find("\r\n");
+
+    while ( start != string::npos )
+    {
+        start += 2;
+
+        string::size_type end = headers.find("\r\n", start);
+        string::size_type col = headers.find(':', start);
+
+        if ( col != string::npos && (end == string::npos || col < end) )
+        {
+            string hname = headers.substr(start, col - start);
+
+            transform(hname.begin(), hname.end(), hname.begin(), ::tolower);
+
+            if ( hname == name )
+            {
+                string value = headers.substr(col + 1, end == string::npos ?
+                        string::npos : end - col - 1);
+
+                string::size_type b = value.find_first_not_of(" \t");
+                string::size_type e = value.find_last_not_of(" \t");
+
+                if ( b == string::npos )
+                {
+                    return "";
+                }
+
+                value = value.substr(b, e - b + 1);
+
+                transform(value.begin(), value.end(), value.begin(), ::tolower);
+
+                return value;
+            }
+        }
+
+        start = end;
+    }
+
+    return "";
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestServer::parse_request(Connection * conn)
+{
+    string::size_type hend;
+    string::size_type mstart;
+    string::size_type mend;
+
+    if ( conn->busy || !conn->header.empty() )
+    {
+        return;
+    }
+
+    hend = conn->in.find("\r\n\r\n");
+
+    if ( hend == string::npos )
+    {
+        if ( conn->in.size() > MAX_HEADER_SIZE )
+        {
+            conn->close = true;
+            send_response(conn, 431, "Request Header Fields Too Large", "");
+        }
+
+        return;
+    }
+
+    string headers = conn->in.substr(0, hend + 2);
+
+    string method;
+    string uri;
+    string version;
+
+    istringstream iss(headers.substr(0, headers.find("\r\n")));
+
+    iss >> method >> uri >> version;
+
+    conn->request_line = headers.substr(0, headers.find("\r\n"));
+
+    // -------------------------------------------------------------------------
+    // Keep-alive
+    // -------------------------------------------------------------------------
+    string connection = header_value(headers, "connection");
+
+    if ( version == "HTTP/1.1" )
+    {
+        conn->close = (connection == "close");
+    }
+    else
+    {
+        conn->close = (connection != "keep-alive");
+    }
+
+    // The last call of the connection is answered with "Connection: close"
+    if ( keepalive_max_conn > 0 && conn->calls + 1 >= keepalive_max_conn )
+    {
+        conn->close = true;
+    }
+
+    if ( method == "GET" && prometheus && uri == "/metrics" )
+    {
+        string text;
+
+        conn->in.erase(0, hend + 4);
+
+        send_response(conn, 200, "OK", RequestMetrics::to_prometheus(text),
+                "text/plain; version=0.0.4");
+        return;
+    }
+
+    if ( method != "POST" )
+    {
+        conn->close = true;
+        send_response(conn, 405, "Method Not Allowed", "");
+        return;
+    }
+
+    // -------------------------------------------------------------------------
+    // Body
+    // -------------------------------------------------------------------------
+    string length_s = header_value(headers, "content-length");
+
+    if ( length_s.empty() )
+    {
+        conn->close = true;
+        send_response(conn, 411, "Length Required", "");
+        return;
+    }
+
+    size_t length = strtoul(length_s.c_str(), 0, 10);
+
+    if ( length > xmlrpc_limit_get(XMLRPC_XML_SIZE_LIMIT_ID) )
+    {
+        conn->close = true;
+        send_response(conn, 413, "Request Entity Too Large", "");
+        return;
+    }
+
+    if ( conn->in.size() < hend + 4 + length )
+    {
+        if ( !conn->continue_sent &&
+             header_value(headers, "expect") == "100-continue" )
+        {
+            static const char * cont = "HTTP/1.1 100 Continue\r\n\r\n";
+
+            send(conn->fd, cont, strlen(cont), MSG_NOSIGNAL);
+
+            conn->continue_sent = true;
+        }
+
+        return;
+    }
+
+    Call * call = new Call;
+
+    call->conn_id = conn->id;
+    call->body    = conn->in.substr(hend + 4, length);
+
+    conn->in.erase(0, hend + 4 + length);
+
+    conn->continue_sent = false;
+
+    // -------------------------------------------------------------------------
+    // Admission in the call queue
+    // -------------------------------------------------------------------------
+    string method_name;
+
+    mstart = call->body.find("<methodName>");
+    mend   = call->body.find("</methodName>");
+
+    if ( mstart != string::npos && mend != string::npos && mstart < mend )
+    {
+        mstart += 12;
+
+        method_name = call->body.substr(mstart, mend - mstart);
+
+        string::size_type b = method_name.find_first_not_of(" \t\r\n");
+        string::size_type e = method_name.find_last_not_of(" \t\r\n");
+
+        if ( b != string::npos )
+        {
+            method_name = method_name.substr(b, e - b + 1);
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Calls proxied to the federation master
+    // -------------------------------------------------------------------------
+    if ( forwarder != 0 && forwarder->forwards(method_name) )
+    {
+        int rc = forwarder->forward(conn->id, method_name, call->body);
+
+        delete call;
+
+        if ( rc != 0 )
+        {
+            send_response(conn, 503, "Service Unavailable",
+                    "Too many requests, try again later.");
+            return;
+        }
+
+        conn->busy = true;
+
+        set_events(conn, 0);
+
+        return;
+    }
+
+    call->cclass = call_class(method_name);
+
+    gettimeofday(&call->queued, 0);
+
+    pthread_mutex_lock(&mutex);
+
+    CallQueue& queue = queues[call->cclass];
+
+    if ( static_cast<int>(queue.calls.size()) >= queue.max_size )
+    {
+        queue.rejected++;
+
+        pthread_mutex_unlock(&mutex);
+
+        delete call;
+
+        send_response(conn, 503, "Service Unavailable",
+                "Too many requests, try again later.");
+
+        return;
+    }
+
+    queue.calls.push_back(call);
+    queue.admitted++;
+
+    pthread_cond_signal(&cond);
+
+    pthread_mutex_unlock(&mutex);
+
+    conn->busy = true;
+
+    set_events(conn, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestServer::send_completed()
+{
+    vector<Call *> completed;
+
+    pthread_mutex_lock(&mutex);
+
+    completed.swap(done);
+
+    pthread_mutex_unlock(&mutex);
+
+    for (unsigned int i = 0; i < completed.size(); i++)
+    {
+        Call * call = completed[i];
+
+        map<int, Connection *>::iterator it = connection_ids.find(call->conn_id);
+
+        if ( it != connection_ids.end() )
+        {
+            Connection * conn = it->second;
+
+            conn->busy = false;
+
+            if ( call->response.empty() )
+            {
+                conn->close = true;
+                send_response(conn, 500, "Internal Server Error", "");
+            }
+            else
+            {
+                send_response(conn, 200, "OK", call->response);
+            }
+
+            if ( connection_ids.count(call->conn_id) != 0 )
+            {
+                process_requests(conn); // Pipelined requests
+            }
+        }
+
+        delete call;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestServer::forward_done(int conn_id, const string& response)
+{
+    Call * call = new Call;
+
+    call->conn_id  = conn_id;
+    call->response = response;
+
+    pthread_mutex_lock(&mutex);
+
+    done.push_back(call);
+
+    pthread_mutex_unlock(&mutex);
+
+    if ( write(wake_fd[1], "c", 1) == -1 && errno != EAGAIN )
+    {
+        NebulaLog::log("ReM", Log::ERROR, "Cannot wake the RPC event loop");
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestServer::send_response(Connection * conn, int code,
+        const string& reason, const string& body, const char * content_type)
+{
+    ostringstream oss;
+
+    oss << "HTTP/1.1 " << code << " " << reason << "\r\n"
+        << "Server: OpenNebula\r\n"
+        << "Content-Type: " << content_type << "\r\n"
+        << "Content-Length: " << body.size() << "\r\n";
+
+    if ( code == 503 )
+    {
+        oss << "Retry-After: 1\r\n";
+    }
+
+    if ( conn->close )
+    {
+        oss << "Connection: close\r\n\r\n";
+    }
+    else
+    {
+        oss << "Connection: keep-alive\r\n\r\n";
+    }
+
+    if ( log.is_open() )
+    {
+        char      date[64];
+        struct tm tm_time;
+        time_t    the_time = time(0);
+
+        localtime_r(&the_time, &tm_time);
+
+        strftime(date, sizeof(date), "%d/%b/%Y:%H:%M:%S %z", &tm_time);
+
+        log << conn->peer << " - - [" << date << "] \"" << conn->request_line
+            << "\" " << code << " " << body.size() << endl;
+    }
+
+    conn->header  = oss.str();
+    conn->body    = body;
+    conn->out_pos = 0;
+
+    write_connection(conn);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestServer::write_connection(Connection * conn)
+{
+    size_t total = conn->header.size() + conn->body.size();
+
+    while ( conn->out_pos < total )
+    {
+        struct iovec  iov[2];
+        struct msghdr msg;
+        int           iovcnt = 0;
+
+        size_t hsize = conn->header.size();
+
+        if ( conn->out_pos < hsize )
+        {
+            iov[iovcnt].iov_base = const_cast<char *>(conn->header.data()) +
+                conn->out_pos;
+            iov[iovcnt].iov_len  = hsize - conn->out_pos;
+            iovcnt++;
+
+            iov[iovcnt].iov_base = const_cast<char *>(conn->body.data());
+            iov[iovcnt].iov_len  = conn->body.size();
+            iovcnt++;
+        }
+        else
+        {
+            iov[iovcnt].iov_base = const_cast<char *>(conn->body.data()) +
+                (conn->out_pos - hsize);
+            iov[iovcnt].iov_len  = total - conn->out_pos;
+            iovcnt++;
+        }
+
+        memset(&msg, 0, sizeof(msg));
+
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = iovcnt;
+
+        ssize_t rc = sendmsg(conn->fd, &msg, MSG_NOSIGNAL);
+
+        if ( rc >= 0 )
+        {
+            conn->out_pos += rc;
+            continue;
+        }
+
+        if ( errno == EINTR )
+        {
+            continue;
+        }
+
+        if ( errno == EAGAIN || errno == EWOULDBLOCK )
+        {
+            set_events(conn, EPOLLOUT);
+            return;
+        }
+
+        close_connection(conn);
+        return;
+    }
+
+    // Response sent
+
+    conn->header.clear();
+    conn->body.clear();
+
+    conn->out_pos       = 0;
+    conn->last_activity = time(0);
+
+    conn->calls++;
+
+    if ( conn->close ||
+         (keepalive_max_conn > 0 && conn->calls >= keepalive_max_conn) )
+    {
+        close_connection(conn);
+        return;
+    }
+
+    set_events(conn, EPOLLIN);
+}
+
+/* ************************************************************************** */
+/* Workers                                                                    */
+/* ************************************************************************** */
+
+RequestServer::Call * RequestServer::next_call()
+{
+    static const CallClass order[] = { WRITE, READ };
+
+    for (int i = 0; i < NUM_CLASSES; i++)
+    {
+        CallQueue& queue = queues[order[i]];
+
+        if ( queue.calls.empty() || queue.active >= queue.concurrency )
+        {
+            continue;
+        }
+
+        Call * call = queue.calls.front();
+
+        queue.calls.pop_front();
+
+        queue.active++;
+        queue.started++;
+
+        struct timeval now;
+
+        gettimeofday(&now, 0);
+
+        unsigned long long qtime = (now.tv_sec - call->queued.tv_sec) * 1000000LL
+            + (now.tv_usec - call->queued.tv_usec);
+
+        queue.queue_time += qtime;
+
+        if ( qtime > queue.max_queue_time )
+        {
+            queue.max_queue_time = qtime;
+        }
+
+        return call;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestServer::worker_loop()
+{
+    Call * call;
+
+    while (true)
+    {
+        call = 0;
+
+        pthread_mutex_lock(&mutex);
+
+        while ( !end && (call = next_call()) == 0 )
+        {
+            pthread_cond_wait(&cond, &mutex);
+        }
+
+        if ( end )
+        {
+            pthread_mutex_unlock(&mutex);
+            return;
+        }
+
+        pthread_mutex_unlock(&mutex);
+
+        try
+        {
+            registry->processCall(call->body, &call->response);
+        }
+        catch (exception& e)
+        {
+            ostringstream oss;
+
+            oss << "Error processing XML-RPC call: " << e.what();
+            NebulaLog::log("ReM", Log::ERROR, oss);
+
+            call->response.clear();
+        }
+
+        call->body.clear();
+
+        pthread_mutex_lock(&mutex);
+
+        queues[call->cclass].active--;
+
+        done.push_back(call);
+
+        // A call of a class that was limited by concurrency may run now
+        pthread_cond_broadcast(&cond);
+
+        pthread_mutex_unlock(&mutex);
+
+        if ( write(wake_fd[1], "c", 1) == -1 && errno != EAGAIN )
+        {
+            NebulaLog::log("ReM", Log::ERROR, "Cannot wake the RPC event loop");
+        }
+    }
+}
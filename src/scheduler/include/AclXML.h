@@ -39,6 +39,14 @@ public:
      */
     int set_up();
 
+protected:
+    /**
+     *  Gets the ACL rule set from oned (one.acl.info)
+     *    @param result of the xml-rpc call
+     *    @return 0 on success.
+     */
+    virtual int load_info(xmlrpc_c::value &result);
+
 private:
     /* ---------------------------------------------------------------------- */
     /* Re-implement DB public functions not used in scheduler                */
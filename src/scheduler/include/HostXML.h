@@ -58,6 +58,32 @@ public:
                 ((max_mem  - mem_usage ) >= mem));
     };
 
+    /**
+     *  Computes the fraction of the host capacity (average of cpu and memory)
+     *  that would be left free after adding a VM. Used to pack VMs in the
+     *  host that best fits them.
+     *    @param cpu needed by the VM (percentage)
+     *    @param mem needed by the VM (in KB)
+     *    @return the free fraction, between 0 and 1 if the VM fits
+     */
+    float free_fraction(long long cpu, long long mem) const
+    {
+        float fcpu = 0;
+        float fmem = 0;
+
+        if ( max_cpu > 0 )
+        {
+            fcpu = static_cast<float>(max_cpu - cpu_usage - cpu) / max_cpu;
+        }
+
+        if ( max_mem > 0 )
+        {
+            fmem = static_cast<float>(max_mem - mem_usage - mem) / max_mem;
+        }
+
+        return (fcpu + fmem) / 2;
+    };
+
     /**
      *  Adds a new VM to the given share by incrementing the cpu,mem and disk
      *  counters
@@ -32,6 +32,10 @@ using namespace std;
 /* -------------------------------------------------------------------------- */
 
 extern "C" void * scheduler_action_loop(void *arg);
+
+extern "C" void * scheduler_match_loop(void *arg);
+
+extern "C" void * scheduler_dispatch_loop(void *arg);
 class  SchedulerTemplate;
 /**
  *  The Scheduler class. It represents the scheduler ...
@@ -60,6 +64,12 @@ protected:
         machines_limit(0),
         dispatch_limit(0),
         host_dispatch_limit(0),
+        match_threads(1),
+        dispatch_threads(1),
+        dispatch_policy(GREEDY),
+        debug_log(false),
+        match_next(0),
+        dispatch_next(0),
         client(0)
     {
         am.addListener(this);
@@ -133,6 +143,13 @@ protected:
 
     virtual int do_scheduled_actions();
 
+    /**
+     *  Sets the scheduling limits and policies (MAX_VM, MAX_DISPATCH,
+     *  MAX_HOST, MATCH_THREADS, DISPATCH_THREADS and DISPATCH_POLICY)
+     *    @param conf the scheduler configuration
+     */
+    void set_limits(const SchedulerTemplate& conf);
+
 private:
     Scheduler(Scheduler const&){};
 
@@ -140,6 +157,10 @@ private:
 
     friend void * scheduler_action_loop(void *arg);
 
+    friend void * scheduler_match_loop(void *arg);
+
+    friend void * scheduler_dispatch_loop(void *arg);
+
     // ---------------------------------------------------------------
     // Scheduling Policies
     // ---------------------------------------------------------------
@@ -170,6 +191,163 @@ private:
      */
     unsigned int host_dispatch_limit;
 
+    /**
+     *  Number of threads used to match the pending VMs.
+     */
+    unsigned int match_threads;
+
+    /**
+     *  Max. number of deploy/migrate calls in flight in the dispatch phase.
+     */
+    unsigned int dispatch_threads;
+
+    /**
+     *  Policies to place the matched VMs in the dispatch phase
+     */
+    enum DispatchPolicy
+    {
+        GREEDY = 0, /**< VMs (by ID) are deployed in its top ranked host */
+        BATCH  = 1  /**< Best-fit decreasing placement of the pending VMs */
+    };
+
+    DispatchPolicy dispatch_policy;
+
+    /**
+     *  True if DEBUG messages are logged, used to skip the match phase
+     *  filter messages otherwise.
+     */
+    bool debug_log;
+
+    // ---------------------------------------------------------------
+    // Match phase state
+    // ---------------------------------------------------------------
+
+    /**
+     *  Result of the match phase for a VM. VMs are matched concurrently, so
+     *  log messages are buffered and written (together with the VM update)
+     *  in the pending VM order once every VM has been matched.
+     */
+    struct VMMatch
+    {
+        VMMatch(VirtualMachineXML * _vm, bool _debug):
+            vm(_vm), update(false), debug(_debug){};
+
+        void log(Log::MessageType type, const ostringstream& oss)
+        {
+            if ( type < Log::DEBUG || debug )
+            {
+                messages.push_back(make_pair(type, oss.str()));
+            }
+        };
+
+        VirtualMachineXML * vm;
+
+        /**
+         *  The VM needs to be updated in oned (i.e. SCHED_MESSAGE was set)
+         */
+        bool update;
+
+        bool debug;
+
+        vector<pair<Log::MessageType, string> > messages;
+    };
+
+    /**
+     *  VMs being matched in the current scheduling cycle
+     */
+    vector<VMMatch> matches;
+
+    /**
+     *  Next VM in matches to be processed by a match thread
+     */
+    unsigned int match_next;
+
+    /**
+     *  Matches pending VMs till the matches vector is exhausted, executed
+     *  by each match thread
+     */
+    void match_loop();
+
+    /**
+     *  Gets the hosts and system datastores that match the requirements of
+     *  a VM and ranks them. Only the VM and the match object are modified,
+     *  pools are only read so it can be executed concurrently for different
+     *  VMs.
+     *    @param match for the VM
+     */
+    void match_vm(VMMatch& match);
+
+    // ---------------------------------------------------------------
+    // Dispatch phase state
+    // ---------------------------------------------------------------
+
+    /**
+     *  A deploy or migrate call of the dispatch phase. When more than one
+     *  dispatch thread is configured, the placement of the VMs is decided
+     *  first and the calls are then made concurrently.
+     */
+    struct VMDispatch
+    {
+        VMDispatch(int _vid, int _hid, int _dsid, bool _resched):
+            vid(_vid), hid(_hid), dsid(_dsid), resched(_resched){};
+
+        int  vid;
+        int  hid;
+        int  dsid;
+        bool resched;
+    };
+
+    /**
+     *  Calls to be made in the current scheduling cycle
+     */
+    vector<VMDispatch> dispatches;
+
+    /**
+     *  Next call in dispatches to be made by a dispatch thread
+     */
+    unsigned int dispatch_next;
+
+    /**
+     *  Makes the dispatch calls till the dispatches vector is exhausted,
+     *  executed by each dispatch thread
+     */
+    void dispatch_loop();
+
+    /**
+     *  Makes the dispatch calls of the current cycle, with up to
+     *  dispatch_threads calls in flight
+     */
+    void dispatch_calls();
+
+    // ---------------------------------------------------------------
+    // Batch placement
+    // ---------------------------------------------------------------
+
+    /**
+     *  Orders the VMs by decreasing size (memory, cpu and system disk)
+     */
+    static bool vm_size_cmp(VirtualMachineXML * a, VirtualMachineXML * b);
+
+    /**
+     *  Orders the matched hosts of a VM by the capacity left free after
+     *  deploying it (best fit first). Hosts without enough capacity are
+     *  placed last.
+     */
+    class BestFitCmp
+    {
+    public:
+        BestFitCmp(HostPoolXML * _hpool, int _cpu, int _mem):
+            hpool(_hpool), cpu(_cpu), mem(_mem){};
+
+        bool operator()(const Resource * a, const Resource * b);
+
+    private:
+        HostPoolXML * hpool;
+
+        int cpu;
+        int mem;
+    };
+
     /**
      *  OpenNebula zone id.
      */
@@ -44,6 +44,8 @@ public:
     const void schedule(ObjectXML * obj)
     {
         vector<float> priority;
+        ScaleWeight   scale(sw);
+
         const vector<Resource *> resources = get_match_resources(obj);
 
         if (resources.empty())
@@ -54,10 +56,10 @@ public:
         //1. Compute priorities
         policy(obj, priority);
 
-        //2. Scale priorities
-        sw.max =fabs(*max_element(priority.begin(), priority.end(), abs_cmp));
+        //2. Scale priorities (local copy, policies are shared by threads)
+        scale.max=fabs(*max_element(priority.begin(), priority.end(), abs_cmp));
 
-        transform(priority.begin(), priority.end(), priority.begin(), sw);
+        transform(priority.begin(), priority.end(), priority.begin(), scale);
 
         //3. Aggregate to other policies
         for (unsigned int i=0; i< resources.size(); i++)
@@ -60,7 +60,7 @@ public:
      *    @param hid the id of the target host
      *    @param resched the machine is going to be rescheduled
      */
-    int dispatch(int vid, int hid, int dsid, bool resched) const;
+    virtual int dispatch(int vid, int hid, int dsid, bool resched) const;
 
     /**
      *  Update the VM template
@@ -69,7 +69,7 @@ public:
      *
      *    @return 0 on success, -1 otherwise
      */
-    int update(int vid, const string &st) const;
+    virtual int update(int vid, const string &st) const;
 
     /**
      *  Update the VM template
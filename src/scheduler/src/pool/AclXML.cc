@@ -21,10 +21,8 @@
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int AclXML::set_up()
-{    
-    xmlrpc_c::value result;
-
+int AclXML::load_info(xmlrpc_c::value &result)
+{
     try
     {
         client->call(client->get_endpoint(),        // serverUrl
@@ -32,7 +30,33 @@ int AclXML::set_up()
                      "s",                           // arguments format
                      &result,                       // resultP
                      client->get_oneauth().c_str());// argument
-        
+        return 0;
+    }
+    catch (exception const& e)
+    {
+        ostringstream   oss;
+        oss << "Exception raised: " << e.what();
+
+        NebulaLog::log("ACL", Log::ERROR, oss);
+
+        return -1;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int AclXML::set_up()
+{    
+    xmlrpc_c::value result;
+
+    if ( load_info(result) != 0 )
+    {
+        return -1;
+    }
+
+    try
+    {
         vector<xmlrpc_c::value> values =
                         xmlrpc_c::value_array(result).vectorValueValue();
 
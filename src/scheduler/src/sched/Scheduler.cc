@@ -62,6 +62,44 @@ extern "C" void * scheduler_action_loop(void *arg)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+extern "C" void * scheduler_match_loop(void *arg)
+{
+    Scheduler *  sched;
+
+    if ( arg == 0 )
+    {
+        return 0;
+    }
+
+    sched = static_cast<Scheduler *>(arg);
+
+    sched->match_loop();
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+extern "C" void * scheduler_dispatch_loop(void *arg)
+{
+    Scheduler *  sched;
+
+    if ( arg == 0 )
+    {
+        return 0;
+    }
+
+    sched = static_cast<Scheduler *>(arg);
+
+    sched->dispatch_loop();
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void Scheduler::start()
 {
     int rc;
@@ -114,14 +152,10 @@ void Scheduler::start()
 
     conf.get("SCHED_INTERVAL", timer);
 
-    conf.get("MAX_VM", machines_limit);
-
-    conf.get("MAX_DISPATCH", dispatch_limit);
-
-    conf.get("MAX_HOST", host_dispatch_limit);
-
     conf.get("LIVE_RESCHEDS", live_rescheds);
 
+    set_limits(conf);
+
     // -----------------------------------------------------------
     // Log system & Configuration File
     // -----------------------------------------------------------
@@ -197,12 +231,13 @@ void Scheduler::start()
 
         conf.get("MESSAGE_SIZE", message_size);
 
-        client = new Client("", url, message_size);
+        client = new Client("", url, message_size, dispatch_threads);
 
         oss.str("");
 
         oss << "XML-RPC client using " << client->get_message_size()
-            << " bytes for response buffer.\n";
+            << " bytes for response buffer and up to "
+            << client->get_max_connections() << " connections.\n";
 
         NebulaLog::log("SCHED", Log::INFO, oss);
     }
@@ -371,6 +406,47 @@ void Scheduler::start()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void Scheduler::set_limits(const SchedulerTemplate& conf)
+{
+    int dispatch;
+
+    conf.get("MAX_VM", machines_limit);
+
+    conf.get("MAX_DISPATCH", dispatch_limit);
+
+    conf.get("MAX_HOST", host_dispatch_limit);
+
+    conf.get("MATCH_THREADS", match_threads);
+
+    conf.get("DISPATCH_THREADS", dispatch_threads);
+
+    conf.get("DISPATCH_POLICY", dispatch);
+
+    if ( dispatch == BATCH )
+    {
+        dispatch_policy = BATCH;
+    }
+    else
+    {
+        dispatch_policy = GREEDY;
+    }
+
+    if ( match_threads == 0 )
+    {
+        long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        match_threads = ncpus > 0 ? ncpus : 1;
+    }
+
+    if ( dispatch_threads == 0 )
+    {
+        dispatch_threads = 1;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int Scheduler::set_up_pools()
 {
     int                             rc;
@@ -456,7 +532,116 @@ int Scheduler::set_up_pools()
 
 void Scheduler::match_schedule()
 {
-    VirtualMachineXML * vm;
+    const map<int, ObjectXML*>& pending_vms = vmpool->get_objects();
+
+    map<int, ObjectXML*>::const_iterator vm_it;
+    vector<VMMatch>::iterator            m_it;
+
+    unsigned int num_threads = match_threads;
+
+    vector<pthread_t> threads;
+    pthread_attr_t    pattr;
+
+    debug_log = (NebulaLog::log_level() >= Log::DEBUG);
+
+    //--------------------------------------------------------------------------
+    // Set up the per-VM match state
+    //--------------------------------------------------------------------------
+
+    matches.clear();
+
+    for (vm_it=pending_vms.begin(); vm_it != pending_vms.end(); vm_it++)
+    {
+        matches.push_back(VMMatch(
+                static_cast<VirtualMachineXML*>(vm_it->second), debug_log));
+    }
+
+    match_next = 0;
+
+    //--------------------------------------------------------------------------
+    // Match the VMs, using the calling thread if only one is configured
+    //--------------------------------------------------------------------------
+
+    if (num_threads > matches.size())
+    {
+        num_threads = matches.size();
+    }
+
+    if (num_threads <= 1)
+    {
+        match_loop();
+    }
+    else
+    {
+        pthread_attr_init(&pattr);
+        pthread_attr_setdetachstate(&pattr, PTHREAD_CREATE_JOINABLE);
+
+        for (unsigned int i = 1; i < num_threads; i++)
+        {
+            pthread_t id;
+
+            if (pthread_create(&id, &pattr, scheduler_match_loop,
+                    (void *) this) != 0)
+            {
+                NebulaLog::log("SCHED", Log::ERROR,
+                        "Could not create match thread");
+                break;
+            }
+
+            threads.push_back(id);
+        }
+
+        pthread_attr_destroy(&pattr);
+
+        match_loop(); //Also match VMs in this thread
+
+        for (unsigned int i = 0; i < threads.size(); i++)
+        {
+            pthread_join(threads[i], 0);
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    // Write the match logs and update the VMs, in the VM order
+    //--------------------------------------------------------------------------
+
+    for (m_it = matches.begin(); m_it != matches.end(); m_it++)
+    {
+        vector<pair<Log::MessageType, string> >::iterator l_it;
+
+        for (l_it=m_it->messages.begin(); l_it!=m_it->messages.end(); l_it++)
+        {
+            NebulaLog::log("SCHED", l_it->first, l_it->second);
+        }
+
+        if (m_it->update)
+        {
+            vmpool->update(m_it->vm);
+        }
+    }
+
+    matches.clear();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Scheduler::match_loop()
+{
+    unsigned int i;
+
+    while ((i = __sync_fetch_and_add(&match_next, 1)) < matches.size())
+    {
+        match_vm(matches[i]);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Scheduler::match_vm(VMMatch& match)
+{
+    VirtualMachineXML * vm = match.vm;
 
     int vm_memory;
     int vm_cpu;
@@ -481,413 +666,454 @@ void Scheduler::match_schedule()
 
     int       rc;
 
-    map<int, ObjectXML*>::const_iterator  vm_it;
     map<int, ObjectXML*>::const_iterator  h_it;
 
     vector<SchedulerPolicy *>::iterator it;
 
-    const map<int, ObjectXML*> pending_vms      = vmpool->get_objects();
-    const map<int, ObjectXML*> hosts            = hpool->get_objects();
-    const map<int, ObjectXML*> datastores       = dspool->get_objects();
+    const map<int, ObjectXML*>& hosts      = hpool->get_objects();
+    const map<int, ObjectXML*>& datastores = dspool->get_objects();
 
-    for (vm_it=pending_vms.begin(); vm_it != pending_vms.end(); vm_it++)
-    {
-        vm = static_cast<VirtualMachineXML*>(vm_it->second);
-
-        reqs = vm->get_requirements();
+    reqs = vm->get_requirements();
 
-        oid = vm->get_oid();
-        uid = vm->get_uid();
-        gid = vm->get_gid();
+    oid = vm->get_oid();
+    uid = vm->get_uid();
+    gid = vm->get_gid();
 
-        vm->get_requirements(vm_cpu,vm_memory,vm_disk);
+    vm->get_requirements(vm_cpu,vm_memory,vm_disk);
 
-        n_resources   = 0;
-        n_matched = 0;
-        n_auth    = 0;
-        n_error   = 0;
+    n_resources   = 0;
+    n_matched = 0;
+    n_auth    = 0;
+    n_error   = 0;
 
-        //--------------------------------------------------------------
-        // Test Image Datastore capacity, but not for migrations
-        //--------------------------------------------------------------
-        if (!vm->is_resched())
+    //--------------------------------------------------------------
+    // Test Image Datastore capacity, but not for migrations
+    //--------------------------------------------------------------
+    if (!vm->is_resched())
+    {
+        if (vm->test_image_datastore_capacity(img_dspool) == false)
         {
-            if (vm->test_image_datastore_capacity(img_dspool) == false)
+            if (vm->is_public_cloud())
             {
-                if (vm->is_public_cloud())
-                {
-                    // Image DS do not have capacity, but if the VM ends
-                    // in a public cloud host, image copies will not
-                    // be performed.
-                    vm->set_only_public_cloud();
-                }
-                else
-                {
-                    continue;
-                }
+                // Image DS do not have capacity, but if the VM ends
+                // in a public cloud host, image copies will not
+                // be performed.
+                vm->set_only_public_cloud();
+            }
+            else
+            {
+                return;
             }
         }
+    }
 
-        // ---------------------------------------------------------------------
-        // Match hosts for this VM that:
-        //  1. Fulfills ACL
-        //  2. Meets user/policy requirements
-        //  3. Have enough capacity to host the VM
-        // ---------------------------------------------------------------------
+    // ---------------------------------------------------------------------
+    // Match hosts for this VM that:
+    //  1. Fulfills ACL
+    //  2. Meets user/policy requirements
+    //  3. Have enough capacity to host the VM
+    // ---------------------------------------------------------------------
 
-        for (h_it=hosts.begin(), matched=false; h_it != hosts.end(); h_it++)
+    for (h_it=hosts.begin(), matched=false; h_it != hosts.end(); h_it++)
+    {
+        host = static_cast<HostXML *>(h_it->second);
+
+        // -----------------------------------------------------------------
+        // Check if user is authorized
+        // -----------------------------------------------------------------
+
+        matched = false;
+
+        if ( uid == 0 || gid == 0 )
         {
-            host = static_cast<HostXML *>(h_it->second);
+            matched = true;
+        }
+        else
+        {
+            PoolObjectAuth host_perms;
 
-            // -----------------------------------------------------------------
-            // Check if user is authorized
-            // -----------------------------------------------------------------
+            host_perms.oid      = host->get_hid();
+            host_perms.cid      = host->get_cid();
+            host_perms.obj_type = PoolObjectSQL::HOST;
 
-            matched = false;
+            // Even if the owner is in several groups, this request only
+            // uses the VM group ID
 
-            if ( uid == 0 || gid == 0 )
-            {
-                matched = true;
-            }
-            else
-            {
-                PoolObjectAuth host_perms;
+            set<int> gids;
+            gids.insert(gid);
 
-                host_perms.oid      = host->get_hid();
-                host_perms.cid      = host->get_cid();
-                host_perms.obj_type = PoolObjectSQL::HOST;
+            matched = acls->authorize(uid,
+                                      gids,
+                                      host_perms,
+                                      AuthRequest::MANAGE);
+        }
 
-                // Even if the owner is in several groups, this request only
-                // uses the VM group ID
+        if ( matched == false )
+        {
+            ostringstream oss;
 
-                set<int> gids;
-                gids.insert(gid);
+            oss << "VM " << oid << ": Host " << host->get_hid()
+                << " filtered out. User is not authorized to "
+                << AuthRequest::operation_to_str(AuthRequest::MANAGE)
+                << " it.";
 
-                matched = acls->authorize(uid,
-                                          gids,
-                                          host_perms,
-                                          AuthRequest::MANAGE);
-            }
+            match.log(Log::DEBUG, oss);
+            continue;
+        }
 
-            if ( matched == false )
-            {
-                ostringstream oss;
+        n_auth++;
 
-                oss << "VM " << oid << ": Host " << host->get_hid()
-                    << " filtered out. User is not authorized to "
-                    << AuthRequest::operation_to_str(AuthRequest::MANAGE)
-                    << " it.";
+        // -----------------------------------------------------------------
+        // Check that VM can be deployed in local hosts
+        // -----------------------------------------------------------------
+        if (vm->is_only_public_cloud() && !host->is_public_cloud())
+        {
+            ostringstream oss;
 
-                NebulaLog::log("SCHED",Log::DEBUG,oss);
-                continue;
-            }
+            oss << "VM " << oid << ": Host " << host->get_hid()
+                << " filtered out. VM can only be deployed in a Public Cloud Host, but this one is local.";
 
-            n_auth++;
+            match.log(Log::DEBUG, oss);
+            continue;
+        }
 
-            // -----------------------------------------------------------------
-            // Check that VM can be deployed in local hosts
-            // -----------------------------------------------------------------
-            if (vm->is_only_public_cloud() && !host->is_public_cloud())
-            {
-                ostringstream oss;
+        // -----------------------------------------------------------------
+        // Filter current Hosts for resched VMs
+        // -----------------------------------------------------------------
+        if (vm->is_resched() && vm->get_hid() == host->get_hid())
+        {
+            ostringstream oss;
 
-                oss << "VM " << oid << ": Host " << host->get_hid()
-                    << " filtered out. VM can only be deployed in a Public Cloud Host, but this one is local.";
+            oss << "VM " << oid << ": Host " << host->get_hid()
+                << " filtered out. VM cannot be migrated to its current Host.";
 
-                NebulaLog::log("SCHED",Log::DEBUG,oss);
-                continue;
-            }
+            match.log(Log::DEBUG, oss);
+            continue;
+        }
 
-            // -----------------------------------------------------------------
-            // Filter current Hosts for resched VMs
-            // -----------------------------------------------------------------
-            if (vm->is_resched() && vm->get_hid() == host->get_hid())
+        // -----------------------------------------------------------------
+        // Evaluate VM requirements
+        // -----------------------------------------------------------------
+
+        if (!reqs.empty())
+        {
+            rc = host->eval_bool(reqs,matched,&error);
+
+            if ( rc != 0 )
             {
                 ostringstream oss;
+                ostringstream error_msg;
 
-                oss << "VM " << oid << ": Host " << host->get_hid()
-                    << " filtered out. VM cannot be migrated to its current Host.";
+                matched = false;
+                n_error++;
 
-                NebulaLog::log("SCHED",Log::DEBUG,oss);
-                continue;
-            }
+                error_msg << "Error in SCHED_REQUIREMENTS: '" << reqs
+                          << "', error: " << error;
 
-            // -----------------------------------------------------------------
-            // Evaluate VM requirements
-            // -----------------------------------------------------------------
+                oss << "VM " << oid << ": " << error_msg.str();
 
-            if (!reqs.empty())
-            {
-                rc = host->eval_bool(reqs,matched,&error);
+                match.log(Log::ERROR, oss);
 
-                if ( rc != 0 )
-                {
-                    ostringstream oss;
-                    ostringstream error_msg;
+                vm->log(error_msg.str());
 
-                    matched = false;
-                    n_error++;
+                free(error);
 
-                    error_msg << "Error in SCHED_REQUIREMENTS: '" << reqs
-                              << "', error: " << error;
+                break;
+            }
+        }
+        else
+        {
+            matched = true;
+        }
 
-                    oss << "VM " << oid << ": " << error_msg.str();
+        if ( matched == false )
+        {
+            ostringstream oss;
 
-                    NebulaLog::log("SCHED",Log::ERROR,oss);
+            oss << "VM " << oid << ": Host " << host->get_hid() <<
+                " filtered out. It does not fulfill SCHED_REQUIREMENTS.";
 
-                    vm->log(error_msg.str());
+            match.log(Log::DEBUG, oss);
+            continue;
+        }
 
-                    free(error);
+        n_matched++;
 
-                    break;
-                }
-            }
-            else
-            {
-                matched = true;
-            }
+        // -----------------------------------------------------------------
+        // Check host capacity
+        // -----------------------------------------------------------------
+        if (host->test_capacity(vm_cpu,vm_memory) == true)
+        {
+            vm->add_match_host(host->get_hid());
 
-            if ( matched == false )
-            {
-                ostringstream oss;
+            n_resources++;
+        }
+        else
+        {
+            ostringstream oss;
 
-                oss << "VM " << oid << ": Host " << host->get_hid() <<
-                    " filtered out. It does not fulfill SCHED_REQUIREMENTS.";
+            oss << "VM " << oid << ": Host " << host->get_hid()
+                << " filtered out. Not enough capacity.";
 
-                NebulaLog::log("SCHED",Log::DEBUG,oss);
-                continue;
-            }
+            match.log(Log::DEBUG, oss);
+        }
+    }
 
-            n_matched++;
+    // ---------------------------------------------------------------------
+    // Log scheduling errors to VM user if any
+    // ---------------------------------------------------------------------
 
-            // -----------------------------------------------------------------
-            // Check host capacity
-            // -----------------------------------------------------------------
-            if (host->test_capacity(vm_cpu,vm_memory) == true)
+    if (n_resources == 0) //No hosts assigned, let's see why
+    {
+        if (n_error == 0) //No syntax error
+        {
+            if (hosts.size() == 0)
             {
-                vm->add_match_host(host->get_hid());
-
-                n_resources++;
+                vm->log("No hosts enabled to run VMs");
             }
-            else
+            else if (n_auth == 0)
+            {
+                vm->log("User is not authorized to use any host");
+            }
+            else if (n_matched == 0)
             {
                 ostringstream oss;
 
-                oss << "VM " << oid << ": Host " << host->get_hid()
-                    << " filtered out. Not enough capacity.";
+                oss << "No host meets SCHED_REQUIREMENTS: "
+                    << reqs;
 
-                NebulaLog::log("SCHED",Log::DEBUG,oss);
+                vm->log(oss.str());
+            }
+            else
+            {
+                vm->log("No host with enough capacity to deploy the VM");
             }
         }
 
-        // ---------------------------------------------------------------------
-        // Log scheduling errors to VM user if any
-        // ---------------------------------------------------------------------
+        match.update = true;
 
-        if (n_resources == 0) //No hosts assigned, let's see why
-        {
-            if (n_error == 0) //No syntax error
-            {
-                if (hosts.size() == 0)
-                {
-                    vm->log("No hosts enabled to run VMs");
-                }
-                else if (n_auth == 0)
-                {
-                    vm->log("User is not authorized to use any host");
-                }
-                else if (n_matched == 0)
-                {
-                    ostringstream oss;
+        return;
+    }
 
-                    oss << "No host meets SCHED_REQUIREMENTS: "
-                        << reqs;
+    // ---------------------------------------------------------------------
+    // Schedule matched hosts
+    // ---------------------------------------------------------------------
 
-                    vm->log(oss.str());
-                }
-                else
-                {
-                    vm->log("No host with enough capacity to deploy the VM");
-                }
-            }
+    for (it=host_policies.begin() ; it != host_policies.end() ; it++)
+    {
+        (*it)->schedule(vm);
+    }
 
-            vmpool->update(vm);
+    vm->sort_match_hosts();
 
-            continue;
-        }
+    if (vm->is_resched())
+    {
+        // Do not schedule storage for migrations, the VMs needs to be
+        // deployed in the same system DS
 
-        // ---------------------------------------------------------------------
-        // Schedule matched hosts
-        // ---------------------------------------------------------------------
+        vm->add_match_datastore(vm->get_dsid());
+        return;
+    }
 
-        for (it=host_policies.begin() ; it != host_policies.end() ; it++)
-        {
-            (*it)->schedule(vm);
-        }
+    // ---------------------------------------------------------------------
+    // Match datastores for this VM that:
+    //  2. Meets requirements
+    //  3. Have enough capacity to host the VM
+    // ---------------------------------------------------------------------
+
+    ds_reqs = vm->get_ds_requirements();
 
-        vm->sort_match_hosts();
+    n_resources   = 0;
+    n_matched = 0;
+    n_error   = 0;
 
-        if (vm->is_resched())
+    for (h_it=datastores.begin(), matched=false; h_it != datastores.end(); h_it++)
+    {
+        ds = static_cast<DatastoreXML *>(h_it->second);
+
+        // -----------------------------------------------------------------
+        // Evaluate VM requirements
+        // -----------------------------------------------------------------
+        if (!ds_reqs.empty())
         {
-            // Do not schedule storage for migrations, the VMs needs to be
-            // deployed in the same system DS
+            rc = ds->eval_bool(ds_reqs, matched, &error);
 
-            vm->add_match_datastore(vm->get_dsid());
-            continue;
-        }
+            if ( rc != 0 )
+            {
+                ostringstream oss;
+                ostringstream error_msg;
 
-        // ---------------------------------------------------------------------
-        // Match datastores for this VM that:
-        //  2. Meets requirements
-        //  3. Have enough capacity to host the VM
-        // ---------------------------------------------------------------------
+                matched = false;
+                n_error++;
 
-        ds_reqs = vm->get_ds_requirements();
+                error_msg << "Error in SCHED_DS_REQUIREMENTS: '" << ds_reqs
+                          << "', error: " << error;
 
-        n_resources   = 0;
-        n_matched = 0;
-        n_error   = 0;
+                oss << "VM " << oid << ": " << error_msg.str();
 
-        for (h_it=datastores.begin(), matched=false; h_it != datastores.end(); h_it++)
-        {
-            ds = static_cast<DatastoreXML *>(h_it->second);
+                match.log(Log::ERROR, oss);
 
-            // -----------------------------------------------------------------
-            // Evaluate VM requirements
-            // -----------------------------------------------------------------
-            if (!ds_reqs.empty())
-            {
-                rc = ds->eval_bool(ds_reqs, matched, &error);
+                vm->log(error_msg.str());
 
-                if ( rc != 0 )
-                {
-                    ostringstream oss;
-                    ostringstream error_msg;
+                free(error);
 
-                    matched = false;
-                    n_error++;
+                break;
+            }
+        }
+        else
+        {
+            matched = true;
+        }
 
-                    error_msg << "Error in SCHED_DS_REQUIREMENTS: '" << ds_reqs
-                              << "', error: " << error;
+        if ( matched == false )
+        {
+            ostringstream oss;
 
-                    oss << "VM " << oid << ": " << error_msg.str();
+            oss << "VM " << oid << ": Datastore " << ds->get_oid() <<
+                " filtered out. It does not fulfill SCHED_DS_REQUIREMENTS.";
 
-                    NebulaLog::log("SCHED",Log::ERROR,oss);
+            match.log(Log::DEBUG, oss);
+            continue;
+        }
 
-                    vm->log(error_msg.str());
+        n_matched++;
 
-                    free(error);
+        // -----------------------------------------------------------------
+        // Check datastore capacity
+        // -----------------------------------------------------------------
 
-                    break;
-                }
-            }
-            else
+        if (ds->is_shared() && ds->is_monitored())
+        {
+            if (ds->test_capacity(vm_disk))
             {
-                matched = true;
-            }
+                vm->add_match_datastore(ds->get_oid());
 
-            if ( matched == false )
+                n_resources++;
+            }
+            else
             {
                 ostringstream oss;
 
-                oss << "VM " << oid << ": Datastore " << ds->get_oid() <<
-                    " filtered out. It does not fulfill SCHED_DS_REQUIREMENTS.";
+                oss << "VM " << oid << ": Datastore " << ds->get_oid()
+                    << " filtered out. Not enough capacity.";
 
-                NebulaLog::log("SCHED",Log::DEBUG,oss);
-                continue;
+                match.log(Log::DEBUG, oss);
             }
+        }
+        else
+        {
+            // All non shared system DS are valid candidates, the
+            // capacity will be checked later for each host
 
-            n_matched++;
+            vm->add_match_datastore(ds->get_oid());
+            n_resources++;
+        }
+    }
 
-            // -----------------------------------------------------------------
-            // Check datastore capacity
-            // -----------------------------------------------------------------
+    // ---------------------------------------------------------------------
+    // Log scheduling errors to VM user if any
+    // ---------------------------------------------------------------------
 
-            if (ds->is_shared() && ds->is_monitored())
+    if (n_resources == 0)
+    {
+        // For a public cloud VM, 0 system DS is not a problem
+        if (vm->is_public_cloud())
+        {
+            vm->set_only_public_cloud();
+
+            return;
+        }
+        else
+        {
+            //No datastores assigned, let's see why
+
+            if (n_error == 0) //No syntax error
             {
-                if (ds->test_capacity(vm_disk))
+                if (datastores.size() == 0)
                 {
-                    vm->add_match_datastore(ds->get_oid());
-
-                    n_resources++;
+                    vm->log("No system datastores found to run VMs");
                 }
-                else
+                else if (n_matched == 0)
                 {
                     ostringstream oss;
 
-                    oss << "VM " << oid << ": Datastore " << ds->get_oid()
-                        << " filtered out. Not enough capacity.";
+                    oss << "No system datastore meets SCHED_DS_REQUIREMENTS: "
+                        << ds_reqs;
 
-                    NebulaLog::log("SCHED",Log::DEBUG,oss);
+                    vm->log(oss.str());
+                }
+                else
+                {
+                    vm->log("No system datastore with enough capacity for the VM");
                 }
             }
-            else
-            {
-                // All non shared system DS are valid candidates, the
-                // capacity will be checked later for each host
 
-                vm->add_match_datastore(ds->get_oid());
-                n_resources++;
-            }
+            vm->clear_match_hosts();
+
+            match.update = true;
+
+            return;
         }
+    }
 
-        // ---------------------------------------------------------------------
-        // Log scheduling errors to VM user if any
-        // ---------------------------------------------------------------------
+    // ---------------------------------------------------------------------
+    // Schedule matched datastores
+    // ---------------------------------------------------------------------
 
-        if (n_resources == 0)
-        {
-            // For a public cloud VM, 0 system DS is not a problem
-            if (vm->is_public_cloud())
-            {
-                vm->set_only_public_cloud();
+    for (it=ds_policies.begin() ; it != ds_policies.end() ; it++)
+    {
+        (*it)->schedule(vm);
+    }
 
-                continue;
-            }
-            else
-            {
-                //No datastores assigned, let's see why
+    vm->sort_match_datastores();
+}
 
-                if (n_error == 0) //No syntax error
-                {
-                    if (datastores.size() == 0)
-                    {
-                        vm->log("No system datastores found to run VMs");
-                    }
-                    else if (n_matched == 0)
-                    {
-                        ostringstream oss;
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
 
-                        oss << "No system datastore meets SCHED_DS_REQUIREMENTS: "
-                            << ds_reqs;
+bool Scheduler::vm_size_cmp(VirtualMachineXML * a, VirtualMachineXML * b)
+{
+    int       cpu_a, cpu_b;
+    int       mem_a, mem_b;
+    long long dsk_a, dsk_b;
 
-                        vm->log(oss.str());
-                    }
-                    else
-                    {
-                        vm->log("No system datastore with enough capacity for the VM");
-                    }
-                }
+    a->get_requirements(cpu_a, mem_a, dsk_a);
+    b->get_requirements(cpu_b, mem_b, dsk_b);
 
-                vm->clear_match_hosts();
+    if ( mem_a != mem_b )
+    {
+        return mem_a > mem_b;
+    }
 
-                vmpool->update(vm);
+    if ( cpu_a != cpu_b )
+    {
+        return cpu_a > cpu_b;
+    }
 
-                continue;
-            }
-        }
+    return dsk_a > dsk_b;
+}
 
-        // ---------------------------------------------------------------------
-        // Schedule matched datastores
-        // ---------------------------------------------------------------------
+/* -------------------------------------------------------------------------- */
 
-        for (it=ds_policies.begin() ; it != ds_policies.end() ; it++)
-        {
-            (*it)->schedule(vm);
-        }
+bool Scheduler::BestFitCmp::operator()(const Resource * a, const Resource * b)
+{
+    HostXML * ha = hpool->get(a->oid);
+    HostXML * hb = hpool->get(b->oid);
 
-        vm->sort_match_datastores();
+    if ( ha == 0 || hb == 0 )
+    {
+        return hb == 0 && ha != 0;
     }
+
+    bool fit_a = ha->test_capacity(cpu, mem);
+    bool fit_b = hb->test_capacity(cpu, mem);
+
+    if ( fit_a != fit_b )
+    {
+        return fit_a;
+    }
+
+    return ha->free_fraction(cpu, mem) < hb->free_fraction(cpu, mem);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -911,9 +1137,15 @@ void Scheduler::dispatch()
     map<int, unsigned int>  host_vms;
     pair<map<int,unsigned int>::iterator, bool> rc;
 
-    vector<Resource *>::const_reverse_iterator i, j;
+    vector<Resource *>::const_iterator         i;
+    vector<Resource *>::const_reverse_iterator j;
+
+    vector<VirtualMachineXML *>           vms;
+    vector<VirtualMachineXML *>::iterator vm_it;
 
-    const map<int, ObjectXML*> pending_vms = vmpool->get_objects();
+    const map<int, ObjectXML*>& pending_vms = vmpool->get_objects();
+
+    dispatches.clear();
 
     //--------------------------------------------------------------------------
     // Print the VMs to schedule and the selected hosts for each one
@@ -931,24 +1163,38 @@ void Scheduler::dispatch()
 
     NebulaLog::log("SCHED", Log::INFO, oss);
 
+    //--------------------------------------------------------------------------
+    // Order the VMs, by ID or by size for batch placement
+    //--------------------------------------------------------------------------
+
+    for (map<int, ObjectXML*>::const_iterator p_it=pending_vms.begin();
+        p_it != pending_vms.end(); p_it++)
+    {
+        vms.push_back(static_cast<VirtualMachineXML*>(p_it->second));
+    }
+
+    if (dispatch_policy == BATCH)
+    {
+        stable_sort(vms.begin(), vms.end(), vm_size_cmp);
+    }
+
     //--------------------------------------------------------------------------
     // Dispatch each VM till we reach the dispatch limit
     //--------------------------------------------------------------------------
 
-    for (map<int, ObjectXML*>::const_iterator vm_it=pending_vms.begin();
-         vm_it != pending_vms.end() &&
+    for (vm_it = vms.begin(); vm_it != vms.end() &&
             ( dispatch_limit <= 0 || dispatched_vms < dispatch_limit );
          vm_it++)
     {
-        vm = static_cast<VirtualMachineXML*>(vm_it->second);
+        vm = *vm_it;
 
-        const vector<Resource *> resources = vm->get_match_hosts();
+        const vector<Resource *> matched = vm->get_match_hosts();
 
         //--------------------------------------------------------------
         // Test Image Datastore capacity, but not for migrations
         //--------------------------------------------------------------
 
-        if (!resources.empty() && !vm->is_resched())
+        if (!matched.empty() && !vm->is_resched())
         {
             if (vm->test_image_datastore_capacity(img_dspool) == false)
             {
@@ -968,11 +1214,24 @@ void Scheduler::dispatch()
 
         vm->get_requirements(cpu,mem,dsk);
 
+        //----------------------------------------------------------------------
+        // Hosts are tried from the highest ranked, for batch placement the
+        // host that best fits the VM is tried first
+        //----------------------------------------------------------------------
+
+        vector<Resource *> resources(matched.rbegin(), matched.rend());
+
+        if (dispatch_policy == BATCH)
+        {
+            stable_sort(resources.begin(), resources.end(),
+                    BestFitCmp(hpool, cpu, mem));
+        }
+
         //----------------------------------------------------------------------
         // Get the highest ranked host and best System DS for it
         //----------------------------------------------------------------------
 
-        for (i = resources.rbegin() ; i != resources.rend() ; i++)
+        for (i = resources.begin() ; i != resources.end() ; i++)
         {
             hid  = (*i)->oid;
             host = hpool->get(hid);
@@ -1098,9 +1357,16 @@ void Scheduler::dispatch()
             }
 
             //------------------------------------------------------------------
-            // Dispatch and update host and DS capacity, and dispatch counters
+            // Dispatch and update host and DS capacity, and dispatch counters.
+            // Concurrent calls are made once every VM has been placed, a
+            // failed call is not retried in other host till the next cycle
             //------------------------------------------------------------------
-            if (vmpool->dispatch(vm_it->first, hid, dsid, vm->is_resched()) != 0)
+            if (dispatch_threads > 1)
+            {
+                dispatches.push_back(VMDispatch(vm->get_oid(), hid, dsid,
+                            vm->is_resched()));
+            }
+            else if (vmpool->dispatch(vm->get_oid(),hid,dsid,vm->is_resched())!=0)
             {
                 continue;
             }
@@ -1130,6 +1396,73 @@ void Scheduler::dispatch()
             break;
         }
     }
+
+    dispatch_calls();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Scheduler::dispatch_calls()
+{
+    unsigned int num_threads = dispatch_threads;
+
+    vector<pthread_t> threads;
+    pthread_attr_t    pattr;
+
+    dispatch_next = 0;
+
+    if (num_threads > dispatches.size())
+    {
+        num_threads = dispatches.size();
+    }
+
+    if (num_threads <= 1)
+    {
+        dispatch_loop();
+        return;
+    }
+
+    pthread_attr_init(&pattr);
+    pthread_attr_setdetachstate(&pattr, PTHREAD_CREATE_JOINABLE);
+
+    for (unsigned int i = 1; i < num_threads; i++)
+    {
+        pthread_t id;
+
+        if (pthread_create(&id, &pattr, scheduler_dispatch_loop,
+                (void *) this) != 0)
+        {
+            NebulaLog::log("SCHED", Log::ERROR,
+                    "Could not create dispatch thread");
+            break;
+        }
+
+        threads.push_back(id);
+    }
+
+    pthread_attr_destroy(&pattr);
+
+    dispatch_loop(); //Also dispatch VMs in this thread
+
+    for (unsigned int i = 0; i < threads.size(); i++)
+    {
+        pthread_join(threads[i], 0);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void Scheduler::dispatch_loop()
+{
+    unsigned int i;
+
+    while ((i = __sync_fetch_and_add(&dispatch_next, 1)) < dispatches.size())
+    {
+        const VMDispatch& d = dispatches[i];
+
+        vmpool->dispatch(d.vid, d.hid, d.dsid, d.resched);
+    }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -44,6 +44,9 @@ void SchedulerTemplate::set_conf_default()
 #  DEFAULT_SCHED
 #  DEFAULT_DS_SCHED
 #  LIVE_RESCHEDS
+#  MATCH_THREADS
+#  DISPATCH_THREADS
+#  DISPATCH_POLICY
 #  LOG
 #-------------------------------------------------------------------------------
 */
@@ -89,6 +92,24 @@ void SchedulerTemplate::set_conf_default()
     attribute = new SingleAttribute("LIVE_RESCHEDS",value);
     conf_default.insert(make_pair(attribute->name(),attribute));
 
+    //MATCH_THREADS
+    value = "1";
+
+    attribute = new SingleAttribute("MATCH_THREADS",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
+    //DISPATCH_THREADS
+    value = "1";
+
+    attribute = new SingleAttribute("DISPATCH_THREADS",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
+    //DISPATCH_POLICY
+    value = "0";
+
+    attribute = new SingleAttribute("DISPATCH_POLICY",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
     //DEFAULT_SCHED
     vvalue.clear();
     vvalue.insert(make_pair("POLICY","1"));
@@ -0,0 +1,923 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Offline scheduler simulation. The scheduler pools are loaded from XML
+ *  documents, either generated or captured from a running oned, e.g.:
+ *
+ *    onehost list -x      > host_pool.xml
+ *    onevm list all -x    > vm_pool.xml
+ *    onedatastore list -x > datastore_pool.xml
+ *    onecluster list -x   > cluster_pool.xml
+ *    oneacl list -x       > acl_pool.xml
+ *
+ *  and the match and dispatch phases are executed without contacting oned.
+ *  Deployments and VM updates are recorded instead of sent to oned.
+ */
+
+#include "Scheduler.h"
+#include "SchedulerTemplate.h"
+#include "RankPolicy.h"
+#include "AclRule.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+using namespace std;
+
+/* -------------------------------------------------------------------------- */
+/* Pool documents                                                             */
+/* -------------------------------------------------------------------------- */
+
+struct BenchData
+{
+    string host_pool;
+    string vm_pool;
+    string datastore_pool;
+    string cluster_pool;
+    string acl_pool;
+};
+
+/**
+ *  Builds the result of a successful pool info call
+ *    @param xml the pool document
+ *    @param result of the call
+ *    @return 0
+ */
+static int pool_info(const string& xml, xmlrpc_c::value &result)
+{
+    vector<xmlrpc_c::value> values;
+
+    values.push_back(xmlrpc_c::value_boolean(true));
+    values.push_back(xmlrpc_c::value_string(xml));
+
+    result = xmlrpc_c::value_array(values);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Pools loaded from the documents instead of oned                            */
+/* -------------------------------------------------------------------------- */
+
+class BenchHostPool : public HostPoolXML
+{
+public:
+    BenchHostPool(const string& _xml):HostPoolXML(0), xml(_xml){};
+
+protected:
+    int load_info(xmlrpc_c::value &result)
+    {
+        return pool_info(xml, result);
+    };
+
+private:
+    const string& xml;
+};
+
+class BenchClusterPool : public ClusterPoolXML
+{
+public:
+    BenchClusterPool(const string& _xml):ClusterPoolXML(0), xml(_xml){};
+
+protected:
+    int load_info(xmlrpc_c::value &result)
+    {
+        return pool_info(xml, result);
+    };
+
+private:
+    const string& xml;
+};
+
+class BenchSystemDatastorePool : public SystemDatastorePoolXML
+{
+public:
+    BenchSystemDatastorePool(const string& _xml):
+        SystemDatastorePoolXML(0), xml(_xml){};
+
+protected:
+    int load_info(xmlrpc_c::value &result)
+    {
+        return pool_info(xml, result);
+    };
+
+private:
+    const string& xml;
+};
+
+class BenchImageDatastorePool : public ImageDatastorePoolXML
+{
+public:
+    BenchImageDatastorePool(const string& _xml):
+        ImageDatastorePoolXML(0), xml(_xml){};
+
+protected:
+    int load_info(xmlrpc_c::value &result)
+    {
+        return pool_info(xml, result);
+    };
+
+private:
+    const string& xml;
+};
+
+class BenchAcl : public AclXML
+{
+public:
+    BenchAcl(const string& _xml):AclXML(0, 0), xml(_xml){};
+
+protected:
+    int load_info(xmlrpc_c::value &result)
+    {
+        return pool_info(xml, result);
+    };
+
+private:
+    const string& xml;
+};
+
+/**
+ *  VM pool that records the deployments and updates. An optional delay
+ *  simulates the latency of the oned calls. Deployments can be recorded by
+ *  several dispatch threads.
+ */
+class BenchVirtualMachinePool : public VirtualMachinePoolXML
+{
+public:
+    BenchVirtualMachinePool(const string& _xml, unsigned int machines_limit,
+            useconds_t _latency):
+        VirtualMachinePoolXML(0, machines_limit, false), xml(_xml),
+        latency(_latency), updates(0)
+    {
+        pthread_mutex_init(&mutex, 0);
+    };
+
+    ~BenchVirtualMachinePool()
+    {
+        pthread_mutex_destroy(&mutex);
+    };
+
+    struct Deployment
+    {
+        int vid;
+        int hid;
+        int dsid;
+    };
+
+    int dispatch(int vid, int hid, int dsid, bool resched) const
+    {
+        Deployment d;
+
+        d.vid  = vid;
+        d.hid  = hid;
+        d.dsid = dsid;
+
+        pthread_mutex_lock(&mutex);
+
+        deployments.push_back(d);
+
+        pthread_mutex_unlock(&mutex);
+
+        delay();
+
+        return 0;
+    };
+
+    int update(int vid, const string &st) const
+    {
+        updates++;
+
+        delay();
+
+        return 0;
+    };
+
+    const vector<Deployment>& get_deployments() const
+    {
+        return deployments;
+    };
+
+    int get_updates() const
+    {
+        return updates;
+    };
+
+    void clear()
+    {
+        deployments.clear();
+        updates = 0;
+    };
+
+protected:
+    int load_info(xmlrpc_c::value &result)
+    {
+        return pool_info(xml, result);
+    };
+
+private:
+    const string& xml;
+
+    useconds_t latency;
+
+    mutable vector<Deployment> deployments;
+
+    mutable int updates;
+
+    mutable pthread_mutex_t mutex;
+
+    void delay() const
+    {
+        if ( latency > 0 )
+        {
+            usleep(latency);
+        }
+    };
+};
+
+/* -------------------------------------------------------------------------- */
+/* Scheduler                                                                  */
+/* -------------------------------------------------------------------------- */
+
+class BenchScheduler : public Scheduler
+{
+public:
+
+    BenchScheduler(const BenchData& data, const SchedulerTemplate& conf,
+            useconds_t latency):Scheduler(),rp_host(0),rp_ds(0)
+    {
+        unsigned int machines_limit;
+
+        conf.get("MAX_VM", machines_limit);
+
+        set_limits(conf);
+
+        bench_vmpool = new BenchVirtualMachinePool(data.vm_pool,
+                machines_limit, latency);
+
+        vmpool = bench_vmpool;
+
+        hpool  = new BenchHostPool(data.host_pool);
+        clpool = new BenchClusterPool(data.cluster_pool);
+
+        dspool     = new BenchSystemDatastorePool(data.datastore_pool);
+        img_dspool = new BenchImageDatastorePool(data.datastore_pool);
+
+        acls = new BenchAcl(data.acl_pool);
+
+        register_policies(conf);
+    };
+
+    ~BenchScheduler()
+    {
+        delete rp_host;
+        delete rp_ds;
+    };
+
+    void register_policies(const SchedulerTemplate& conf)
+    {
+        rp_host = new RankHostPolicy(hpool, conf.get_policy(), 1.0);
+
+        add_host_policy(rp_host);
+
+        rp_ds = new RankDatastorePolicy(dspool, conf.get_ds_policy(), 1.0);
+
+        add_ds_policy(rp_ds);
+    };
+
+    /**
+     *  Timings of a scheduling cycle, in seconds
+     */
+    struct Cycle
+    {
+        double set_up;
+        double match;
+        double dispatch;
+    };
+
+    /**
+     *  Runs a scheduling cycle: set up the pools, match and dispatch
+     *    @param cycle timings
+     *    @return 0 on success, -1 if the pools cannot be loaded or there are
+     *    no pending VMs
+     */
+    int cycle(Cycle& cycle);
+
+    /**
+     *  Prints the pool sizes and the placement of the last cycle
+     */
+    void print_placement(ostream& os);
+
+private:
+    RankPolicy * rp_host;
+    RankPolicy * rp_ds;
+
+    BenchVirtualMachinePool * bench_vmpool;
+
+    unsigned int pending;
+};
+
+/* -------------------------------------------------------------------------- */
+/* Timing & memory helpers                                                    */
+/* -------------------------------------------------------------------------- */
+
+static double now()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, 0);
+
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ *  @return resident memory of the process, in KB
+ */
+static long rss_kb()
+{
+    ifstream statm("/proc/self/statm");
+    long     size;
+    long     resident = 0;
+
+    statm >> size >> resident;
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/**
+ *  @return peak resident memory of the process, in KB
+ */
+static long max_rss_kb()
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_maxrss;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int BenchScheduler::cycle(Cycle& cycle)
+{
+    double start;
+    int    rc;
+
+    bench_vmpool->clear();
+
+    start = now();
+
+    rc = set_up_pools();
+
+    cycle.set_up = now() - start;
+
+    if ( rc != 0 )
+    {
+        return -1;
+    }
+
+    pending = vmpool->get_objects().size();
+
+    start = now();
+
+    match_schedule();
+
+    cycle.match = now() - start;
+
+    start = now();
+
+    dispatch();
+
+    cycle.dispatch = now() - start;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void BenchScheduler::print_placement(ostream& os)
+{
+    const map<int, ObjectXML*>& hosts = hpool->get_objects();
+    map<int, ObjectXML*>::const_iterator it;
+
+    const vector<BenchVirtualMachinePool::Deployment>& deployments =
+        bench_vmpool->get_deployments();
+
+    set<int> used_hosts;
+
+    int   empty_hosts = 0;
+    float used_free   = 0;
+
+    for (unsigned int i = 0; i < deployments.size(); i++)
+    {
+        used_hosts.insert(deployments[i].hid);
+    }
+
+    for (it = hosts.begin(); it != hosts.end(); it++)
+    {
+        HostXML * host = static_cast<HostXML *>(it->second);
+        float     free = host->free_fraction(0, 0);
+
+        if ( free >= 1 )
+        {
+            empty_hosts++;
+        }
+
+        if ( used_hosts.count(host->get_hid()) > 0 )
+        {
+            used_free += free;
+        }
+    }
+
+    os << "Pools" << endl
+       << "  hosts:                " << hosts.size() << endl
+       << "  clusters:             " << clpool->get_objects().size() << endl
+       << "  system datastores:    " << dspool->get_objects().size() << endl
+       << "  pending VMs:          " << pending << endl;
+
+    os << "Placement (last cycle)" << endl
+       << "  dispatched VMs:       " << deployments.size() << endl
+       << "  VMs updated:          " << bench_vmpool->get_updates() << endl
+       << "  hosts receiving VMs:  " << used_hosts.size() << endl
+       << "  empty hosts:          " << empty_hosts << endl;
+
+    if ( !used_hosts.empty() )
+    {
+        os << "  free capacity (used): " << fixed << setprecision(1)
+           << 100 * used_free / used_hosts.size() << "%" << endl;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* Synthetic pools                                                            */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Generates the pool documents, the capacity and usage of the hosts and the
+ *  size of the VMs are randomly distributed.
+ *    @param data the pool documents
+ *    @param num_hosts number of hosts
+ *    @param num_vms number of pending VMs
+ *    @param num_clusters the hosts and VMs are evenly distributed in them
+ */
+static void generate(BenchData& data, int num_hosts, int num_vms,
+        int num_clusters)
+{
+    static const int cpus[] = {800, 1600, 3200, 6400};
+    static const int mems[] = {512, 1024, 2048, 4096, 8192};
+    static const float vcpus[] = {0.5, 1, 2, 4};
+
+    ostringstream oss;
+    string        xml;
+
+    // -------------------------------------------------------------------------
+    // Clusters, a shared system datastore per cluster and an image datastore
+    // -------------------------------------------------------------------------
+
+    oss << "<CLUSTER_POOL>";
+
+    for (int i = 0; i < num_clusters; i++)
+    {
+        oss << "<CLUSTER><ID>" << i << "</ID><NAME>cluster" << i << "</NAME>"
+            << "<TEMPLATE><RESERVED_CPU/><RESERVED_MEM/></TEMPLATE></CLUSTER>";
+    }
+
+    oss << "</CLUSTER_POOL>";
+
+    data.cluster_pool = oss.str();
+
+    oss.str("");
+
+    oss << "<DATASTORE_POOL>"
+        << "<DATASTORE><ID>1</ID><NAME>default</NAME><TYPE>0</TYPE>"
+        << "<CLUSTER_ID>-1</CLUSTER_ID><TOTAL_MB>10485760</TOTAL_MB>"
+        << "<FREE_MB>8388608</FREE_MB><USED_MB>2097152</USED_MB>"
+        << "<TEMPLATE><DS_MAD>fs</DS_MAD><TM_MAD>shared</TM_MAD></TEMPLATE>"
+        << "</DATASTORE>";
+
+    for (int i = 0; i < num_clusters; i++)
+    {
+        oss << "<DATASTORE><ID>" << 100 + i << "</ID><NAME>system" << i
+            << "</NAME><TYPE>1</TYPE><CLUSTER_ID>" << i << "</CLUSTER_ID>"
+            << "<TOTAL_MB>10485760</TOTAL_MB><FREE_MB>8388608</FREE_MB>"
+            << "<USED_MB>2097152</USED_MB><TEMPLATE><SHARED>YES</SHARED>"
+            << "<TM_MAD>shared</TM_MAD></TEMPLATE></DATASTORE>";
+    }
+
+    oss << "</DATASTORE_POOL>";
+
+    data.datastore_pool = oss.str();
+
+    // -------------------------------------------------------------------------
+    // Hosts, 4GB per CPU and up to a 60% of their capacity in use
+    // -------------------------------------------------------------------------
+
+    oss.str("");
+
+    oss << "<HOST_POOL>";
+
+    for (int i = 0; i < num_hosts; i++)
+    {
+        long long max_cpu = cpus[rand() % 4];
+        long long max_mem = max_cpu * 4 * 1024 * 1024 / 100;
+
+        long long cpu_usage = max_cpu * (rand() % 60) / 100;
+        long long mem_usage = max_mem * (rand() % 60) / 100;
+
+        oss << "<HOST><ID>" << i << "</ID><NAME>host" << i << "</NAME>"
+            << "<STATE>2</STATE><CLUSTER_ID>" << i % num_clusters
+            << "</CLUSTER_ID><HOST_SHARE>"
+            << "<DISK_USAGE>0</DISK_USAGE>"
+            << "<MEM_USAGE>" << mem_usage << "</MEM_USAGE>"
+            << "<CPU_USAGE>" << cpu_usage << "</CPU_USAGE>"
+            << "<MAX_DISK>1048576</MAX_DISK>"
+            << "<MAX_MEM>" << max_mem << "</MAX_MEM>"
+            << "<MAX_CPU>" << max_cpu << "</MAX_CPU>"
+            << "<FREE_DISK>1048576</FREE_DISK>"
+            << "<FREE_MEM>" << max_mem - mem_usage << "</FREE_MEM>"
+            << "<FREE_CPU>" << max_cpu - cpu_usage << "</FREE_CPU>"
+            << "<USED_DISK>0</USED_DISK>"
+            << "<USED_MEM>" << mem_usage << "</USED_MEM>"
+            << "<USED_CPU>" << cpu_usage << "</USED_CPU>"
+            << "<RUNNING_VMS>" << cpu_usage / 100 << "</RUNNING_VMS>"
+            << "<DATASTORES/></HOST_SHARE><VMS/>"
+            << "<TEMPLATE><HYPERVISOR>kvm</HYPERVISOR>"
+            << "<ARCH>x86_64</ARCH><CPUSPEED>2600</CPUSPEED></TEMPLATE>"
+            << "</HOST>";
+    }
+
+    oss << "</HOST_POOL>";
+
+    data.host_pool = oss.str();
+
+    // -------------------------------------------------------------------------
+    // Pending VMs, owned by users of the "users" group. One every four VMs
+    // has additional user requirements
+    // -------------------------------------------------------------------------
+
+    oss.str("");
+
+    oss << "<VM_POOL>";
+
+    for (int i = 0; i < num_vms; i++)
+    {
+        int cluster = rand() % num_clusters;
+
+        oss << "<VM><ID>" << i << "</ID><UID>" << 2 + i % 10 << "</UID>"
+            << "<GID>1</GID><NAME>vm" << i << "</NAME>"
+            << "<STATE>1</STATE><LCM_STATE>0</LCM_STATE><RESCHED>0</RESCHED>"
+            << "<TEMPLATE><CPU>" << vcpus[rand() % 4] << "</CPU>"
+            << "<MEMORY>" << mems[rand() % 5] << "</MEMORY>"
+            << "<AUTOMATIC_REQUIREMENTS>CLUSTER_ID = " << cluster
+            << " &amp; !(PUBLIC_CLOUD = YES)</AUTOMATIC_REQUIREMENTS>"
+            << "</TEMPLATE><USER_TEMPLATE>";
+
+        if ( i % 4 == 0 )
+        {
+            oss << "<SCHED_REQUIREMENTS>HYPERVISOR = \"kvm\" &amp; "
+                << "FREE_CPU &gt; 100</SCHED_REQUIREMENTS>";
+        }
+
+        oss << "</USER_TEMPLATE><HISTORY_RECORDS/></VM>";
+    }
+
+    oss << "</VM_POOL>";
+
+    data.vm_pool = oss.str();
+
+    // -------------------------------------------------------------------------
+    // ACL: the "users" group can manage every host
+    // -------------------------------------------------------------------------
+
+    AclRule rule(0,
+                 AclRule::GROUP_ID | 1,
+                 PoolObjectSQL::HOST | AclRule::ALL_ID,
+                 AuthRequest::MANAGE,
+                 AclRule::ALL_ID);
+
+    data.acl_pool = "<ACL_POOL>" + rule.to_xml(xml) + "</ACL_POOL>";
+}
+
+/* -------------------------------------------------------------------------- */
+/* Pool document files                                                        */
+/* -------------------------------------------------------------------------- */
+
+static const char * pool_files[] = {
+    "host_pool.xml",
+    "vm_pool.xml",
+    "datastore_pool.xml",
+    "cluster_pool.xml",
+    "acl_pool.xml"
+};
+
+static string * pool_documents(BenchData& data, int i)
+{
+    string * docs[] = {
+        &data.host_pool,
+        &data.vm_pool,
+        &data.datastore_pool,
+        &data.cluster_pool,
+        &data.acl_pool
+    };
+
+    return docs[i];
+}
+
+static int read_pools(const string& dir, BenchData& data)
+{
+    for (int i = 0; i < 5; i++)
+    {
+        string   path = dir + "/" + pool_files[i];
+        ifstream file(path.c_str());
+
+        ostringstream oss;
+
+        if ( !file.good() )
+        {
+            cerr << "Error: cannot read " << path << endl;
+            return -1;
+        }
+
+        oss << file.rdbuf();
+
+        *pool_documents(data, i) = oss.str();
+    }
+
+    return 0;
+}
+
+static int write_pools(const string& dir, BenchData& data)
+{
+    for (int i = 0; i < 5; i++)
+    {
+        string   path = dir + "/" + pool_files[i];
+        ofstream file(path.c_str());
+
+        if ( !file.good() )
+        {
+            cerr << "Error: cannot write " << path << endl;
+            return -1;
+        }
+
+        file << *pool_documents(data, i) << endl;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+static void report(const string& name, const vector<double>& times)
+{
+    double total = 0;
+    double min   = times[0];
+    double max   = times[0];
+
+    for (unsigned int i = 0; i < times.size(); i++)
+    {
+        total += times[i];
+
+        if ( times[i] < min )
+        {
+            min = times[i];
+        }
+
+        if ( times[i] > max )
+        {
+            max = times[i];
+        }
+    }
+
+    cout << "  " << left << setw(10) << name << right << fixed
+         << setprecision(3)
+         << setw(12) << min * 1e3
+         << setw(12) << total * 1e3 / times.size()
+         << setw(12) << max * 1e3 << endl;
+}
+
+static void print_usage(const char * name)
+{
+    cout << "Usage: " << name << " -c etc_dir [-i dir | -H hosts -V vms "
+         << "[-C clusters] [-s seed]]\n"
+         << "         [-o dir] [-n cycles] [-t threads] [-p policy] "
+         << "[-m dispatch]\n"
+         << "         [-D threads] [-l latency] [-d level]\n"
+         << "  -c: directory of sched.conf\n"
+         << "  -i: directory with the pool documents to load ("
+         << "host_pool.xml, vm_pool.xml,\n"
+         << "      datastore_pool.xml, cluster_pool.xml and acl_pool.xml)\n"
+         << "  -H: number of hosts to generate (1000)\n"
+         << "  -V: number of pending VMs to generate (5000)\n"
+         << "  -C: number of clusters to generate (4)\n"
+         << "  -s: random seed for the generated pools (1)\n"
+         << "  -o: write the pool documents to this directory\n"
+         << "  -n: number of scheduling cycles (5)\n"
+         << "  -t: MATCH_THREADS, overrides sched.conf\n"
+         << "  -p: DISPATCH_POLICY, overrides sched.conf\n"
+         << "  -m: MAX_DISPATCH and MAX_VM, overrides sched.conf\n"
+         << "  -D: DISPATCH_THREADS, overrides sched.conf\n"
+         << "  -l: simulated latency of oned calls in microseconds (0)\n"
+         << "  -d: log level, 0 = ERROR ... 3 = DEBUG (0)\n";
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char ** argv)
+{
+    string etc_path;
+    string in_dir;
+    string out_dir;
+
+    int num_hosts    = 1000;
+    int num_vms      = 5000;
+    int num_clusters = 4;
+    int seed         = 1;
+    int cycles       = 5;
+    int latency      = 0;
+    int level        = 0;
+
+    string threads;
+    string policy;
+    string max_dispatch;
+    string dispatch_threads;
+
+    BenchData data;
+    int       opt;
+    long      rss;
+
+    while ((opt = getopt(argc, argv, "c:i:H:V:C:s:o:n:t:p:m:D:l:d:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'c': etc_path     = string(optarg) + "/"; break;
+            case 'i': in_dir       = optarg; break;
+            case 'H': num_hosts    = atoi(optarg); break;
+            case 'V': num_vms      = atoi(optarg); break;
+            case 'C': num_clusters = atoi(optarg); break;
+            case 's': seed         = atoi(optarg); break;
+            case 'o': out_dir      = optarg; break;
+            case 'n': cycles       = atoi(optarg); break;
+            case 't': threads      = optarg; break;
+            case 'p': policy       = optarg; break;
+            case 'm': max_dispatch = optarg; break;
+            case 'D': dispatch_threads = optarg; break;
+            case 'l': latency      = atoi(optarg); break;
+            case 'd': level        = atoi(optarg); break;
+            default:
+                print_usage(argv[0]);
+                return -1;
+        }
+    }
+
+    if ( etc_path.empty() || cycles < 1 || num_clusters < 1 ||
+         level < 0 || level > 3 )
+    {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    // -------------------------------------------------------------------------
+    // Configuration, options override the values in sched.conf
+    // -------------------------------------------------------------------------
+
+    SchedulerTemplate conf(etc_path);
+
+    if ( conf.load_configuration() != 0 )
+    {
+        cerr << "Error: cannot load " << etc_path << "sched.conf" << endl;
+        return -1;
+    }
+
+    if ( !threads.empty() )
+    {
+        conf.replace("MATCH_THREADS", threads);
+    }
+
+    if ( !policy.empty() )
+    {
+        conf.replace("DISPATCH_POLICY", policy);
+    }
+
+    if ( !max_dispatch.empty() )
+    {
+        conf.replace("MAX_DISPATCH", max_dispatch);
+        conf.replace("MAX_VM", max_dispatch);
+    }
+
+    if ( !dispatch_threads.empty() )
+    {
+        conf.replace("DISPATCH_THREADS", dispatch_threads);
+    }
+
+    NebulaLog::init_log_system(NebulaLog::CERR,
+                               static_cast<Log::MessageType>(level),
+                               0,
+                               ios_base::trunc,
+                               "sched_bench");
+    xmlInitParser();
+
+    // -------------------------------------------------------------------------
+    // Pool documents
+    // -------------------------------------------------------------------------
+
+    rss = rss_kb();
+
+    if ( !in_dir.empty() )
+    {
+        if ( read_pools(in_dir, data) != 0 )
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        srand(seed);
+
+        generate(data, num_hosts, num_vms, num_clusters);
+    }
+
+    if ( !out_dir.empty() && write_pools(out_dir, data) != 0 )
+    {
+        return -1;
+    }
+
+    cout << "Pool documents: " << (data.host_pool.size() + data.vm_pool.size()
+            + data.datastore_pool.size() + data.cluster_pool.size()
+            + data.acl_pool.size()) / 1024 << " KB" << endl;
+
+    // -------------------------------------------------------------------------
+    // Scheduling cycles
+    // -------------------------------------------------------------------------
+
+    BenchScheduler sched(data, conf, latency);
+
+    vector<double> set_up_t;
+    vector<double> match_t;
+    vector<double> dispatch_t;
+    vector<double> cycle_t;
+
+    for (int i = 0; i < cycles; i++)
+    {
+        BenchScheduler::Cycle cycle;
+
+        if ( sched.cycle(cycle) != 0 )
+        {
+            cerr << "Error: cannot set up the pools or no pending VMs" << endl;
+            return -1;
+        }
+
+        set_up_t.push_back(cycle.set_up);
+        match_t.push_back(cycle.match);
+        dispatch_t.push_back(cycle.dispatch);
+        cycle_t.push_back(cycle.set_up + cycle.match + cycle.dispatch);
+    }
+
+    sched.print_placement(cout);
+
+    cout << "Memory" << endl
+         << "  pools and documents:  " << rss_kb() - rss << " KB" << endl
+         << "  peak RSS:             " << max_rss_kb() << " KB" << endl;
+
+    cout << "Timing (" << cycles << " cycles, ms)" << endl
+         << "  " << left << setw(10) << "phase" << right
+         << setw(12) << "min" << setw(12) << "avg" << setw(12) << "max" << endl;
+
+    report("set up", set_up_t);
+    report("match", match_t);
+    report("dispatch", dispatch_t);
+    report("cycle", cycle_t);
+
+    xmlCleanupParser();
+
+    NebulaLog::finalize_log_system();
+
+    return 0;
+}
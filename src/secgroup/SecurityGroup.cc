@@ -30,6 +30,12 @@ const char * SecurityGroup::db_bootstrap = "CREATE TABLE IF NOT EXISTS secgroup_
     "gid INTEGER, owner_u INTEGER, group_u INTEGER, other_u INTEGER, "
     "UNIQUE(name,uid))";
 
+const char * SecurityGroup::vms_table = "secgroup_vms";
+
+const char * SecurityGroup::vms_db_bootstrap = "CREATE TABLE IF NOT EXISTS "
+    "secgroup_vms (secgroup_oid INTEGER, vm_oid INTEGER, "
+    "PRIMARY KEY(secgroup_oid, vm_oid))";
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
@@ -41,8 +47,10 @@ SecurityGroup::SecurityGroup(
         int             _umask,
         Template*       sgroup_template):
         PoolObjectSQL(-1, SECGROUP, "", _uid,_gid,_uname,_gname,table),
-        vm_collection("VMS")
+        vm_collection("VMS", vms_table, "secgroup_oid", "vm_oid")
 {
+    collections.push_back(&vm_collection);
+
     if (sgroup_template != 0)
     {
         obj_template = sgroup_template;
@@ -137,7 +145,7 @@ int SecurityGroup::insert_replace(SqlDB *db, bool replace, string& error_str)
         goto error_name;
     }
 
-    sql_xml = db->escape_str(to_xml(xml_body).c_str());
+    sql_xml = db->escape_str(to_xml(xml_body, false).c_str());
 
     if ( sql_xml == 0 )
     {
@@ -202,13 +210,22 @@ error_common:
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-string& SecurityGroup::to_xml(string& xml) const
+string& SecurityGroup::to_xml(string& xml, bool with_collections) const
 {
     ostringstream   oss;
     string          template_xml;
     string          perms_xml;
     string          vm_collection_xml;
 
+    if ( with_collections )
+    {
+        vm_collection.to_xml(vm_collection_xml);
+    }
+    else
+    {
+        vm_collection.to_xml_db(vm_collection_xml);
+    }
+
     oss <<
     "<SECURITY_GROUP>"    <<
         "<ID>"      << oid      << "</ID>"          <<
@@ -218,7 +235,7 @@ string& SecurityGroup::to_xml(string& xml) const
         "<GNAME>"   << gname    << "</GNAME>"       <<
         "<NAME>"    << name     << "</NAME>"        <<
         perms_to_xml(perms_xml)                                   <<
-        vm_collection.to_xml(vm_collection_xml)                   <<
+        vm_collection_xml                                         <<
         obj_template->to_xml(template_xml) <<
     "</SECURITY_GROUP>";
 
@@ -263,18 +280,6 @@ int SecurityGroup::from_xml(const string& xml)
     ObjectXML::free_nodes(content);
     content.clear();
 
-    ObjectXML::get_nodes("/SECURITY_GROUP/VMS", content);
-
-    if (content.empty())
-    {
-        return -1;
-    }
-
-    rc += vm_collection.from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
-    content.clear();
-
     if (rc != 0)
     {
         return -1;
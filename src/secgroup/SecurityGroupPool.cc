@@ -15,6 +15,7 @@
 /* -------------------------------------------------------------------------- */
 
 #include "SecurityGroupPool.h"
+#include "VirtualNetworkPool.h"
 #include "User.h"
 #include "Nebula.h"
 #include "NebulaLog.h"
@@ -24,6 +25,8 @@
 SecurityGroupPool::SecurityGroupPool(SqlDB * db)
     :PoolSQL(db, SecurityGroup::table, true, true)
 {
+    pthread_mutex_init(&cache_mutex, 0);
+
     //lastOID is set in PoolSQL::init_cb
     if (get_lastOID() == -1)
     {
@@ -76,6 +79,32 @@ SecurityGroupPool::SecurityGroupPool(SqlDB * db)
     return;
 }
 
+/* -------------------------------------------------------------------------- */
+
+SecurityGroupPool::~SecurityGroupPool()
+{
+    map<int, RuleExpansion *>::iterator it;
+
+    for (it = rule_cache.begin(); it != rule_cache.end(); it++)
+    {
+        delete it->second;
+    }
+
+    pthread_mutex_destroy(&cache_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+SecurityGroupPool::RuleExpansion::~RuleExpansion()
+{
+    vector<VectorAttribute *>::iterator it;
+
+    for (it = rules.begin(); it != rules.end(); it++)
+    {
+        delete *it;
+    }
+}
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
@@ -141,3 +170,201 @@ int SecurityGroupPool::update(SecurityGroup * securitygroup)
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
+
+int SecurityGroupPool::drop(PoolObjectSQL * objsql, string& error_msg)
+{
+    map<int, RuleExpansion *>::iterator it;
+
+    int oid = objsql->get_oid();
+    int rc  = PoolSQL::drop(objsql, error_msg);
+
+    if ( rc != 0 )
+    {
+        return rc;
+    }
+
+    pthread_mutex_lock(&cache_mutex);
+
+    it = rule_cache.find(oid);
+
+    if ( it != rule_cache.end() )
+    {
+        delete it->second;
+
+        rule_cache.erase(it);
+    }
+
+    pthread_mutex_unlock(&cache_mutex);
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+string SecurityGroupPool::rules_key(const vector<VectorAttribute*>& sg_rules)
+{
+    ostringstream oss;
+
+    vector<VectorAttribute*>::const_iterator it;
+
+    for (it = sg_rules.begin(); it != sg_rules.end(); it++)
+    {
+        string * str = (*it)->marshall();
+
+        if ( str != 0 )
+        {
+            oss << *str;
+
+            delete str;
+        }
+
+        oss << "\n";
+    }
+
+    return oss.str();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void SecurityGroupPool::invalidate_vnet(int vnid)
+{
+    pthread_mutex_lock(&cache_mutex);
+
+    vnet_generation[vnid]++;
+
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void SecurityGroupPool::expand_rules(int sgid,
+        vector<VectorAttribute*>& sg_rules, vector<VectorAttribute*>& rules)
+{
+    vector<VectorAttribute*>::iterator  it;
+    map<int, unsigned long>::iterator   gen_it;
+    map<int, RuleExpansion *>::iterator cache_it;
+
+    vector<VectorAttribute*> expanded;
+    RuleExpansion *          expansion;
+
+    int  vnet_id;
+    bool valid;
+
+    VirtualNetwork *     vnet;
+    VirtualNetworkPool * vnet_pool = Nebula::instance().get_vnpool();
+
+    string key = rules_key(sg_rules);
+
+    // -------------------------------------------------------------------------
+    // Look up the cache, the expansion is valid if the group rules and the
+    // address ranges of the referenced networks have not changed
+    // -------------------------------------------------------------------------
+    pthread_mutex_lock(&cache_mutex);
+
+    cache_it = rule_cache.find(sgid);
+
+    if ( cache_it != rule_cache.end() && cache_it->second->key == key )
+    {
+        expansion = cache_it->second;
+        valid     = true;
+
+        for (gen_it = expansion->vnets.begin();
+             valid && gen_it != expansion->vnets.end(); gen_it++)
+        {
+            valid = (get_generation(gen_it->first) == gen_it->second);
+        }
+
+        if ( valid )
+        {
+            for (it = expansion->rules.begin(); it!=expansion->rules.end(); it++)
+            {
+                rules.push_back((*it)->clone());
+            }
+
+            pthread_mutex_unlock(&cache_mutex);
+
+            for (it = sg_rules.begin(); it != sg_rules.end(); it++)
+            {
+                delete *it;
+            }
+
+            sg_rules.clear();
+
+            return;
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Get the network generations before the expansion, so a concurrent
+    // update of a network leaves the new entry stale
+    // -------------------------------------------------------------------------
+    expansion = new RuleExpansion;
+
+    expansion->key = key;
+
+    for (it = sg_rules.begin(); it != sg_rules.end(); it++)
+    {
+        if ( (*it)->vector_value("NETWORK_ID", vnet_id) != -1 )
+        {
+            expansion->vnets[vnet_id] = get_generation(vnet_id);
+        }
+    }
+
+    pthread_mutex_unlock(&cache_mutex);
+
+    // -------------------------------------------------------------------------
+    // Expand the rules, one for each address range of the network
+    // -------------------------------------------------------------------------
+    for (it = sg_rules.begin(); it != sg_rules.end(); it++)
+    {
+        if ( (*it)->vector_value("NETWORK_ID", vnet_id) == -1 )
+        {
+            expanded.push_back(*it);
+            continue;
+        }
+
+        vnet = vnet_pool->get(vnet_id, true);
+
+        if ( vnet != 0 )
+        {
+            vnet->process_security_rule(*it, expanded);
+
+            vnet->unlock();
+        }
+
+        delete *it;
+    }
+
+    sg_rules.clear();
+
+    for (it = expanded.begin(); it != expanded.end(); it++)
+    {
+        expansion->rules.push_back((*it)->clone());
+    }
+
+    rules.insert(rules.end(), expanded.begin(), expanded.end());
+
+    // -------------------------------------------------------------------------
+    // Store the new expansion
+    // -------------------------------------------------------------------------
+    pthread_mutex_lock(&cache_mutex);
+
+    cache_it = rule_cache.find(sgid);
+
+    if ( cache_it != rule_cache.end() )
+    {
+        delete cache_it->second;
+
+        cache_it->second = expansion;
+    }
+    else
+    {
+        rule_cache.insert(make_pair(sgid, expansion));
+    }
+
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
@@ -57,7 +57,7 @@ bool QuotaVirtualMachine::check(Template * tmpl,
 {
     map<string, float> vm_request;
 
-    int         memory;
+    int         memory, vms;
     float       cpu;
     long long   size;
 
@@ -73,9 +73,14 @@ bool QuotaVirtualMachine::check(Template * tmpl,
         return false;
     }
 
+    if ( tmpl->get("VMS", vms) == false )
+    {
+        vms = 1;
+    }
+
     size = VirtualMachine::get_volatile_disk_size(tmpl);
 
-    vm_request.insert(make_pair("VMS",1));
+    vm_request.insert(make_pair("VMS", vms));
     vm_request.insert(make_pair("MEMORY", memory));
     vm_request.insert(make_pair("CPU", cpu));
     vm_request.insert(make_pair("VOLATILE_SIZE", size));
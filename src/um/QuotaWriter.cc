@@ -0,0 +1,81 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "QuotaWriter.h"
+#include "QuotasSQL.h"
+#include "NebulaLog.h"
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+extern "C" void * quotaw_action_loop(void *arg)
+{
+    QuotaWriter * quotaw;
+
+    if ( arg == 0 )
+    {
+        return 0;
+    }
+
+    NebulaLog::log("QUO",Log::INFO,"Quota Writer started.");
+
+    quotaw = static_cast<QuotaWriter *>(arg);
+
+    quotaw->am.loop(quotaw->timer_period,0);
+
+    NebulaLog::log("QUO",Log::INFO,"Quota Writer stopped.");
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int QuotaWriter::start()
+{
+    pthread_attr_t pattr;
+
+    NebulaLog::log("QUO",Log::INFO,"Starting Quota Writer...");
+
+    pthread_attr_init (&pattr);
+    pthread_attr_setdetachstate (&pattr, PTHREAD_CREATE_JOINABLE);
+
+    return pthread_create(&quotaw_thread,&pattr,quotaw_action_loop,(void *)this);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void QuotaWriter::do_action(const string &action, void * arg)
+{
+    if (action == ACTION_TIMER)
+    {
+        QuotasSQL::flush(db);
+    }
+    else if (action == ACTION_FINALIZE)
+    {
+        NebulaLog::log("QUO",Log::INFO,"Stopping Quota Writer...");
+
+        QuotasSQL::flush(db);
+    }
+    else
+    {
+        ostringstream oss;
+        oss << "Unknown action name: " << action;
+
+        NebulaLog::log("QUO", Log::ERROR, oss);
+    }
+}
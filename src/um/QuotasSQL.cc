@@ -22,6 +22,21 @@
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+const unsigned int QuotasSQL::FLUSH_BATCH_SIZE = 100;
+
+bool QuotasSQL::write_behind = true;
+
+map<string, map<int, string> > QuotasSQL::pending;
+
+pthread_mutex_t QuotasSQL::pending_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+pthread_mutex_t QuotasSQL::flush_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+map<string, ChangeLog *> QuotasSQL::change_logs;
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 string& QuotasSQL::to_xml_db(string& xml) const
 {
     ostringstream oss;
@@ -58,6 +73,14 @@ int QuotasSQL::select(SqlDB * db)
 {
     ostringstream   oss;
     int             rc;
+    string          body;
+
+    // Quotas not yet written are newer than the DB ones. There are no
+    // pending Quotas in a federation, so the usage of other zones is read
+    if ( write_behind && get_pending(body) )
+    {
+        return from_xml(body);
+    }
 
     set_callback(static_cast<Callbackable::Callback>(&QuotasSQL::select_cb));
 
@@ -163,11 +186,228 @@ int QuotasSQL::drop(SqlDB *db)
     ostringstream oss;
     int rc;
 
+    pthread_mutex_lock(&flush_mutex);
+
+    pthread_mutex_lock(&pending_mutex);
+
+    pending[table()].erase(oid);
+
+    pthread_mutex_unlock(&pending_mutex);
+
     oss << "DELETE FROM " << table()
         << " WHERE " << table_oid_column() << " = " << oid;
 
     rc = db->exec(oss);
 
+    pthread_mutex_unlock(&flush_mutex);
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int QuotasSQL::update_deferred(int _oid, SqlDB * db)
+{
+    string xml_quota;
+
+    oid = _oid;
+
+    to_xml_db(xml_quota);
+
+    if ( !write_behind )
+    {
+        map<int, string> written;
+
+        int rc = update(db);
+
+        if ( rc == 0 )
+        {
+            written.insert(make_pair(oid, xml_quota));
+
+            log_changes(table(), written);
+        }
+
+        return rc;
+    }
+
+    pthread_mutex_lock(&pending_mutex);
+
+    pending[table()][oid] = xml_quota;
+
+    pthread_mutex_unlock(&pending_mutex);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool QuotasSQL::get_pending(string& body)
+{
+    map<string, map<int, string> >::iterator it;
+    map<int, string>::iterator               qit;
+
+    bool found = false;
+
+    pthread_mutex_lock(&pending_mutex);
+
+    it = pending.find(table());
+
+    if ( it != pending.end() )
+    {
+        qit = it->second.find(oid);
+
+        if ( qit != it->second.end() )
+        {
+            body  = qit->second;
+            found = true;
+        }
+    }
+
+    pthread_mutex_unlock(&pending_mutex);
+
+    return found;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int QuotasSQL::write_batch(SqlDB *                  db,
+                           const string&            table,
+                           const map<int, string>&  batch)
+{
+    ostringstream oss;
+    char *        sql_quota_xml;
+
+    map<int, string>::const_iterator it;
+
+    oss << "REPLACE INTO " << table << " VALUES ";
+
+    for ( it = batch.begin(); it != batch.end(); it++ )
+    {
+        sql_quota_xml = db->escape_str(it->second.c_str());
+
+        if ( sql_quota_xml == 0 )
+        {
+            return -1;
+        }
+
+        if ( ObjectXML::validate_xml(sql_quota_xml) != 0 )
+        {
+            db->free_str(sql_quota_xml);
+            return -1;
+        }
+
+        if ( it != batch.begin() )
+        {
+            oss << ",";
+        }
+
+        oss << "(" << it->first << ",'" << sql_quota_xml << "')";
+
+        db->free_str(sql_quota_xml);
+    }
+
+    return db->exec(oss);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void QuotasSQL::log_changes(const string&           table,
+                            const map<int, string>& batch)
+{
+    map<string, ChangeLog *>::iterator cit = change_logs.find(table);
+    map<int, string>::const_iterator   it;
+
+    if ( cit == change_logs.end() || cit->second == 0 )
+    {
+        return;
+    }
+
+    for ( it = batch.begin(); it != batch.end(); it++ )
+    {
+        cit->second->log(it->first);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+int QuotasSQL::flush(SqlDB * db)
+{
+    map<string, map<int, string> >           to_write;
+    map<string, map<int, string> >::iterator it;
+
+    map<int, string>::iterator  qit;
+    map<int, string>::iterator  pit;
+
+    map<int, string>            batch;
+    map<string, map<int, string> > written;
+
+    int rc = 0;
+
+    pthread_mutex_lock(&flush_mutex);
+
+    pthread_mutex_lock(&pending_mutex);
+
+    to_write = pending;
+
+    pthread_mutex_unlock(&pending_mutex);
+
+    for ( it = to_write.begin(); it != to_write.end(); it++ )
+    {
+        for ( qit = it->second.begin(); qit != it->second.end(); )
+        {
+            batch.insert(*qit++);
+
+            if ( batch.size() < FLUSH_BATCH_SIZE && qit != it->second.end() )
+            {
+                continue;
+            }
+
+            if ( write_batch(db, it->first, batch) == 0 )
+            {
+                written[it->first].insert(batch.begin(), batch.end());
+
+                log_changes(it->first, batch);
+            }
+            else
+            {
+                ostringstream oss;
+
+                oss << "Error writing " << batch.size() << " quotas in "
+                    << it->first << ", will retry.";
+
+                NebulaLog::log("ONE", Log::ERROR, oss);
+
+                rc = -1;
+            }
+
+            batch.clear();
+        }
+    }
+
+    // Quotas updated while they were written are kept pending
+    pthread_mutex_lock(&pending_mutex);
+
+    for ( it = written.begin(); it != written.end(); it++ )
+    {
+        map<int, string>& table_pending = pending[it->first];
+
+        for ( qit = it->second.begin(); qit != it->second.end(); qit++ )
+        {
+            pit = table_pending.find(qit->first);
+
+            if ( pit != table_pending.end() && pit->second == qit->second )
+            {
+                table_pending.erase(pit);
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&pending_mutex);
+
+    pthread_mutex_unlock(&flush_mutex);
+
     return rc;
 }
 
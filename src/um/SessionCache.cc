@@ -0,0 +1,195 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2014, OpenNebula Project (OpenNebula.org), C12G Labs        */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "SessionCache.h"
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+const unsigned int SessionCache::NUM_SHARDS     = 16;
+
+const unsigned int SessionCache::MAX_SHARD_SIZE = 4096;
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+SessionCache::SessionCache():generation(0)
+{
+    shards = new Shard[NUM_SHARDS];
+
+    for (unsigned int i = 0; i < NUM_SHARDS; i++)
+    {
+        pthread_rwlock_init(&(shards[i].rwlock), 0);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+SessionCache::~SessionCache()
+{
+    for (unsigned int i = 0; i < NUM_SHARDS; i++)
+    {
+        pthread_rwlock_destroy(&(shards[i].rwlock));
+    }
+
+    delete[] shards;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+SessionCache::Shard& SessionCache::shard(const string& session)
+{
+    unsigned int hash = 2166136261U;
+
+    for (string::const_iterator it = session.begin(); it != session.end(); it++)
+    {
+        hash ^= static_cast<unsigned char>(*it);
+        hash *= 16777619U;
+    }
+
+    return shards[hash % NUM_SHARDS];
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+bool SessionCache::get(const string& session,
+                       string&       password,
+                       int&          uid,
+                       int&          gid,
+                       string&       uname,
+                       string&       gname,
+                       set<int>&     group_ids,
+                       int&          umask)
+{
+    map<string, Session>::iterator it;
+
+    Shard& sh = shard(session);
+    bool   found = false;
+
+    pthread_rwlock_rdlock(&sh.rwlock);
+
+    it = sh.sessions.find(session);
+
+    if ( it != sh.sessions.end() && it->second.expiration > time(0) )
+    {
+        password  = it->second.password;
+        uid       = it->second.uid;
+        gid       = it->second.gid;
+        uname     = it->second.uname;
+        gname     = it->second.gname;
+        group_ids = it->second.group_ids;
+        umask     = it->second.umask;
+
+        found = true;
+    }
+
+    pthread_rwlock_unlock(&sh.rwlock);
+
+    return found;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void SessionCache::insert(const string&   session,
+                          unsigned long   _generation,
+                          time_t          expiration,
+                          const string&   password,
+                          int             uid,
+                          int             gid,
+                          const string&   uname,
+                          const string&   gname,
+                          const set<int>& group_ids,
+                          int             umask)
+{
+    map<string, Session>::iterator it;
+
+    Shard& sh  = shard(session);
+    time_t the_time = time(0);
+
+    if ( expiration <= the_time )
+    {
+        return;
+    }
+
+    pthread_rwlock_wrlock(&sh.rwlock);
+
+    // A user has been invalidated since it was read
+    if ( _generation != get_generation() )
+    {
+        pthread_rwlock_unlock(&sh.rwlock);
+        return;
+    }
+
+    if ( sh.sessions.size() >= MAX_SHARD_SIZE )
+    {
+        for ( it = sh.sessions.begin(); it != sh.sessions.end(); )
+        {
+            if ( it->second.expiration <= the_time )
+            {
+                sh.sessions.erase(it++);
+            }
+            else
+            {
+                it++;
+            }
+        }
+    }
+
+    Session& entry = sh.sessions[session];
+
+    entry.expiration = expiration;
+    entry.password   = password;
+    entry.uid        = uid;
+    entry.gid        = gid;
+    entry.uname      = uname;
+    entry.gname      = gname;
+    entry.group_ids  = group_ids;
+    entry.umask      = umask;
+
+    pthread_rwlock_unlock(&sh.rwlock);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void SessionCache::invalidate(int uid)
+{
+    map<string, Session>::iterator it;
+
+    __sync_fetch_and_add(&generation, 1);
+
+    for (unsigned int i = 0; i < NUM_SHARDS; i++)
+    {
+        pthread_rwlock_wrlock(&(shards[i].rwlock));
+
+        for ( it = shards[i].sessions.begin(); it != shards[i].sessions.end(); )
+        {
+            if ( it->second.uid == uid )
+            {
+                shards[i].sessions.erase(it++);
+            }
+            else
+            {
+                it++;
+            }
+        }
+
+        pthread_rwlock_unlock(&(shards[i].rwlock));
+    }
+}
@@ -57,7 +57,7 @@ UserPool::UserPool(SqlDB * db,
                    vector<const Attribute *> hook_mads,
                    const string&             remotes_location,
                    bool                      is_federation_slave):
-                       PoolSQL(db, User::table, !is_federation_slave, true)
+                       PoolSQL(db, User::table, true, true), sessions(0)
 {
     int           one_uid    = -1;
     int           server_uid = -1;
@@ -80,6 +80,20 @@ UserPool::UserPool(SqlDB * db,
 
     _session_expiration_time = __session_expiration_time;
 
+    // Slaves check the cached users against the changes done by the master
+    if (nd.is_federation_enabled())
+    {
+        enable_change_log(is_federation_slave);
+
+        // Quota usage is written by every zone, and cached with the user
+        UserQuotas::set_change_log(UserQuotas::db_table, get_change_log());
+    }
+
+    if (!is_federation_slave)
+    {
+        sessions = new SessionCache();
+    }
+
     User * oneadmin_user = get(0, true);
 
     //Slaves do not need to init the pool, just the oneadmin username
@@ -382,7 +396,14 @@ int UserPool::drop(PoolObjectSQL * objsql, string& error_msg)
         return -1;
     }
 
-    return PoolSQL::drop(objsql, error_msg);
+    int rc = PoolSQL::drop(objsql, error_msg);
+
+    if ( rc == 0 )
+    {
+        invalidate_sessions(objsql->get_oid());
+    }
+
+    return rc;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -399,7 +420,16 @@ int UserPool::update(User * user)
         return -1;
     }
 
-    return user->update(db);
+    int rc = user->update(db);
+
+    if ( rc == 0 )
+    {
+        log_change(user->get_oid());
+    }
+
+    invalidate_sessions(user->get_oid());
+
+    return rc;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -407,6 +437,8 @@ int UserPool::update(User * user)
 
 int UserPool::update_quotas(User * user)
 {
+    // The change is recorded in the change log (master and slaves) by
+    // QuotasSQL, once the quotas are written in the DB
     return user->update_quotas(db);
 }
 
@@ -421,7 +453,8 @@ bool UserPool::authenticate_internal(User *        user,
                                      string&       uname,
                                      string&       gname,
                                      set<int>&     group_ids,
-                                     int&          umask)
+                                     int&          umask,
+                                     time_t&       expiration)
 {
     bool result = false;
 
@@ -446,12 +479,29 @@ bool UserPool::authenticate_internal(User *        user,
 
     auth_driver = user->auth_driver;
 
+    expiration = 0;
+
     //Check if token is a login token
     result = user->login_token.is_valid(token);
 
-    if (!result) //Not a login token check if the token is a session token
+    if (result)
+    {
+        expiration = user->login_token.get_expiration_time();
+    }
+    else //Not a login token check if the token is a session token
     {
         result = user->session.is_valid(token);
+
+        if (result)
+        {
+            expiration = user->session.get_expiration_time();
+        }
+    }
+
+    // Never expiring tokens are cached as a regular session
+    if (expiration == -1)
+    {
+        expiration = time(0) + _session_expiration_time;
     }
 
     umask = user->get_umask();
@@ -501,6 +551,9 @@ bool UserPool::authenticate_internal(User *        user,
     if (user != 0)
     {
         user->session.set(token, _session_expiration_time);
+
+        expiration = user->session.get_expiration_time();
+
         user->unlock();
     }
 
@@ -922,6 +975,21 @@ bool UserPool::authenticate(const string& session,
     int  rc;
     bool ar;
 
+    unsigned long generation = 0;
+    time_t        expiration = 0;
+
+    // Sessions already authenticated do not need to get the user
+    if ( sessions != 0 )
+    {
+        if ( sessions->get(session, password, user_id, group_id, uname, gname,
+                           group_ids, umask) )
+        {
+            return true;
+        }
+
+        generation = sessions->get_generation();
+    }
+
     rc = User::split_secret(session,username,token);
 
     if ( rc != 0 )
@@ -943,7 +1011,13 @@ bool UserPool::authenticate(const string& session,
         else
         {
             ar = authenticate_internal(user, token, password, user_id, group_id,
-                uname, gname, group_ids, umask);
+                uname, gname, group_ids, umask, expiration);
+
+            if ( ar && sessions != 0 )
+            {
+                sessions->insert(session, generation, expiration, password,
+                    user_id, group_id, uname, gname, group_ids, umask);
+            }
         }
     }
     else
@@ -135,14 +135,7 @@ const int VirtualMachine::NUM_NO_NIC_DEFAULTS = 4;
 
 int VirtualMachine::select(SqlDB * db)
 {
-    ostringstream   oss;
-    ostringstream   ose;
-
-    string system_dir;
-    int    rc;
-    int    last_seq;
-
-    Nebula& nd = Nebula::instance();
+    int rc;
 
     // Rebuild the VirtualMachine object
     rc = PoolObjectSQL::select(db);
@@ -152,30 +145,42 @@ int VirtualMachine::select(SqlDB * db)
         return rc;
     }
 
-    //Get History Records. Current history is built in from_xml() (if any).
-    if( hasHistory() )
-    {
-        last_seq = history->seq - 1;
+    return select_extra(db);
+}
 
-        for (int i = last_seq; i >= 0; i--)
-        {
-            History * hp;
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
 
-            hp = new History(oid, i);
-            rc = hp->select(db);
+int VirtualMachine::select_extra(SqlDB * db)
+{
+    ostringstream   oss;
+    ostringstream   ose;
 
-            if ( rc != 0)
-            {
-                goto error_previous_history;
-            }
+    string system_dir;
+    int    rc;
+    int    last_seq;
 
-            history_records[i] = hp;
+    Nebula& nd = Nebula::instance();
 
-            if ( i == last_seq )
-            {
-                previous_history = hp;
-            }
+    //Get the previous History Record. Current history is built in from_xml()
+    //(if any). Older records are read on demand by select_history()
+    if( hasHistory() && history->seq > 0 )
+    {
+        History * hp;
+
+        last_seq = history->seq - 1;
+
+        hp = new History(oid, last_seq);
+        rc = hp->select(db);
+
+        if ( rc != 0)
+        {
+            delete hp;
+            goto error_previous_history;
         }
+
+        history_records[last_seq] = hp;
+        previous_history          = hp;
     }
 
     if ( state == DONE ) //Do not recreate dirs. They may be deleted
@@ -246,6 +251,75 @@ error_previous_history:
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int VirtualMachine::select_history_cb(void *nil, int num, char **values,
+        char **names)
+{
+    History * hp;
+
+    if ( (!values[0]) || (num != 1) )
+    {
+        return -1;
+    }
+
+    hp = new History(oid);
+
+    if ( hp->from_xml(values[0]) != 0 || hp->seq < 0 ||
+         hp->seq >= static_cast<int>(history_records.size()) )
+    {
+        delete hp;
+        return -1;
+    }
+
+    if ( history_records[hp->seq] != 0 ) //Already in memory
+    {
+        delete hp;
+        return 0;
+    }
+
+    hp->non_persistent_data();
+
+    history_records[hp->seq] = hp;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int VirtualMachine::select_history(SqlDB * db)
+{
+    ostringstream oss;
+    int           rc;
+    int           last_seq = -1;
+
+    for (unsigned int i = 0; i < history_records.size(); i++)
+    {
+        if ( history_records[i] == 0 )
+        {
+            last_seq = i;
+        }
+    }
+
+    if ( last_seq == -1 ) //All the records are already loaded
+    {
+        return 0;
+    }
+
+    oss << "SELECT body FROM " << History::table << " WHERE vid = " << oid
+        << " AND seq <= " << last_seq << " ORDER BY seq";
+
+    set_callback(static_cast<Callbackable::Callback>(
+                &VirtualMachine::select_history_cb));
+
+    rc = db->exec(oss, this);
+
+    unset_callback();
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int VirtualMachine::insert(SqlDB * db, string& error_str)
 {
     int    rc;
@@ -2856,13 +2930,8 @@ void VirtualMachine::get_security_group_rules(int id, set<int>& secgroups,
     SecurityGroup*     sgroup;
     SecurityGroupPool* sgroup_pool = Nebula::instance().get_secgrouppool();
 
-    vector<VectorAttribute*>::iterator rule_it;
     vector<VectorAttribute*> sgroup_rules;
 
-    int                 vnet_id;
-    VirtualNetwork*     vnet;
-    VirtualNetworkPool* vnet_pool = Nebula::instance().get_vnpool();
-
     for (sg_it = secgroups.begin(); sg_it != secgroups.end(); sg_it++, sgroup_rules.clear())
     {
         sgroup = sgroup_pool->get(*sg_it, true);
@@ -2880,34 +2949,7 @@ void VirtualMachine::get_security_group_rules(int id, set<int>& secgroups,
 
         sgroup->unlock();
 
-        for (rule_it = sgroup_rules.begin(); rule_it != sgroup_rules.end(); rule_it++)
-        {
-            if ( (*rule_it)->vector_value("NETWORK_ID", vnet_id) != -1 )
-            {
-                vector<VectorAttribute*> vnet_rules;
-
-                VectorAttribute * rule = *rule_it;
-
-                vnet = vnet_pool->get(vnet_id, true);
-
-                if (vnet == 0)
-                {
-                    continue;
-                }
-
-                vnet->process_security_rule(rule, vnet_rules);
-
-                delete rule;
-
-                rules.insert(rules.end(), vnet_rules.begin(), vnet_rules.end());
-
-                vnet->unlock();
-            }
-            else
-            {
-                rules.push_back(*rule_it);
-            }
-        }
+        sgroup_pool->expand_rules(*sg_it, sgroup_rules, rules);
     }
 }
 
@@ -3675,6 +3717,11 @@ string& VirtualMachine::to_xml_extended(string& xml, int n_history) const
         {
             for (unsigned int i=0; i < history_records.size(); i++)
             {
+                if ( history_records[i] == 0 ) //Not read, see select_history
+                {
+                    continue;
+                }
+
                 oss << history_records[i]->to_xml(history_xml);
             }
         }
@@ -21,38 +21,67 @@
 // -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
 
-map<int,VirtualMachineStateMapHook::VmStates>
-                                     VirtualMachineStateMapHook::vm_states;
+void VirtualMachineStateHook::execute(VirtualMachine * vm,
+            VirtualMachine::VmState prev_dm, VirtualMachine::LcmState prev_lcm)
+{
+    HookExecution * he;
+
+    if ( remote && !vm->hasHistory() )
+    {
+        return;
+    }
+
+    he = new_execution(vm);
+
+    VirtualMachine::vm_state_to_str(he->prev_state, prev_dm);
+    VirtualMachine::lcm_state_to_str(he->prev_lcm_state, prev_lcm);
+
+    if ( remote )
+    {
+        he->hostname = vm->get_hostname();
+    }
+
+    Hook::execute(he);
+}
 
+// -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
 
-int VirtualMachineStateMapHook::get_state(int id,
-        VirtualMachine::LcmState &lcm_state,
-        VirtualMachine::VmState  &vm_state)
+VirtualMachineUpdateStateHook::~VirtualMachineUpdateStateHook()
 {
-    map<int,VmStates>::iterator it;
+    multimap<pair<int,int>, VirtualMachineStateHook *>::iterator it;
 
-    it = vm_states.find(id);
-
-    if ( it == vm_states.end() )
+    for (it = state_hooks.begin(); it != state_hooks.end(); ++it)
     {
-        return -1;
+        delete it->second;
     }
 
-    lcm_state = it->second.lcm;
-    vm_state  = it->second.vm;
+    pthread_mutex_destroy(&mutex);
+}
+
+// -----------------------------------------------------------------------------
 
-    return 0;
+void VirtualMachineUpdateStateHook::add_state_hook(
+        VirtualMachineStateHook * hook)
+{
+    pair<int,int> key(hook->get_state(), hook->get_lcm_state());
+
+    state_hooks.insert(make_pair(key, hook));
 }
 
 // -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
 
-void VirtualMachineStateMapHook::update_state (int id,
-        VirtualMachine::LcmState lcm_state,
-        VirtualMachine::VmState  vm_state)
+int VirtualMachineUpdateStateHook::update_state (int id,
+        VirtualMachine::LcmState  lcm_state,
+        VirtualMachine::VmState   vm_state,
+        VirtualMachine::LcmState& prev_lcm,
+        VirtualMachine::VmState&  prev_vm)
 {
     map<int,VmStates>::iterator it;
+    int rc = 0;
+
+    pthread_mutex_lock(&mutex);
 
     it = vm_states.find(id);
 
@@ -61,9 +90,14 @@ void VirtualMachineStateMapHook::update_state (int id,
         VmStates states(lcm_state, vm_state);
 
         vm_states.insert(make_pair(id,states));
+
+        rc = -1;
     }
     else
     {
+        prev_lcm = it->second.lcm;
+        prev_vm  = it->second.vm;
+
         if ( vm_state == VirtualMachine::DONE )
         {
             vm_states.erase(it);
@@ -74,115 +108,52 @@ void VirtualMachineStateMapHook::update_state (int id,
             it->second.vm  = vm_state;
         }
     }
+
+    pthread_mutex_unlock(&mutex);
+
+    return rc;
 }
 
 // -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
 
-void VirtualMachineStateHook::do_hook(void *arg)
+void VirtualMachineUpdateStateHook::do_hook(void *arg)
 {
-
-    VirtualMachine * vm;
-    int              rc;
+    VirtualMachine * vm = static_cast<VirtualMachine *>(arg);
 
     VirtualMachine::LcmState prev_lcm, cur_lcm;
     VirtualMachine::VmState  prev_vm, cur_vm;
 
-    vm = static_cast<VirtualMachine *>(arg);
+    multimap<pair<int,int>, VirtualMachineStateHook *>::iterator it;
+    pair<multimap<pair<int,int>, VirtualMachineStateHook *>::iterator,
+         multimap<pair<int,int>, VirtualMachineStateHook *>::iterator> range;
 
     if ( vm == 0 )
     {
         return;
     }
 
-    rc = get_state(vm->get_oid(), prev_lcm, prev_vm);
-
-    if ( rc != 0 )
-    {
-        return;
-    }
-
     cur_lcm = vm->get_lcm_state();
     cur_vm  = vm->get_state();
 
-    if ( prev_lcm == cur_lcm && prev_vm == cur_vm ) //Still in the same state
+    if ( update_state(vm->get_oid(), cur_lcm, cur_vm, prev_lcm, prev_vm) != 0 )
     {
         return;
     }
 
-    if ( cur_lcm == lcm && cur_vm == this->vm )
-    {
-        string  parsed_args = args;
-
-        parse_hook_arguments(vm, prev_vm, prev_lcm, parsed_args);
-
-        Nebula& ne        = Nebula::instance();
-        HookManager * hm  = ne.get_hm();
-
-        const HookManagerDriver * hmd = hm->get();
-
-        if ( hmd != 0 )
-        {
-            if ( ! remote )
-            {
-                hmd->execute(vm->get_oid(),name,cmd,parsed_args);
-            }
-            else if ( vm->hasHistory() )
-            {
-                hmd->execute(vm->get_oid(),
-                     name,
-                     vm->get_hostname(),
-                     cmd,
-                     parsed_args);
-            }
-        }
-    }
-}
-// -----------------------------------------------------------------------------
-// -----------------------------------------------------------------------------
-
-void VirtualMachineStateHook::parse_hook_arguments(PoolObjectSQL * obj,
-            VirtualMachine::VmState prev_dm, VirtualMachine::LcmState prev_lcm,
-            string& parsed)
-{
-    Hook::parse_hook_arguments(obj, parsed);
-
-    size_t  found;
-
-    found = parsed.find("$PREV_STATE");
-
-    if ( found !=string::npos )
-    {
-        string str;
-
-        parsed.replace(found, 11, VirtualMachine::vm_state_to_str(str, prev_dm));
-    }
-
-    found = parsed.find("$PREV_LCM_STATE");
-
-    if ( found != string::npos )
+    if ( prev_lcm == cur_lcm && prev_vm == cur_vm ) //Still in the same state
     {
-        string str;
-
-        parsed.replace(found, 15, VirtualMachine::lcm_state_to_str(str, prev_lcm));
+        return;
     }
-}
 
-// -----------------------------------------------------------------------------
-// -----------------------------------------------------------------------------
+    range = state_hooks.equal_range(make_pair(static_cast<int>(cur_vm),
+                                              static_cast<int>(cur_lcm)));
 
-void VirtualMachineUpdateStateHook::do_hook(void *arg)
-{
-    VirtualMachine * vm = static_cast<VirtualMachine *>(arg);
-
-    if ( vm == 0 )
+    for (it = range.first; it != range.second; ++it)
     {
-        return;
+        it->second->execute(vm, prev_vm, prev_lcm);
     }
-
-    update_state(vm->get_oid(), vm->get_lcm_state(), vm->get_state());
 }
 
 // -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
-
@@ -18,8 +18,10 @@
 #include "VirtualMachineHook.h"
 
 #include "NebulaLog.h"
+#include "Nebula.h"
 
 #include <sstream>
+#include <algorithm>
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
@@ -48,7 +50,8 @@ VirtualMachinePool::VirtualMachinePool(
     string arg;
     bool   remote;
 
-    bool state_hook = false;
+    VirtualMachineUpdateStateHook * state_hooks =
+        new VirtualMachineUpdateStateHook();
 
     _monitor_expiration = expire_time;
     _submit_on_hold = on_hold;
@@ -116,9 +119,7 @@ VirtualMachinePool::VirtualMachinePool(
 
             hook = new VirtualMachineStateHook(name, cmd, arg, remote,
                            VirtualMachine::PROLOG, VirtualMachine::ACTIVE);
-            add_hook(hook);
-
-            state_hook = true;
+            state_hooks->add_state_hook(hook);
         }
         else if ( on == "RUNNING" )
         {
@@ -126,9 +127,7 @@ VirtualMachinePool::VirtualMachinePool(
 
             hook = new VirtualMachineStateHook(name, cmd, arg, remote,
                            VirtualMachine::RUNNING, VirtualMachine::ACTIVE);
-            add_hook(hook);
-
-            state_hook = true;
+            state_hooks->add_state_hook(hook);
         }
         else if ( on == "SHUTDOWN" )
         {
@@ -136,9 +135,7 @@ VirtualMachinePool::VirtualMachinePool(
 
             hook = new VirtualMachineStateHook(name, cmd, arg, remote,
                             VirtualMachine::EPILOG, VirtualMachine::ACTIVE);
-            add_hook(hook);
-
-            state_hook = true;
+            state_hooks->add_state_hook(hook);
         }
         else if ( on == "STOP" )
         {
@@ -146,9 +143,7 @@ VirtualMachinePool::VirtualMachinePool(
 
             hook = new VirtualMachineStateHook(name, cmd, arg, remote,
                             VirtualMachine::LCM_INIT, VirtualMachine::STOPPED);
-            add_hook(hook);
-
-            state_hook = true;
+            state_hooks->add_state_hook(hook);
         }
         else if ( on == "DONE" )
         {
@@ -156,9 +151,7 @@ VirtualMachinePool::VirtualMachinePool(
 
             hook = new VirtualMachineStateHook(name, cmd, arg, remote,
                             VirtualMachine::LCM_INIT, VirtualMachine::DONE);
-            add_hook(hook);
-
-            state_hook = true;
+            state_hooks->add_state_hook(hook);
         }
         else if ( on == "FAILED" )
         {
@@ -166,9 +159,7 @@ VirtualMachinePool::VirtualMachinePool(
 
             hook = new VirtualMachineStateHook(name, cmd, arg, remote,
                             VirtualMachine::LCM_INIT, VirtualMachine::FAILED);
-            add_hook(hook);
-
-            state_hook = true;
+            state_hooks->add_state_hook(hook);
         }
         else if ( on == "UNKNOWN" )
         {
@@ -176,9 +167,7 @@ VirtualMachinePool::VirtualMachinePool(
 
             hook = new VirtualMachineStateHook(name, cmd, arg, remote,
                             VirtualMachine::UNKNOWN, VirtualMachine::ACTIVE);
-            add_hook(hook);
-
-            state_hook = true;
+            state_hooks->add_state_hook(hook);
         }
         else if ( on == "CUSTOM" )
         {
@@ -211,9 +200,7 @@ VirtualMachinePool::VirtualMachinePool(
             hook = new VirtualMachineStateHook(name, cmd, arg, remote,
                     lcm_state, vm_state);
 
-            add_hook(hook);
-
-            state_hook = true;
+            state_hooks->add_state_hook(hook);
         }
         else
         {
@@ -224,13 +211,13 @@ VirtualMachinePool::VirtualMachinePool(
         }
     }
 
-    if ( state_hook )
+    if ( state_hooks->empty() )
     {
-        VirtualMachineUpdateStateHook * hook;
-
-        hook = new VirtualMachineUpdateStateHook();
-
-        add_hook(hook);
+        delete state_hooks;
+    }
+    else
+    {
+        add_hook(state_hooks);
     }
 
     // Set restricted attributes
@@ -495,6 +482,241 @@ static string put_time(time_t t)
 
 /* -------------------------------------------------------------------------- */
 
+/* -------------------------------------------------------------------------- */
+/* Showback                                                                   */
+/* -------------------------------------------------------------------------- */
+
+const char * VirtualMachinePool::showback_attr = "SHOWBACK_LAST_RUN";
+
+const int VirtualMachinePool::SHOWBACK_PAGE_SIZE = 1000;
+
+const int VirtualMachinePool::SHOWBACK_BATCH_SIZE = 1000;
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  History data used to compute the showback of a VM
+ */
+struct ShowbackRecord
+{
+    int     vid;
+    int     seq;
+    time_t  stime;
+    time_t  etime;
+    float   cpu;
+    int     mem;
+    float   cpu_cost;
+    float   mem_cost;
+};
+
+/* -------------------------------------------------------------------------- */
+
+int VirtualMachinePool::showback_cb(void * _records, int num, char **values,
+        char **names)
+{
+    vector<ShowbackRecord> * records;
+    ShowbackRecord           record;
+
+    records = static_cast<vector<ShowbackRecord> *>(_records);
+
+    if ( num != 5 || values[0] == 0 || values[1] == 0 || values[2] == 0 ||
+         values[3] == 0 || values[4] == 0 )
+    {
+        return -1;
+    }
+
+    ObjectXML history(values[4]);
+
+    record.vid   = atoi(values[0]);
+    record.seq   = atoi(values[1]);
+    record.stime = static_cast<time_t>(strtoll(values[2], 0, 10));
+    record.etime = static_cast<time_t>(strtoll(values[3], 0, 10));
+
+    history.xpath(record.cpu,      "/HISTORY/VM/TEMPLATE/CPU", 0);
+    history.xpath(record.mem,      "/HISTORY/VM/TEMPLATE/MEMORY", 0);
+
+    history.xpath(record.cpu_cost, "/HISTORY/VM/TEMPLATE/CPU_COST", 0);
+    history.xpath(record.mem_cost, "/HISTORY/VM/TEMPLATE/MEMORY_COST", 0);
+
+    records->push_back(record);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+time_t VirtualMachinePool::get_showback_last_run()
+{
+    string    xml_body;
+    long long last_run;
+
+    Nebula& nd = Nebula::instance();
+
+    if ( nd.select_sys_attribute(showback_attr, xml_body) != 0 )
+    {
+        return -1;
+    }
+
+    ObjectXML xml(xml_body);
+
+    if ( xml.xpath(last_run, "/SHOWBACK_LAST_RUN/TIME", -1) != 0 )
+    {
+        return -1;
+    }
+
+    return static_cast<time_t>(last_run);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int VirtualMachinePool::set_showback_last_run(time_t last_run)
+{
+    ostringstream oss;
+    string        error_str;
+
+    Nebula& nd = Nebula::instance();
+
+    oss << "<" << showback_attr << "><TIME>" << last_run << "</TIME></"
+        << showback_attr << ">";
+
+    return nd.update_sys_attribute(showback_attr, oss.str(), error_str);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int VirtualMachinePool::add_showback(
+        int                              vid,
+        const vector<time_t>&            slots,
+        vector<pair<float, float> >&     totals,
+        vector<bool>&                    used,
+        ostringstream&                   oss,
+        int&                             n_entries,
+        string&                          error_str)
+{
+    VirtualMachine* vm;
+
+    ostringstream   body;
+    char *          sql_body;
+    tm              tmp_tm;
+    int             rc;
+
+    int    uid    = 0;
+    int    gid    = 0;
+    string uname  = "";
+    string gname  = "";
+    string vmname = "";
+
+    if ( vid == -1 )
+    {
+        return 0;
+    }
+
+    vm = get(vid, true);
+
+    if (vm != 0)
+    {
+        uid = vm->get_uid();
+        gid = vm->get_gid();
+
+        uname = vm->get_uname();
+        gname = vm->get_gname();
+
+        vmname = vm->get_name();
+
+        vm->unlock();
+    }
+
+    for (unsigned int i = 0; i < used.size(); i++)
+    {
+        if ( !used[i] )
+        {
+            continue;
+        }
+
+        localtime_r(&slots[i], &tmp_tm);
+
+        body.str("");
+
+        string cost  = one_util::float_to_str(totals[i].first);
+        string hours = one_util::float_to_str(totals[i].second);
+
+        body << "<SHOWBACK>"
+                << "<VMID>"     << vid                      << "</VMID>"
+                << "<VMNAME>"   << vmname                   << "</VMNAME>"
+                << "<UID>"      << uid                      << "</UID>"
+                << "<GID>"      << gid                      << "</GID>"
+                << "<UNAME>"    << uname                    << "</UNAME>"
+                << "<GNAME>"    << gname                    << "</GNAME>"
+                << "<YEAR>"     << tmp_tm.tm_year + 1900    << "</YEAR>"
+                << "<MONTH>"    << tmp_tm.tm_mon + 1        << "</MONTH>"
+                << "<COST>"     << cost                     << "</COST>"
+                << "<HOURS>"    << hours                    << "</HOURS>"
+            << "</SHOWBACK>";
+
+        sql_body =  db->escape_str(body.str().c_str());
+
+        if ( sql_body == 0 )
+        {
+            error_str = "Error creating XML body.";
+            return -1;
+        }
+
+        if (n_entries == 0)
+        {
+            oss.str("");
+            oss << "REPLACE INTO " << VirtualMachine::showback_table
+                << " ("<< VirtualMachine::showback_db_names <<") VALUES ";
+        }
+        else
+        {
+            oss << ",";
+        }
+
+        oss << " (" <<  vid                     << ","
+            <<          tmp_tm.tm_year + 1900   << ","
+            <<          tmp_tm.tm_mon + 1       << ","
+            << "'"  <<  sql_body                << "')";
+
+        db->free_str(sql_body);
+
+        n_entries++;
+
+        // To avoid the oss to grow indefinitely, flush contents
+        if (n_entries == SHOWBACK_BATCH_SIZE)
+        {
+            rc = db->exec(oss);
+
+            if (rc != 0)
+            {
+                error_str = "Error writing to DB.";
+                return -1;
+            }
+
+            n_entries = 0;
+        }
+
+#ifdef SBDDEBUG
+        ostringstream debug;
+
+        debug << "VM " << vid
+            << " cost for Y " << tmp_tm.tm_year + 1900
+            << " M " << tmp_tm.tm_mon + 1
+            << " COST " << cost << " €"
+            << " HOURS " << hours;
+
+        NebulaLog::log("SHOWBACK", Log::DEBUG, debug);
+#endif
+        totals[i] = make_pair(0, 0);
+        used[i]   = false;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int VirtualMachinePool::calculate_showback(
         int start_month,
         int start_year,
@@ -502,36 +724,34 @@ int VirtualMachinePool::calculate_showback(
         int end_year,
         string &error_str)
 {
-    vector<xmlNodePtr>              nodes;
-    vector<xmlNodePtr>::iterator    node_it;
-
-    vector<time_t>                  showback_slots;
-    vector<time_t>::iterator        slot_it;
+    vector<ShowbackRecord>           records;
+    vector<ShowbackRecord>::iterator rec_it;
 
-    // map<vid, map<month, pair<total_cost, n_hours> > >
-    map<int, map<time_t, pair<float,float> > >            vm_cost;
-    map<int, map<time_t, pair<float, float> > >::iterator vm_it;
-    map<time_t, pair<float,float> >::iterator vm_month_it;
+    vector<time_t>                   showback_slots;
+    vector<time_t>::iterator         slot_it;
 
-    VirtualMachine* vm;
+    // Totals of the VM being processed, per slot <total_cost, n_hours>
+    vector<pair<float,float> >       totals;
+    vector<bool>                     used;
 
     int             rc;
     ostringstream   oss;
-    ostringstream   body;
-    char *          sql_body;
+    ostringstream   cmd;
 
     tm      tmp_tm;
-    int     vid;
-    int     h_stime;
-    int     h_etime;
-    float   cpu_cost;
-    float   mem_cost;
-    float   cpu;
-    int     mem;
+    int     vid      = -1;
+    int     last_vid = -1;
+    int     last_seq = -1;
+    int     n_entries = 0;
+
+    time_t  last_run;
+    time_t  last_run_month = -1;
+    bool    incremental    = false;
 
 #ifdef SBDEBUG
     ostringstream debug;
     time_t debug_t_0 = time(0);
+    int    debug_n   = 0;
 #endif
 
     //--------------------------------------------------------------------------
@@ -540,8 +760,26 @@ int VirtualMachinePool::calculate_showback(
 
     tzset();
 
-    time_t start_time = time(0);
-    time_t end_time   = time(0);
+    time_t now        = time(0);
+    time_t start_time = now;
+    time_t end_time   = now;
+
+    last_run = get_showback_last_run();
+
+    if ( last_run != -1 )
+    {
+        // First day of the month of the last run. Records closed before it
+        // were completely processed by the last run
+        localtime_r(&last_run, &tmp_tm);
+
+        tmp_tm.tm_sec  = 0;
+        tmp_tm.tm_min  = 0;
+        tmp_tm.tm_hour = 0;
+        tmp_tm.tm_mday = 1;
+        tmp_tm.tm_isdst = -1;
+
+        last_run_month = mktime(&tmp_tm);
+    }
 
     if (start_month != -1 && start_year != -1)
     {
@@ -556,6 +794,13 @@ int VirtualMachinePool::calculate_showback(
 
         start_time = mktime(&tmp_tm);
     }
+    else if ( last_run_month != -1 )
+    {
+        // Incremental run, only the history records still open or closed
+        // after the last run are processed
+        start_time  = last_run_month;
+        incremental = true;
+    }
     else
     {
         // Set start time to the lowest stime from the history records
@@ -589,19 +834,6 @@ int VirtualMachinePool::calculate_showback(
         }
     }
 
-    //--------------------------------------------------------------------------
-    // Get accounting history records
-    //--------------------------------------------------------------------------
-
-    oss.str("");
-    rc = dump_acct(oss, "", start_time, end_time);
-
-    ObjectXML xml(oss.str());
-
-#ifdef SBDEBUG
-    time_t debug_t_1 = time(0);
-#endif
-
     //--------------------------------------------------------------------------
     // Create the monthly time slots
     //--------------------------------------------------------------------------
@@ -631,6 +863,14 @@ int VirtualMachinePool::calculate_showback(
         tmp_t = mktime(&tmp_tm);
     }
 
+    if ( showback_slots.empty() )
+    {
+        return 0;
+    }
+
+    totals.resize(showback_slots.size(), make_pair(0.0f, 0.0f));
+    used.resize(showback_slots.size(), false);
+
     // Extra slot that won't be used. Is needed only to calculate the time
     // for the second-to-last slot
     showback_slots.push_back(end_time);
@@ -645,198 +885,123 @@ int VirtualMachinePool::calculate_showback(
 #endif
 
     //--------------------------------------------------------------------------
-    // Process the history records
+    // Process the history records, read in pages ordered by (vid, seq). The
+    // totals are kept only for the VM being processed, and written to the DB
+    // when the next VM is found. The callback is set only for each page
+    // query, so the VMs are not locked (add_showback) while holding it.
     //--------------------------------------------------------------------------
 
-    rc = xml.get_nodes("/HISTORY_RECORDS/HISTORY", nodes);
-
-    for ( node_it = nodes.begin(); node_it != nodes.end(); node_it++ )
+    do
     {
-        ObjectXML history(*node_it);
+        records.clear();
 
-        history.xpath(vid,      "/HISTORY/OID", -1);
+        cmd.str("");
 
-        history.xpath(h_stime,  "/HISTORY/STIME", 0);
-        history.xpath(h_etime,  "/HISTORY/ETIME", 0);
+        cmd << "SELECT vid, seq, stime, etime, " << History::table << ".body"
+            << " FROM " << History::table << " INNER JOIN "
+            << VirtualMachine::table << " WHERE vid=oid"
+            << " AND (etime > " << start_time << " OR etime = 0)"
+            << " AND stime < " << end_time
+            << " AND (vid > " << last_vid
+            << " OR (vid = " << last_vid << " AND seq > " << last_seq << "))"
+            << " ORDER BY vid,seq LIMIT " << SHOWBACK_PAGE_SIZE;
 
-        history.xpath(cpu,      "/HISTORY/VM/TEMPLATE/CPU", 0);
-        history.xpath(mem,      "/HISTORY/VM/TEMPLATE/MEMORY", 0);
+        set_callback(static_cast<Callbackable::Callback>(&VirtualMachinePool::showback_cb),
+                     static_cast<void *>(&records));
 
-        history.xpath(cpu_cost, "/HISTORY/VM/TEMPLATE/CPU_COST", 0);
-        history.xpath(mem_cost, "/HISTORY/VM/TEMPLATE/MEMORY_COST", 0);
-
-#ifdef SBDDEBUG
-        int seq;
-        history.xpath(seq, "/HISTORY/SEQ", -1);
-
-        debug.str("");
-        debug << "VM " << vid << " SEQ " << seq << endl
-            << "h_stime   " << h_stime << endl
-            << "h_etime   " << h_etime << endl
-            << "cpu_cost  " << cpu_cost << endl
-            << "mem_cost  " << mem_cost << endl
-            << "cpu       " << cpu << endl
-            << "mem       " << mem;
+        rc = db->exec(cmd, this);
 
-        NebulaLog::log("SHOWBACK", Log::DEBUG, debug);
-#endif
+        unset_callback();
 
-        for ( slot_it = showback_slots.begin(); slot_it != showback_slots.end()-1; slot_it++ )
+        if ( rc != 0 )
         {
-            time_t t      = *slot_it;
-            time_t t_next = *(slot_it+1);
-
-            if( (h_etime > t || h_etime == 0) &&
-                (h_stime != 0 && h_stime <= t_next) ) {
-
-                time_t stime = t;
-                if(h_stime != 0){
-                    stime = (t < h_stime) ? h_stime : t; //max(t, h_stime);
-                }
-
-                time_t etime = t_next;
-                if(h_etime != 0){
-                    etime = (t_next < h_etime) ? t_next : h_etime; //min(t_next, h_etime);
-                }
-
-                float n_hours = difftime(etime, stime) / 60 / 60;
-
-                float cost = 0;
-
-                cost += cpu_cost * cpu * n_hours;
-                cost += mem_cost * mem * n_hours;
+            error_str = "Error reading the history records.";
+            return -1;
+        }
 
-                // Add to vm time slot.
-                map<time_t, pair<float,float> >& totals = vm_cost[vid];
+        for ( rec_it = records.begin(); rec_it != records.end(); rec_it++ )
+        {
+            time_t h_stime = rec_it->stime;
+            time_t h_etime = rec_it->etime;
 
-                if(totals.count(t) == 0)
+            if ( rec_it->vid != vid )
+            {
+                if ( add_showback(vid, showback_slots, totals, used, oss,
+                            n_entries, error_str) != 0 )
                 {
-                    totals[t] = make_pair(0,0);
+                    return -1;
                 }
 
-                totals[t].first  += cost;
-                totals[t].second += n_hours;
+                vid = rec_it->vid;
             }
-        }
-    }
-
-    xml.free_nodes(nodes);
 
 #ifdef SBDEBUG
-    time_t debug_t_2 = time(0);
+            debug_n++;
 #endif
-
-    // Write to DB
-
-    oss.str("");
-    oss << "REPLACE INTO " << VirtualMachine::showback_table
-        << " ("<< VirtualMachine::showback_db_names <<") VALUES ";
-
-    int n_entries = 0;
-
-    for ( vm_it = vm_cost.begin(); vm_it != vm_cost.end(); vm_it++ )
-    {
-        map<time_t, pair<float,float> >& totals = vm_it->second;
-
-        for ( vm_month_it = totals.begin(); vm_month_it != totals.end(); vm_month_it++ )
-        {
-            int vmid = vm_it->first;
-
-            vm = get(vmid, true);
-
-            int uid = 0;
-            int gid = 0;
-            string uname = "";
-            string gname = "";
-            string vmname = "";
-
-            if (vm != 0)
+            if ( h_stime == 0 )
             {
-                uid = vm->get_uid();
-                gid = vm->get_gid();
-
-                uname = vm->get_uname();
-                gname = vm->get_gname();
-
-                vmname = vm->get_name();
-
-                vm->unlock();
+                continue;
             }
 
-            localtime_r(&vm_month_it->first, &tmp_tm);
-
-            body.str("");
-
-            string cost  = one_util::float_to_str(vm_month_it->second.first);
-            string hours = one_util::float_to_str(vm_month_it->second.second);
-
-            body << "<SHOWBACK>"
-                    << "<VMID>"     << vmid                     << "</VMID>"
-                    << "<VMNAME>"   << vmname                   << "</VMNAME>"
-                    << "<UID>"      << uid                      << "</UID>"
-                    << "<GID>"      << gid                      << "</GID>"
-                    << "<UNAME>"    << uname                    << "</UNAME>"
-                    << "<GNAME>"    << gname                    << "</GNAME>"
-                    << "<YEAR>"     << tmp_tm.tm_year + 1900    << "</YEAR>"
-                    << "<MONTH>"    << tmp_tm.tm_mon + 1        << "</MONTH>"
-                    << "<COST>"     << cost                     << "</COST>"
-                    << "<HOURS>"    << hours                    << "</HOURS>"
-                << "</SHOWBACK>";
+            // First slot that ends after the record start time
+            slot_it = lower_bound(showback_slots.begin(),
+                                  showback_slots.end()-1, h_stime);
 
-            sql_body =  db->escape_str(body.str().c_str());
-
-            if ( sql_body == 0 )
+            if ( slot_it != showback_slots.begin() )
             {
-                error_str = "Error creating XML body.";
-                return -1;
+                slot_it--;
             }
 
-            if (n_entries == 0)
-            {
-                oss.str("");
-                oss << "REPLACE INTO " << VirtualMachine::showback_table
-                    << " ("<< VirtualMachine::showback_db_names <<") VALUES ";
-            }
-            else
+            for ( ; slot_it != showback_slots.end()-1; slot_it++ )
             {
-                oss << ",";
-            }
+                time_t t      = *slot_it;
+                time_t t_next = *(slot_it+1);
 
-            oss << " (" <<  vm_it->first            << ","
-                <<          tmp_tm.tm_year + 1900   << ","
-                <<          tmp_tm.tm_mon + 1       << ","
-                << "'"  <<  sql_body                << "')";
-
-            db->free_str(sql_body);
+                if ( h_etime != 0 && h_etime <= t )
+                {
+                    break;
+                }
 
-            n_entries++;
+                if ( h_stime > t_next )
+                {
+                    continue;
+                }
 
-            // To avoid the oss to grow indefinitely, flush contents
-            if (n_entries == 1000)
-            {
-                rc = db->exec(oss);
+                time_t stime = (t < h_stime) ? h_stime : t; //max(t, h_stime);
+                time_t etime = t_next;
 
-                if (rc != 0)
-                {
-                    error_str = "Error writing to DB.";
-                    return -1;
+                if(h_etime != 0){
+                    etime = (t_next < h_etime) ? t_next : h_etime; //min(t_next, h_etime);
                 }
 
-                n_entries = 0;
-            }
+                float n_hours = difftime(etime, stime) / 60 / 60;
 
-#ifdef SBDDEBUG
-            debug.str("");
+                float cost = 0;
 
-            debug << "VM " << vm_it->first
-                << " cost for Y " << tmp_tm.tm_year + 1900
-                << " M " << tmp_tm.tm_mon + 1
-                << " COST " << cost << " €"
-                << " HOURS " << hours;
+                cost += rec_it->cpu_cost * rec_it->cpu * n_hours;
+                cost += rec_it->mem_cost * rec_it->mem * n_hours;
 
-            NebulaLog::log("SHOWBACK", Log::DEBUG, debug);
-#endif            
+                // Add to vm time slot.
+                int i = slot_it - showback_slots.begin();
+
+                totals[i].first  += cost;
+                totals[i].second += n_hours;
+                used[i]           = true;
+            }
         }
+
+        if ( !records.empty() )
+        {
+            last_vid = records.back().vid;
+            last_seq = records.back().seq;
+        }
+    }
+    while ( records.size() == static_cast<unsigned int>(SHOWBACK_PAGE_SIZE) );
+
+    if ( add_showback(vid, showback_slots, totals, used, oss, n_entries,
+                error_str) != 0 )
+    {
+        return -1;
     }
 
     if (n_entries > 0)
@@ -850,19 +1015,22 @@ int VirtualMachinePool::calculate_showback(
         }
     }
 
-#ifdef SBDEBUG
-    time_t debug_t_3 = time(0);
+    //--------------------------------------------------------------------------
+    // Save the time of this run if it covers the next incremental window
+    //--------------------------------------------------------------------------
 
-    debug.str("");
-    debug << "Time to dump acct to mem: " << debug_t_1 - debug_t_0;
-    NebulaLog::log("SHOWBACK", Log::DEBUG, debug);
+    if ( end_time == now && ( incremental ||
+         (last_run_month != -1 && start_time <= last_run_month) ||
+         (start_month == -1 || start_year == -1) ) )
+    {
+        set_showback_last_run(now);
+    }
 
+#ifdef SBDEBUG
     debug.str("");
-    debug << "Time to process numbers:  " << debug_t_2 - debug_t_1;
-    NebulaLog::log("SHOWBACK", Log::DEBUG, debug);
+    debug << "Processed " << debug_n << " history records in "
+          << time(0) - debug_t_0 << "s.";
 
-    debug.str("");
-    debug << "Time to write to db:      " << debug_t_3 - debug_t_2;
     NebulaLog::log("SHOWBACK", Log::DEBUG, debug);
 #endif
 
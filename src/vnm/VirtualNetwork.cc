@@ -28,6 +28,8 @@
 
 #include "NebulaUtil.h"
 
+#include "Nebula.h"
+
 #define TO_UPPER(S) transform(S.begin(),S.end(),S.begin(),(int(*)(int))toupper)
 
 /* ************************************************************************** */
@@ -310,6 +312,21 @@ int VirtualNetwork::post_update_template(string& error)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int VirtualNetwork::drop(SqlDB * db)
+{
+    int rc = PoolObjectSQL::drop(db);
+
+    if ( rc == 0 )
+    {
+        invalidate_security_rules();
+    }
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int VirtualNetwork::insert_replace(SqlDB *db, bool replace, string& error_str)
 {
     ostringstream   oss;
@@ -672,6 +689,8 @@ int VirtualNetwork::add_var(vector<Attribute *> &var, string& error_msg)
 
         VectorAttribute * ar = oar->clone();
 
+        invalidate_security_rules();
+
         if (ar_pool.from_vattr(ar, error_msg) != 0)
         {
             delete ar;
@@ -703,6 +722,8 @@ int VirtualNetwork::add_ar(VirtualNetworkTemplate * ars_tmpl, string& error_msg)
 
     VectorAttribute * nar = ar->clone();
 
+    invalidate_security_rules();
+
     if (ar_pool.from_vattr(nar, error_msg) != 0)
     {
         delete nar;
@@ -731,6 +752,8 @@ int VirtualNetwork::update_ar(
 
     keep_restricted = keep_restricted && is_reservation();
 
+    invalidate_security_rules();
+
     return ar_pool.update_ar(tmp_ars, keep_restricted, error_msg);
 }
 
@@ -739,12 +762,22 @@ int VirtualNetwork::update_ar(
 
 int VirtualNetwork::rm_ar(unsigned int ar_id, string& error_msg)
 {
+    invalidate_security_rules();
+
     return ar_pool.rm_ar(ar_id, error_msg);
 }
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void VirtualNetwork::invalidate_security_rules()
+{
+    Nebula::instance().get_secgrouppool()->invalidate_vnet(oid);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int VirtualNetwork::hold_leases(VirtualNetworkTemplate * leases_template,
                                 string&                  error_msg)
 {
@@ -87,14 +87,27 @@ ObjectXML::~ObjectXML()
 
 vector<string> ObjectXML::operator[] (const char * xpath_expr)
 {
-    xmlXPathObjectPtr obj;
-    vector<string>    content;
+    xmlXPathContextPtr xctx;
+    xmlXPathObjectPtr  obj;
+    vector<string>     content;
+
+    // The shared ctx keeps evaluation state, so each lookup uses its own
+    // context. This way the object can be searched by several threads
+    xctx = xmlXPathNewContext(xml);
+
+    if (xctx == 0)
+    {
+        return content;
+    }
 
     obj = xmlXPathEvalExpression(
-        reinterpret_cast<const xmlChar *>(xpath_expr), ctx);
+        reinterpret_cast<const xmlChar *>(xpath_expr), xctx);
+
+    xmlXPathFreeContext(xctx);
 
     if (obj == 0 || obj->nodesetval == 0)
     {
+        xmlXPathFreeObject(obj);
         return content;
     }
 
@@ -626,15 +639,23 @@ extern "C"
 {
     typedef struct yy_buffer_state * YY_BUFFER_STATE;
 
-    int expr_bool_parse(ObjectXML * oxml, bool& result, char ** errmsg);
+    typedef void * yyscan_t;
+
+    int expr_bool_parse(ObjectXML * oxml, bool& result, char ** errmsg,
+        yyscan_t scanner);
 
-    int expr_arith_parse(ObjectXML * oxml, int& result, char ** errmsg);
+    int expr_arith_parse(ObjectXML * oxml, int& result, char ** errmsg,
+        yyscan_t scanner);
 
-    int expr_lex_destroy();
+    int expr_lex_init(yyscan_t * scanner);
 
-    YY_BUFFER_STATE expr__scan_string(const char * str);
+    int expr_lex_destroy(yyscan_t scanner);
 
-    void expr__delete_buffer(YY_BUFFER_STATE);
+    void expr_set_lineno(int line_number, yyscan_t scanner);
+
+    YY_BUFFER_STATE expr__scan_string(const char * str, yyscan_t scanner);
+
+    void expr__delete_buffer(YY_BUFFER_STATE, yyscan_t scanner);
 }
 
 /* ------------------------------------------------------------------------ */
@@ -643,6 +664,7 @@ extern "C"
 int ObjectXML::eval_bool(const string& expr, bool& result, char **errmsg)
 {
     YY_BUFFER_STATE     str_buffer = 0;
+    yyscan_t            scanner    = 0;
     const char *        str;
     int                 rc;
 
@@ -650,23 +672,34 @@ int ObjectXML::eval_bool(const string& expr, bool& result, char **errmsg)
 
     str = expr.c_str();
 
-    str_buffer = expr__scan_string(str);
+    if ( expr_lex_init(&scanner) != 0 )
+    {
+        *errmsg=strdup("Error initializing scanner");
+
+        return -1;
+    }
+
+    str_buffer = expr__scan_string(str, scanner);
 
     if (str_buffer == 0)
     {
         goto error_yy;
     }
 
-    rc = expr_bool_parse(this,result,errmsg);
+    expr_set_lineno(1, scanner);
 
-    expr__delete_buffer(str_buffer);
+    rc = expr_bool_parse(this, result, errmsg, scanner);
 
-    expr_lex_destroy();
+    expr__delete_buffer(str_buffer, scanner);
+
+    expr_lex_destroy(scanner);
 
     return rc;
 
 error_yy:
 
+    expr_lex_destroy(scanner);
+
     *errmsg=strdup("Error setting scan buffer");
 
     return -1;
@@ -678,6 +711,7 @@ error_yy:
 int ObjectXML::eval_arith(const string& expr, int& result, char **errmsg)
 {
     YY_BUFFER_STATE     str_buffer = 0;
+    yyscan_t            scanner    = 0;
     const char *        str;
     int                 rc;
 
@@ -685,23 +719,34 @@ int ObjectXML::eval_arith(const string& expr, int& result, char **errmsg)
 
     str = expr.c_str();
 
-    str_buffer = expr__scan_string(str);
+    if ( expr_lex_init(&scanner) != 0 )
+    {
+        *errmsg=strdup("Error initializing scanner");
+
+        return -1;
+    }
+
+    str_buffer = expr__scan_string(str, scanner);
 
     if (str_buffer == 0)
     {
         goto error_yy;
     }
 
-    rc = expr_arith_parse(this,result,errmsg);
+    expr_set_lineno(1, scanner);
+
+    rc = expr_arith_parse(this, result, errmsg, scanner);
 
-    expr__delete_buffer(str_buffer);
+    expr__delete_buffer(str_buffer, scanner);
 
-    expr_lex_destroy();
+    expr_lex_destroy(scanner);
 
     return rc;
 
 error_yy:
 
+    expr_lex_destroy(scanner);
+
     *errmsg=strdup("Error setting scan buffer");
 
     return -1;
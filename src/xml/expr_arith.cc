@@ -97,23 +97,27 @@ extern "C"
         ObjectXML *     oxml,
         int&            result,
         char **         error_msg,
+        void *          scanner,
         const char *    str);
 
-    int expr_arith__lex (YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc);
+    int expr_arith__lex (YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc,
+        void * scanner);
 
     int expr_arith__parse(mem_collector * mc,
                           ObjectXML *     oxml,
                           int&            result,
-                          char **         errmsg);
+                          char **         errmsg,
+                          void *          scanner);
 
-    int expr_arith_parse(ObjectXML *oxml, int& result, char ** errmsg)
+    int expr_arith_parse(ObjectXML *oxml, int& result, char ** errmsg,
+        void * scanner)
     {
         mem_collector mc;
         int           rc;
 
         mem_collector_init(&mc);
 
-        rc = expr_arith__parse(&mc,oxml,result,errmsg);
+        rc = expr_arith__parse(&mc,oxml,result,errmsg,scanner);
 
         mem_collector_cleanup(&mc);
 
@@ -122,7 +126,7 @@ extern "C"
 }
 
 
-#line 126 "expr_arith.cc" /* yacc.c:339  */
+#line 130 "expr_arith.cc" /* yacc.c:339  */
 
 # ifndef YY_NULLPTR
 #  if defined __cplusplus && 201103L <= __cplusplus
@@ -168,13 +172,13 @@ extern int expr_arith__debug;
 typedef union YYSTYPE YYSTYPE;
 union YYSTYPE
 {
-#line 78 "expr_arith.y" /* yacc.c:355  */
+#line 84 "expr_arith.y" /* yacc.c:355  */
 
     char *  val_str;
     int     val_int;
     float   val_float;
 
-#line 178 "expr_arith.cc" /* yacc.c:355  */
+#line 182 "expr_arith.cc" /* yacc.c:355  */
 };
 # define YYSTYPE_IS_TRIVIAL 1
 # define YYSTYPE_IS_DECLARED 1
@@ -196,13 +200,13 @@ struct YYLTYPE
 
 
 
-int expr_arith__parse (mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg);
+int expr_arith__parse (mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg, void *      scanner);
 
 #endif /* !YY_EXPR_ARITH_EXPR_ARITH_HH_INCLUDED  */
 
 /* Copy the second part of user declarations.  */
 
-#line 206 "expr_arith.cc" /* yacc.c:358  */
+#line 210 "expr_arith.cc" /* yacc.c:358  */
 
 #ifdef short
 # undef short
@@ -502,8 +506,8 @@ static const yytype_uint8 yytranslate[] =
   /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,   100,   100,   101,   104,   105,   106,   107,   108,   109,
-     110,   111,   112
+       0,   106,   106,   107,   110,   111,   112,   113,   114,   115,
+     116,   117,   118
 };
 #endif
 
@@ -630,7 +634,7 @@ do                                                              \
     }                                                           \
   else                                                          \
     {                                                           \
-      yyerror (&yylloc, mc, oxml, result, error_msg, YY_("syntax error: cannot back up")); \
+      yyerror (&yylloc, mc, oxml, result, error_msg, scanner, YY_("syntax error: cannot back up")); \
       YYERROR;                                                  \
     }                                                           \
 while (0)
@@ -732,7 +736,7 @@ do {                                                                      \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value, Location, mc, oxml, result, error_msg); \
+                  Type, Value, Location, mc, oxml, result, error_msg, scanner); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -743,7 +747,7 @@ do {                                                                      \
 `----------------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg)
+yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg, void *      scanner)
 {
   FILE *yyo = yyoutput;
   YYUSE (yyo);
@@ -752,6 +756,7 @@ yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvalue
   YYUSE (oxml);
   YYUSE (result);
   YYUSE (error_msg);
+  YYUSE (scanner);
   if (!yyvaluep)
     return;
 # ifdef YYPRINT
@@ -767,14 +772,14 @@ yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvalue
 `--------------------------------*/
 
 static void
-yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg)
+yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg, void *      scanner)
 {
   YYFPRINTF (yyoutput, "%s %s (",
              yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
 
   YY_LOCATION_PRINT (yyoutput, *yylocationp);
   YYFPRINTF (yyoutput, ": ");
-  yy_symbol_value_print (yyoutput, yytype, yyvaluep, yylocationp, mc, oxml, result, error_msg);
+  yy_symbol_value_print (yyoutput, yytype, yyvaluep, yylocationp, mc, oxml, result, error_msg, scanner);
   YYFPRINTF (yyoutput, ")");
 }
 
@@ -807,7 +812,7 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule, mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg)
+yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule, mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg, void *      scanner)
 {
   unsigned long int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -821,7 +826,7 @@ yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule
       yy_symbol_print (stderr,
                        yystos[yyssp[yyi + 1 - yynrhs]],
                        &(yyvsp[(yyi + 1) - (yynrhs)])
-                       , &(yylsp[(yyi + 1) - (yynrhs)])                       , mc, oxml, result, error_msg);
+                       , &(yylsp[(yyi + 1) - (yynrhs)])                       , mc, oxml, result, error_msg, scanner);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -829,7 +834,7 @@ yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule
 # define YY_REDUCE_PRINT(Rule)          \
 do {                                    \
   if (yydebug)                          \
-    yy_reduce_print (yyssp, yyvsp, yylsp, Rule, mc, oxml, result, error_msg); \
+    yy_reduce_print (yyssp, yyvsp, yylsp, Rule, mc, oxml, result, error_msg, scanner); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
@@ -1087,7 +1092,7 @@ yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg)
+yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg, void *      scanner)
 {
   YYUSE (yyvaluep);
   YYUSE (yylocationp);
@@ -1095,6 +1100,7 @@ yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocatio
   YYUSE (oxml);
   YYUSE (result);
   YYUSE (error_msg);
+  YYUSE (scanner);
   if (!yymsg)
     yymsg = "Deleting";
   YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
@@ -1112,7 +1118,7 @@ yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocatio
 `----------*/
 
 int
-yyparse (mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg)
+yyparse (mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg, void *      scanner)
 {
 /* The lookahead symbol.  */
 int yychar;
@@ -1306,7 +1312,7 @@ yybackup:
   if (yychar == YYEMPTY)
     {
       YYDPRINTF ((stderr, "Reading a token: "));
-      yychar = yylex (&yylval, &yylloc, mc);
+      yychar = yylex (&yylval, &yylloc, mc, scanner);
     }
 
   if (yychar <= YYEOF)
@@ -1386,73 +1392,73 @@ yyreduce:
   switch (yyn)
     {
         case 2:
-#line 100 "expr_arith.y" /* yacc.c:1646  */
+#line 106 "expr_arith.y" /* yacc.c:1646  */
     { result = static_cast<int>((yyvsp[0].val_float));}
-#line 1392 "expr_arith.cc" /* yacc.c:1646  */
+#line 1398 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 3:
-#line 101 "expr_arith.y" /* yacc.c:1646  */
+#line 107 "expr_arith.y" /* yacc.c:1646  */
     { result = 0; }
-#line 1398 "expr_arith.cc" /* yacc.c:1646  */
+#line 1404 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 4:
-#line 104 "expr_arith.y" /* yacc.c:1646  */
+#line 110 "expr_arith.y" /* yacc.c:1646  */
     { float val; oxml->search((yyvsp[0].val_str), val); (yyval.val_float) = val; }
-#line 1404 "expr_arith.cc" /* yacc.c:1646  */
+#line 1410 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 5:
-#line 105 "expr_arith.y" /* yacc.c:1646  */
+#line 111 "expr_arith.y" /* yacc.c:1646  */
     { (yyval.val_float) = (yyvsp[0].val_float); }
-#line 1410 "expr_arith.cc" /* yacc.c:1646  */
+#line 1416 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 6:
-#line 106 "expr_arith.y" /* yacc.c:1646  */
+#line 112 "expr_arith.y" /* yacc.c:1646  */
     { (yyval.val_float) = static_cast<float>((yyvsp[0].val_int)); }
-#line 1416 "expr_arith.cc" /* yacc.c:1646  */
+#line 1422 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 7:
-#line 107 "expr_arith.y" /* yacc.c:1646  */
+#line 113 "expr_arith.y" /* yacc.c:1646  */
     { (yyval.val_float) = (yyvsp[-2].val_float) + (yyvsp[0].val_float);}
-#line 1422 "expr_arith.cc" /* yacc.c:1646  */
+#line 1428 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 8:
-#line 108 "expr_arith.y" /* yacc.c:1646  */
+#line 114 "expr_arith.y" /* yacc.c:1646  */
     { (yyval.val_float) = (yyvsp[-2].val_float) - (yyvsp[0].val_float);}
-#line 1428 "expr_arith.cc" /* yacc.c:1646  */
+#line 1434 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 9:
-#line 109 "expr_arith.y" /* yacc.c:1646  */
+#line 115 "expr_arith.y" /* yacc.c:1646  */
     { (yyval.val_float) = (yyvsp[-2].val_float) * (yyvsp[0].val_float);}
-#line 1434 "expr_arith.cc" /* yacc.c:1646  */
+#line 1440 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 10:
-#line 110 "expr_arith.y" /* yacc.c:1646  */
+#line 116 "expr_arith.y" /* yacc.c:1646  */
     { (yyval.val_float) = (yyvsp[-2].val_float) / (yyvsp[0].val_float);}
-#line 1440 "expr_arith.cc" /* yacc.c:1646  */
+#line 1446 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 11:
-#line 111 "expr_arith.y" /* yacc.c:1646  */
+#line 117 "expr_arith.y" /* yacc.c:1646  */
     { (yyval.val_float) = - (yyvsp[0].val_float);}
-#line 1446 "expr_arith.cc" /* yacc.c:1646  */
+#line 1452 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 12:
-#line 112 "expr_arith.y" /* yacc.c:1646  */
+#line 118 "expr_arith.y" /* yacc.c:1646  */
     { (yyval.val_float) = (yyvsp[-1].val_float);}
-#line 1452 "expr_arith.cc" /* yacc.c:1646  */
+#line 1458 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
 
-#line 1456 "expr_arith.cc" /* yacc.c:1646  */
+#line 1462 "expr_arith.cc" /* yacc.c:1646  */
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -1503,7 +1509,7 @@ yyerrlab:
     {
       ++yynerrs;
 #if ! YYERROR_VERBOSE
-      yyerror (&yylloc, mc, oxml, result, error_msg, YY_("syntax error"));
+      yyerror (&yylloc, mc, oxml, result, error_msg, scanner, YY_("syntax error"));
 #else
 # define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
                                         yyssp, yytoken)
@@ -1530,7 +1536,7 @@ yyerrlab:
                 yymsgp = yymsg;
               }
           }
-        yyerror (&yylloc, mc, oxml, result, error_msg, yymsgp);
+        yyerror (&yylloc, mc, oxml, result, error_msg, scanner, yymsgp);
         if (yysyntax_error_status == 2)
           goto yyexhaustedlab;
       }
@@ -1554,7 +1560,7 @@ yyerrlab:
       else
         {
           yydestruct ("Error: discarding",
-                      yytoken, &yylval, &yylloc, mc, oxml, result, error_msg);
+                      yytoken, &yylval, &yylloc, mc, oxml, result, error_msg, scanner);
           yychar = YYEMPTY;
         }
     }
@@ -1611,7 +1617,7 @@ yyerrlab1:
 
       yyerror_range[1] = *yylsp;
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp, yylsp, mc, oxml, result, error_msg);
+                  yystos[yystate], yyvsp, yylsp, mc, oxml, result, error_msg, scanner);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1653,7 +1659,7 @@ yyabortlab:
 | yyexhaustedlab -- memory exhaustion comes here.  |
 `-------------------------------------------------*/
 yyexhaustedlab:
-  yyerror (&yylloc, mc, oxml, result, error_msg, YY_("memory exhausted"));
+  yyerror (&yylloc, mc, oxml, result, error_msg, scanner, YY_("memory exhausted"));
   yyresult = 2;
   /* Fall through.  */
 #endif
@@ -1665,7 +1671,7 @@ yyreturn:
          user semantic actions for why this is necessary.  */
       yytoken = YYTRANSLATE (yychar);
       yydestruct ("Cleanup: discarding lookahead",
-                  yytoken, &yylval, &yylloc, mc, oxml, result, error_msg);
+                  yytoken, &yylval, &yylloc, mc, oxml, result, error_msg, scanner);
     }
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
@@ -1674,7 +1680,7 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[*yyssp], yyvsp, yylsp, mc, oxml, result, error_msg);
+                  yystos[*yyssp], yyvsp, yylsp, mc, oxml, result, error_msg, scanner);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
@@ -1687,7 +1693,7 @@ yyreturn:
 #endif
   return yyresult;
 }
-#line 115 "expr_arith.y" /* yacc.c:1906  */
+#line 121 "expr_arith.y" /* yacc.c:1906  */
 
 
 extern "C" void expr_arith__error(
@@ -1696,6 +1702,7 @@ extern "C" void expr_arith__error(
     ObjectXML *     oxml,
     int&            result,
     char **         error_msg,
+    void *          scanner,
     const char *    str)
 {
     int length;
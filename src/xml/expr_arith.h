@@ -56,7 +56,7 @@ extern int expr_arith__debug;
 typedef union YYSTYPE YYSTYPE;
 union YYSTYPE
 {
-#line 78 "expr_arith.y" /* yacc.c:1909  */
+#line 84 "expr_arith.y" /* yacc.c:1909  */
 
     char *  val_str;
     int     val_int;
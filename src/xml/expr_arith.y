@@ -42,23 +42,27 @@ extern "C"
         ObjectXML *     oxml,
         int&            result,
         char **         error_msg,
+        void *          scanner,
         const char *    str);
 
-    int expr_arith__lex (YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc);
+    int expr_arith__lex (YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc,
+        void * scanner);
 
     int expr_arith__parse(mem_collector * mc,
                           ObjectXML *     oxml,
                           int&            result,
-                          char **         errmsg);
+                          char **         errmsg,
+                          void *          scanner);
 
-    int expr_arith_parse(ObjectXML *oxml, int& result, char ** errmsg)
+    int expr_arith_parse(ObjectXML *oxml, int& result, char ** errmsg,
+        void * scanner)
     {
         mem_collector mc;
         int           rc;
 
         mem_collector_init(&mc);
 
-        rc = expr_arith__parse(&mc,oxml,result,errmsg);
+        rc = expr_arith__parse(&mc,oxml,result,errmsg,scanner);
 
         mem_collector_cleanup(&mc);
 
@@ -72,8 +76,10 @@ extern "C"
 %parse-param {ObjectXML * oxml}
 %parse-param {int&        result}
 %parse-param {char **     error_msg}
+%parse-param {void *      scanner}
 
 %lex-param {mem_collector * mc}
+%lex-param {void *          scanner}
 
 %union {
     char *  val_str;
@@ -120,6 +126,7 @@ extern "C" void expr_arith__error(
     ObjectXML *     oxml,
     int&            result,
     char **         error_msg,
+    void *          scanner,
     const char *    str)
 {
     int length;
@@ -97,23 +97,27 @@ extern "C"
         ObjectXML *     oxml,
         bool&           result,
         char **         error_msg,
+        void *          scanner,
         const char *    str);
 
-    int expr_bool__lex (YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc);
+    int expr_bool__lex (YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc,
+        void * scanner);
 
     int expr_bool__parse(mem_collector * mc,
                          ObjectXML *     oxml,
                          bool&           result,
-                         char **         errmsg);
+                         char **         errmsg,
+                         void *          scanner);
 
-    int expr_bool_parse(ObjectXML *oxml, bool& result, char ** errmsg)
+    int expr_bool_parse(ObjectXML *oxml, bool& result, char ** errmsg,
+        void * scanner)
     {
         mem_collector mc;
         int           rc;
 
         mem_collector_init(&mc);
 
-        rc = expr_bool__parse(&mc,oxml,result,errmsg);
+        rc = expr_bool__parse(&mc,oxml,result,errmsg,scanner);
 
         mem_collector_cleanup(&mc);
 
@@ -121,7 +125,7 @@ extern "C"
     }
 }
 
-#line 125 "expr_bool.cc" /* yacc.c:339  */
+#line 129 "expr_bool.cc" /* yacc.c:339  */
 
 # ifndef YY_NULLPTR
 #  if defined __cplusplus && 201103L <= __cplusplus
@@ -167,13 +171,13 @@ extern int expr_bool__debug;
 typedef union YYSTYPE YYSTYPE;
 union YYSTYPE
 {
-#line 77 "expr_bool.y" /* yacc.c:355  */
+#line 83 "expr_bool.y" /* yacc.c:355  */
 
     char * 	val_str;
     int 	val_int;
     float   val_float;
 
-#line 177 "expr_bool.cc" /* yacc.c:355  */
+#line 181 "expr_bool.cc" /* yacc.c:355  */
 };
 # define YYSTYPE_IS_TRIVIAL 1
 # define YYSTYPE_IS_DECLARED 1
@@ -195,13 +199,13 @@ struct YYLTYPE
 
 
 
-int expr_bool__parse (mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg);
+int expr_bool__parse (mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg, void *          scanner);
 
 #endif /* !YY_EXPR_BOOL_EXPR_BOOL_HH_INCLUDED  */
 
 /* Copy the second part of user declarations.  */
 
-#line 205 "expr_bool.cc" /* yacc.c:358  */
+#line 209 "expr_bool.cc" /* yacc.c:358  */
 
 #ifdef short
 # undef short
@@ -501,8 +505,8 @@ static const yytype_uint8 yytranslate[] =
   /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,    97,    97,    98,   101,   110,   119,   126,   133,   140,
-     147,   154,   160,   168,   176,   177,   178,   179
+       0,   103,   103,   104,   107,   116,   125,   132,   139,   146,
+     153,   160,   166,   174,   182,   183,   184,   185
 };
 #endif
 
@@ -632,7 +636,7 @@ do                                                              \
     }                                                           \
   else                                                          \
     {                                                           \
-      yyerror (&yylloc, mc, oxml, result, error_msg, YY_("syntax error: cannot back up")); \
+      yyerror (&yylloc, mc, oxml, result, error_msg, scanner, YY_("syntax error: cannot back up")); \
       YYERROR;                                                  \
     }                                                           \
 while (0)
@@ -734,7 +738,7 @@ do {                                                                      \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value, Location, mc, oxml, result, error_msg); \
+                  Type, Value, Location, mc, oxml, result, error_msg, scanner); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -745,7 +749,7 @@ do {                                                                      \
 `----------------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg)
+yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg, void *          scanner)
 {
   FILE *yyo = yyoutput;
   YYUSE (yyo);
@@ -754,6 +758,7 @@ yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvalue
   YYUSE (oxml);
   YYUSE (result);
   YYUSE (error_msg);
+  YYUSE (scanner);
   if (!yyvaluep)
     return;
 # ifdef YYPRINT
@@ -769,14 +774,14 @@ yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvalue
 `--------------------------------*/
 
 static void
-yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg)
+yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg, void *          scanner)
 {
   YYFPRINTF (yyoutput, "%s %s (",
              yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
 
   YY_LOCATION_PRINT (yyoutput, *yylocationp);
   YYFPRINTF (yyoutput, ": ");
-  yy_symbol_value_print (yyoutput, yytype, yyvaluep, yylocationp, mc, oxml, result, error_msg);
+  yy_symbol_value_print (yyoutput, yytype, yyvaluep, yylocationp, mc, oxml, result, error_msg, scanner);
   YYFPRINTF (yyoutput, ")");
 }
 
@@ -809,7 +814,7 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule, mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg)
+yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule, mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg, void *          scanner)
 {
   unsigned long int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -823,7 +828,7 @@ yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule
       yy_symbol_print (stderr,
                        yystos[yyssp[yyi + 1 - yynrhs]],
                        &(yyvsp[(yyi + 1) - (yynrhs)])
-                       , &(yylsp[(yyi + 1) - (yynrhs)])                       , mc, oxml, result, error_msg);
+                       , &(yylsp[(yyi + 1) - (yynrhs)])                       , mc, oxml, result, error_msg, scanner);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -831,7 +836,7 @@ yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule
 # define YY_REDUCE_PRINT(Rule)          \
 do {                                    \
   if (yydebug)                          \
-    yy_reduce_print (yyssp, yyvsp, yylsp, Rule, mc, oxml, result, error_msg); \
+    yy_reduce_print (yyssp, yyvsp, yylsp, Rule, mc, oxml, result, error_msg, scanner); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
@@ -1089,7 +1094,7 @@ yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg)
+yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg, void *          scanner)
 {
   YYUSE (yyvaluep);
   YYUSE (yylocationp);
@@ -1097,6 +1102,7 @@ yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocatio
   YYUSE (oxml);
   YYUSE (result);
   YYUSE (error_msg);
+  YYUSE (scanner);
   if (!yymsg)
     yymsg = "Deleting";
   YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
@@ -1114,7 +1120,7 @@ yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocatio
 `----------*/
 
 int
-yyparse (mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg)
+yyparse (mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg, void *          scanner)
 {
 /* The lookahead symbol.  */
 int yychar;
@@ -1308,7 +1314,7 @@ yybackup:
   if (yychar == YYEMPTY)
     {
       YYDPRINTF ((stderr, "Reading a token: "));
-      yychar = yylex (&yylval, &yylloc, mc);
+      yychar = yylex (&yylval, &yylloc, mc, scanner);
     }
 
   if (yychar <= YYEOF)
@@ -1388,19 +1394,19 @@ yyreduce:
   switch (yyn)
     {
         case 2:
-#line 97 "expr_bool.y" /* yacc.c:1646  */
+#line 103 "expr_bool.y" /* yacc.c:1646  */
     { result=(yyvsp[0].val_int);   }
-#line 1394 "expr_bool.cc" /* yacc.c:1646  */
+#line 1400 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 3:
-#line 98 "expr_bool.y" /* yacc.c:1646  */
+#line 104 "expr_bool.y" /* yacc.c:1646  */
     { result=true; }
-#line 1400 "expr_bool.cc" /* yacc.c:1646  */
+#line 1406 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 4:
-#line 101 "expr_bool.y" /* yacc.c:1646  */
+#line 107 "expr_bool.y" /* yacc.c:1646  */
     {
             int val = (yyvsp[0].val_int);
             int rc;
@@ -1409,11 +1415,11 @@ yyreduce:
 
             (yyval.val_int) = (rc == 0 && val == (yyvsp[0].val_int));
         }
-#line 1413 "expr_bool.cc" /* yacc.c:1646  */
+#line 1419 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 5:
-#line 110 "expr_bool.y" /* yacc.c:1646  */
+#line 116 "expr_bool.y" /* yacc.c:1646  */
     {
             int val = (yyvsp[0].val_int);
             int rc;
@@ -1422,76 +1428,76 @@ yyreduce:
 
             (yyval.val_int) = (rc == 0 && val != (yyvsp[0].val_int));
         }
-#line 1426 "expr_bool.cc" /* yacc.c:1646  */
+#line 1432 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 6:
-#line 119 "expr_bool.y" /* yacc.c:1646  */
+#line 125 "expr_bool.y" /* yacc.c:1646  */
     {
             int val, rc;
 
             rc = oxml->search((yyvsp[-2].val_str),val);
             (yyval.val_int) = (rc == 0 && val > (yyvsp[0].val_int));
         }
-#line 1437 "expr_bool.cc" /* yacc.c:1646  */
+#line 1443 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 7:
-#line 126 "expr_bool.y" /* yacc.c:1646  */
+#line 132 "expr_bool.y" /* yacc.c:1646  */
     {
             int val, rc;
 
             rc = oxml->search((yyvsp[-2].val_str),val);
             (yyval.val_int) = (rc == 0 && val < (yyvsp[0].val_int));
         }
-#line 1448 "expr_bool.cc" /* yacc.c:1646  */
+#line 1454 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 8:
-#line 133 "expr_bool.y" /* yacc.c:1646  */
+#line 139 "expr_bool.y" /* yacc.c:1646  */
     {
             float val, rc;
 
             rc = oxml->search((yyvsp[-2].val_str),val);
             (yyval.val_int) = (rc == 0 && val == (yyvsp[0].val_float));
         }
-#line 1459 "expr_bool.cc" /* yacc.c:1646  */
+#line 1465 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 9:
-#line 140 "expr_bool.y" /* yacc.c:1646  */
+#line 146 "expr_bool.y" /* yacc.c:1646  */
     {
             float val, rc;
 
             rc = oxml->search((yyvsp[-3].val_str),val);
             (yyval.val_int) = (rc == 0 && val != (yyvsp[0].val_float));
         }
-#line 1470 "expr_bool.cc" /* yacc.c:1646  */
+#line 1476 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 10:
-#line 147 "expr_bool.y" /* yacc.c:1646  */
+#line 153 "expr_bool.y" /* yacc.c:1646  */
     {
             float val, rc;
 
             rc = oxml->search((yyvsp[-2].val_str),val);
             (yyval.val_int) = (rc == 0 && val > (yyvsp[0].val_float));
         }
-#line 1481 "expr_bool.cc" /* yacc.c:1646  */
+#line 1487 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 11:
-#line 154 "expr_bool.y" /* yacc.c:1646  */
+#line 160 "expr_bool.y" /* yacc.c:1646  */
     {
             float val, rc;
 
             rc = oxml->search((yyvsp[-2].val_str),val);
             (yyval.val_int) = (rc == 0 && val < (yyvsp[0].val_float));}
-#line 1491 "expr_bool.cc" /* yacc.c:1646  */
+#line 1497 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 12:
-#line 160 "expr_bool.y" /* yacc.c:1646  */
+#line 166 "expr_bool.y" /* yacc.c:1646  */
     {
             string val;
             int rc;
@@ -1499,11 +1505,11 @@ yyreduce:
             rc = oxml->search((yyvsp[-2].val_str),val);
             (yyval.val_int) = (rc != 0 || (yyvsp[0].val_str)==0) ? false : fnmatch((yyvsp[0].val_str),val.c_str(),0)==0;
         }
-#line 1503 "expr_bool.cc" /* yacc.c:1646  */
+#line 1509 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 13:
-#line 168 "expr_bool.y" /* yacc.c:1646  */
+#line 174 "expr_bool.y" /* yacc.c:1646  */
     {
             string val;
             int rc;
@@ -1511,35 +1517,35 @@ yyreduce:
             rc = oxml->search((yyvsp[-3].val_str),val);
             (yyval.val_int) = (rc != 0 || (yyvsp[0].val_str)==0) ? false : fnmatch((yyvsp[0].val_str),val.c_str(),0)!=0;
         }
-#line 1515 "expr_bool.cc" /* yacc.c:1646  */
+#line 1521 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 14:
-#line 176 "expr_bool.y" /* yacc.c:1646  */
+#line 182 "expr_bool.y" /* yacc.c:1646  */
     { (yyval.val_int) = (yyvsp[-2].val_int) && (yyvsp[0].val_int); }
-#line 1521 "expr_bool.cc" /* yacc.c:1646  */
+#line 1527 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 15:
-#line 177 "expr_bool.y" /* yacc.c:1646  */
+#line 183 "expr_bool.y" /* yacc.c:1646  */
     { (yyval.val_int) = (yyvsp[-2].val_int) || (yyvsp[0].val_int); }
-#line 1527 "expr_bool.cc" /* yacc.c:1646  */
+#line 1533 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 16:
-#line 178 "expr_bool.y" /* yacc.c:1646  */
+#line 184 "expr_bool.y" /* yacc.c:1646  */
     { (yyval.val_int) = ! (yyvsp[0].val_int); }
-#line 1533 "expr_bool.cc" /* yacc.c:1646  */
+#line 1539 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 17:
-#line 179 "expr_bool.y" /* yacc.c:1646  */
+#line 185 "expr_bool.y" /* yacc.c:1646  */
     { (yyval.val_int) =   (yyvsp[-1].val_int); }
-#line 1539 "expr_bool.cc" /* yacc.c:1646  */
+#line 1545 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
 
-#line 1543 "expr_bool.cc" /* yacc.c:1646  */
+#line 1549 "expr_bool.cc" /* yacc.c:1646  */
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -1590,7 +1596,7 @@ yyerrlab:
     {
       ++yynerrs;
 #if ! YYERROR_VERBOSE
-      yyerror (&yylloc, mc, oxml, result, error_msg, YY_("syntax error"));
+      yyerror (&yylloc, mc, oxml, result, error_msg, scanner, YY_("syntax error"));
 #else
 # define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
                                         yyssp, yytoken)
@@ -1617,7 +1623,7 @@ yyerrlab:
                 yymsgp = yymsg;
               }
           }
-        yyerror (&yylloc, mc, oxml, result, error_msg, yymsgp);
+        yyerror (&yylloc, mc, oxml, result, error_msg, scanner, yymsgp);
         if (yysyntax_error_status == 2)
           goto yyexhaustedlab;
       }
@@ -1641,7 +1647,7 @@ yyerrlab:
       else
         {
           yydestruct ("Error: discarding",
-                      yytoken, &yylval, &yylloc, mc, oxml, result, error_msg);
+                      yytoken, &yylval, &yylloc, mc, oxml, result, error_msg, scanner);
           yychar = YYEMPTY;
         }
     }
@@ -1698,7 +1704,7 @@ yyerrlab1:
 
       yyerror_range[1] = *yylsp;
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp, yylsp, mc, oxml, result, error_msg);
+                  yystos[yystate], yyvsp, yylsp, mc, oxml, result, error_msg, scanner);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1740,7 +1746,7 @@ yyabortlab:
 | yyexhaustedlab -- memory exhaustion comes here.  |
 `-------------------------------------------------*/
 yyexhaustedlab:
-  yyerror (&yylloc, mc, oxml, result, error_msg, YY_("memory exhausted"));
+  yyerror (&yylloc, mc, oxml, result, error_msg, scanner, YY_("memory exhausted"));
   yyresult = 2;
   /* Fall through.  */
 #endif
@@ -1752,7 +1758,7 @@ yyreturn:
          user semantic actions for why this is necessary.  */
       yytoken = YYTRANSLATE (yychar);
       yydestruct ("Cleanup: discarding lookahead",
-                  yytoken, &yylval, &yylloc, mc, oxml, result, error_msg);
+                  yytoken, &yylval, &yylloc, mc, oxml, result, error_msg, scanner);
     }
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
@@ -1761,7 +1767,7 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[*yyssp], yyvsp, yylsp, mc, oxml, result, error_msg);
+                  yystos[*yyssp], yyvsp, yylsp, mc, oxml, result, error_msg, scanner);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
@@ -1774,7 +1780,7 @@ yyreturn:
 #endif
   return yyresult;
 }
-#line 182 "expr_bool.y" /* yacc.c:1906  */
+#line 188 "expr_bool.y" /* yacc.c:1906  */
 
 
 extern "C" void expr_bool__error(
@@ -1783,6 +1789,7 @@ extern "C" void expr_bool__error(
     ObjectXML *     oxml,
     bool&           result,
     char **         error_msg,
+    void *          scanner,
     const char *    str)
 {
     int length;
@@ -56,7 +56,7 @@ extern int expr_bool__debug;
 typedef union YYSTYPE YYSTYPE;
 union YYSTYPE
 {
-#line 77 "expr_bool.y" /* yacc.c:1909  */
+#line 83 "expr_bool.y" /* yacc.c:1909  */
 
     char * 	val_str;
     int 	val_int;
@@ -42,23 +42,27 @@ extern "C"
         ObjectXML *     oxml,
         bool&           result,
         char **         error_msg,
+        void *          scanner,
         const char *    str);
 
-    int expr_bool__lex (YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc);
+    int expr_bool__lex (YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc,
+        void * scanner);
 
     int expr_bool__parse(mem_collector * mc,
                          ObjectXML *     oxml,
                          bool&           result,
-                         char **         errmsg);
+                         char **         errmsg,
+                         void *          scanner);
 
-    int expr_bool_parse(ObjectXML *oxml, bool& result, char ** errmsg)
+    int expr_bool_parse(ObjectXML *oxml, bool& result, char ** errmsg,
+        void * scanner)
     {
         mem_collector mc;
         int           rc;
 
         mem_collector_init(&mc);
 
-        rc = expr_bool__parse(&mc,oxml,result,errmsg);
+        rc = expr_bool__parse(&mc,oxml,result,errmsg,scanner);
 
         mem_collector_cleanup(&mc);
 
@@ -71,8 +75,10 @@ extern "C"
 %parse-param {ObjectXML *     oxml}
 %parse-param {bool&           result}
 %parse-param {char **         error_msg}
+%parse-param {void *          scanner}
 
 %lex-param {mem_collector * mc}
+%lex-param {void *          scanner}
 
 %union {
     char * 	val_str;
@@ -187,6 +193,7 @@ extern "C" void expr_bool__error(
     ObjectXML *     oxml,
     bool&           result,
     char **         error_msg,
+    void *          scanner,
     const char *    str)
 {
     int length;
@@ -28,10 +28,16 @@ const int ZonePool::STANDALONE_ZONE_ID = 0;
 /* -------------------------------------------------------------------------- */
 
 ZonePool::ZonePool(SqlDB * db, bool is_federation_slave)
-    :PoolSQL(db, Zone::table, !is_federation_slave, true)
+    :PoolSQL(db, Zone::table, true, true)
 {
     string error_str;
 
+    // Slaves check the cached zones against the changes done by the master
+    if (Nebula::instance().is_federation_enabled())
+    {
+        enable_change_log(is_federation_slave);
+    }
+
     //Federation slaves do not need to init the pool
     if (is_federation_slave)
     {
@@ -169,7 +175,14 @@ int ZonePool::update(Zone * zone)
         return -1;
     }
 
-    return zone->update(db);
+    int rc = zone->update(db);
+
+    if ( rc == 0 )
+    {
+        log_change(zone->get_oid());
+    }
+
+    return rc;
 }
 
 /* -------------------------------------------------------------------------- */